@@ -0,0 +1,17 @@
+/**
+ * Check persistent_worker.hpp for details
+ *
+ * https://github.com/catchorg/Catch2/blob/master/docs/own-main.md
+ */
+#define CATCH_CONFIG_RUNNER
+#include "catch2/catch_all.hpp"
+
+#include "persistent_worker.hpp"
+
+int main(int argc, char* argv[]) {
+  // expensive global setup could come here: it will be done only once
+
+  return testmate_persistent_worker::run(argc, argv, [](int argc, char* argv[]) {
+    return Catch::Session().run(argc, argv);
+  });
+}
@@ -0,0 +1,19 @@
+/**
+ * Check persistent_worker.hpp for details
+ *
+ * https://github.com/google/googletest/blob/master/googletest/docs/primer.md#writing-the-main-function
+ *
+ */
+
+#include "gtest/gtest.h"
+
+#include "persistent_worker.hpp"
+
+int main(int argc, char **argv) {
+  // expensive global setup could come here: it will be done only once
+
+  return testmate_persistent_worker::run(argc, argv, [](int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+  });
+}
@@ -0,0 +1,123 @@
+/**
+ * Persistent worker for TestMate C++: `advancedExecutables[].persistentWorker`
+ *
+ * The static initialization, dynamic linking and any expensive setup done before
+ * calling `testmate_persistent_worker::run` happens only once.
+ * After that the process stays alive and for every run request it forks a child
+ * which runs the test framework's main with the requested arguments.
+ * The forked child starts from the already initialized state.
+ *
+ * Protocol (the extension takes care of it, documented only for the curious):
+ *   - The executable is started with `TESTMATE_PERSISTENT_WORKER=3` and `--help` (the arguments are ignored:
+ *     an executable which doesn't support the protocol prints its help and exits).
+ *   - worker -> extension: `@@TestMate.persistentWorker.ready@@ 3`
+ *   - extension -> worker: number of arguments in a line, then every argument in a separate line.
+ *   - child -> extension: `@@TestMate.persistentWorker.started@@ <pid>` then the normal output.
+ *     The stdin of the child is `/dev/null`: the requests are read only by the worker.
+ *   - worker -> extension: `\n@@TestMate.persistentWorker.exited@@ <exitCode> <signal>` to stdout and stderr.
+ *
+ * Without the environment variable it behaves like a normal main.
+ *
+ * Note: Requires `fork()`. On Windows it reports `unsupported` and the extension falls back to
+ *   spawning the executable for every run.
+ */
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace testmate_persistent_worker {
+
+inline bool isRequested() {
+  const char* value = std::getenv("TESTMATE_PERSISTENT_WORKER");
+  return value != nullptr && std::string(value) == "3";
+}
+
+/**
+ * `runMain` should be callable as `int(int argc, char* argv[])`.
+ * Returns the exit code for `main`.
+ */
+template <typename RunMainT>
+int run(int argc, char* argv[], RunMainT&& runMain) {
+  if (!isRequested()) return runMain(argc, argv);
+
+#ifdef _WIN32
+  std::cout << "@@TestMate.persistentWorker.unsupported@@" << std::endl;
+  return 0;
+#else
+  std::cout << "@@TestMate.persistentWorker.ready@@ 3" << std::endl;
+
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    if (line.empty()) continue;
+
+    int count = 0;
+    try {
+      count = std::stoi(line);
+    } catch (...) {
+      std::cerr << "persistent worker: wrong request: " << line << std::endl;
+      return 1;
+    }
+
+    std::vector<std::string> args;
+    args.push_back(argc > 0 ? argv[0] : "");
+    for (int i = 0; i < count && std::getline(std::cin, line); ++i) args.push_back(line);
+
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+
+    const pid_t pid = fork();
+    if (pid == 0) {
+      // child: runs the tests starting from the already initialized state
+      unsetenv("TESTMATE_PERSISTENT_WORKER");
+      // a test reading stdin would consume the next requests (and the already buffered ones are dropped)
+      if (std::freopen("/dev/null", "r", stdin) == nullptr) close(STDIN_FILENO);
+      std::cin.clear();
+      std::cout << "@@TestMate.persistentWorker.started@@ " << getpid() << std::endl;
+
+      std::vector<char*> childArgv;
+      for (auto& a : args) childArgv.push_back(&a[0]);
+      childArgv.push_back(nullptr);
+
+      const int exitCode = runMain(static_cast<int>(args.size()), childArgv.data());
+
+      std::cout.flush();
+      std::cerr.flush();
+      std::exit(exitCode);  // runs the atexit handlers: coverage data is written
+    }
+
+    int exitCode = -1;
+    int signal = 0;
+    if (pid > 0) {
+      int status = 0;
+      while (waitpid(pid, &status, 0) == -1 && errno == EINTR) {
+      }
+      if (WIFEXITED(status))
+        exitCode = WEXITSTATUS(status);
+      else if (WIFSIGNALED(status))
+        signal = WTERMSIG(status);
+    } else {
+      std::cerr << "persistent worker: fork failed: " << errno << std::endl;
+    }
+
+    // the stderr of the child is complete only after it has exited
+    std::cerr << "\n@@TestMate.persistentWorker.exited@@ " << exitCode << ' ' << signal << std::endl;
+    std::cout << "\n@@TestMate.persistentWorker.exited@@ " << exitCode << ' ' << signal << std::endl;
+  }
+
+  return 0;
+#endif
+}
+
+}  // namespace testmate_persistent_worker
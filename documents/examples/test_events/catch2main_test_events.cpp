@@ -0,0 +1,17 @@
+/**
+ * Check testmate_events.hpp for details
+ *
+ * Linked with Catch2WithMain: the reporter only has to be included once.
+ */
+#include "catch2/catch_test_macros.hpp"
+
+#include "testmate_events_catch2.hpp"
+
+TEST_CASE("passing") { REQUIRE(1 + 1 == 2); }
+
+TEST_CASE("failing") {
+  SECTION("section") {
+    int a = 1;
+    CHECK(a == 2);
+  }
+}
@@ -0,0 +1,16 @@
+/**
+ * Check testmate_events.hpp for details
+ */
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+#include "testmate_events_doctest.hpp"
+
+TEST_CASE("passing") { CHECK(1 + 1 == 2); }
+
+TEST_CASE("failing") {
+  SUBCASE("subcase") {
+    int a = 1;
+    CHECK(a == 2);
+  }
+}
@@ -0,0 +1,20 @@
+/**
+ * Check testmate_events.hpp for details
+ *
+ * https://github.com/google/googletest/blob/master/googletest/docs/primer.md#writing-the-main-function
+ *
+ */
+
+#include "gtest/gtest.h"
+
+#include "testmate_events_gtest.hpp"
+
+TEST(TestEvents, Passing) { EXPECT_EQ(1 + 1, 2); }
+
+TEST(TestEvents, Failing) { EXPECT_EQ(1, 2) << "message"; }
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  testmate_events::installGoogleTestListener();
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,179 @@
+/**
+ * Event reporter for TestMate C++: the test results as NDJSON events on a dedicated file descriptor.
+ *
+ * Parsing the XML or console output of the test frameworks is the most expensive part of running
+ * assertion heavy suites. With one of the framework specific headers linked the extension reads
+ * these compact events instead and doesn't parse the output at all:
+ *   - Catch2 v3: `testmate_events_catch2.hpp` (registers the `testmate` reporter)
+ *   - Google Test: `testmate_events_gtest.hpp` (call `testmate_events::installGoogleTestListener()` in your main)
+ *   - doctest: `testmate_events_doctest.hpp` (registers the `testmate` reporter)
+ * Include it in exactly one translation unit, the one with the main is a good candidate.
+ * The extension finds the reporter by the `TESTMATE_EVENTS_FD` string in the `.rodata` section of ELF binaries.
+ * Otherwise (or to be explicit) set `testEvents: true` in `testMate.cpp.test.advancedExecutables`.
+ *
+ * Protocol (the extension takes care of it, documented only for the curious):
+ *   - The run is started with `TESTMATE_EVENTS_FD=<fd>`, `TESTMATE_EVENTS=1` and the `testmate` reporter
+ *     (Catch2, doctest). The fd is opened only for the executables having the reporter.
+ *   - executable -> extension (at static initialization): `{"type":"hello","version":1}`.
+ *     Without it the extension falls back to parsing the output for the current build of the executable.
+ *   - Every line on the fd is a JSON object:
+ *       {"type":"testStart","name":"...","suite":"...","file":"...","line":1}
+ *       {"type":"sectionStart","name":"...","file":"...","line":1}
+ *       {"type":"failure","file":"...","line":1,"macro":"REQUIRE","expr":"a == b","expanded":"1 == 2",
+ *        "message":"...","kind":"exception"}
+ *       {"type":"sectionEnd","result":"passed|failed|skipped","durationMs":1.5}
+ *       {"type":"testEnd","result":"passed|failed|skipped","durationMs":1.5}
+ *     The sections (Catch2 `SECTION`, doctest `SUBCASE`) are nested into the test and into each other,
+ *     a failure belongs to the innermost one.
+ *   - The output of the tests isn't captured: it goes to stdout as it is.
+ *
+ * Without the environment variables it does nothing.
+ */
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+namespace testmate_events {
+
+inline int getFd() {
+  static const int fd = [] {
+    const char* value = std::getenv("TESTMATE_EVENTS_FD");
+    return value != nullptr ? std::atoi(value) : -1;
+  }();
+  return fd;
+}
+
+/**
+ * True if the extension asks for the events instead of the normal output of the framework.
+ */
+inline bool isRequested() {
+  const char* value = std::getenv("TESTMATE_EVENTS");
+  return getFd() > 2 && value != nullptr && std::string(value) == "1";
+}
+
+inline void writeLine(const std::string& line) {
+  const int fd = getFd();
+  if (fd <= 2) return;  // never into stdin, stdout or stderr
+  const char* data = line.data();
+  size_t left = line.size();
+  while (left > 0) {
+#ifdef _WIN32
+    const int written = _write(fd, data, static_cast<unsigned int>(left));
+    if (written <= 0) return;
+#else
+    const ssize_t written = write(fd, data, left);
+    if (written < 0 && errno == EINTR) continue;
+    if (written <= 0) return;
+#endif
+    data += written;
+    left -= static_cast<size_t>(written);
+  }
+}
+
+/**
+ * Builds one line of the protocol: `Event("testEnd").str("result", "passed").num("durationMs", 1.5).emit();`
+ */
+class Event {
+ public:
+  explicit Event(const char* type) : m_json("{\"type\":\"") {
+    m_json += type;
+    m_json += '"';
+  }
+
+  Event& str(const char* key, const std::string& value) {
+    appendKey(key);
+    appendString(value);
+    return *this;
+  }
+
+  Event& str(const char* key, const char* value) {
+    if (value != nullptr) str(key, std::string(value));
+    return *this;
+  }
+
+  Event& num(const char* key, double value) {
+    appendKey(key);
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+    m_json += buffer;
+    return *this;
+  }
+
+  void emit() {
+    m_json += "}\n";
+    writeLine(m_json);
+  }
+
+ private:
+  void appendKey(const char* key) {
+    m_json += ",\"";
+    m_json += key;
+    m_json += "\":";
+  }
+
+  void appendString(const std::string& value) {
+    m_json += '"';
+    for (const char c : value) {
+      switch (c) {
+        case '"':
+          m_json += "\\\"";
+          break;
+        case '\\':
+          m_json += "\\\\";
+          break;
+        case '\n':
+          m_json += "\\n";
+          break;
+        case '\r':
+          m_json += "\\r";
+          break;
+        case '\t':
+          m_json += "\\t";
+          break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20) {
+            char buffer[8];
+            std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned>(c));
+            m_json += buffer;
+          } else {
+            m_json += c;
+          }
+      }
+    }
+    m_json += '"';
+  }
+
+  std::string m_json;
+};
+
+namespace detail {
+
+// once per process even if more translation units include it
+inline void sayHello() {
+  static const bool said = [] {
+    if (getFd() > 2) Event("hello").num("version", 1).emit();
+    return true;
+  }();
+  (void)said;
+}
+
+struct HelloAtStaticInit {
+  HelloAtStaticInit() { sayHello(); }
+};
+
+namespace {
+const HelloAtStaticInit helloAtStaticInit;
+}  // namespace
+
+}  // namespace detail
+
+}  // namespace testmate_events
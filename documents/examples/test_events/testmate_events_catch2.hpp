@@ -0,0 +1,113 @@
+/**
+ * Check testmate_events.hpp for details
+ *
+ * Catch2 v3: registers the `testmate` reporter. Include it in exactly one translation unit.
+ * The skipped results (`SKIP`) are reported from v3.3.0.
+ *
+ * https://github.com/catchorg/Catch2/blob/devel/docs/reporters.md
+ */
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include "catch2/catch_test_case_info.hpp"
+#include "catch2/catch_version_macros.hpp"
+#include "catch2/reporters/catch_reporter_registrars.hpp"
+#include "catch2/reporters/catch_reporter_streaming_base.hpp"
+
+#include "testmate_events.hpp"
+
+namespace testmate_events {
+
+// `Counts::skipped` exists since v3.3.0
+inline bool hasSkipped(const Catch::Counts& counts) {
+#if CATCH_VERSION_MAJOR > 3 || (CATCH_VERSION_MAJOR == 3 && CATCH_VERSION_MINOR >= 3)
+  return counts.skipped > 0;
+#else
+  static_cast<void>(counts);
+  return false;
+#endif
+}
+
+class Catch2Reporter : public Catch::StreamingReporterBase {
+ public:
+  explicit Catch2Reporter(Catch::ReporterConfig&& config) : StreamingReporterBase(std::move(config)) {
+    // the output of the tests goes to stdout as it is
+    m_preferences.shouldRedirectStdOut = false;
+    m_preferences.shouldReportAllAssertions = false;
+  }
+
+  static std::string getDescription() { return "NDJSON events for TestMate C++ (see testmate_events.hpp)"; }
+
+  void testCaseStarting(Catch::TestCaseInfo const& info) override {
+    StreamingReporterBase::testCaseStarting(info);
+    m_start = std::chrono::steady_clock::now();
+    Event("testStart")
+        .str("name", info.name)
+        .str("file", info.lineInfo.file)
+        .num("line", static_cast<double>(info.lineInfo.line))
+        .emit();
+  }
+
+  void assertionEnded(Catch::AssertionStats const& stats) override {
+    const Catch::AssertionResult& result = stats.assertionResult;
+    if (result.isOk()) return;  // warnings and skips too
+
+    std::string message;
+    for (const Catch::MessageInfo& info : stats.infoMessages) {
+      if (!message.empty()) message += '\n';
+      message += info.message;
+    }
+    if (result.hasMessage()) {
+      if (!message.empty()) message += '\n';
+      message += static_cast<std::string>(result.getMessage());
+    }
+
+    Event event("failure");
+    event.str("file", result.getSourceInfo().file).num("line", static_cast<double>(result.getSourceInfo().line));
+    event.str("macro", static_cast<std::string>(result.getTestMacroName()));
+    if (result.hasExpression()) event.str("expr", result.getExpression());
+    if (result.hasExpandedExpression()) event.str("expanded", result.getExpandedExpression());
+    if (result.getResultType() == Catch::ResultWas::ThrewException) event.str("kind", "exception");
+    event.str("message", message).emit();
+  }
+
+  void sectionStarting(Catch::SectionInfo const& info) override {
+    StreamingReporterBase::sectionStarting(info);
+    // the first one is the test case itself
+    if (m_sectionStack.size() <= 1) return;
+    Event("sectionStart")
+        .str("name", info.name)
+        .str("file", info.lineInfo.file)
+        .num("line", static_cast<double>(info.lineInfo.line))
+        .emit();
+  }
+
+  void sectionEnded(Catch::SectionStats const& stats) override {
+    if (m_sectionStack.size() > 1) {
+      const char* result = stats.assertions.failed > 0    ? "failed"
+                           : hasSkipped(stats.assertions) ? "skipped"
+                                                          : "passed";
+      Event("sectionEnd").str("result", result).num("durationMs", stats.durationInSeconds * 1000).emit();
+    }
+    StreamingReporterBase::sectionEnded(stats);
+  }
+
+  void testCaseEnded(Catch::TestCaseStats const& stats) override {
+    const double durationMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+    const char* result = stats.totals.assertions.failed > 0    ? "failed"
+                         : hasSkipped(stats.totals.assertions) ? "skipped"
+                                                               : "passed";
+    Event("testEnd").str("result", result).num("durationMs", durationMs).emit();
+    StreamingReporterBase::testCaseEnded(stats);
+  }
+
+ private:
+  std::chrono::steady_clock::time_point m_start;
+};
+
+}  // namespace testmate_events
+
+CATCH_REGISTER_REPORTER("testmate", testmate_events::Catch2Reporter)
@@ -0,0 +1,105 @@
+/**
+ * Check testmate_events.hpp for details
+ *
+ * doctest: registers the `testmate` reporter. Include it in exactly one translation unit
+ * after `doctest/doctest.h` (the one with `DOCTEST_CONFIG_IMPLEMENT` or `DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN`).
+ *
+ * https://github.com/doctest/doctest/blob/master/doc/markdown/reporters.md
+ */
+#pragma once
+
+#include <vector>
+
+#include "doctest/doctest.h"
+
+#include "testmate_events.hpp"
+
+namespace testmate_events {
+
+struct DoctestReporter : public doctest::IReporter {
+  explicit DoctestReporter(const doctest::ContextOptions&) {}
+
+  void report_query(const doctest::QueryData&) override {}
+
+  void test_run_start() override {}
+
+  void test_run_end(const doctest::TestRunStats&) override {}
+
+  void test_case_start(const doctest::TestCaseData& tc) override {
+    m_subcaseFailed.clear();
+    Event("testStart")
+        .str("name", tc.m_name)
+        .str("suite", tc.m_test_suite)
+        .str("file", doctest::skipPathFromFilename(tc.m_file.c_str()))
+        .num("line", tc.m_line)
+        .emit();
+  }
+
+  void test_case_reenter(const doctest::TestCaseData&) override { m_subcaseFailed.clear(); }
+
+  void test_case_end(const doctest::CurrentTestCaseStats& stats) override {
+    Event("testEnd")
+        .str("result", stats.testCaseSuccess ? "passed" : "failed")
+        .num("durationMs", stats.seconds * 1000)
+        .emit();
+  }
+
+  void test_case_exception(const doctest::TestCaseException& e) override {
+    markFailed();
+    Event("failure").str("kind", "exception").str("message", e.error_string.c_str()).emit();
+  }
+
+  void subcase_start(const doctest::SubcaseSignature& signature) override {
+    m_subcaseFailed.push_back(false);
+    Event("sectionStart")
+        .str("name", signature.m_name.c_str())
+        .str("file", doctest::skipPathFromFilename(signature.m_file))
+        .num("line", signature.m_line)
+        .emit();
+  }
+
+  void subcase_end() override {
+    if (m_subcaseFailed.empty()) return;
+    Event("sectionEnd").str("result", m_subcaseFailed.back() ? "failed" : "passed").emit();
+    m_subcaseFailed.pop_back();
+  }
+
+  void log_assert(const doctest::AssertData& ad) override {
+    if (!ad.m_failed) return;
+    markFailed();
+    Event event("failure");
+    event.str("file", doctest::skipPathFromFilename(ad.m_file)).num("line", ad.m_line);
+    event.str("macro", doctest::assertString(ad.m_at)).str("expr", ad.m_expr);
+    if (ad.m_threw) {
+      event.str("kind", "exception").str("message", ad.m_exception.c_str());
+    } else {
+      event.str("expanded", ad.m_decomp.c_str());
+    }
+    event.emit();
+  }
+
+  void log_message(const doctest::MessageData& md) override {
+    if (!(md.m_severity & doctest::assertType::is_check) && !(md.m_severity & doctest::assertType::is_require))
+      return;  // warnings
+    markFailed();
+    Event("failure")
+        .str("file", doctest::skipPathFromFilename(md.m_file))
+        .num("line", md.m_line)
+        .str("message", md.m_string.c_str())
+        .emit();
+  }
+
+  void test_case_skipped(const doctest::TestCaseData&) override {}
+
+ private:
+  // a failure fails every entered subcase
+  void markFailed() {
+    for (size_t i = 0; i < m_subcaseFailed.size(); ++i) m_subcaseFailed[i] = true;
+  }
+
+  std::vector<bool> m_subcaseFailed;
+};
+
+}  // namespace testmate_events
+
+REGISTER_REPORTER("testmate", 1, testmate_events::DoctestReporter);
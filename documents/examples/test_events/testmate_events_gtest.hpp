@@ -0,0 +1,52 @@
+/**
+ * Check testmate_events.hpp for details
+ *
+ * Google Test: call `testmate_events::installGoogleTestListener()` after `::testing::InitGoogleTest`.
+ * If the extension asks for the events it replaces the default result printer.
+ *
+ * https://github.com/google/googletest/blob/main/docs/advanced.md#extending-googletest-by-handling-test-events
+ */
+#pragma once
+
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "testmate_events.hpp"
+
+namespace testmate_events {
+
+class GoogleTestListener : public ::testing::EmptyTestEventListener {
+ public:
+  void OnTestStart(const ::testing::TestInfo& info) override {
+    Event("testStart")
+        .str("name", info.name())
+        .str("suite", info.test_suite_name())
+        .str("file", info.file())
+        .num("line", info.line())
+        .emit();
+  }
+
+  void OnTestPartResult(const ::testing::TestPartResult& result) override {
+    if (!result.failed()) return;
+    Event event("failure");
+    event.str("file", result.file_name());
+    if (result.line_number() >= 0) event.num("line", result.line_number());
+    event.str("macro", result.fatally_failed() ? "ASSERT" : "EXPECT").str("message", result.message()).emit();
+  }
+
+  void OnTestEnd(const ::testing::TestInfo& info) override {
+    const ::testing::TestResult* result = info.result();
+    const char* status = result->Failed() ? "failed" : result->Skipped() ? "skipped" : "passed";
+    Event("testEnd").str("result", status).num("durationMs", static_cast<double>(result->elapsed_time())).emit();
+  }
+};
+
+inline void installGoogleTestListener() {
+  if (!isRequested()) return;
+  ::testing::TestEventListeners& listeners = ::testing::UnitTest::GetInstance()->listeners();
+  delete listeners.Release(listeners.default_result_printer());
+  listeners.Append(new GoogleTestListener);
+}
+
+}  // namespace testmate_events
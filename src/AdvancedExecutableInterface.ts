@@ -23,6 +23,9 @@ export type AdvancedExecutableConfig = {
   markAsSkipped?: boolean;
   executableRunAsImplicitAll?: boolean;
   executableCloning?: boolean;
+  dynamicTestDispatch?: boolean;
+  persistentWorker?: boolean;
+  testEvents?: boolean;
   executableSuffixToInclude?: string[];
   waitForBuildProcess?: boolean | string;
   'debug.configTemplate': DebugConfig;
@@ -67,6 +70,7 @@ export interface FrameworkSpecificConfig {
   ignoreTestEnumerationStdErr?: boolean;
   'debug.enableOutputColouring'?: boolean;
   failIfExceedsLimitNs?: number;
+  failIfRegressesPercent?: number;
 }
 
 type ResolvableString = string;
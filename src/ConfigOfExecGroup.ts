@@ -24,7 +24,8 @@ import { FrameworkType } from './framework/Framework';
 import { readFileSync } from 'fs';
 import { getModiTime } from './Util';
 import { SubProgressReporter } from './util/ProgressReporter';
-import { ExecCloner } from './framework/AbstractExecutable';
+import { ExecClonePool } from './util/ExecClonePool';
+import { WatchEventBatcher } from './util/WatchEventBatcher';
 import { DebugConfigData } from './DebugConfigType';
 
 ///
@@ -48,6 +49,9 @@ export class ConfigOfExecGroup implements vscode.Disposable {
     private readonly _markAsSkipped: boolean | undefined,
     private readonly _executableRunAsImplicitAll: boolean | undefined,
     private readonly _executableCloning: boolean | undefined,
+    private readonly _dynamicTestDispatch: boolean | undefined,
+    private readonly _persistentWorker: boolean | undefined,
+    private readonly _testEvents: boolean | undefined,
     executableSuffixToInclude: string[] | undefined,
     private readonly _waitForBuildProcess: boolean | string,
     private readonly _debugConfigData: DebugConfigData | undefined,
@@ -95,13 +99,22 @@ export class ConfigOfExecGroup implements vscode.Disposable {
             '.xml',
           ])
         : undefined;
+    this._watchEventBatcher = new WatchEventBatcher(_shared.log, {
+      waitForBuild: (): Promise<void> =>
+        _shared.buildProcessChecker.resolveAtFinish(_waitForBuildProcess, _shared.cancellationToken),
+      rank: (filePath: string): number => this._rank(filePath),
+      handle: (filePath: string): Promise<void> =>
+        this._handleChangedPath(filePath).finally(() => this._lastEventArrivedAt.delete(filePath)),
+    });
   }
 
   private readonly _executableSuffixToInclude: Set<string> | undefined;
   private readonly _executableSuffixToExclude: Set<string> | undefined;
+  private readonly _watchEventBatcher: WatchEventBatcher;
   private _disposables: vscode.Disposable[] = [];
 
   dispose(): void {
+    this._watchEventBatcher.dispose();
     this._disposables.forEach(d => d.dispose());
     this._disposables = [];
     for (const exec of this._executables.values()) {
@@ -255,7 +268,7 @@ export class ConfigOfExecGroup implements vscode.Disposable {
           getModiTime(fsPath).then(modiTime => {
             if (modiTime === undefined) {
               for (const exec of this._executables.values()) {
-                if (exec) exec.dispose();
+                if (exec) exec.disposeRemoved();
               }
               this._executables.clear();
               this._shared.log.infoS('Symlink was removed', pattern);
@@ -511,6 +524,9 @@ export class ConfigOfExecGroup implements vscode.Disposable {
       this._markAsSkipped === true,
       this._executableRunAsImplicitAll === true,
       this._executableCloning === true,
+      this._dynamicTestDispatch === true,
+      this._persistentWorker === true,
+      this._testEvents,
       this._debugConfigData,
       this._executableSuffixToInclude,
       this._executableSuffixToExclude,
@@ -525,7 +541,7 @@ export class ConfigOfExecGroup implements vscode.Disposable {
 
   private readonly _lastEventArrivedAt: Map<string /*fsPath*/, number /*Date*/> = new Map();
 
-  private async _handleEverything(filePath: string): Promise<void> {
+  private _handleEverything(filePath: string): void {
     if (this._shared.cancellationToken.isCancellationRequested) return;
 
     const isHandlerRunningForFile = this._lastEventArrivedAt.get(filePath) !== undefined;
@@ -534,26 +550,46 @@ export class ConfigOfExecGroup implements vscode.Disposable {
 
     if (isHandlerRunningForFile) return;
 
-    await promisify(setTimeout)(1000); // just not to be hasty. no other reason for this
+    this._watchEventBatcher.add(filePath);
+  }
+
+  /**
+   * @returns 0: executables with failed tests or tests in the visible editors, 1: other known executables, 2: new files
+   */
+  private _rank(filePath: string): number {
+    const executable = this._executables.get(filePath);
+    if (executable === undefined) return 2;
+    const visibleFiles = new Set(vscode.window.visibleTextEditors.map(e => e.document.uri.fsPath));
+    for (const test of executable.getTests()) {
+      if (test.lastRunFailed || (test.item.uri !== undefined && visibleFiles.has(test.item.uri.fsPath))) return 0;
+    }
+    return 1;
+  }
+
+  private async _handleChangedPath(filePath: string): Promise<void> {
+    if (this._shared.cancellationToken.isCancellationRequested) return;
 
     const runnable = this._executables.get(filePath);
 
-    try {
-      if (runnable !== undefined) {
-        await this._recursiveHandleRunnable(runnable).catch(reject => {
-          this._shared.log.errorS(`_recursiveHandleRunnable errors should be handled inside`, reject);
-        });
-      } else {
-        if (this._shouldIgnorePath(filePath)) return;
+    if (runnable !== undefined) {
+      // the build has finished: no need to wait before the first check
+      const isExec = await c2fs
+        .checkIsNativeExecutable(filePath, this._executableSuffixToInclude, this._executableSuffixToExclude)
+        .then(
+          () => true,
+          () => false,
+        );
+      await this._recursiveHandleRunnable(runnable, isExec).catch(reject => {
+        this._shared.log.errorS(`_recursiveHandleRunnable errors should be handled inside`, reject);
+      });
+    } else {
+      if (this._shouldIgnorePath(filePath)) return;
 
-        this._shared.log.info('possibly new suite: ' + filePath);
+      this._shared.log.info('possibly new suite: ' + filePath);
 
-        await this._recursiveHandleFile(filePath).catch(reject => {
-          this._shared.log.errorS(`_recursiveHandleFile errors should be handled inside`, reject);
-        });
-      }
-    } finally {
-      this._lastEventArrivedAt.delete(filePath);
+      await this._recursiveHandleFile(filePath).catch(reject => {
+        this._shared.log.errorS(`_recursiveHandleFile errors should be handled inside`, reject);
+      });
     }
   }
 
@@ -646,7 +682,7 @@ export class ConfigOfExecGroup implements vscode.Disposable {
       this._shared.log.info('refresh timed out:', filePath);
       const foundRunnable = this._executables.get(filePath);
       if (foundRunnable) {
-        foundRunnable.dispose();
+        foundRunnable.disposeRemoved();
         this._executables.delete(filePath);
       }
     } else {
@@ -672,7 +708,7 @@ export class ConfigOfExecGroup implements vscode.Disposable {
       // cmake fetches the dependencies here. we dont care about it 🤞
       this._shared.log.info('skipping because it is under "/CMakeFiles/"', filePath);
       return true;
-    } else if (filePath.endsWith(ExecCloner.suffix)) {
+    } else if (ExecClonePool.isClonePath(filePath)) {
       this._shared.log.info('skipping because it is part of the cloning feature of this extension', filePath);
       return true;
     } else {
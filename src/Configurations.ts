@@ -40,6 +40,8 @@ export type Config =
   | 'discovery.gracePeriodForMissing'
   | 'discovery.runtimeLimit'
   | 'discovery.testListCaching'
+  | 'discovery.binaryScan'
+  | 'discovery.outputLimit'
   | 'discovery.strictPattern'
   | 'debug.configTemplate'
   | 'debug.breakOnFailure'
@@ -384,6 +386,15 @@ export class Configurations {
     return this._getD<boolean>('discovery.testListCaching', false);
   }
 
+  getEnableBinaryScan(): boolean {
+    return this._getD<boolean>('discovery.binaryScan', false);
+  }
+
+  getDiscoveryOutputLimit(): number {
+    const r = this._getD<number>('discovery.outputLimit', 64);
+    return Math.max(1, r) * 1024 * 1024;
+  }
+
   getEnableStrictPattern(): boolean {
     return this._getD<boolean>('discovery.strictPattern', false);
   }
@@ -425,6 +436,9 @@ export class Configurations {
         undefined,
         undefined,
         undefined,
+        undefined,
+        undefined,
+        undefined,
         false,
         undefined,
         undefined,
@@ -545,6 +559,12 @@ export class Configurations {
 
         const executableCloning: boolean | undefined = obj.executableCloning;
 
+        const dynamicTestDispatch: boolean | undefined = obj.dynamicTestDispatch;
+
+        const persistentWorker: boolean | undefined = obj.persistentWorker;
+
+        const testEvents: boolean | undefined = obj.testEvents;
+
         const executableSuffixToInclude: string[] | undefined = obj.executableSuffixToInclude;
 
         const waitForBuildProcess: boolean | string = obj.waitForBuildProcess ?? false;
@@ -582,6 +602,9 @@ export class Configurations {
           markAsSkipped,
           executableRunAsImplicitAll,
           executableCloning,
+          dynamicTestDispatch,
+          persistentWorker,
+          testEvents,
           executableSuffixToInclude,
           waitForBuildProcess,
           debugConfigData,
@@ -639,6 +662,8 @@ export class Configurations {
         r['debug.enableOutputColouring'] = obj['debug.enableOutputColouring'];
 
       if (typeof obj.failIfExceedsLimitNs === 'number') r.failIfExceedsLimitNs = obj.failIfExceedsLimitNs;
+
+      if (typeof obj.failIfRegressesPercent === 'number') r.failIfRegressesPercent = obj.failIfRegressesPercent;
     }
     return r;
   }
@@ -9,10 +9,12 @@ export class Logger {
   }
 
   private _logger: util.Log;
+  // it is called for every parsed event: looking up process.env every time is not cheap
+  private static readonly _isTraceEnabled = !!process.env['TESTMATE_DEBUG'];
 
   //eslint-disable-next-line
   trace(msg: any, ...msgs: any[]): void {
-    if (process.env['TESTMATE_DEBUG']) this._logger.debug(msg, ...msgs);
+    if (Logger._isTraceEnabled) this._logger.debug(msg, ...msgs);
   }
 
   //eslint-disable-next-line
@@ -0,0 +1,495 @@
+import * as os from 'os';
+import { EventEmitter } from 'events';
+import { PassThrough } from 'stream';
+
+import * as fsw from './util/FSWrapper';
+import { Spawner, SpawnOptionsWithoutStdio, SpawnReturns } from './Spawner';
+import { OutputCaptureOptions } from './util/OutputCapture';
+import { Logger } from './Logger';
+import { Disposable, getModiTime, hashString } from './Util';
+
+///
+
+// Protocol of documents/examples/persistent_worker/persistent_worker.hpp
+//
+// The executable is started with `TESTMATE_PERSISTENT_WORKER=3` and `--help`: an executable which doesn't
+// support the protocol prints its help and exits instead of running all of its tests.
+// - worker -> adapter: `@@TestMate.persistentWorker.ready@@ 3` or `@@TestMate.persistentWorker.unsupported@@`
+// - adapter -> worker: the number of arguments in a line, then every argument in a separate line
+// - worker forks, child -> adapter: `@@TestMate.persistentWorker.started@@ <pid>`, then the normal output.
+//   The stdin of the child is `/dev/null`: a test reading its stdin must not consume the next requests.
+//   (Version 2 workers don't do it: they are treated as unsupported.)
+// - worker -> adapter after the child has exited: `\n@@TestMate.persistentWorker.exited@@ <exitCode> <signal>`
+//   both to stdout and stderr, so the late stderr of the child (ex.: sanitizer reports) belongs to the run too.
+// Stderr outside of the runs (ex.: static initialization) is attached to the next run.
+
+const envKey = 'TESTMATE_PERSISTENT_WORKER';
+const protocolVersion = '3';
+const probeArgs = ['--help'];
+const readyMarker = '@@TestMate.persistentWorker.ready@@ ' + protocolVersion;
+const unsupportedMarker = '@@TestMate.persistentWorker.unsupported@@';
+const startedMarker = '@@TestMate.persistentWorker.started@@ ';
+const exitedMarker = '\n@@TestMate.persistentWorker.exited@@ ';
+const _maxMarkerLength = Math.max(readyMarker.length, unsupportedMarker.length) + 2;
+const _maxStderrBacklogLength = 64 * 1024;
+
+const _startupTimeoutMillis = 30000;
+const _idleTimeoutMillis = 5 * 60 * 1000;
+
+const signalName = (signal: number): NodeJS.Signals | null => {
+  for (const [name, num] of Object.entries(os.constants.signals)) {
+    if (num === signal) return name as NodeJS.Signals;
+  }
+  return null;
+};
+
+// the length of the end of the text which can be the beginning of the marker
+const partialMarkerLength = (text: string, marker: string): number => {
+  for (let k = Math.min(text.length, marker.length - 1); k > 0; --k) {
+    if (marker.startsWith(text.substring(text.length - k))) return k;
+  }
+  return 0;
+};
+
+const parseExited = (line: string): { code: number | null; signal: NodeJS.Signals | null } => {
+  const [codeStr, signalStr] = line.split(' ');
+  const signal = parseInt(signalStr);
+  const code = parseInt(codeStr);
+  if (signal > 0) return { code: null, signal: signalName(signal) };
+  return { code: Number.isNaN(code) ? null : code, signal: null };
+};
+
+///
+
+/**
+ * Mimics the necessary part of a `ChildProcess` for `RunningExecutable`.
+ * Represents one forked child of the worker.
+ */
+class PersistentWorkerRun extends EventEmitter {
+  constructor(
+    readonly spawnfile: string,
+    readonly spawnargs: string[],
+  ) {
+    super();
+  }
+
+  readonly stdout = new PassThrough();
+  readonly stderr = new PassThrough();
+  pid: number | undefined = undefined;
+  exitCode: number | null = null;
+  signalCode: NodeJS.Signals | null = null;
+  killed = false;
+
+  kill(signal: NodeJS.Signals | number = 'SIGTERM'): boolean {
+    if (this.pid === undefined || this.exitCode !== null || this.signalCode !== null) return false;
+    try {
+      process.kill(this.pid, signal);
+      this.killed = true;
+      return true;
+    } catch {
+      return false;
+    }
+  }
+
+  finish(code: number | null, signal: NodeJS.Signals | null): void {
+    this.exitCode = code;
+    this.signalCode = signal;
+    this.stdout.end();
+    this.stderr.end();
+    this.emit('exit', code, signal);
+    // ChildProcess emits 'close' after the stdio streams are closed
+    Promise.all([
+      new Promise(r => (this.stdout.closed ? r(undefined) : this.stdout.once('close', r))),
+      new Promise(r => (this.stderr.closed ? r(undefined) : this.stderr.once('close', r))),
+    ]).then(() => this.emit('close', code, signal));
+  }
+}
+
+///
+
+class PersistentWorker {
+  constructor(
+    private readonly _log: Logger,
+    readonly cmd: string,
+    readonly modiTime: number | undefined,
+    private readonly _proc: fsw.ChildProcessWithoutNullStreams,
+  ) {
+    this.ready = new Promise<void>((resolve, reject) => {
+      this._startup = { resolve, reject };
+    });
+    this.ready.catch(() => {}); // handled by the caller
+
+    const timeout = setTimeout(() => this._failStartup('startup timeout'), _startupTimeoutMillis);
+    this.ready.finally(() => clearTimeout(timeout)).catch(() => {});
+
+    // the multi-byte characters can be split between chunks
+    _proc.stdout.setEncoding('utf8');
+    _proc.stderr.setEncoding('utf8');
+    _proc.stdout.on('data', (chunk: string) => this._onStdout(chunk));
+    _proc.stderr.on('data', (chunk: string) => this._onStderr(chunk));
+    _proc.stdin.on('error', (err: Error) => this._log.warn('persistent worker stdin error', cmd, err));
+    _proc.on('error', (err: Error) => {
+      this._log.warn('persistent worker error', cmd, err);
+      this._failStartup(err.message);
+    });
+    _proc.once('close', (code: number | null, signal: NodeJS.Signals | null) => {
+      this._log.info('persistent worker closed', cmd, code, signal);
+      this._dead = true;
+      this._failStartup(`closed: ${code} ${signal}`);
+      const current = this._current;
+      if (current) {
+        this._current = undefined;
+        current.startedReject?.(Error('persistent worker has closed'));
+        if (current.started) {
+          current.run.stdout.write(current.pending);
+          current.run.stderr.write(this._stderrPending);
+        }
+        current.run.finish(current.exited?.code ?? code, current.exited?.signal ?? signal);
+      }
+    });
+  }
+
+  readonly ready: Promise<void>;
+  private _startup: { resolve: () => void; reject: (e: Error) => void } | undefined;
+  private _startupBuffer = '';
+  private _stderrPending = '';
+  // stderr which doesn't belong to a started run: it is written to the next one
+  private _stderrBacklog = '';
+  private _dead = false;
+  private _reserved = false;
+  private _idleTimer: NodeJS.Timeout | undefined = undefined;
+  private _current:
+    | {
+        run: PersistentWorkerRun;
+        started: boolean;
+        pending: string;
+        startedResolve?: () => void;
+        startedReject?: (e: Error) => void;
+        // the run is finished when the exited marker has arrived on both streams
+        exited?: { code: number | null; signal: NodeJS.Signals | null };
+        stderrExited: boolean;
+      }
+    | undefined = undefined;
+
+  get isAlive(): boolean {
+    return !this._dead;
+  }
+
+  get isIdle(): boolean {
+    return !this._dead && !this._reserved && this._startup === undefined && this._current === undefined;
+  }
+
+  reserve(): void {
+    this._reserved = true;
+  }
+
+  dispose(): void {
+    if (this._idleTimer) clearTimeout(this._idleTimer);
+    this._dead = true;
+    try {
+      this._proc.stdin.end();
+      this._proc.kill();
+    } catch {} // eslint-disable-line
+  }
+
+  setIdleTimeout(onIdle: () => void): void {
+    if (this._idleTimer) clearTimeout(this._idleTimer);
+    this._idleTimer = setTimeout(onIdle, _idleTimeoutMillis);
+  }
+
+  async run(args: string[]): Promise<PersistentWorkerRun> {
+    if (this._dead || this._current !== undefined) throw Error('assert: persistent worker is not idle');
+    this._reserved = false;
+    if (args.some(a => a.indexOf('\n') !== -1)) throw Error('argument with new line is not supported');
+
+    if (this._idleTimer) {
+      clearTimeout(this._idleTimer);
+      this._idleTimer = undefined;
+    }
+
+    const run = new PersistentWorkerRun(this.cmd, [this.cmd, ...args]);
+    const started = new Promise<void>((resolve, reject) => {
+      this._current = {
+        run,
+        started: false,
+        pending: '',
+        startedResolve: resolve,
+        startedReject: reject,
+        stderrExited: false,
+      };
+    });
+
+    this._proc.stdin.write([args.length.toString(), ...args].map(a => a + '\n').join(''));
+
+    await started;
+    return run;
+  }
+
+  private _failStartup(reason: string): void {
+    if (this._startup) {
+      this._startup.reject(Error('persistent worker startup failed: ' + reason));
+      this._startup = undefined;
+    }
+  }
+
+  private _onStdout(chunk: string): void {
+    if (this._startup) {
+      this._startupBuffer += chunk;
+      const newLine = this._startupBuffer.indexOf('\n');
+      if (newLine === -1) {
+        if (this._startupBuffer.length > _maxMarkerLength) this._failStartup('unexpected output');
+        return;
+      }
+      const line = this._startupBuffer.substring(0, newLine).trim();
+      this._startupBuffer = '';
+      if (line === readyMarker) {
+        this._startup.resolve();
+        this._startup = undefined;
+      } else if (line === unsupportedMarker) {
+        this._failStartup('unsupported platform');
+      } else {
+        this._failStartup('unexpected output: ' + line);
+      }
+    } else if (this._current && this._current.exited === undefined) {
+      this._onRequestStdout(chunk);
+    } else {
+      this._log.warn('persistent worker: unexpected output', this.cmd, chunk);
+    }
+  }
+
+  private _onRequestStdout(chunk: string): void {
+    const current = this._current!;
+    current.pending += chunk;
+
+    if (!current.started) {
+      if (current.pending.startsWith('\n') && exitedMarker.startsWith(current.pending)) return; // wait for more
+      if (!current.pending.startsWith(exitedMarker)) {
+        const newLine = current.pending.indexOf('\n');
+        if (newLine === -1) return;
+        const line = current.pending.substring(0, newLine);
+        if (line.startsWith(startedMarker)) {
+          current.run.pid = parseInt(line.substring(startedMarker.length));
+          current.pending = current.pending.substring(newLine + 1);
+        } else {
+          this._log.warn('persistent worker: missing started marker', this.cmd, line);
+        }
+        current.started = true;
+        current.startedResolve!();
+        if (this._stderrBacklog) {
+          current.run.stderr.write(this._stderrBacklog);
+          this._stderrBacklog = '';
+        }
+      }
+    }
+
+    const exitedAt = current.pending.indexOf(exitedMarker);
+    if (exitedAt === -1) {
+      const safeLength = current.pending.length - partialMarkerLength(current.pending, exitedMarker);
+      if (safeLength > 0 && current.started) {
+        current.run.stdout.write(current.pending.substring(0, safeLength));
+        current.pending = current.pending.substring(safeLength);
+      }
+      return;
+    }
+
+    const lineEnd = current.pending.indexOf('\n', exitedAt + exitedMarker.length);
+    if (lineEnd === -1) return; // wait for the rest of the line
+
+    const exited = parseExited(current.pending.substring(exitedAt + exitedMarker.length, lineEnd));
+
+    if (!current.started) {
+      this._current = undefined;
+      current.startedReject!(Error('persistent worker could not start the run'));
+      return;
+    }
+
+    if (exitedAt > 0) current.run.stdout.write(current.pending.substring(0, exitedAt));
+    current.pending = '';
+    current.exited = exited;
+    this._finishIfExited();
+  }
+
+  private _onStderr(chunk: string): void {
+    this._stderrPending += chunk;
+
+    for (;;) {
+      const exitedAt = this._stderrPending.indexOf(exitedMarker);
+      if (exitedAt === -1) {
+        const safeLength = this._stderrPending.length - partialMarkerLength(this._stderrPending, exitedMarker);
+        this._writeStderr(this._stderrPending.substring(0, safeLength));
+        this._stderrPending = this._stderrPending.substring(safeLength);
+        return;
+      }
+
+      this._writeStderr(this._stderrPending.substring(0, exitedAt));
+      this._stderrPending = this._stderrPending.substring(exitedAt);
+      const lineEnd = this._stderrPending.indexOf('\n', exitedMarker.length);
+      if (lineEnd === -1) return; // wait for the rest of the line
+      this._stderrPending = this._stderrPending.substring(lineEnd + 1);
+
+      // the streams are not synchronised: it can arrive even before the started marker on stdout
+      if (this._current) {
+        this._current.stderrExited = true;
+        this._finishIfExited();
+      }
+    }
+  }
+
+  private _writeStderr(text: string): void {
+    if (text.length === 0) return;
+    if (this._current?.started && !this._current.stderrExited) {
+      this._current.run.stderr.write(text);
+    } else {
+      this._log.debug('persistent worker stderr outside of a run', this.cmd, text);
+      this._stderrBacklog += text;
+      if (this._stderrBacklog.length > _maxStderrBacklogLength)
+        this._stderrBacklog = this._stderrBacklog.substring(this._stderrBacklog.length - _maxStderrBacklogLength);
+    }
+  }
+
+  private _finishIfExited(): void {
+    const current = this._current;
+    if (current?.exited === undefined || !current.stderrExited) return;
+    this._current = undefined;
+    current.run.finish(current.exited.code, current.exited.signal);
+  }
+}
+
+///
+
+/**
+ * Keeps test executables alive between runs. Opt-in by `advancedExecutables[].persistentWorker`.
+ * If the executable doesn't speak the protocol it falls back to a normal spawn.
+ */
+export class PersistentWorkerPool implements Disposable {
+  constructor(private readonly _log: Logger) {}
+
+  private readonly _workers = new Map<string /*key*/, PersistentWorker[]>();
+  private readonly _unsupported = new Map<string /*key*/, number | undefined /*modiTime*/>();
+
+  dispose(): void {
+    for (const workers of this._workers.values()) workers.forEach(w => w.dispose());
+    this._workers.clear();
+  }
+
+  createSpawner(base: Spawner): Spawner {
+    return new PersistentWorkerSpawner(this, base);
+  }
+
+  async spawn(
+    base: Spawner,
+    cmd: string,
+    args: string[],
+    options: SpawnOptionsWithoutStdio,
+  ): Promise<fsw.ChildProcessWithoutNullStreams> {
+    const key = hashString(JSON.stringify([base.toString(), cmd, options.cwd, options.env]));
+    const modiTime = await getModiTime(cmd);
+
+    if (this._unsupported.has(key) && this._unsupported.get(key) === modiTime) {
+      return base.spawn(cmd, args, options);
+    }
+
+    let worker: PersistentWorker;
+    try {
+      worker = await this._acquire(key, base, cmd, options, modiTime);
+    } catch (e) {
+      this._log.info('persistent worker is not available, falling back to normal spawn', cmd, e);
+      this._unsupported.set(key, modiTime);
+      return base.spawn(cmd, args, options);
+    }
+
+    try {
+      const run = await worker.run(args);
+      run.once('close', () => this._release(key, worker));
+      return run as unknown as fsw.ChildProcessWithoutNullStreams;
+    } catch (e) {
+      this._log.warn('persistent worker run failed, falling back to normal spawn', cmd, e);
+      this._remove(key, worker);
+      return base.spawn(cmd, args, options);
+    }
+  }
+
+  private async _acquire(
+    key: string,
+    base: Spawner,
+    cmd: string,
+    options: SpawnOptionsWithoutStdio,
+    modiTime: number | undefined,
+  ): Promise<PersistentWorker> {
+    let workers = this._workers.get(key);
+    if (workers === undefined) {
+      workers = [];
+      this._workers.set(key, workers);
+    }
+
+    for (const w of [...workers]) {
+      if (!w.isAlive || w.modiTime !== modiTime) {
+        // the executable has changed since the worker was started
+        this._remove(key, w);
+      } else if (w.isIdle) {
+        w.reserve();
+        return w;
+      }
+    }
+
+    const proc = await base.spawn(cmd, probeArgs, { ...options, env: { ...options.env, [envKey]: protocolVersion } });
+    const worker = new PersistentWorker(this._log, cmd, modiTime, proc);
+    worker.reserve();
+    workers.push(worker);
+
+    try {
+      await worker.ready;
+    } catch (e) {
+      this._remove(key, worker);
+      throw e;
+    }
+
+    this._log.info('persistent worker started', cmd, proc.pid);
+    return worker;
+  }
+
+  private _release(key: string, worker: PersistentWorker): void {
+    if (!worker.isAlive) {
+      this._remove(key, worker);
+    } else {
+      worker.setIdleTimeout(() => this._remove(key, worker));
+    }
+  }
+
+  private _remove(key: string, worker: PersistentWorker): void {
+    worker.dispose();
+    const workers = this._workers.get(key);
+    if (workers) {
+      const index = workers.indexOf(worker);
+      if (index !== -1) workers.splice(index, 1);
+      if (workers.length === 0) this._workers.delete(key);
+    }
+  }
+}
+
+///
+
+class PersistentWorkerSpawner implements Spawner {
+  constructor(
+    private readonly _pool: PersistentWorkerPool,
+    private readonly _base: Spawner,
+  ) {}
+
+  spawnAsync(
+    cmd: string,
+    args: string[],
+    options: SpawnOptionsWithoutStdio,
+    timeout?: number,
+    capture?: OutputCaptureOptions,
+  ): Promise<SpawnReturns> {
+    return this._base.spawnAsync(cmd, args, options, timeout, capture);
+  }
+
+  spawn(cmd: string, args: string[], options: SpawnOptionsWithoutStdio): Promise<fsw.ChildProcessWithoutNullStreams> {
+    return this._pool.spawn(this._base, cmd, args, options);
+  }
+
+  toString(): string {
+    return `PersistentWorkerSpawner(${this._base})`;
+  }
+}
@@ -1,10 +1,14 @@
 import * as fsw from './util/FSWrapper';
+import { OutputCapture, OutputCaptureOptions } from './util/OutputCapture';
 import { resolveVariablesAsync } from './util/ResolveRule';
 
 ///
 
 export interface SpawnReturns extends fsw.SpawnSyncReturns<string> {
   closed: boolean;
+  // set if `spawnAsync` was called with `capture`: `stdout` and `stderr` contain only the head of the output.
+  // The caller has to dispose it in case of `capture.spill`.
+  stdoutCapture?: OutputCapture;
 }
 
 export type SpawnOptionsWithoutStdio = fsw.SpawnOptionsWithoutStdio;
@@ -18,7 +22,16 @@ export interface SpawnOptionsWithoutStdioEx extends fsw.SpawnOptionsWithoutStdio
 
 //TODO:future, add cancellation flag
 export interface Spawner {
-  spawnAsync(cmd: string, args: string[], options: SpawnOptionsWithoutStdio, timeout?: number): Promise<SpawnReturns>;
+  /**
+   * @param capture bounds the memory used by the output (stderr is never spilled)
+   */
+  spawnAsync(
+    cmd: string,
+    args: string[],
+    options: SpawnOptionsWithoutStdio,
+    timeout?: number,
+    capture?: OutputCaptureOptions,
+  ): Promise<SpawnReturns>;
 
   spawn(cmd: string, args: string[], options: SpawnOptionsWithoutStdio): Promise<fsw.ChildProcessWithoutNullStreams>;
 }
@@ -46,7 +59,15 @@ export class SpawnBuilder {
 ///
 
 export class DefaultSpawner implements Spawner {
-  spawnAsync(cmd: string, args: string[], options: SpawnOptionsWithoutStdio, timeout?: number): Promise<SpawnReturns> {
+  spawnAsync(
+    cmd: string,
+    args: string[],
+    options: SpawnOptionsWithoutStdio,
+    timeout?: number,
+    capture?: OutputCaptureOptions,
+  ): Promise<SpawnReturns> {
+    if (capture) return this._spawnAsyncWithCapture(cmd, args, options, timeout, capture);
+
     return new Promise((resolve, reject) => {
       const ret: SpawnReturns = {
         pid: 0,
@@ -96,6 +117,73 @@ export class DefaultSpawner implements Spawner {
     });
   }
 
+  private _spawnAsyncWithCapture(
+    cmd: string,
+    args: string[],
+    options: SpawnOptionsWithoutStdio,
+    timeout: number | undefined,
+    capture: OutputCaptureOptions,
+  ): Promise<SpawnReturns> {
+    return new Promise((resolve, reject) => {
+      const stdout = new OutputCapture(capture);
+      const stderr = new OutputCapture({ limit: capture.limit });
+      const ret: SpawnReturns = {
+        pid: 0,
+        output: [null as unknown as string, '', ''],
+        stdout: '',
+        stderr: '',
+        status: 0,
+        signal: null,
+        error: undefined,
+        closed: false,
+        stdoutCapture: stdout,
+      };
+
+      const optionsEx = Object.assign<SpawnOptionsWithoutStdio, SpawnOptionsWithoutStdio>({ timeout }, options || {});
+
+      const command = fsw.spawn(cmd, args || [], optionsEx);
+
+      Object.assign(ret, { process: command }); // for debugging
+
+      ret.pid = command.pid || -42;
+
+      command.stdout.on('data', function (data: Buffer) {
+        if (!stdout.write(data)) {
+          command.stdout.pause();
+          stdout.drain().then(() => command.stdout.resume());
+        }
+      });
+
+      command.stderr.on('data', function (data: Buffer) {
+        stderr.write(data);
+      });
+
+      command.on('error', function (err: Error) {
+        ret.error = err;
+        stdout.dispose();
+        reject(err);
+      });
+
+      command.on('close', async function (code: number, signal: NodeJS.Signals) {
+        ret.closed = true;
+        await stdout.finish();
+
+        ret.stdout = stdout.head();
+        ret.stderr = stderr.head();
+        ret.output = [null as unknown as string, ret.stdout, ret.stderr];
+
+        if (signal !== null) {
+          ret.signal = signal;
+          stdout.dispose();
+          reject(new Error('FsWrapper.spawnAsync signal: ' + signal));
+        } else {
+          ret.status = code;
+          resolve(ret);
+        }
+      });
+    });
+  }
+
   spawn(cmd: string, args: string[], options: SpawnOptionsWithoutStdio): Promise<fsw.ChildProcessWithoutNullStreams> {
     return Promise.resolve(fsw.spawn(cmd, args, options));
   }
@@ -138,9 +226,10 @@ export class SpawnWithExecutor extends DefaultSpawner {
     args: string[],
     options: SpawnOptionsWithoutStdio,
     timeout?: number,
+    capture?: OutputCaptureOptions,
   ): Promise<SpawnReturns> {
     const argsV = await this.getArgs(cmd, args);
-    return super.spawnAsync(this._executor, argsV, options, timeout);
+    return super.spawnAsync(this._executor, argsV, options, timeout, capture);
   }
 
   override async spawn(
@@ -96,6 +96,24 @@ export class TestItemManager {
     return curr;
   }
 
+  /**
+   * The id of a {@linkcode vscode.TestItem} is unique only between its siblings: this one identifies it in the tree.
+   */
+  static getUniqueId(item: Readonly<vscode.TestItem>): string {
+    const path = [item.id];
+    for (let p = item.parent; p; p = p.parent) path.unshift(p.id);
+    return JSON.stringify(path);
+  }
+
+  findByUniqueId(uniqueId: string): vscode.TestItem | undefined {
+    try {
+      const path = JSON.parse(uniqueId);
+      return Array.isArray(path) ? this.findPath(path) : undefined;
+    } catch {
+      return undefined;
+    }
+  }
+
   async update(
     item: vscode.TestItem,
     file: string | undefined,
@@ -46,6 +46,11 @@ export interface TestMateProcessBuilder {
   cmd: string;
   args: string[];
   env: Record<string, string | undefined>;
+  /**
+   * The ids of the tests the process is going to run: JSON arrays of the {@linkcode vscode.TestItem} ids from the root.
+   * Set only if {@linkcode TestMateTestRunHandler.isolateTests} is set and the process runs with a test filter.
+   */
+  testIds?: readonly string[];
 }
 
 export interface TestMateTestRunHandler {
@@ -60,6 +65,13 @@ export interface TestMateTestRunHandler {
    */
   readonly allowExecutableConcurrentInvocations?: boolean;
 
+  /**
+   * If `true` every test is run by a separate process so the coverage of a process belongs to a single test.
+   * See {@linkcode TestMateProcessBuilder.testIds} and {@linkcode TestMateAPI.testCoverageIndex}.
+   * It is slower: the process startup cost is paid per test.
+   */
+  readonly isolateTests?: boolean;
+
   /**
    * During this callback, one can do the global init part.
    * Use `testRun.token` !!!
@@ -185,6 +197,70 @@ export interface TestMateTestRunProfile {
   dispose(): void;
 }
 
+export interface TestMateTestCoverageRecord {
+  /**
+   * The ids of the tests which were run by the process. See {@linkcode TestMateProcessBuilder.testIds}.
+   */
+  testIds: readonly string[];
+
+  /**
+   * The covered lines (0-based) by file system path.
+   */
+  coveredLines: ReadonlyMap<string, readonly number[]>;
+}
+
+/**
+ * Stores which tests cover which lines. It is persisted in the workspace storage.
+ */
+export interface TestMateTestCoverageIndex {
+  /**
+   * The previous coverage of the tests of the records is replaced.
+   */
+  update(records: readonly TestMateTestCoverageRecord[]): Promise<void>;
+
+  /**
+   * @param lines 0-based line numbers
+   * @returns the ids of the tests which cover any of the lines
+   */
+  getTestsCoveringLines(file: vscode.Uri, lines: readonly number[]): Promise<string[]>;
+}
+
+export interface TestMateTimingHistogram {
+  count: number;
+  sumMillis: number;
+  minMillis: number;
+  maxMillis: number;
+  /**
+   * Processed characters of the output (only for `parse`).
+   */
+  chars: number;
+  /**
+   * `buckets[i]` is the number of durations <= `bucketBoundsMillis[i]`, the last one is the rest.
+   */
+  buckets: number[];
+}
+
+export type TestMateTimingPhase = 'discovery' | 'listing' | 'spawn' | 'parse' | 'resultBuild' | 'coverageFinalise';
+
+export interface TestMateExecutableCloning {
+  /**
+   * Size of the executables which didn't have to be copied: linked, reflinked or shared clones.
+   */
+  bytesSaved: number;
+  bytesCopied: number;
+  /**
+   * Number of the created clones by method.
+   */
+  clones: { reflink: number; hardlink: number; copy: number; existing: number };
+}
+
+export interface TestMateTimings {
+  bucketBoundsMillis: number[];
+  phases: Partial<Record<TestMateTimingPhase, TestMateTimingHistogram>>;
+  executables: Record<string, Partial<Record<TestMateTimingPhase, TestMateTimingHistogram>>>;
+  executableCloning?: TestMateExecutableCloning;
+}
+
 export interface TestMateAPI {
   /**
    * Call this to register your (Coverage) Profile Adapter.
@@ -193,4 +269,15 @@ export interface TestMateAPI {
    * Profile will depend on the adapter so first the profile should be disposed then the adapter.
    */
   createTestRunProfile(adapter: TestMateTestRunProfileAdapter): TestMateTestRunProfile;
+
+  /**
+   * Per-test coverage: a coverage adapter can record which test covers which line if it runs with `isolateTests`.
+   */
+  readonly testCoverageIndex: TestMateTestCoverageIndex;
+
+  /**
+   * Latency histograms of the phases (discovery, listing, spawn, parse, result building, coverage finalisation)
+   * in total and by executable since the activation.
+   */
+  getTimings(): TestMateTimings;
 }
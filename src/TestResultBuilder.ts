@@ -253,8 +253,18 @@ export class TestResultBuilder<T extends AbstractTest = AbstractTest> {
       throw Error('TestEventBuilder state was not set for test: ' + this.test.id);
     }
 
+    const stopTiming = this.test.exec.shared.shared.phaseTimings.start('resultBuild', this.test.exec.shared.path);
+
     this.endMessage();
 
+    if (this.level === 0 && this._duration !== undefined && (this._result === 'passed' || this._result === 'failed')) {
+      this.test.exec.recordTestDuration(this.test, this._duration);
+    }
+
+    if (this.level === 0 && this._result !== 'skipped') {
+      this.test.lastRunFailed = this._result !== 'passed';
+    }
+
     const messages = this._messages;
     // const messages = [];
     // if (this.level === 0) {
@@ -279,6 +289,7 @@ export class TestResultBuilder<T extends AbstractTest = AbstractTest> {
         break;
     }
 
+    stopTiming();
     this._built = true;
   }
 
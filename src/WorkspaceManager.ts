@@ -17,6 +17,11 @@ import { AbstractTest } from './framework/AbstractTest';
 import { TestItemManager } from './TestItemManager';
 import { ProgressReporter } from './util/ProgressReporter';
 import { TestRunData } from './TestRunData';
+import { TestListCache } from './util/TestListCache';
+import { ExecClonePool } from './util/ExecClonePool';
+import { PhaseTimings } from './util/PhaseTimings';
+import { BenchmarkBaselineStore } from './util/BenchmarkBaselineStore';
+import { TestCoverageIndex } from './util/TestCoverageIndex';
 
 export class WorkspaceManager implements vscode.Disposable {
   constructor(
@@ -24,6 +29,12 @@ export class WorkspaceManager implements vscode.Disposable {
     private readonly log: Logger,
     testItemManager: TestItemManager,
     executableChanged: (e: Iterable<AbstractExecutable>) => void,
+    workspaceState: vscode.Memento | undefined,
+    testListCache: TestListCache,
+    execClonePool: ExecClonePool,
+    phaseTimings: PhaseTimings,
+    benchmarkBaselineStore: BenchmarkBaselineStore,
+    testCoverageIndex: TestCoverageIndex,
   ) {
     const workspaceNameRes: ResolveRuleAsync = { resolve: '${workspaceName}', rule: this.workspaceFolder.name };
 
@@ -166,12 +177,20 @@ export class WorkspaceManager implements vscode.Disposable {
       configuration.getDefaultNoThrow(),
       configuration.getParallelExecutionLimit(),
       configuration.getEnableTestListCaching(),
+      configuration.getEnableBinaryScan(),
+      configuration.getDiscoveryOutputLimit(),
       configuration.getEnableStrictPattern(),
       configuration.getGoogleTestTreatGMockWarningAs(),
       configuration.getGoogleTestGMockVerbose(),
       false,
       configuration.getTestNameLengthLimit(),
       configuration.getStderrDecorator(),
+      workspaceState,
+      testListCache,
+      execClonePool,
+      phaseTimings,
+      benchmarkBaselineStore,
+      testCoverageIndex,
     );
 
     this._disposables.push(
@@ -207,6 +226,12 @@ export class WorkspaceManager implements vscode.Disposable {
           if (changeEvent.affects('discovery.testListCaching')) {
             this._shared.enabledTestListCaching = config.getEnableTestListCaching();
           }
+          if (changeEvent.affects('discovery.binaryScan')) {
+            this._shared.enabledBinaryScan = config.getEnableBinaryScan();
+          }
+          if (changeEvent.affects('discovery.outputLimit')) {
+            this._shared.discoveryOutputLimit = config.getDiscoveryOutputLimit();
+          }
           if (changeEvent.affects('discovery.strictPattern')) {
             this._shared.enabledStrictPattern = config.getEnableStrictPattern();
           }
@@ -383,11 +408,14 @@ export class WorkspaceManager implements vscode.Disposable {
           _token: vscode.CancellationToken,
         ): Promise<void> => {
           if (!data.testRunHandler?.finalise) return;
+          const stopTiming = this._shared.phaseTimings.start('coverageFinalise', undefined);
           try {
             this.log.debug('testRunHandler.finalise');
             await data.testRunHandler?.finalise(progress);
           } catch (e) {
             this.log.error('profileRunHandler.finalise', e);
+          } finally {
+            stopTiming();
           }
         },
       );
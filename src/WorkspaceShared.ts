@@ -4,6 +4,13 @@ import { TaskPool } from './util/TaskPool';
 import { ResolveRuleAsync } from './util/ResolveRule';
 import { BuildProcessChecker, buildProcessCheckerFactory } from './util/BuildProcessChecker';
 import { CancellationToken } from './Util';
+import { TestDurationStore } from './util/TestDurationStore';
+import { TestListCache } from './util/TestListCache';
+import { ExecClonePool } from './util/ExecClonePool';
+import { PhaseTimings } from './util/PhaseTimings';
+import { BenchmarkBaselineStore } from './util/BenchmarkBaselineStore';
+import { TestCoverageIndex } from './util/TestCoverageIndex';
+import { PersistentWorkerPool } from './PersistentWorker';
 import { TestItemManager } from './TestItemManager';
 import { AbstractExecutable } from './framework/AbstractExecutable';
 
@@ -26,19 +33,31 @@ export class WorkspaceShared {
     public isNoThrow: boolean,
     workerMaxNumber: number,
     public enabledTestListCaching: boolean,
+    public enabledBinaryScan: boolean,
+    public discoveryOutputLimit: number,
     public enabledStrictPattern: boolean,
     public googleTestTreatGMockWarningAs: 'nothing' | 'failure',
     public googleTestGMockVerbose: 'default' | 'info' | 'warning' | 'error',
     public hideUninterestingOutput: boolean,
     public testNameLengthLimit: number,
     public stderrDecorator: boolean,
+    workspaceState: vscode.Memento | undefined,
+    readonly testListCache: TestListCache,
+    readonly execClonePool: ExecClonePool,
+    readonly phaseTimings: PhaseTimings,
+    readonly benchmarkBaselineStore: BenchmarkBaselineStore,
+    readonly testCoverageIndex: TestCoverageIndex,
   ) {
     this.taskPool = new TaskPool(workerMaxNumber);
     this.buildProcessChecker = buildProcessCheckerFactory.create(log);
+    this.testDurationStore = new TestDurationStore(workspaceState, log);
+    this.persistentWorkerPool = new PersistentWorkerPool(log);
   }
 
   readonly taskPool: TaskPool;
   readonly buildProcessChecker: BuildProcessChecker;
+  readonly testDurationStore: TestDurationStore;
+  readonly persistentWorkerPool: PersistentWorkerPool;
   private readonly _execRunningTimeoutChangeEmitter = new vscode.EventEmitter<void>();
   private readonly _cancellationTokenSource: vscode.CancellationTokenSource = new vscode.CancellationTokenSource();
   readonly cancellationToken: CancellationToken = this._cancellationTokenSource.token;
@@ -46,6 +65,8 @@ export class WorkspaceShared {
   dispose(): void {
     this._cancellationTokenSource.cancel();
     this.buildProcessChecker.dispose();
+    this.testDurationStore.dispose();
+    this.persistentWorkerPool.dispose();
     this._execRunningTimeoutChangeEmitter.dispose();
   }
 
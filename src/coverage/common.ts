@@ -6,17 +6,27 @@ import { SharedTestTags } from '../framework/SharedTestTags';
 
 export const testMateExtensionId = 'matepek.vscode-catch2-test-adapter';
 
+/**
+ * @param onStdout if it is set the stdout is passed to it instead of collecting it: the returned stdout is empty
+ */
 export const execute = async (
   cmd: string,
   args: string[],
   cwd: string | undefined,
   token: vscode.CancellationToken,
+  onStdout?: (data: string) => void,
 ): Promise<[string, string]> => {
   const proc = cp.spawn(cmd, args, { stdio: 'pipe', cwd });
   const stdout: string[] = [];
   const stderr: string[] = [];
 
-  proc.stdout.on('data', o => stdout.push(o.toString('utf8')));
+  if (onStdout) {
+    // the multi-byte characters can be split between chunks
+    proc.stdout.setEncoding('utf8');
+    proc.stdout.on('data', (o: string) => onStdout(o));
+  } else {
+    proc.stdout.on('data', o => stdout.push(o.toString('utf8')));
+  }
   proc.stderr.on('data', o => stderr.push(o.toString('utf8')));
 
   const closeP = new Promise<void>((res, rej) => {
@@ -41,11 +51,12 @@ export const executeWithPlatformToolchain = async (
   args: string[],
   cwd: string | undefined,
   token: vscode.CancellationToken,
+  onStdout?: (data: string) => void,
 ): Promise<[string, string]> => {
   if (process.platform === 'darwin') {
-    return await execute('xcrun', [cmd, ...args], cwd, token);
+    return await execute('xcrun', [cmd, ...args], cwd, token, onStdout);
   } else if (process.platform === 'linux' || process.platform === 'win32') {
-    return await execute(cmd, args, cwd, token);
+    return await execute(cmd, args, cwd, token, onStdout);
   } else {
     throw Error('assert platform toolchain');
   }
@@ -58,7 +69,7 @@ export const create_advanced_activate =
   <TestMateAdapterT extends TMA.TestMateTestRunProfileAdapter>(
     configSection: string,
     label: string,
-    factory: (log: Log) => TestMateAdapterT,
+    factory: (log: Log, testMate: TMA.TestMateAPI) => TestMateAdapterT,
   ) =>
   async (context: vscode.ExtensionContext) => {
     const log = new Log(configSection, undefined, label, { depth: 3 }, false);
@@ -84,7 +95,7 @@ export const create_advanced_activate =
       const create = async () => {
         if (!adapter) {
           const testMate = await testMateExtension.activate();
-          adapter = factory(log);
+          adapter = factory(log, testMate);
           profile = testMate.createTestRunProfile(adapter);
           log.info('created profile', adapter?.label, adapter?.kind, testMateExtensionId);
         }
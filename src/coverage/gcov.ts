@@ -7,6 +7,7 @@ import zlib from 'node:zlib';
 import { promisify } from 'node:util';
 import { Log } from 'vscode-test-adapter-util';
 import { create_advanced_activate, execute } from './common';
+import { TaskPool } from '../util/TaskPool';
 
 const gunzip = promisify(zlib.gunzip);
 
@@ -193,48 +194,41 @@ class GcovTestMateTestRunHandler implements TMA.TestMateTestRunHandler {
     }
   }
 
-  async finaliseInner(progress: vscode.Progress<{ message?: string; increment?: number }>): Promise<void> {
-    if (!this.data) throw new Error('assert:data');
-
-    const gcdaFiles = await this.getGcdaPath();
-
-    if (gcdaFiles.length === 0) {
-      this.log.warn('No .gcda files found. Ensure code is compiled with --coverage and executed successfully.');
-      return;
-    }
-
-    progress.report({ message: 'gcov' });
-    const fileCoverageMap = new Map<string, AggregatedFileCoverage>();
+  // @returns the directory of the output or undefined if it was cancelled
+  private async runGcov(gcdaPaths: string[], batchIndex: number): Promise<string | undefined> {
+    if (this.testRun.token.isCancellationRequested) return undefined;
 
-    // Sequential process execution prevents OS EMFILE limits
-    for (const file of gcdaFiles) {
-      if (this.testRun.token.isCancellationRequested) return;
+    // separate directory so the output of the batch can be parsed when its gcov has finished
+    const outDir = pathlib.join(this.data!.tmpDir.path, `batch${batchIndex}`);
+    await fs.mkdir(outDir);
 
-      try {
-        await execute(
-          'gcov',
-          [
-            '--preserve-paths', //to resolve filename collisions
-            '--json-format',
-            file.fsPath,
-          ],
-          this.data.tmpDir.path,
-          this.testRun.token,
-        );
-      } catch (e) {
-        this.log.error(`Failed to execute gcov on ${file.fsPath}`, e);
-      }
+    try {
+      await execute(
+        'gcov',
+        [
+          '--preserve-paths', //to resolve filename collisions
+          '--json-format',
+          ...gcdaPaths,
+        ],
+        outDir,
+        this.testRun.token,
+      );
+    } catch (e) {
+      // the output of the processable files is still there
+      this.log.error(`Failed to execute gcov on ${gcdaPaths.length} file(s)`, e, gcdaPaths);
     }
 
-    const gcovOutputFiles = await fs.readdir(this.data.tmpDir.path);
-    const jsonGzFiles = gcovOutputFiles.filter(f => f.endsWith('.gcov.json.gz'));
+    return outDir;
+  }
 
-    progress.report({ message: 'aggregating' });
+  private async parseGcovOutputDir(outDir: string): Promise<ParsedGcovFile[]> {
+    const jsonGzFiles = (await fs.readdir(outDir)).filter(f => f.endsWith('.gcov.json.gz')).sort();
+    const result: ParsedGcovFile[] = [];
 
-    // Execute decompression and parsing concurrently mapping over all generated files
-    const parsePromises = jsonGzFiles.map(async gzFile => {
-      if (this.testRun.token.isCancellationRequested) return;
-      const filePath = pathlib.join(this.data!.tmpDir.path, gzFile);
+    // sequentially: the number of open files is bounded by the number of batches processed in parallel
+    for (const gzFile of jsonGzFiles) {
+      if (this.testRun.token.isCancellationRequested) return result;
+      const filePath = pathlib.join(outDir, gzFile);
 
       let jsonStr: string;
       try {
@@ -242,7 +236,7 @@ class GcovTestMateTestRunHandler implements TMA.TestMateTestRunHandler {
         jsonStr = (await gunzip(buffer)).toString('utf8');
       } catch (e) {
         this.log.error(`Failed to decompress ${gzFile}`, e);
-        return;
+        continue;
       }
 
       let coverageJson;
@@ -250,10 +244,10 @@ class GcovTestMateTestRunHandler implements TMA.TestMateTestRunHandler {
         coverageJson = JSON.parse(jsonStr);
       } catch (e) {
         this.log.error(`Failed to parse JSON from ${gzFile}`, e);
-        return;
+        continue;
       }
 
-      if (!Array.isArray(coverageJson['files'])) return;
+      if (!Array.isArray(coverageJson['files'])) continue;
 
       const cwd = coverageJson['current_working_directory'] || this.workspaceFolder.uri.fsPath;
 
@@ -261,29 +255,68 @@ class GcovTestMateTestRunHandler implements TMA.TestMateTestRunHandler {
         const rawFilePath = sourceFile['file'];
         if (!rawFilePath || typeof rawFilePath !== 'string') continue;
 
-        const absoluteFilePath = pathlib.isAbsolute(rawFilePath) ? rawFilePath : pathlib.resolve(cwd, rawFilePath);
+        result.push({
+          path: pathlib.isAbsolute(rawFilePath) ? rawFilePath : pathlib.resolve(cwd, rawFilePath),
+          lines: Array.isArray(sourceFile['lines']) ? (sourceFile['lines'] as GcovLine[]) : [],
+          functions: Array.isArray(sourceFile['functions']) ? (sourceFile['functions'] as GcovFunction[]) : [],
+        });
+      }
+    }
 
-        if (!fileCoverageMap.has(absoluteFilePath)) {
-          fileCoverageMap.set(absoluteFilePath, new AggregatedFileCoverage());
-        }
+    return result;
+  }
+
+  async finaliseInner(progress: vscode.Progress<{ message?: string; increment?: number }>): Promise<void> {
+    if (!this.data) throw new Error('assert:data');
 
-        const aggregated = fileCoverageMap.get(absoluteFilePath)!;
+    const gcdaFiles = await this.getGcdaPath();
 
-        if (Array.isArray(sourceFile['lines'])) {
-          for (const line of sourceFile['lines']) {
-            aggregated.mergeLine(line as GcovLine);
-          }
-        }
+    if (gcdaFiles.length === 0) {
+      this.log.warn('No .gcda files found. Ensure code is compiled with --coverage and executed successfully.');
+      return;
+    }
+
+    progress.report({ message: 'gcov' });
+    const fileCoverageMap = new Map<string, AggregatedFileCoverage>();
+
+    // sorted and merged in batch order: the result doesn't depend on which gcov process finishes first
+    const batches = createGcdaBatches(gcdaFiles.map(f => f.fsPath).sort(), gcovParallelism);
+    const parsedBatches: (ParsedGcovFile[] | undefined)[] = new Array(batches.length);
+    let nextToMerge = 0;
 
-        if (Array.isArray(sourceFile['functions'])) {
-          for (const func of sourceFile['functions']) {
-            aggregated.mergeFunction(func as GcovFunction);
+    const mergeReadyBatches = () => {
+      while (nextToMerge < batches.length && parsedBatches[nextToMerge] !== undefined) {
+        for (const parsed of parsedBatches[nextToMerge]!) {
+          if (!fileCoverageMap.has(parsed.path)) {
+            fileCoverageMap.set(parsed.path, new AggregatedFileCoverage());
           }
+          const aggregated = fileCoverageMap.get(parsed.path)!;
+          for (const line of parsed.lines) aggregated.mergeLine(line);
+          for (const func of parsed.functions) aggregated.mergeFunction(func);
         }
+        parsedBatches[nextToMerge++] = []; // releasing the memory
       }
-    });
+    };
+
+    // The pool bounds the number of gcov processes (and so the open files).
+    // The output of a finished gcov is decompressed and parsed while the others are still running.
+    const pool = new TaskPool(gcovParallelism);
+    let finishedBatches = 0;
+
+    await Promise.all(
+      batches.map(async (batch, index) => {
+        try {
+          const outDir = await pool.scheduleTask(() => this.runGcov(batch, index));
+          parsedBatches[index] = outDir ? await this.parseGcovOutputDir(outDir) : [];
+        } catch (e) {
+          this.log.error('Failed to process gcov batch', e, batch);
+          parsedBatches[index] = [];
+        }
+        mergeReadyBatches();
+        progress.report({ message: `gcov ${++finishedBatches}/${batches.length}` });
+      }),
+    );
 
-    await Promise.all(parsePromises);
     if (this.testRun.token.isCancellationRequested) return;
 
     progress.report({ message: 'reporting' });
@@ -323,6 +356,39 @@ class GcovTestMateTestRunHandler implements TMA.TestMateTestRunHandler {
   }
 }
 
+///
+
+interface ParsedGcovFile {
+  path: string;
+  lines: GcovLine[];
+  functions: GcovFunction[];
+}
+
+const gcovParallelism = Math.max(1, os.availableParallelism());
+export const maxGcdaPerGcov = 64;
+export const maxGcovArgsLength = 16 * 1024; // command line length limits (Windows)
+
+// many .gcda files per gcov invocation, but at least as many batches as parallel processes
+export function createGcdaBatches(gcdaPaths: string[], parallelism: number): string[][] {
+  const batchSize = Math.max(1, Math.min(maxGcdaPerGcov, Math.ceil(gcdaPaths.length / parallelism)));
+  const batches: string[][] = [];
+  let current: string[] = [];
+  let currentLength = 0;
+
+  for (const gcdaPath of gcdaPaths) {
+    if (current.length >= batchSize || (current.length > 0 && currentLength + gcdaPath.length > maxGcovArgsLength)) {
+      batches.push(current);
+      current = [];
+      currentLength = 0;
+    }
+    current.push(gcdaPath);
+    currentLength += gcdaPath.length + 1;
+  }
+  if (current.length > 0) batches.push(current);
+
+  return batches;
+}
+
 class TestMateAdapter implements TMA.TestMateTestRunProfileAdapter {
   constructor(private readonly log: Log) {}
 
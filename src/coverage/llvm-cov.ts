@@ -6,6 +6,8 @@ import os from 'node:os';
 import crypto from 'node:crypto';
 import { Log } from 'vscode-test-adapter-util';
 import { create_advanced_activate, executeWithPlatformToolchain } from './common';
+import { JsonStreamParser } from '../util/JsonStreamParser';
+import { TaskPool } from '../util/TaskPool';
 
 const testMateExtensionId = 'matepek.vscode-catch2-test-adapter';
 const configSection = 'testMate.cpp.experimental.llvm-cov';
@@ -14,152 +16,317 @@ const ENV_LLVM_PROFILE_FILE = 'LLVM_PROFILE_FILE';
 
 ///
 
-class LlvmCovFileCoverage extends vscode.FileCoverage {
-  constructor(
+// [line, col, count, hasCount, isRegionEntry, isGapRegion] per segment
+const segmentSize = 6;
+// [startLine, startCol, endLine, endCol, trueCount, falseCount] per branch
+const branchSize = 6;
+// [startLine, startCol, endLine, endCol, count] per function
+const declarationSize = 5;
+
+// The details are kept compact until `load` is called: the JSON of a big project doesn't fit into the memory.
+function packSegments(segments: unknown): Float64Array {
+  if (!Array.isArray(segments)) return new Float64Array(0);
+  const packed = new Float64Array(segments.length * segmentSize);
+  for (let i = 0; i < segments.length; ++i) {
+    const seg = segments[i];
+    if (!Array.isArray(seg)) continue;
+    for (let j = 0; j < segmentSize && j < seg.length; ++j) packed[i * segmentSize + j] = Number(seg[j]);
+    // a malformed segment is just an end for the previous one
+    if (seg.length < segmentSize) packed[i * segmentSize + 3] = 0;
+  }
+  return packed;
+}
+
+function packBranches(branches: unknown): Float64Array {
+  if (!Array.isArray(branches)) return new Float64Array(0);
+  const valid = branches.filter(b => Array.isArray(b) && b.length >= branchSize);
+  const packed = new Float64Array(valid.length * branchSize);
+  for (let i = 0; i < valid.length; ++i) {
+    for (let j = 0; j < branchSize; ++j) packed[i * branchSize + j] = Number(valid[i][j]);
+  }
+  return packed;
+}
+
+export class FileDeclarations {
+  readonly names: string[] = [];
+  readonly regions: number[] = [];
+
+  add(name: string, region: number[]): void {
+    this.names.push(name);
+    for (let j = 0; j < declarationSize; ++j) this.regions.push(Number(region[j]));
+  }
+}
+
+// the coverage of a file by one `llvm-cov export`
+export interface CoveragePart {
+  segments: Float64Array;
+  branches: Float64Array;
+  declarations: FileDeclarations;
+}
+
+export class LlvmCovFileCoverage extends vscode.FileCoverage {
+  /**
+   * A header can be part of more objects which are exported separately and every object can cover different lines
+   * of it: the summary is calculated from the union of the parts.
+   * The same calculation is used for a single part too so the counts don't change when a part is merged.
+   */
+  static fromParts(uri: vscode.Uri, log: Log, parts: readonly CoveragePart[]): LlvmCovFileCoverage {
+    const summary = summarizeCoverageParts(parts);
+    const count = ([covered, total]: [number, number]) => new vscode.TestCoverageCount(covered, total);
+    return new LlvmCovFileCoverage(
+      uri,
+      count(summary.lines),
+      count(summary.branches),
+      count(summary.functions),
+      log,
+      parts,
+    );
+  }
+
+  private constructor(
     uri: vscode.Uri,
     statementCoverage: vscode.TestCoverageCount,
     branchCoverage: vscode.TestCoverageCount,
     declarationCoverage: vscode.TestCoverageCount,
     private readonly log: Log,
-    fileDetailsJson: unknown,
-    fileFunctionsJson: unknown[],
+    private readonly parts: readonly CoveragePart[],
   ) {
     super(uri, statementCoverage, branchCoverage, declarationCoverage);
-    this.data.fileDetailsJson = fileDetailsJson;
-    this.data.fileFunctionsJson = fileFunctionsJson;
   }
 
-  // eslint-disable-next-line @typescript-eslint/no-explicit-any
-  private readonly data: { fileDetailsJson?: any; fileFunctionsJson?: any[]; details?: vscode.FileCoverageDetail[] } =
-    {};
+  private details: vscode.FileCoverageDetail[] | undefined = undefined;
+
+  mergeWith(other: LlvmCovFileCoverage): LlvmCovFileCoverage {
+    return LlvmCovFileCoverage.fromParts(this.uri, this.log, [...this.parts, ...other.parts]);
+  }
 
   async load(token: vscode.CancellationToken): Promise<vscode.FileCoverageDetail[]> {
-    if (!this.data.fileDetailsJson) return [];
     // seems it is called only once but API doesn't say any guarantee so prepard for multiple calls
-    if (this.data.details) return this.data.details;
+    if (this.details) return this.details;
 
     const details: vscode.FileCoverageDetail[] = [];
     try {
-      const segments = Array.isArray(this.data.fileDetailsJson['segments'])
-        ? this.data.fileDetailsJson['segments']
-        : [];
-      const branches = Array.isArray(this.data.fileDetailsJson['branches'])
-        ? this.data.fileDetailsJson['branches']
-        : [];
-
-      // 1. Convert branches to vscode.BranchCoverage and keep track of unassigned branches
-      const unassignedBranches = new Set<{ branch: vscode.BranchCoverage; startPos: vscode.Position }>();
-
-      for (const b of branches) {
-        if (token.isCancellationRequested) return details;
-        if (b.length < 6) continue;
-        const startLine = Math.max(0, b[0] - 1);
-        const startCol = Math.max(0, b[1] - 1);
-        const endLine = Math.max(0, b[2] - 1);
-        const endCol = Math.max(0, b[3] - 1);
-        const range = new vscode.Range(startLine, startCol, endLine, endCol);
-        const trueExecCount = b[4];
-        const falseExecCount = b[5];
-
-        const startPos = new vscode.Position(startLine, startCol);
-        unassignedBranches.add({
-          branch: new vscode.BranchCoverage(trueExecCount, range),
-          startPos,
-        });
-        unassignedBranches.add({
-          branch: new vscode.BranchCoverage(falseExecCount, range),
-          startPos,
-        });
+      for (const part of this.parts) {
+        if (!this.loadPart(part, token, details)) return details;
       }
+      this.details = this.parts.length > 1 ? mergeDetails(details) : details;
+    } catch (e) {
+      this.log.error('Error loading detailed coverage:', e, this.uri);
+    }
+    return this.details ?? details;
+  }
 
-      // 2. Parse segments to form continuous statement coverage ranges
-      for (let i = 0; i < segments.length - 1; i++) {
-        if (token.isCancellationRequested) return details;
-        const seg = segments[i];
-        const nextSeg = segments[i + 1];
-
-        if (seg.length < 6 || nextSeg.length < 2) continue;
-
-        const line = Math.max(0, seg[0] - 1);
-        const col = Math.max(0, seg[1] - 1);
-        const count = seg[2];
-        const hasCount = seg[3];
-        const isGapRegion = seg[5];
+  // @returns false if it was cancelled
+  private loadPart(part: CoveragePart, token: vscode.CancellationToken, details: vscode.FileCoverageDetail[]): boolean {
+    const { segments, branches, declarations } = part;
+
+    // 1. Convert branches to vscode.BranchCoverage and keep track of unassigned branches
+    const unassignedBranches = new Set<{ branch: vscode.BranchCoverage; startPos: vscode.Position }>();
+
+    for (let b = 0; b < branches.length; b += branchSize) {
+      if (token.isCancellationRequested) return false;
+      const startLine = Math.max(0, branches[b] - 1);
+      const startCol = Math.max(0, branches[b + 1] - 1);
+      const endLine = Math.max(0, branches[b + 2] - 1);
+      const endCol = Math.max(0, branches[b + 3] - 1);
+      const range = new vscode.Range(startLine, startCol, endLine, endCol);
+      const trueExecCount = branches[b + 4];
+      const falseExecCount = branches[b + 5];
+
+      const startPos = new vscode.Position(startLine, startCol);
+      unassignedBranches.add({
+        branch: new vscode.BranchCoverage(trueExecCount, range),
+        startPos,
+      });
+      unassignedBranches.add({
+        branch: new vscode.BranchCoverage(falseExecCount, range),
+        startPos,
+      });
+    }
 
-        if (!hasCount || isGapRegion) continue;
+    // 2. Parse segments to form continuous statement coverage ranges
+    for (let s = 0; s + segmentSize < segments.length; s += segmentSize) {
+      if (token.isCancellationRequested) return false;
+      const next = s + segmentSize;
 
-        const endLine = Math.max(0, nextSeg[0] - 1);
-        const endCol = Math.max(0, nextSeg[1] - 1);
+      const line = Math.max(0, segments[s] - 1);
+      const col = Math.max(0, segments[s + 1] - 1);
+      const count = segments[s + 2];
+      const hasCount = segments[s + 3];
+      const isGapRegion = segments[s + 5];
 
-        if (line > endLine || (line === endLine && col >= endCol)) continue;
+      if (!hasCount || isGapRegion) continue;
 
-        const range = new vscode.Range(line, col, endLine, endCol);
+      const endLine = Math.max(0, segments[next] - 1);
+      const endCol = Math.max(0, segments[next + 1] - 1);
 
-        const statementBranches: vscode.BranchCoverage[] = [];
-        for (const item of unassignedBranches) {
-          if (token.isCancellationRequested) return details;
-          if (range.contains(item.startPos)) {
-            statementBranches.push(item.branch);
-            unassignedBranches.delete(item);
-          }
-        }
+      if (line > endLine || (line === endLine && col >= endCol)) continue;
 
-        details.push(
-          new vscode.StatementCoverage(count, range, statementBranches.length > 0 ? statementBranches : undefined),
-        );
-      }
+      const range = new vscode.Range(line, col, endLine, endCol);
 
-      // 3. Resolve orphaned branches
-      const orphanedByLine = new Map<number, vscode.BranchCoverage[]>();
+      const statementBranches: vscode.BranchCoverage[] = [];
       for (const item of unassignedBranches) {
-        if (token.isCancellationRequested) return details;
-        const line = item.startPos.line;
-        if (!orphanedByLine.has(line)) {
-          orphanedByLine.set(line, []);
+        if (token.isCancellationRequested) return false;
+        if (range.contains(item.startPos)) {
+          statementBranches.push(item.branch);
+          unassignedBranches.delete(item);
         }
-        orphanedByLine.get(line)!.push(item.branch);
       }
 
-      for (const [line, brs] of orphanedByLine.entries()) {
-        if (token.isCancellationRequested) return details;
-        const totalExecCount = brs.reduce((sum, b) => sum + (typeof b.executed === 'number' ? b.executed : 0), 0);
-        const fallbackRange = new vscode.Range(line, 0, line, 1);
-        details.push(new vscode.StatementCoverage(totalExecCount, fallbackRange, brs));
+      details.push(
+        new vscode.StatementCoverage(count, range, statementBranches.length > 0 ? statementBranches : undefined),
+      );
+    }
+
+    // 3. Resolve orphaned branches
+    const orphanedByLine = new Map<number, vscode.BranchCoverage[]>();
+    for (const item of unassignedBranches) {
+      if (token.isCancellationRequested) return false;
+      const line = item.startPos.line;
+      if (!orphanedByLine.has(line)) {
+        orphanedByLine.set(line, []);
       }
+      orphanedByLine.get(line)!.push(item.branch);
+    }
 
-      // 4. Try to compute DeclarationCoverage from functions in the same file
-      if (this.data.fileFunctionsJson) {
-        for (const func of this.data.fileFunctionsJson) {
-          if (token.isCancellationRequested) return details;
-          if (!func || !Array.isArray(func['filenames']) || !Array.isArray(func['regions'])) continue;
-
-          for (const region of func['regions']) {
-            if (region.length < 6) continue;
-            const fileIndex = region[5];
-            const fileName = func['filenames'][fileIndex];
-
-            if (fileName === this.uri.fsPath) {
-              const startLine = Math.max(0, region[0] - 1);
-              const startCol = Math.max(0, region[1] - 1);
-              const endLine = Math.max(0, region[2] - 1);
-              const endCol = Math.max(0, region[3] - 1);
-              const count = region[4];
-
-              const range = new vscode.Range(startLine, startCol, endLine, endCol);
-              details.push(new vscode.DeclarationCoverage(func['name'] || '<unknown>', count, range));
-              break;
-            }
-          }
-        }
+    for (const [line, brs] of orphanedByLine.entries()) {
+      if (token.isCancellationRequested) return false;
+      const totalExecCount = brs.reduce((sum, b) => sum + (typeof b.executed === 'number' ? b.executed : 0), 0);
+      const fallbackRange = new vscode.Range(line, 0, line, 1);
+      details.push(new vscode.StatementCoverage(totalExecCount, fallbackRange, brs));
+    }
+
+    // 4. DeclarationCoverage from the functions of the file
+    for (let d = 0; d < declarations.names.length; ++d) {
+      if (token.isCancellationRequested) return false;
+      const region = declarations.regions;
+      const r = d * declarationSize;
+      const startLine = Math.max(0, region[r] - 1);
+      const startCol = Math.max(0, region[r + 1] - 1);
+      const endLine = Math.max(0, region[r + 2] - 1);
+      const endCol = Math.max(0, region[r + 3] - 1);
+      const count = region[r + 4];
+
+      const range = new vscode.Range(startLine, startCol, endLine, endCol);
+      details.push(new vscode.DeclarationCoverage(declarations.names[d], count, range));
+    }
+
+    return true;
+  }
+}
+
+/**
+ * [covered, total] of the lines, branches and functions of the parts of the same file.
+ * The profile is merged already so the counts of the same region are the same in every part.
+ */
+export function summarizeCoverageParts(parts: readonly CoveragePart[]): {
+  lines: [number, number];
+  branches: [number, number];
+  functions: [number, number];
+} {
+  const lines = new Map<number, boolean>();
+  const branches = new Map<string, [boolean, boolean]>();
+  const functions = new Map<string, boolean>();
+
+  for (const { segments, branches: packedBranches, declarations } of parts) {
+    for (let s = 0; s < segments.length; s += segmentSize) {
+      const hasCount = segments[s + 3];
+      const isGapRegion = segments[s + 5];
+      if (!hasCount || isGapRegion) continue;
+      const line = segments[s];
+      const executed = segments[s + 2] > 0;
+      const nextLine = s + segmentSize < segments.length ? segments[s + segmentSize] : line;
+      for (let l = line; l <= Math.max(line, nextLine - 1); ++l) lines.set(l, executed || lines.get(l) === true);
+    }
+
+    for (let b = 0; b < packedBranches.length; b += branchSize) {
+      const key = packedBranches.slice(b, b + 4).join(':');
+      const prev = branches.get(key);
+      branches.set(key, [prev?.[0] || packedBranches[b + 4] > 0, prev?.[1] || packedBranches[b + 5] > 0]);
+    }
+
+    for (let d = 0; d < declarations.names.length; ++d) {
+      const r = d * declarationSize;
+      const key = declarations.names[d] + ':' + declarations.regions.slice(r, r + 4).join(':');
+      functions.set(key, functions.get(key) === true || declarations.regions[r + 4] > 0);
+    }
+  }
+
+  const countTrue = (values: Iterable<boolean>) => [...values].filter(v => v).length;
+  let coveredBranches = 0;
+  for (const [t, f] of branches.values()) coveredBranches += (t ? 1 : 0) + (f ? 1 : 0);
+
+  return {
+    lines: [countTrue(lines.values()), lines.size],
+    branches: [coveredBranches, branches.size * 2],
+    functions: [countTrue(functions.values()), functions.size],
+  };
+}
+
+const maxExecuted = (a: number | boolean, b: number | boolean): number | boolean =>
+  typeof a === 'number' && typeof b === 'number' ? Math.max(a, b) : a || b;
+
+const rangeKey = (r: vscode.Range): string => `${r.start.line}:${r.start.character}:${r.end.line}:${r.end.character}`;
+
+// the details of the same region from different parts are merged
+function mergeDetails(details: vscode.FileCoverageDetail[]): vscode.FileCoverageDetail[] {
+  const merged = new Map<string, vscode.FileCoverageDetail>();
+
+  for (const detail of details) {
+    if (!(detail.location instanceof vscode.Range)) continue;
+    const key =
+      (detail instanceof vscode.DeclarationCoverage ? 'd:' + detail.name + ':' : 's:') + rangeKey(detail.location);
+    const prev = merged.get(key);
+
+    if (prev === undefined) {
+      merged.set(key, detail);
+    } else if (prev instanceof vscode.DeclarationCoverage) {
+      prev.executed = maxExecuted(prev.executed, detail.executed);
+    } else if (prev instanceof vscode.StatementCoverage && detail instanceof vscode.StatementCoverage) {
+      prev.executed = maxExecuted(prev.executed, detail.executed);
+      if (prev.branches.length === detail.branches.length) {
+        prev.branches.forEach((b, i) => (b.executed = maxExecuted(b.executed, detail.branches[i].executed)));
       }
-      this.data.details = details;
-      delete this.data.fileDetailsJson;
-      delete this.data.fileFunctionsJson;
-    } catch (e) {
-      this.log.error('Error loading detailed coverage:', e, this.data);
     }
-    return details;
   }
+
+  return [...merged.values()];
+}
+
+///
+
+// the first region of the function in every file it belongs to
+function addDeclarations(func: Record<string, unknown>, getDeclarations: (fileName: string) => FileDeclarations): void {
+  if (!func) return;
+  const filenames = func['filenames'];
+  const regions = func['regions'];
+  if (!Array.isArray(filenames) || !Array.isArray(regions)) return;
+
+  const name = typeof func['name'] === 'string' && func['name'] ? func['name'] : '<unknown>';
+  const seen = new Set<string>();
+
+  for (const region of regions) {
+    if (!Array.isArray(region) || region.length < 6) continue;
+    const fileName = filenames[region[5]];
+    if (typeof fileName !== 'string' || seen.has(fileName)) continue;
+    seen.add(fileName);
+    getDeclarations(fileName).add(name, region);
+  }
+}
+
+// the lines of the segments which were executed: the gap regions are skipped
+function getCoveredLines(segments: Float64Array): number[] {
+  const lines = new Set<number>();
+  for (let i = 0; i < segments.length; i += segmentSize) {
+    const line = segments[i];
+    const count = segments[i + 2];
+    const hasCount = segments[i + 3];
+    const isGapRegion = segments[i + 5];
+    if (!hasCount || count <= 0 || isGapRegion) continue;
+    const nextLine = i + segmentSize < segments.length ? segments[i + segmentSize] : line;
+    for (let l = line; l <= Math.max(line, nextLine - 1); ++l) lines.add(l - 1);
+  }
+  return [...lines].sort((a, b) => a - b);
 }
 
 interface TestRunData {
@@ -167,12 +334,21 @@ interface TestRunData {
     path: string;
     remove(): Promise<void>;
   };
-  argsProfrawsPath: string;
-  argsProfrawsFile: fs.FileHandle;
-  argsObjectsPath: string;
-  argsObjectsFile: fs.FileHandle;
-  argsObjectsFileFirst: boolean;
-  dispose: () => void;
+  profraws: string[];
+  objects: Set<string>;
+  // only in case of `perTestCoverage`
+  perTest: { profraw: string; object: string; testIds: readonly string[] }[];
+  dispose: () => Promise<void>;
+}
+
+const parallelism = Math.max(1, os.availableParallelism());
+// smaller merges are not worth a separate process
+const minProfileMergeShardSize = 8;
+
+function splitIntoShards<T>(items: readonly T[], shardSize: number): T[][] {
+  const shards: T[][] = [];
+  for (let i = 0; i < items.length; i += shardSize) shards.push(items.slice(i, i + shardSize));
+  return shards;
 }
 
 class LlvmCovTestMateTestRunHandler implements TMA.TestMateTestRunHandler {
@@ -180,21 +356,20 @@ class LlvmCovTestMateTestRunHandler implements TMA.TestMateTestRunHandler {
     private readonly testRun: TMA.TestMateTestRun,
     private readonly workspaceFolder: vscode.WorkspaceFolder,
     private readonly log: Log,
+    private readonly testCoverageIndex: TMA.TestMateTestCoverageIndex | undefined,
   ) {
     // these configs don't need reload, will be applied for future runs
     const config = vscode.workspace.getConfiguration(configSection);
     this.allowExecutableConcurrentInvocations = config.get<boolean>('allowExecutableConcurrentInvocations', true);
+    this.isolateTests = testCoverageIndex !== undefined && config.get<boolean>('perTestCoverage', false);
   }
 
   allowExecutableConcurrentInvocations: boolean;
+  isolateTests: boolean;
   private data: TestRunData | undefined = undefined;
 
   async init(): Promise<void> {
     const tmpDirPath = await fs.mkdtemp(pathlib.join(os.tmpdir(), 'llvm-cov_'));
-    const argsProfrawsPath = pathlib.join(tmpDirPath, 'profraws.args.txt');
-    const argsProfrawsFile = await fs.open(argsProfrawsPath, 'w');
-    const argsObjectsPath = pathlib.join(tmpDirPath, 'objects.args.txt');
-    const argsObjectsFile = await fs.open(argsObjectsPath, 'w');
 
     this.data = {
       tmpDir: {
@@ -203,14 +378,10 @@ class LlvmCovTestMateTestRunHandler implements TMA.TestMateTestRunHandler {
           await fs.rm(this.path, { recursive: true, force: true });
         },
       },
-      argsProfrawsPath,
-      argsProfrawsFile,
-      argsObjectsPath,
-      argsObjectsFile,
-      argsObjectsFileFirst: true,
+      profraws: [],
+      objects: new Set(),
+      perTest: [],
       async dispose() {
-        await this.argsProfrawsFile.close();
-        await this.argsObjectsFile.close();
         await this.tmpDir.remove();
       },
     };
@@ -225,12 +396,15 @@ class LlvmCovTestMateTestRunHandler implements TMA.TestMateTestRunHandler {
       if (!this.data) throw Error('assert:data');
 
       // fs.exists
-      this.data.argsProfrawsFile.writeFile(builder.env[ENV_LLVM_PROFILE_FILE]! + '\n');
-
-      if (this.data.argsObjectsFileFirst) {
-        this.data.argsObjectsFileFirst = false;
-        await this.data.argsObjectsFile.writeFile(builder.cmd + '\n');
-      } else await this.data.argsObjectsFile.writeFile('-object\n' + builder.cmd + '\n');
+      this.data.profraws.push(builder.env[ENV_LLVM_PROFILE_FILE]!);
+      this.data.objects.add(builder.cmd);
+      if (this.isolateTests && builder.testIds?.length) {
+        this.data.perTest.push({
+          profraw: builder.env[ENV_LLVM_PROFILE_FILE]!,
+          object: builder.cmd,
+          testIds: builder.testIds,
+        });
+      }
     }
   }
 
@@ -248,101 +422,279 @@ class LlvmCovTestMateTestRunHandler implements TMA.TestMateTestRunHandler {
   private async finaliseInner(progress: vscode.Progress<{ message?: string; increment?: number }>): Promise<void> {
     if (!this.data) throw Error('assert:data');
 
+    // both the merges and the exports are processes: bounded by the number of cores
+    const pool = new TaskPool(parallelism);
+
     progress.report({ message: 'llvm-profdata' });
-    const mergedProfdataPath = pathlib.join(this.data.tmpDir.path, 'merged.profdata');
-    await this.data.argsProfrawsFile.close().catch(e => this.log.error('closing file', e));
-    // Use LLVM Response files to bypass OS ARG_MAX limits for profdata
-    const mergeArgs = ['merge', '-sparse', `@${this.data.argsProfrawsPath}`, '-o', mergedProfdataPath];
+    let mergedProfdataPath: string;
     try {
-      this.log.debug('llvm-profdata', mergeArgs);
-      await executeWithPlatformToolchain('llvm-profdata', mergeArgs, this.data.tmpDir.path, this.testRun.token);
+      mergedProfdataPath = await this.mergeProfiles(pool, progress);
     } catch (e) {
       this.log.error('Failed to merge profdata. Ensure llvm-profdata is in PATH.', e);
       return;
     }
 
+    if (this.testRun.token.isCancellationRequested) return;
+
     progress.report({ message: 'collecting object files' });
     const objectsPattern = vscode.workspace
       .getConfiguration(configSection)
       .get<string[]>('objects', ['**/*.{dylib,so,dll}']);
-    try {
-      for (const pattern of objectsPattern) {
-        const sharedLibs = await vscode.workspace.findFiles(
-          new vscode.RelativePattern(this.workspaceFolder, pattern),
-          '**/{node_modules,_deps}/**',
-        );
-        for (const l of sharedLibs) {
-          if (this.data.argsObjectsFileFirst) throw Error('assert argsObjectsFileFirst');
-          await this.data.argsObjectsFile.writeFile('-object\n' + l.fsPath + '\n');
-        }
+    const sharedLibs: string[] = [];
+    for (const pattern of objectsPattern) {
+      const found = await vscode.workspace.findFiles(
+        new vscode.RelativePattern(this.workspaceFolder, pattern),
+        '**/{node_modules,_deps}/**',
+      );
+      for (const l of found) {
+        sharedLibs.push(l.fsPath);
+        this.data.objects.add(l.fsPath);
       }
-    } finally {
-      await this.data.argsObjectsFile.close().catch(e => this.log.error('closing file', e));
     }
 
+    // the objects are exported in parallel groups, the results are reported as they arrive
     progress.report({ message: 'llvm-cov' });
-    const exportArgs = [
-      'export',
-      `@${this.data.argsObjectsPath}`,
-      '-instr-profile',
-      mergedProfdataPath,
-      '-format=text',
-    ];
-    let dataArr;
+    const objects = [...this.data.objects];
+    const groups = splitIntoShards(objects, Math.max(1, Math.ceil(objects.length / parallelism)));
+    const fileCoverages = new Map<string, LlvmCovFileCoverage>();
+    let finishedGroups = 0;
+
+    await Promise.all(
+      groups.map((group, index) =>
+        pool
+          .scheduleTask(() => this.exportCoverage(group, index, mergedProfdataPath))
+          .then(exported => {
+            for (const fileCoverage of exported) {
+              if (this.testRun.token.isCancellationRequested) return;
+              const key = fileCoverage.uri.fsPath;
+              const prev = fileCoverages.get(key);
+              const merged = prev ? prev.mergeWith(fileCoverage) : fileCoverage;
+              fileCoverages.set(key, merged);
+              // the merged one replaces the previous
+              this.testRun.addCoverage(merged);
+            }
+            progress.report({ message: `llvm-cov ${++finishedGroups}/${groups.length}` });
+          }),
+      ),
+    );
+
+    if (this.testRun.token.isCancellationRequested) throw Error('canceled');
+
+    if (this.testCoverageIndex && this.data.perTest.length > 0) {
+      await this.updateTestCoverageIndex(this.testCoverageIndex, pool, sharedLibs, progress);
+    }
+  }
+
+  /**
+   * Every test had its own process and profile: the profiles are exported one by one to get the covered lines.
+   */
+  private async updateTestCoverageIndex(
+    testCoverageIndex: TMA.TestMateTestCoverageIndex,
+    pool: TaskPool,
+    sharedLibs: readonly string[],
+    progress: vscode.Progress<{ message?: string; increment?: number }>,
+  ): Promise<void> {
+    const perTest = this.data!.perTest;
+    let finished = 0;
+
+    const records = await Promise.all(
+      perTest.map((test, index) =>
+        pool.scheduleTask(async (): Promise<TMA.TestMateTestCoverageRecord | undefined> => {
+          if (this.testRun.token.isCancellationRequested) return undefined;
+          try {
+            const profdataPath = pathlib.join(this.data!.tmpDir.path, `test.${index}.profdata`);
+            await this.mergeProfileShard([test.profraw], profdataPath);
+            const coveredLines = await this.exportCoveredLines([test.object, ...sharedLibs], index, profdataPath);
+            return { testIds: test.testIds, coveredLines };
+          } catch (e) {
+            this.log.warnS('Failed to collect the coverage of the test', test.testIds, e);
+            return undefined;
+          } finally {
+            progress.report({ message: `per-test coverage ${++finished}/${perTest.length}` });
+          }
+        }),
+      ),
+    );
+
+    if (this.testRun.token.isCancellationRequested) throw Error('canceled');
+
+    await testCoverageIndex.update(records.filter(r => r !== undefined));
+  }
+
+  /**
+   * Tree reduction: shards of the profiles are merged in parallel until one remains.
+   * @returns the path of the merged profile
+   */
+  private async mergeProfiles(
+    pool: TaskPool,
+    progress: vscode.Progress<{ message?: string; increment?: number }>,
+  ): Promise<string> {
+    const tmpDir = this.data!.tmpDir.path;
+    let inputs = this.data!.profraws;
+
+    for (let level = 0; ; ++level) {
+      if (this.testRun.token.isCancellationRequested) throw Error('canceled');
+
+      const shardSize = Math.max(minProfileMergeShardSize, Math.ceil(inputs.length / parallelism));
+
+      if (inputs.length <= shardSize) {
+        const mergedProfdataPath = pathlib.join(tmpDir, 'merged.profdata');
+        await this.mergeProfileShard(inputs, mergedProfdataPath);
+        return mergedProfdataPath;
+      }
+
+      const shards = splitIntoShards(inputs, shardSize);
+      progress.report({ message: `llvm-profdata ${inputs.length} => ${shards.length}` });
+      inputs = await Promise.all(
+        shards.map((shard, index) =>
+          pool.scheduleTask(async () => {
+            const output = pathlib.join(tmpDir, `merged.${level}.${index}.profdata`);
+            await this.mergeProfileShard(shard, output);
+            return output;
+          }),
+        ),
+      );
+    }
+  }
+
+  private async mergeProfileShard(inputs: string[], output: string): Promise<void> {
+    // Use LLVM Response files to bypass OS ARG_MAX limits for profdata
+    const argsPath = output + '.args.txt';
+    await fs.writeFile(argsPath, inputs.map(p => p + '\n').join(''));
+    const mergeArgs = ['merge', '-sparse', `@${argsPath}`, '-o', output];
+    this.log.debug('llvm-profdata', mergeArgs);
+    await executeWithPlatformToolchain('llvm-profdata', mergeArgs, this.data!.tmpDir.path, this.testRun.token);
+  }
+
+  private async exportCoverage(
+    objects: string[],
+    groupIndex: number,
+    mergedProfdataPath: string,
+  ): Promise<LlvmCovFileCoverage[]> {
+    if (this.testRun.token.isCancellationRequested) return [];
+
+    const argsObjectsPath = await this.writeObjectsArgs(objects, `objects.${groupIndex}`);
+    const exportArgs = ['export', `@${argsObjectsPath}`, '-instr-profile', mergedProfdataPath, '-format=text'];
+
+    // the export is streamed: one `files[]` entry at a time, so only the biggest file has to fit into the memory
+    const fileParts: [vscode.Uri, CoveragePart][] = [];
+    const declarationsByFile = new Map<string, FileDeclarations>();
+    const getDeclarations = (fileName: string): FileDeclarations => {
+      let declarations = declarationsByFile.get(fileName);
+      if (declarations === undefined) {
+        declarations = new FileDeclarations();
+        declarationsByFile.set(fileName, declarations);
+      }
+      return declarations;
+    };
+    let covType: unknown = undefined;
+    let covVersion: unknown = undefined;
+
+    const parser = new JsonStreamParser(
+      this.log,
+      {
+        onvalue: (path: string, value: unknown): void => {
+          if (path === 'data[].files[]') {
+            fileParts.push(this.createCoveragePart(value, getDeclarations));
+          } else if (path === 'data[].functions[]') {
+            addDeclarations(value as Record<string, unknown>, getDeclarations);
+          } else if (path === 'type') {
+            covType = value;
+          } else if (path === 'version') {
+            covVersion = value;
+          }
+        },
+      },
+      ['data', 'data[]', 'data[].files', 'data[].functions'],
+    );
+
     try {
       this.log.debug('llvm-cov', exportArgs);
-      const [outputStr] = await executeWithPlatformToolchain(
-        'llvm-cov',
-        exportArgs,
-        this.data.tmpDir.path,
-        this.testRun.token,
+      await executeWithPlatformToolchain('llvm-cov', exportArgs, this.data!.tmpDir.path, this.testRun.token, data =>
+        parser.write(data),
       );
-      try {
-        const coverageJson = JSON.parse(outputStr);
-        const covType = coverageJson['type'] as string;
-        const covVersion = coverageJson['version'] as string;
-        if (covType !== 'llvm.coverage.json.export') throw Error(`wrong type: ${covType}`);
-        if (!covVersion.startsWith('2.') && !covVersion.startsWith('3.')) throw Error(`wrong version: ${covVersion}`);
-        if (!Array.isArray(coverageJson['data'])) throw Error(`assert: data json array`);
-        else dataArr = coverageJson['data'];
-      } catch (e) {
-        this.log.error('Failed to parse coverage JSON:', e);
-        return;
-      }
+      await parser.end();
     } catch (e) {
-      this.log.error('Failed to export coverage. Ensure llvm-cov is in PATH.', e);
-      return;
+      this.log.error('Failed to export coverage. Ensure llvm-cov is in PATH.', e, objects);
+      return [];
     }
 
-    progress.report({ message: 'reporting' });
-    for (const data of dataArr) {
-      if (this.testRun.token.isCancellationRequested) throw Error('canceled');
-      if (!Array.isArray(data['files'])) continue;
-
-      const functionsList = Array.isArray(data['functions']) ? data['functions'] : [];
-
-      for (const file of data['files']) {
-        if (this.testRun.token.isCancellationRequested) throw Error('canceled');
-
-        const uri = vscode.Uri.file(file['filename']);
-        const statementCov = new vscode.TestCoverageCount(
-          file['summary']['lines']['covered'],
-          file['summary']['lines']['count'],
-        );
-        const branchCov = new vscode.TestCoverageCount(
-          file['summary']['branches']['covered'],
-          file['summary']['branches']['count'],
-        );
-        const declCov = new vscode.TestCoverageCount(
-          file['summary']['functions']['covered'],
-          file['summary']['functions']['count'],
-        );
-
-        this.testRun.addCoverage(
-          new LlvmCovFileCoverage(uri, statementCov, branchCov, declCov, this.log, file, functionsList),
-        );
-      }
+    try {
+      if (covType !== 'llvm.coverage.json.export') throw Error(`wrong type: ${covType}`);
+      if (typeof covVersion !== 'string' || (!covVersion.startsWith('2.') && !covVersion.startsWith('3.')))
+        throw Error(`wrong version: ${covVersion}`);
+    } catch (e) {
+      this.log.errorS('Failed to parse coverage JSON:', e);
+      return [];
     }
+
+    // the `functions` come after the `files`: the declarations are complete only now
+    return fileParts.map(([uri, part]) => LlvmCovFileCoverage.fromParts(uri, this.log, [part]));
+  }
+
+  private async writeObjectsArgs(objects: readonly string[], name: string): Promise<string> {
+    const argsObjectsPath = pathlib.join(this.data!.tmpDir.path, `${name}.args.txt`);
+    await fs.writeFile(argsObjectsPath, objects.map((o, i) => (i === 0 ? o : '-object\n' + o) + '\n').join(''));
+    return argsObjectsPath;
+  }
+
+  /**
+   * @returns the 0-based lines which have a segment with non-zero count by file path
+   */
+  private async exportCoveredLines(
+    objects: readonly string[],
+    testIndex: number,
+    profdataPath: string,
+  ): Promise<Map<string, number[]>> {
+    const argsObjectsPath = await this.writeObjectsArgs(objects, `test.${testIndex}`);
+    const exportArgs = [
+      'export',
+      `@${argsObjectsPath}`,
+      '-instr-profile',
+      profdataPath,
+      '-format=text',
+      '-skip-functions',
+    ];
+
+    const coveredLines = new Map<string, number[]>();
+    const parser = new JsonStreamParser(
+      this.log,
+      {
+        onvalue: (path: string, value: unknown): void => {
+          if (path !== 'data[].files[]') return;
+          const file = value as Record<string, unknown>;
+          if (typeof file['filename'] !== 'string') return;
+          const lines = getCoveredLines(packSegments(file['segments']));
+          if (lines.length > 0) coveredLines.set(vscode.Uri.file(file['filename']).fsPath, lines);
+        },
+      },
+      ['data', 'data[]', 'data[].files'],
+    );
+
+    this.log.debug('llvm-cov', exportArgs);
+    await executeWithPlatformToolchain('llvm-cov', exportArgs, this.data!.tmpDir.path, this.testRun.token, data =>
+      parser.write(data),
+    );
+    await parser.end();
+
+    return coveredLines;
+  }
+
+  private createCoveragePart(
+    fileJson: unknown,
+    getDeclarations: (fileName: string) => FileDeclarations,
+  ): [vscode.Uri, CoveragePart] {
+    // eslint-disable-next-line @typescript-eslint/no-explicit-any
+    const file = fileJson as any;
+    const uri = vscode.Uri.file(file['filename']);
+    return [
+      uri,
+      {
+        segments: packSegments(file['segments']),
+        branches: packBranches(file['branches']),
+        declarations: getDeclarations(uri.fsPath),
+      },
+    ];
   }
 
   async mapTestRunProcessBuilder(builder: TMA.TestMateProcessBuilder): Promise<TMA.TestMateProcessBuilder> {
@@ -360,7 +712,10 @@ class LlvmCovTestMateTestRunHandler implements TMA.TestMateTestRunHandler {
 }
 
 class TestMateAdapter implements TMA.TestMateTestRunProfileAdapter {
-  constructor(private readonly log: Log) {}
+  constructor(
+    private readonly log: Log,
+    private readonly testCoverageIndex?: TMA.TestMateTestCoverageIndex,
+  ) {}
 
   label = label;
   kind = vscode.TestRunProfileKind.Coverage;
@@ -370,7 +725,7 @@ class TestMateAdapter implements TMA.TestMateTestRunProfileAdapter {
     testRun: TMA.TestMateTestRun,
     workspaceFolder: vscode.WorkspaceFolder,
   ): TMA.TestMateTestRunHandler {
-    return new LlvmCovTestMateTestRunHandler(testRun, workspaceFolder, this.log);
+    return new LlvmCovTestMateTestRunHandler(testRun, workspaceFolder, this.log, this.testCoverageIndex);
   }
 
   async loadDetailedCoverage(
@@ -401,7 +756,7 @@ export async function activate(context: vscode.ExtensionContext) {
   const testMateExtension = vscode.extensions.getExtension<TMA.TestMateAPI>(testMateExtensionId);
   if (testMateExtension) {
     const testMate = await testMateExtension.activate();
-    const adapter = new TestMateAdapter(log);
+    const adapter = new TestMateAdapter(log, testMate.testCoverageIndex);
     const profile = testMate.createTestRunProfile(adapter);
     context.subscriptions.push(adapter, profile);
     log.info('created adapter', adapter.label, adapter.kind, testMateExtensionId);
@@ -413,4 +768,8 @@ export async function activate(context: vscode.ExtensionContext) {
 /**
  * advanced example
  */
-export const advanced_activate = create_advanced_activate(configSection, label, log => new TestMateAdapter(log));
+export const advanced_activate = create_advanced_activate(
+  configSection,
+  label,
+  (log, testMate) => new TestMateAdapter(log, testMate.testCoverageIndex),
+);
@@ -1,21 +1,13 @@
 import * as pathlib from 'path';
 import * as vscode from 'vscode';
-import * as fs from 'fs';
 import { EOL } from 'os';
 
 import { SharedVarOfExec } from './SharedVarOfExec';
-import { AbstractTest } from './AbstractTest';
+import { AbstractTest, SubTest, SubTestTree } from './AbstractTest';
 import { combine, TaskPool } from '../util/TaskPool';
 import { ExecutableRunResultValue, RunningExecutable } from '../RunningExecutable';
 import { promisify } from 'util';
-import {
-  Version,
-  getAbsolutePath,
-  CancellationToken,
-  reindentStr,
-  getModiTime,
-  applyRegexpWithSubstitution,
-} from '../Util';
+import { Version, CancellationToken, reindentStr, getModiTime } from '../Util';
 import {
   createRegexReplaceForStringVariable,
   createPythonIndexerForPathVariable,
@@ -35,15 +27,31 @@ import {
   GroupBySplittedTestName,
 } from '../TestGroupingInterface';
 import { isSpawnBusyError } from '../util/FSWrapper';
-import { TestResultBuilder } from '../TestResultBuilder';
+import { addOutputForTestRun, TestResultBuilder } from '../TestResultBuilder';
 import { debugAssert, debugBreak } from '../util/DevelopmentHelper';
 import { SpawnBuilder } from '../Spawner';
 import { SharedTestTags } from './SharedTestTags';
 import { Disposable } from '../Util';
-import { FilePathResolver, TestItemParent } from '../TestItemManager';
+import { FilePathResolver, TestItemManager, TestItemParent } from '../TestItemManager';
 import { Logger } from '../Logger';
 import { TestRunData } from '../TestRunData';
+import { AdaptiveBatchQueue } from '../util/AdaptiveBatchQueue';
+import { distributeByDuration } from '../util/TestDurationStore';
+import { SourceFileResolver } from '../util/SourceFileResolver';
 import * as TMA from '../TestMateApi';
+import {
+  hasTestEventsReporter,
+  TestEvent,
+  TestEventFailure,
+  TestEventParser,
+  TestEventSectionStart,
+  TestEventTestStart,
+  testEventsFd,
+  testEventsFdEnv,
+  testEventsRequestedEnv,
+} from '../util/TestEventParser';
+import { ParserInterface, pipeOutputStreams2Parser, pipeProcess2Parser } from '../util/ParserInterface';
+import { Readable } from 'stream';
 
 ///
 
@@ -74,6 +82,19 @@ export abstract class AbstractExecutable<TestT extends AbstractTest = AbstractTe
     }
   }
 
+  /**
+   * The executable was deleted: unlike at `dispose` its tests won't come back.
+   */
+  disposeRemoved(): void {
+    const testIds = [...this._tests.values()].map(test => TestItemManager.getUniqueId(test.item));
+    this.dispose();
+    if (testIds.length > 0) {
+      this.shared.shared.testCoverageIndex
+        .removeTests(testIds)
+        .catch(e => this.shared.log.warn('testCoverageIndex', e));
+    }
+  }
+
   private static _reportedFrameworks: string[] = [];
 
   protected _getGroupByExecutable(): GroupByExecutable {
@@ -84,6 +105,8 @@ export abstract class AbstractExecutable<TestT extends AbstractTest = AbstractTe
   }
 
   private _lastReloadTime: number | undefined = undefined;
+  // whether the build of the executable (by modification time) links the TestMate event reporter
+  private _testEventsSupport: { modiTime: number; supported: Promise<boolean> } | undefined = undefined;
 
   // don't use this directly because _addTest and _getTest can be overwritten
   private _tests = new Map<string /*id*/, AbstractTest>();
@@ -517,24 +540,24 @@ export abstract class AbstractExecutable<TestT extends AbstractTest = AbstractTe
     );
   }
 
-  private _splitTestSetForMultirunIfEnabled(tests: readonly AbstractTest[]): (readonly AbstractTest[])[] {
-    const parallelizationLimit = this.shared.parallelizationPool.maxTaskCount;
+  private _getTargetTaskCount(testCount: number): number {
+    // user intention?
+    let testPerTask = Math.max(1, Math.round(testCount / this.shared.parallelizationPool.maxTaskCount));
 
-    if (parallelizationLimit > 1 || this.shared.maxTestsPerExecutable !== null) {
-      // user intention?
-      let testPerTask = Math.max(1, Math.round(tests.length / parallelizationLimit));
+    if (this.shared.maxTestsPerExecutable !== null) {
+      testPerTask = Math.min(testPerTask, this.shared.maxTestsPerExecutable);
+    }
 
-      if (this.shared.maxTestsPerExecutable !== null) {
-        testPerTask = Math.min(testPerTask, this.shared.maxTestsPerExecutable);
-      }
+    return Math.min(testCount, Math.max(1, Math.round(testCount / testPerTask)));
+  }
 
-      const targetTaskCount = Math.min(tests.length, Math.max(1, Math.round(tests.length / testPerTask)));
+  private _splitTestSetForMultirunIfEnabled(tests: readonly AbstractTest[]): (readonly AbstractTest[])[] {
+    const parallelizationLimit = this.shared.parallelizationPool.maxTaskCount;
 
-      const buckets: AbstractTest[][] = Array.from({ length: targetTaskCount }, () => []);
+    if (parallelizationLimit > 1 || this.shared.maxTestsPerExecutable !== null) {
+      const targetTaskCount = this._getTargetTaskCount(tests.length);
 
-      for (let i = 0; i < tests.length; ++i) {
-        buckets[i % buckets.length].push(tests[i]);
-      }
+      const buckets = this._distributeTestsByRecordedDuration(tests, targetTaskCount);
 
       if (buckets.length > 1) {
         this.shared.log.info(
@@ -549,6 +572,30 @@ export abstract class AbstractExecutable<TestT extends AbstractTest = AbstractTe
     }
   }
 
+  private _distributeTestsByRecordedDuration(tests: readonly AbstractTest[], bucketCount: number): AbstractTest[][] {
+    const { buckets, bucketDurations, withoutDurationCount } = distributeByDuration(tests, bucketCount, test =>
+      this.getRecordedTestDuration(test),
+    );
+
+    if (withoutDurationCount < tests.length) {
+      this.shared.log.debug('buckets by recorded duration', bucketDurations, withoutDurationCount);
+    }
+
+    return buckets;
+  }
+
+  private get _testDurationKey(): string {
+    return `${this.shared.path}#${this.shared.optionsHash}`;
+  }
+
+  getRecordedTestDuration(test: AbstractTest): number | undefined {
+    return this.shared.shared.testDurationStore.get(this._testDurationKey, test.id);
+  }
+
+  recordTestDuration(test: AbstractTest, durationMilisec: number): void {
+    this.shared.shared.testDurationStore.set(this._testDurationKey, test.id, durationMilisec);
+  }
+
   private _splitTestsToSmallEnoughSubsetsAndRemoveLooLongIds(
     tests: readonly AbstractTest[],
     testRun: vscode.TestRun,
@@ -586,6 +633,26 @@ export abstract class AbstractExecutable<TestT extends AbstractTest = AbstractTe
 
   protected abstract _reloadChildren(cancellationToken: CancellationToken): Promise<void>;
 
+  /**
+   * The test list cache is keyed by the content of the executable, `format` and everything else
+   * which can affect the output of the listing.
+   */
+  private _getTestListCacheKeyParts(format: string): string[] {
+    return [this.frameworkName, this.frameworkVersion?.toString() ?? 'unknown', this.shared.optionsHash, format];
+  }
+
+  protected async _loadTestListFromCache(format: string): Promise<string | undefined> {
+    if (!this.shared.enabledTestListCaching) return undefined;
+    return this.shared.shared.testListCache.get(this.shared.path, this._getTestListCacheKeyParts(format));
+  }
+
+  protected _storeTestListToCache(format: string, content: string): void {
+    if (!this.shared.enabledTestListCaching) return;
+    this.shared.shared.testListCache
+      .set(this.shared.path, this._getTestListCacheKeyParts(format), content)
+      .catch(err => this.shared.log.warn('couldnt write cache:', err));
+  }
+
   protected abstract _getRunParamsInner(childrenToRun: readonly Readonly<AbstractTest>[] | null): string[];
 
   private async _getRunParams(childrenToRun: readonly Readonly<AbstractTest>[] | null): Promise<string[]> {
@@ -629,6 +696,39 @@ export abstract class AbstractExecutable<TestT extends AbstractTest = AbstractTe
     return [tests];
   }
 
+  /**
+   * Can be overridden if the framework has a TestMate event reporter (documents/examples/test_events).
+   * @returns the run params which select it instead of the parsed output, undefined if there is none
+   */
+  protected _getTestEventsRunParams(_runParams: readonly string[]): string[] | undefined {
+    return undefined;
+  }
+
+  /**
+   * Can be overridden, the id of the test by the event of the TestMate event reporter.
+   */
+  protected _getTestIdOfEvent(event: TestEventTestStart): string {
+    return event.name;
+  }
+
+  /**
+   * Can be overridden if the framework can split the test list itself (without filter arguments).
+   * The returned variables are added to the environment and the arguments to the run params of the shard's process.
+   * @returns the params of every shard, undefined if the executable cannot be sharded
+   */
+  protected _getShardParams(_shardCount: number): ShardParams[] | undefined {
+    return undefined;
+  }
+
+  /**
+   * Can be overridden if the framework can select a contiguous range of its test list.
+   * @returns the params of the processes which run exactly the given tests (without filter arguments),
+   *   undefined if the tests cannot be selected this way
+   */
+  protected _getRangeParams(_tests: readonly AbstractTest[], _processCount: number): ShardParams[] | undefined {
+    return undefined;
+  }
+
   async getDebugParams(childrenToRun: readonly Readonly<AbstractTest>[], breakOnFailure: boolean): Promise<string[]> {
     const prependTestDebuggingArgs = await Promise.all(
       this.shared.prependTestDebuggingArgs.map(x => this.resolveText(x)),
@@ -655,10 +755,28 @@ export abstract class AbstractExecutable<TestT extends AbstractTest = AbstractTe
           this._tests = new Map();
           this._execItem.clearError();
 
-          await this._reloadChildren(cancellationToken);
+          // the executable was rebuilt: the paths in its output might have changed
+          this._sourceFileResolver?.clearCache();
+
+          await this.shared.shared.phaseTimings.measure('listing', this.shared.path, () =>
+            this._reloadChildren(cancellationToken),
+          );
 
+          const removedTestIds: string[] = [];
           for (const test of prevTests.values()) {
-            if (!this._getTest(test.id)) this.removeTest(test);
+            if (!this._getTest(test.id)) {
+              removedTestIds.push(TestItemManager.getUniqueId(test.item));
+              this.removeTest(test);
+            }
+          }
+
+          if (!cancellationToken.isCancellationRequested && this._tests.size > 0) {
+            this.shared.shared.testDurationStore.removeMissing(this._testDurationKey, this._tests.keys());
+          }
+          if (removedTestIds.length > 0) {
+            this.shared.shared.testCoverageIndex
+              .removeTests(removedTestIds)
+              .catch(e => this.shared.log.warn('testCoverageIndex', e));
           }
         } else {
           this.shared.log.debug('reloadTests was skipped due to mtime', this.shared.path);
@@ -713,7 +831,46 @@ export abstract class AbstractExecutable<TestT extends AbstractTest = AbstractTe
     }
 
     try {
-      if (!testsToRun.implicitAll) {
+      const shardCount = this._getShardCount(testsToRun, testsToRunFinal);
+      const shardParams = shardCount > 1 ? this._getShardParams(shardCount) : undefined;
+      const rangeParams =
+        shardParams !== undefined || testsToRun.implicitAll || this._isDynamicDispatchEnabled()
+          ? undefined
+          : this._getRangeParams(testsToRunFinal, this._getTargetTaskCount(testsToRunFinal.length));
+      if (data.testRunHandler?.isolateTests && !testsToRun.implicitAll) {
+        // per-test coverage: the output of a process has to belong to a single test
+        const runningTestPromises = testsToRunFinal.map(t =>
+          this._runInner(data, [t], workspaceTaskPool).catch(err => {
+            vscode.window.showWarningMessage(err.toString());
+          }),
+        );
+        await Promise.allSettled(runningTestPromises);
+      } else if (shardParams !== undefined) {
+        this.shared.log.info('Running the executable as shards.', shardParams.length);
+        const runningShardPromises = shardParams.map(shard =>
+          this._runInner(data, null, workspaceTaskPool, undefined, shard).catch(err => {
+            vscode.window.showWarningMessage(err.toString());
+          }),
+        );
+        await Promise.allSettled(runningShardPromises);
+      } else if (!testsToRun.implicitAll && this._isDynamicDispatchEnabled()) {
+        const splittedForFramework = this._splitTests(testsToRunFinal);
+        await Promise.allSettled(
+          splittedForFramework.map(tests =>
+            this._runDynamically(data, tests, workspaceTaskPool).catch(err => {
+              vscode.window.showWarningMessage(err.toString());
+            }),
+          ),
+        );
+      } else if (rangeParams !== undefined && rangeParams.length > 0) {
+        this.shared.log.info('Running the tests as ranges.', rangeParams.length);
+        const runningRangePromises = rangeParams.map(range =>
+          this._runInner(data, null, workspaceTaskPool, undefined, range).catch(err => {
+            vscode.window.showWarningMessage(err.toString());
+          }),
+        );
+        await Promise.allSettled(runningRangePromises);
+      } else if (!testsToRun.implicitAll) {
         const splittedForFramework = this._splitTests(testsToRunFinal);
         const splittedForMultirun = splittedForFramework.flatMap(v => this._splitTestSetForMultirunIfEnabled(v));
         const splittedFinal = splittedForMultirun.flatMap(b =>
@@ -747,18 +904,80 @@ export abstract class AbstractExecutable<TestT extends AbstractTest = AbstractTe
     }
   }
 
+  /**
+   * Sharding is used only if every (not skipped) test of the executable is going to be run:
+   * the shards run without filter arguments so there is no need to build and match huge filter lists.
+   */
+  private _getShardCount(testsToRun: TestsToRun, testsToRunFinal: readonly AbstractTest[]): number {
+    const parallelizationLimit = this.shared.parallelizationPool.maxTaskCount;
+    if (parallelizationLimit <= 1 || this.shared.dynamicTestDispatch || testsToRun.direct.length > 0) return 1;
+
+    let runnableCount = 0;
+    for (const test of this._tests.values()) {
+      if (!test.hasStaticError && !test.skipped) ++runnableCount;
+    }
+
+    if (!testsToRun.implicitAll && testsToRunFinal.length !== runnableCount) return 1;
+
+    let shardCount = parallelizationLimit;
+    if (this.shared.maxTestsPerExecutable !== null) {
+      shardCount = Math.max(shardCount, Math.ceil(runnableCount / this.shared.maxTestsPerExecutable));
+    }
+    return Math.min(shardCount, runnableCount);
+  }
+
+  private _isDynamicDispatchEnabled(): boolean {
+    return this.shared.dynamicTestDispatch && this.shared.parallelizationPool.maxTaskCount > 1;
+  }
+
+  /**
+   * Instead of static buckets every parallel worker takes the next batch from a shared queue
+   * when its previous process has finished. The batch size adapts to the observed test durations.
+   */
+  private async _runDynamically(
+    data: TestRunData,
+    tests: readonly AbstractTest[],
+    workspaceTaskPool: TaskPool,
+  ): Promise<void> {
+    const workerCount = Math.min(tests.length, this.shared.parallelizationPool.maxTaskCount);
+    const queue = new AdaptiveBatchQueue(tests, workerCount, this.shared.maxTestsPerExecutable, t =>
+      this.getRecordedTestDuration(t),
+    );
+
+    this.shared.log.info('Dynamic test dispatch of the same executable is enabled.', tests.length, workerCount);
+
+    const worker = async (): Promise<void> => {
+      while (!queue.isEmpty && !data.testRun.token.isCancellationRequested) {
+        const batch = queue.next();
+        for (const subset of this._splitTestsToSmallEnoughSubsetsAndRemoveLooLongIds(batch, data.testRun)) {
+          await this._runInner(data, subset, workspaceTaskPool, elapsedMilisec =>
+            queue.reportBatch(subset.length, elapsedMilisec),
+          );
+        }
+      }
+    };
+
+    const workers: Promise<void>[] = [];
+    for (let i = 0; i < workerCount; ++i) workers.push(worker());
+    await Promise.all(workers);
+  }
+
   private _runInner(
     data: TestRunData,
     testsToRun: readonly AbstractTest[] | null,
     workspaceTaskPool: TaskPool,
+    onProcessFinished?: (elapsedMilisec: number) => void,
+    shard?: ShardParams,
   ): Promise<void> {
     return combine(data.taskPoolForExecutables.get(this), this.shared.parallelizationPool).scheduleTask(async () => {
-      const runIfNotCancelled = (): Promise<void> => {
+      const runIfNotCancelled = async (): Promise<void> => {
         if (data.testRun.token.isCancellationRequested) {
           this.shared.log.info('test was canceled:', this);
-          return Promise.resolve();
+          return;
         }
-        return this._runProcess(data, testsToRun);
+        const start = Date.now();
+        await this._runProcess(data, testsToRun, shard);
+        onProcessFinished?.(Date.now() - start);
       };
 
       try {
@@ -782,46 +1001,69 @@ export abstract class AbstractExecutable<TestT extends AbstractTest = AbstractTe
    * we should use this function which will make sure we are not working on the original file
    * if the feature is enabled
    */
-  protected async _getPathForExecution(): Promise<string> {
+  protected _getPathForExecution(): Promise<string> {
     if (!this.shared.executableCloning) {
-      return this.shared.path;
-    }
-    const origModiTime = await getModiTime(this.shared.path);
-    if (origModiTime === undefined) {
-      return this.shared.path; // no file exists, nothing to do
+      return Promise.resolve(this.shared.path);
     }
+    return this.shared.shared.execClonePool.getClone(this.shared.path);
+  }
 
-    const clonePath = ExecCloner.generateClonePath(this.shared.path);
-    const cloneModiTime = await getModiTime(clonePath);
+  private async _runProcess(
+    data: TestRunData,
+    childrenToRun: readonly AbstractTest[] | null,
+    shard: ShardParams | undefined,
+    withoutTestEvents = false,
+  ): Promise<void> {
+    let execParams = await this._getRunParams(childrenToRun);
+    if (shard?.args) execParams = execParams.concat(shard.args);
+    const pathForExecution = await this._getPathForExecution();
 
-    if (cloneModiTime === undefined || cloneModiTime < origModiTime) {
-      await fs.promises.copyFile(this.shared.path, clonePath, fs.constants.COPYFILE_FICLONE);
-    }
+    // the coverage handlers need a fresh process (env, profile files) so the worker is skipped for them
+    const usePersistentWorker = this.shared.persistentWorker && data.testRunHandler === undefined;
 
-    return clonePath;
-  }
+    let env = shard?.env ? { ...this.shared.options.env, ...shard.env } : this.shared.options.env;
 
-  private async _runProcess(data: TestRunData, childrenToRun: readonly AbstractTest[] | null): Promise<void> {
-    const execParams = await this._getRunParams(childrenToRun);
-    const pathForExecution = await this._getPathForExecution();
+    // the forked children of the worker would inherit the worker's descriptors.
+    // the extra pipe is opened only for the reporter: a daemon inheriting it would keep the run open.
+    const testEventsParams =
+      !usePersistentWorker && !withoutTestEvents && (await this._isTestEventsSupported())
+        ? this._getTestEventsRunParams(execParams)
+        : undefined;
+    if (testEventsParams) {
+      execParams = testEventsParams;
+      env = { ...env, [testEventsFdEnv]: testEventsFd.toString(), [testEventsRequestedEnv]: '1' };
+    }
 
     let builderProps: TMA.TestMateProcessBuilder = {
       cmd: pathForExecution,
       args: execParams,
       cwd: this.shared.options.cwd,
-      env: this.shared.options.env,
+      env,
     };
 
+    // only the isolated runs are attributed to tests: without filter the process runs every test together
+    if (data.testRunHandler?.isolateTests && childrenToRun !== null)
+      builderProps.testIds = childrenToRun.map(t => TestItemManager.getUniqueId(t.item));
+
     if (data.testRunHandler?.mapTestRunProcessBuilder) {
       builderProps = await data.testRunHandler.mapTestRunProcessBuilder(builderProps);
       this.shared.log.info('mapTestRunProcessBuilder', builderProps);
     }
 
+    const spawner = usePersistentWorker
+      ? this.shared.shared.persistentWorkerPool.createSpawner(this.shared.spawnerForExecution)
+      : this.shared.spawnerForExecution;
+
     const builder = new SpawnBuilder(
-      this.shared.spawnerForExecution,
+      spawner,
       builderProps.cmd,
       builderProps.args,
-      { ...this.shared.options, cwd: builderProps.cwd, env: builderProps.env },
+      {
+        ...this.shared.options,
+        cwd: builderProps.cwd,
+        env: builderProps.env,
+        stdio: testEventsParams ? ['pipe', 'pipe', 'pipe', 'pipe'] : undefined,
+      },
       undefined,
     );
 
@@ -835,7 +1077,9 @@ export abstract class AbstractExecutable<TestT extends AbstractTest = AbstractTe
 
     this.shared.log.info('proc starting', pathForExecution, execParams, this.shared.path);
 
-    const runInfo = await RunningExecutable.create(builder, childrenToRun, data.testRun.token, this.shared);
+    const runInfo = await this.shared.shared.phaseTimings.measure('spawn', this.shared.path, () =>
+      RunningExecutable.create(builder, childrenToRun, data.testRun.token, this.shared),
+    );
 
     data.testRun.appendOutput(runInfo.getProcStartLine());
 
@@ -886,15 +1130,34 @@ export abstract class AbstractExecutable<TestT extends AbstractTest = AbstractTe
       });
     }
 
+    const testEventStream = testEventsParams
+      ? (runInfo.process.stdio[testEventsFd] as Readable | null | undefined)
+      : undefined;
+
+    let runAgain = false;
     try {
-      const { unexpectedTests, expectedToRunAndFoundTests, leftBehindBuilder } = await this._handleProcess(
-        data.testRun,
-        runInfo,
-      );
+      const handled =
+        testEventsParams && testEventStream
+          ? await this._handleTestEvents(data.testRun, runInfo, testEventStream)
+          : await this._handleProcess(data.testRun, runInfo);
       const result = await runInfo.result;
 
       data.testRun.appendOutput(runInfo.getProcStopLine(result));
 
+      if (handled === undefined) {
+        // the reporter isn't active so nothing was reported: the tests are run again and their output is parsed
+        runAgain =
+          result.value !== ExecutableRunResultValue.CancelledByUser &&
+          result.value !== ExecutableRunResultValue.TimeoutByUser;
+        if (runAgain)
+          data.testRun.appendOutput(runInfo.runPrefix + '⚠️ TestMate event reporter is not active, running again.');
+      }
+
+      const { unexpectedTests, expectedToRunAndFoundTests, leftBehindBuilder, reloadNeeded } = handled ?? {
+        unexpectedTests: [],
+        expectedToRunAndFoundTests: [],
+      };
+
       if (result.value === ExecutableRunResultValue.Errored) {
         this.shared.log.warn(result.toString(), result, runInfo, this);
         data.testRun.appendOutput(runInfo.runPrefix + '❌ Executable run is finished with error.');
@@ -939,8 +1202,11 @@ export abstract class AbstractExecutable<TestT extends AbstractTest = AbstractTe
       }
 
       const hasMissingTest =
-        runInfo.childrenToRun && expectedToRunAndFoundTests.length < runInfo.childrenToRun.length && result.Ok;
-      const hasNewTest = unexpectedTests.length > 0;
+        handled !== undefined &&
+        runInfo.childrenToRun &&
+        expectedToRunAndFoundTests.length < runInfo.childrenToRun.length &&
+        result.Ok;
+      const hasNewTest = unexpectedTests.length > 0 || reloadNeeded === true;
 
       if (hasMissingTest || hasNewTest) {
         // exec probably has changed
@@ -963,6 +1229,168 @@ export abstract class AbstractExecutable<TestT extends AbstractTest = AbstractTe
     } finally {
       this.shared.log.info('proc finished:', pathForExecution);
     }
+
+    if (runAgain) await this._runProcess(data, childrenToRun, shard, true);
+  }
+
+  private async _isTestEventsSupported(): Promise<boolean> {
+    if (this.shared.testEvents !== undefined) return this.shared.testEvents;
+    const modiTime = await getModiTime(this.shared.path);
+    if (modiTime === undefined) return false;
+    if (this._testEventsSupport?.modiTime !== modiTime) {
+      const supported = hasTestEventsReporter(this.shared.path, this.shared.log);
+      this._testEventsSupport = { modiTime, supported };
+      supported.then(s => s && this.shared.log.info('TestMate event reporter has been detected', this.shared.path));
+    }
+    return this._testEventsSupport.supported;
+  }
+
+  /**
+   * @returns undefined if the reporter hasn't said hello: it isn't active, nothing was reported
+   */
+  private async _handleTestEvents(
+    testRun: vscode.TestRun,
+    runInfo: RunningExecutable,
+    eventStream: Readable,
+  ): Promise<HandleProcessResult | undefined> {
+    const expectedToRunAndFoundTests: AbstractTest[] = [];
+    let reloadNeeded = false;
+    let saidHello = false;
+    let builder: TestResultBuilder | undefined = undefined;
+    // the builders of the entered sections, the innermost is the last
+    const sectionBuilders: TestResultBuilder[] = [];
+    const sectionTrees: SubTestTree[] = [];
+    const currentBuilder = (): TestResultBuilder | undefined => sectionBuilders.at(-1) ?? builder;
+
+    const parser = new TestEventParser(this.shared.log, (event: TestEvent): void | Promise<void> => {
+      switch (event.type) {
+        case 'hello':
+          saidHello = true;
+          return;
+        case 'testStart': {
+          const test = this._getTest(this._getTestIdOfEvent(event));
+          builder = undefined;
+          sectionBuilders.length = 0;
+          sectionTrees.length = 0;
+          if (!test) {
+            this.shared.log.info('TestCase not found in children', event);
+            reloadNeeded = true;
+            return;
+          }
+          expectedToRunAndFoundTests.push(test);
+          builder = new TestResultBuilder(test, testRun, runInfo.runPrefix, true);
+          builder.started();
+          sectionTrees.push(new Map());
+          return;
+        }
+        case 'sectionStart':
+          if (builder) return this._startTestEventSection(currentBuilder()!, sectionTrees, sectionBuilders, event);
+          return;
+        case 'sectionEnd': {
+          const sectionBuilder = sectionBuilders.pop();
+          if (!sectionBuilder) return;
+          sectionTrees.pop();
+          sectionBuilder.setDurationMilisec(event.durationMs);
+          sectionBuilder[event.result]();
+          sectionBuilder.build();
+          return;
+        }
+        case 'failure': {
+          const b = currentBuilder();
+          if (b) return this._addTestEventFailure(b, event);
+          return;
+        }
+        case 'testEnd':
+          if (!builder) return;
+          for (const sectionBuilder of sectionBuilders.splice(0)) {
+            sectionBuilder.errored();
+            sectionBuilder.build();
+          }
+          // if a subtest is run then not all the sections arrive: the missing ones weren't run
+          if (runInfo.childrenToRun) {
+            if (runInfo.childrenToRun.length !== 1 || !(runInfo.childrenToRun[0] instanceof SubTest))
+              builder.test.removeMissingSubTests(sectionTrees[0]);
+          }
+          builder.setDurationMilisec(event.durationMs);
+          builder[event.result]();
+          builder.build();
+          builder = undefined;
+          return;
+      }
+    });
+
+    // the output of the tests isn't captured by the reporter, it is shown as it is
+    let outputRest = '';
+    const outputParser: ParserInterface = {
+      write: (data: string): void => {
+        const lastNewline = data.lastIndexOf('\n');
+        if (lastNewline === -1) {
+          outputRest += data;
+          return;
+        }
+        addOutputForTestRun(testRun, runInfo.runPrefix, 0, 0, false, outputRest + data.substring(0, lastNewline));
+        outputRest = data.substring(lastNewline + 1);
+      },
+      end: async (): Promise<void> => {
+        if (outputRest) addOutputForTestRun(testRun, runInfo.runPrefix, 0, 0, false, outputRest);
+      },
+      writeStdErr: (): Promise<boolean> => Promise.resolve(false),
+    };
+
+    await Promise.all([
+      pipeOutputStreams2Parser(runInfo.process.stdout, runInfo.process.stderr, outputParser, (data: string) =>
+        this.processStdErr(testRun, runInfo.runPrefix, data),
+      ),
+      pipeProcess2Parser(runInfo, parser, undefined, eventStream, undefined),
+    ]);
+
+    if (!saidHello) {
+      this.shared.log.warn('TestMate event reporter has not said hello', this.shared.path);
+      // the signature was found but the reporter isn't active: the next runs are parsed as usual
+      if (this._testEventsSupport) this._testEventsSupport.supported = Promise.resolve(false);
+      return undefined;
+    }
+
+    return {
+      unexpectedTests: [],
+      expectedToRunAndFoundTests,
+      leftBehindBuilder: builder,
+      reloadNeeded,
+    };
+  }
+
+  private async _startTestEventSection(
+    parentBuilder: TestResultBuilder,
+    sectionTrees: SubTestTree[],
+    sectionBuilders: TestResultBuilder[],
+    event: TestEventSectionStart,
+  ): Promise<void> {
+    const file = await this.findSourceFilePath(event.file);
+    const line = event.line?.toString();
+    const subTest = await parentBuilder.test.getOrCreateSubTest(event.name, undefined, file, line, true);
+    const sectionBuilder = parentBuilder.createSubTestBuilder(subTest);
+    sectionBuilder.started();
+    sectionBuilders.push(sectionBuilder);
+
+    const parentTree = sectionTrees.at(-1)!;
+    let tree = parentTree.get(event.name);
+    if (tree === undefined) {
+      tree = new Map();
+      parentTree.set(event.name, tree);
+    }
+    sectionTrees.push(tree);
+  }
+
+  private async _addTestEventFailure(builder: TestResultBuilder, event: TestEventFailure): Promise<void> {
+    const message = event.message ? [event.message] : [];
+    const line = event.line?.toString();
+    if (event.expr !== undefined && event.expanded !== undefined) {
+      await builder.addExpressionMsg(event.file, line, event.expr, event.expanded, event.macro, ...message);
+    } else {
+      const title = event.kind === 'exception' ? 'Exception was thrown' : (event.macro ?? 'Failure');
+      await builder.addMessageWithOutput(event.file, line, title, ...message);
+    }
+    builder.failed();
   }
 
   async runTasks(
@@ -997,106 +1425,25 @@ export abstract class AbstractExecutable<TestT extends AbstractTest = AbstractTe
     }
   }
 
-  async findSourceFilePath(file: string | undefined): Promise<string | undefined> {
-    if (typeof file != 'string') return undefined;
-
-    // normalize before apply resolvedSourceFileMap because it is normalize too
-    // this is for better platform independent resolution
-    const normalizedFileInput = pathlib.normalize(file);
-    let resolved = normalizedFileInput;
-    const keys = Object.keys(this.shared.resolvedSourceFileMap);
-    if (keys.length > 0) {
-      // REMARK: this logic dos not guarantee that the `normalizedFileInput` is actually absolute
-      // we just assume that most ofe the cases it is relative.
-      let relativeFileInput = normalizedFileInput;
-      let absoluteFileInput = normalizedFileInput;
-      if (pathlib.isAbsolute(normalizedFileInput)) {
-        relativeFileInput = pathlib.relative(this.shared.workspacePath, normalizedFileInput);
-      } else {
-        absoluteFileInput = pathlib.join(this.shared.workspacePath, normalizedFileInput);
-      }
+  findSourceFilePath(file: string | undefined): Promise<string | undefined> {
+    if (typeof file != 'string') return Promise.resolve(undefined);
 
-      const strategyKey = '$strategy';
-      const strategy = this.shared.resolvedSourceFileMap[strategyKey] ?? 'legacy';
-      if (strategy === 'legacy') {
-        resolved = normalizedFileInput;
-        for (const m of keys) {
-          if (m === strategyKey) continue;
-          resolved = resolved.replace(m, this.shared.resolvedSourceFileMap[m]); // Note: it just replaces the first occurence
-        }
-      } else if (strategy === 'starts-with') {
-        for (const m of keys) {
-          if (m === strategyKey) continue;
-          if (pathlib.isAbsolute(m)) {
-            if (absoluteFileInput.startsWith(m)) {
-              resolved = absoluteFileInput.replace(m, this.shared.resolvedSourceFileMap[m]); // Note: it just replaces the first occurence
-              break;
-            }
-          } else {
-            if (relativeFileInput.startsWith(m)) {
-              resolved = relativeFileInput.replace(m, this.shared.resolvedSourceFileMap[m]); // Note: it just replaces the first occurence
-              break;
-            }
-          }
-        }
-      } else if (strategy === 'replace-first') {
-        for (const m of keys) {
-          if (m === strategyKey) continue;
-          if (pathlib.isAbsolute(m)) {
-            if (absoluteFileInput.includes(m)) {
-              resolved = absoluteFileInput.replace(m, this.shared.resolvedSourceFileMap[m]); // Note: it just replaces the first occurence
-              break;
-            }
-          } else {
-            if (relativeFileInput.includes(m)) {
-              resolved = relativeFileInput.replace(m, this.shared.resolvedSourceFileMap[m]); // Note: it just replaces the first occurence
-              break;
-            }
-          }
-        }
-      } else if (strategy === 'regex-relative') {
-        for (const m of keys) {
-          if (m === strategyKey) continue;
-          const match = applyRegexpWithSubstitution(
-            new RegExp(m),
-            relativeFileInput,
-            this.shared.resolvedSourceFileMap[m],
-          );
-          if (match !== null) {
-            resolved = match;
-            break;
-          }
-        }
-      } else if (strategy === 'regex-absolute') {
-        for (const m of keys) {
-          if (m === strategyKey) continue;
-          const match = applyRegexpWithSubstitution(
-            new RegExp(m),
-            absoluteFileInput,
-            this.shared.resolvedSourceFileMap[m],
-          );
-          if (match !== null) {
-            resolved = match;
-            break;
-          }
-        }
-      } else {
-        this.log.errorS('unexpected strategy', strategy);
-      }
+    if (this._sourceFileResolver === undefined) {
+      this._sourceFileResolver = new SourceFileResolver(
+        this.shared.log,
+        this.shared.resolvedSourceFileMap,
+        this.shared.workspacePath,
+        this._getDirectoriesToCheck(),
+      );
     }
 
-    resolved = await this._findFilePath(resolved);
-
-    this.shared.log.debug('findSourceFilePath:', file, '=>', resolved);
-
-    resolved = pathlib.normalize(resolved);
-
-    return resolved;
+    return this._sourceFileResolver.resolve(file);
   }
 
-  private async _findFilePath(path: string): Promise<string> {
-    if (pathlib.isAbsolute(path)) return path;
+  private _sourceFileResolver: SourceFileResolver | undefined = undefined;
 
+  // for the relative paths of the outputs
+  private _getDirectoriesToCheck(): string[] {
     const directoriesToCheck: string[] = [];
 
     const cwd = this.shared.options.cwd?.toString();
@@ -1114,9 +1461,7 @@ export abstract class AbstractExecutable<TestT extends AbstractTest = AbstractTe
 
     directoriesToCheck.push(pathlib.dirname(this.shared.path));
 
-    const found = await getAbsolutePath(path, directoriesToCheck);
-
-    return found || path;
+    return directoriesToCheck;
   }
 
   protected processStdErr(testRun: vscode.TestRun, runPrefix: string, str: string): void {
@@ -1133,10 +1478,17 @@ export abstract class AbstractExecutable<TestT extends AbstractTest = AbstractTe
   }
 }
 
+export interface ShardParams {
+  env?: Record<string, string>;
+  args?: string[];
+}
+
 export interface HandleProcessResult {
   unexpectedTests: readonly Readonly<AbstractTest>[];
   expectedToRunAndFoundTests: readonly Readonly<AbstractTest>[];
   leftBehindBuilder?: Readonly<TestResultBuilder<AbstractTest>>;
+  // the output contained a test which is unknown but it couldn't be created from the output
+  reloadNeeded?: boolean;
 }
 
 class ExecutableGroup {
@@ -1226,17 +1578,3 @@ export class TestsToRun {
     for (const i of this.parent) yield i;
   }
 }
-
-///
-
-export class ExecCloner {
-  private constructor() {}
-
-  public static readonly prefix = '.';
-  public static readonly suffix = '.TestMate.execClone.tmp';
-
-  public static generateClonePath(path: string): string {
-    const { dir, base } = pathlib.parse(path);
-    return pathlib.join(dir, this.prefix + base + this.suffix);
-  }
-}
@@ -102,6 +102,9 @@ export abstract class AbstractTest {
 
   private _skipReported = false;
 
+  // the executables with failed tests are reloaded first after a rebuild
+  lastRunFailed = false;
+
   reportIfSkippedFirstOnly(testRun: vscode.TestRun): boolean {
     const skipped = this.skipped;
     if (!this._skipReported && skipped) {
@@ -1,10 +1,9 @@
 import * as vscode from 'vscode';
-import * as fs from 'fs';
-import { inspect, promisify } from 'util';
+import { inspect } from 'util';
 
 import { XmlParser, XmlTag, XmlTagProcessor } from '../../util/XmlParser';
 import { SharedVarOfExec } from '../SharedVarOfExec';
-import { AbstractExecutable, HandleProcessResult } from '../AbstractExecutable';
+import { AbstractExecutable, HandleProcessResult, ShardParams } from '../AbstractExecutable';
 import { Catch2Test } from './Catch2Test';
 import { RunningExecutable } from '../../RunningExecutable';
 import { AbstractTest, SubTest, SubTestTree } from '../AbstractTest';
@@ -15,6 +14,11 @@ import { assert, debugBreak } from '../../util/DevelopmentHelper';
 import { pipeOutputStreams2Parser, pipeOutputStreams2String, pipeProcess2Parser } from '../../util/ParserInterface';
 import { Readable } from 'stream';
 
+///
+
+// `--shard-count` and `--shard-index` arrived after the v3 previews (all of them report 3.0.0)
+const ShardingSupport = new Version(3, 0, 1);
+
 export class Catch2Executable extends AbstractExecutable<Catch2Test> {
   constructor(
     sharedVarOfExec: SharedVarOfExec,
@@ -211,21 +215,15 @@ export class Catch2Executable extends AbstractExecutable<Catch2Test> {
   };
 
   protected async _reloadChildren(cancellationFlag: CancellationFlag): Promise<void> {
-    const cacheFile = this.shared.path + `.TestMate.testListCache.${this.shared.optionsHash}.txt`;
+    const isXml = this._catch2Version !== undefined && this._catch2Version.major >= 3;
+    const cacheFormat = isXml ? 'xml' : 'txt';
 
-    if (this.shared.enabledTestListCaching) {
+    const cached = await this._loadTestListFromCache(cacheFormat);
+    if (cached !== undefined) {
       try {
-        const cacheStat = await promisify(fs.stat)(cacheFile);
-        const execStat = await promisify(fs.stat)(this.shared.path);
-
-        if (cacheStat.size > 0 && cacheStat.mtime > execStat.mtime) {
-          this.shared.log.info('loading from cache: ', cacheFile);
-          const stream = fs.createReadStream(cacheFile, 'utf8');
-
-          if (this._catch2Version && this._catch2Version.major >= 3)
-            await this._reloadFromXml(stream, cancellationFlag);
-          else await this._reloadFromString(stream, cancellationFlag);
-        }
+        const stream = Readable.from([cached]);
+        if (isXml) return await this._reloadFromXml(stream, cancellationFlag);
+        else return await this._reloadFromString(stream, cancellationFlag);
       } catch (e) {
         this.shared.log.warn('coudnt use cache', e);
       }
@@ -234,7 +232,7 @@ export class Catch2Executable extends AbstractExecutable<Catch2Test> {
     const prependTestListingArgs = await Promise.all(this.shared.prependTestListingArgs.map(x => this.resolveText(x)));
     const args = prependTestListingArgs.concat(['[.],*', '--verbosity', 'high', '--list-tests']);
 
-    if (this._catch2Version && this._catch2Version.major >= 3) args.push('--reporter', 'xml');
+    if (isXml) args.push('--reporter', 'xml');
     else args.push('--use-colour', 'no');
 
     const pathForExecution = await this._getPathForExecution();
@@ -245,19 +243,18 @@ export class Catch2Executable extends AbstractExecutable<Catch2Test> {
       this.shared.options,
     );
 
-    const result =
-      this._catch2Version && this._catch2Version.major >= 3
-        ? await this._reloadFromXml(catch2TestListingProcess.stdout, cancellationFlag)
-        : await this._reloadFromString(catch2TestListingProcess.stdout, cancellationFlag);
-
+    // decoded at once: a multi-byte character of a test name can be split between chunks
+    const stdoutChunks: Buffer[] = [];
     if (this.shared.enabledTestListCaching) {
-      const writeStream = fs.createWriteStream(cacheFile);
-      catch2TestListingProcess.stdout.pipe(writeStream);
-      writeStream.once('error', (err: Error) => {
-        this.shared.log.warn('couldnt write cache file:', err);
-      });
+      catch2TestListingProcess.stdout.on('data', (chunk: Buffer) => stdoutChunks.push(chunk));
     }
 
+    const result = isXml
+      ? await this._reloadFromXml(catch2TestListingProcess.stdout, cancellationFlag)
+      : await this._reloadFromString(catch2TestListingProcess.stdout, cancellationFlag);
+
+    this._storeTestListToCache(cacheFormat, Buffer.concat(stdoutChunks).toString('utf8'));
+
     return result;
   }
 
@@ -307,6 +304,20 @@ export class Catch2Executable extends AbstractExecutable<Catch2Test> {
     return execParams;
   }
 
+  protected override _getShardParams(shardCount: number): ShardParams[] | undefined {
+    // https://github.com/catchorg/Catch2/blob/devel/docs/command-line.md#test-sharding
+    if (this._catch2Version === undefined || this._catch2Version.smaller(ShardingSupport)) return undefined;
+    return Array.from({ length: shardCount }, (_, shardIndex) => ({
+      args: ['--shard-count', shardCount.toString(), '--shard-index', shardIndex.toString()],
+    }));
+  }
+
+  protected override _getTestEventsRunParams(runParams: readonly string[]): string[] | undefined {
+    const i = runParams.lastIndexOf('--reporter');
+    if (i === -1 || runParams[i + 1] !== 'xml') return undefined;
+    return [...runParams.slice(0, i + 1), 'testmate', ...runParams.slice(i + 2)];
+  }
+
   protected _getDebugParamsInner(childrenToRun: readonly AbstractTest[], breakOnFailure: boolean): string[] {
     const debugParams = this._getCatch2RunParams(childrenToRun);
 
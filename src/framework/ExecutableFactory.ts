@@ -13,6 +13,8 @@ import { ResolveRuleAsync } from '../util/ResolveRule';
 import { WorkspaceShared } from '../WorkspaceShared';
 import { Framework, FrameworkId, FrameworkType } from './Framework';
 import { DebugConfigData } from '../DebugConfigType';
+import { ElfFile } from '../util/Elf';
+import { Logger } from '../Logger';
 
 export class ExecutableFactory {
   constructor(
@@ -28,6 +30,9 @@ export class ExecutableFactory {
     private readonly _markAsSkipped: boolean,
     private readonly _executableRunAsImplicitAll: boolean,
     private readonly _executableCloning: boolean,
+    private readonly _dynamicTestDispatch: boolean,
+    private readonly _persistentWorker: boolean,
+    private readonly _testEvents: boolean | undefined,
     private readonly _debugConfigData: DebugConfigData | undefined,
     private readonly _executableSuffixToInclude: Set<string> | undefined,
     private readonly _executableSuffixToExclude: Set<string> | undefined,
@@ -40,21 +45,40 @@ export class ExecutableFactory {
   ) {}
 
   async create(checkIsNativeExecutable: boolean): Promise<AbstractExecutable | undefined> {
-    const runWithHelpRes = await this._shared.taskPool.scheduleTask(async () => {
-      if (checkIsNativeExecutable)
-        await c2fs.checkIsNativeExecutable(
+    const runWithHelpRes = await this._shared.taskPool.scheduleTask(() =>
+      this._shared.phaseTimings.measure('discovery', this._execPath, async () => {
+        if (checkIsNativeExecutable)
+          await c2fs.checkIsNativeExecutable(
+            this._execPath,
+            this._executableSuffixToInclude,
+            this._executableSuffixToExclude,
+          );
+
+        if (this._shared.enabledBinaryScan) {
+          const scanRes = await this._scanBinary();
+          if (scanRes !== undefined) return scanRes;
+        }
+
+        // only the beginning of the help is interesting
+        return this._spawnerForDiscovery.spawnAsync(
           this._execPath,
-          this._executableSuffixToInclude,
-          this._executableSuffixToExclude,
+          ['--help'],
+          this._execOptions,
+          this._shared.execParsingTimeout,
+          { limit: this._shared.discoveryOutputLimit },
         );
+      }),
+    );
+
+    if ('notATest' in runWithHelpRes) {
+      this._shared.log.debug('Not a test executable: no framework in the binary', this._execPath);
+      return undefined;
+    } else if ('scannedFramework' in runWithHelpRes) {
+      const scanned = runWithHelpRes.scannedFramework;
+      const frameworkSpecific = this._frameworkSpecific[Framework.map[scanned.frameworkId].type];
+      return scanned.create(await this._createSharedVarOfExec(frameworkSpecific));
+    }
 
-      return this._spawnerForDiscovery.spawnAsync(
-        this._execPath,
-        ['--help'],
-        this._execOptions,
-        this._shared.execParsingTimeout,
-      );
-    });
     // https://developer.mozilla.org/en-US/docs/Web/JavaScript/Guide/Regular_Expressions
     // s: dotAll
     // u: unicode
@@ -79,28 +103,7 @@ export class ExecutableFactory {
       }
 
       if (match) {
-        const sharedVarOfExec = new SharedVarOfExec(
-          this._shared,
-          this._execName,
-          this._execDescription,
-          this._testTags,
-          this._varToValue,
-          this._execPath,
-          this._execOptions,
-          frameworkSpecific,
-          this._parallelizationLimit,
-          this._maxTestsPerExecutable,
-          this._markAsSkipped,
-          this._executableRunAsImplicitAll,
-          this._executableCloning,
-          this._debugConfigData,
-          this._runTask,
-          this._spawnerForListing,
-          this._spawnerForExecution,
-          this._resolvedSourceFileMap,
-        );
-
-        return frameworkData.create(sharedVarOfExec, match);
+        return frameworkData.create(await this._createSharedVarOfExec(frameworkSpecific), match);
       }
     }
 
@@ -112,14 +115,108 @@ export class ExecutableFactory {
     });
     return undefined;
   }
+
+  private async _createSharedVarOfExec(frameworkSpecific: FrameworkSpecificConfig): Promise<SharedVarOfExec> {
+    const optionsHash = await hashExecOptions(this._execOptions, frameworkSpecific, this._varToValue);
+    return new SharedVarOfExec(
+      this._shared,
+      this._execName,
+      this._execDescription,
+      this._testTags,
+      this._varToValue,
+      this._execPath,
+      this._execOptions,
+      optionsHash,
+      frameworkSpecific,
+      this._parallelizationLimit,
+      this._maxTestsPerExecutable,
+      this._markAsSkipped,
+      this._executableRunAsImplicitAll,
+      this._executableCloning,
+      this._dynamicTestDispatch,
+      this._persistentWorker,
+      this._testEvents,
+      this._debugConfigData,
+      this._runTask,
+      this._spawnerForListing,
+      this._spawnerForExecution,
+      this._resolvedSourceFileMap,
+    );
+  }
+
+  private async _scanBinary(): Promise<{ scannedFramework: ScannedFramework } | { notATest: true } | undefined> {
+    // custom regex means custom help output: the signatures are not reliable
+    if (Object.values(this._frameworkSpecific).some(f => f.helpRegex)) return undefined;
+
+    const scanned = await scanBinary(this._execPath, this._shared.log);
+    if (scanned === 'notATest') return { notATest: true };
+    return scanned ? { scannedFramework: scanned } : undefined;
+  }
 }
 
+/**
+ * Classifies the executable without running it.
+ * Returns `undefined` if it is not sure and `--help` decides.
+ * The missing signatures alone don't mean anything: the framework can be linked as a shared library
+ * (its help texts are not in the executable) or the binary can be stripped.
+ * So it is `'notATest'` only if the sections could be scanned and not even a marker
+ * (namespace of the framework, name of its shared library) was found.
+ */
+export async function scanBinary(execPath: string, log: Logger): Promise<ScannedFramework | 'notATest' | undefined> {
+  const elf = await ElfFile.open(execPath);
+  if (elf === undefined) return undefined;
+
+  try {
+    const found = await elf.findInSections(scannedSections, allNeedles);
+    const candidates = frameworkIdsSorted.filter(id => frameworkDatas[id].signatures.some(sig => found.has(sig)));
+
+    log.debug('binary scan', execPath, candidates, [...found]);
+
+    if (candidates.length === 1) {
+      const frameworkId = candidates[0];
+      const create = frameworkDatas[frameworkId].createFromScan?.(found);
+      return create ? { frameworkId, create } : undefined;
+    } else if (candidates.length === 0 && found.size === 0) {
+      // without section headers (ex.: sstrip) there was nothing to scan
+      const sections = await elf.getSections();
+      return sections.some(s => scannedSections.includes(s.name)) ? 'notATest' : undefined;
+    } else {
+      return undefined;
+    }
+  } catch (e) {
+    log.warn('binary scan failed', execPath, e);
+    return undefined;
+  } finally {
+    await elf.close().catch(() => {});
+  }
+}
+
+export type ScannedFramework = Readonly<{
+  frameworkId: FrameworkId;
+  create: (sharedVarOfExec: SharedVarOfExec) => AbstractExecutable;
+}>;
+
+// part of the colour encoded help message of Google Test (`kColorEncodedHelpMessage`)
+const gtestListTestsHelp = '@G--gtest_list_tests@D';
+// v2 prints `Catch v`
+const catch2v3Help = 'Catch2 v';
+// the option exists since v3.0.1
+const catch2ShardingHelp = '--shard-count';
+
 const frameworkDatas: Record<
   FrameworkId,
   Readonly<{
     priority: number;
     regex: RegExp;
     create: (sharedVarOfExec: SharedVarOfExec, match: RegExpMatchArray) => AbstractExecutable;
+    // mangled symbols and help text fragments which can be found in the binary
+    signatures: readonly string[];
+    // not enough to tell the framework but enough to tell that the executable might be a test
+    markers: readonly string[];
+    // only if the signatures are enough to create the executable (ex.: no version is needed)
+    createFromScan?: (
+      found: ReadonlySet<string>,
+    ) => ((sharedVarOfExec: SharedVarOfExec) => AbstractExecutable) | undefined;
   }>
 > = {
   catch2: {
@@ -127,6 +224,15 @@ const frameworkDatas: Record<
     regex: /Catch2? v(\d+)\.(\d+)\.(\d+)\s?/,
     create: (sharedVarOfExec: SharedVarOfExec, match: RegExpMatchArray) =>
       new Catch2Executable(sharedVarOfExec, parseVersion123(match)),
+    signatures: ['_ZN5Catch7Session', 'Catch v', catch2v3Help, '--list-tests'],
+    markers: ['_ZN5Catch', 'libCatch2'],
+    createFromScan: (found: ReadonlySet<string>) => {
+      // v2: the minor version matters (ex.: escaping bug before 2.11.4) and it is not in the binary
+      if (!found.has(catch2v3Help)) return undefined;
+      // the lowest version which has the found features
+      const version = found.has(catch2ShardingHelp) ? new Version(3, 0, 1) : new Version(3, 0, 0);
+      return (sharedVarOfExec: SharedVarOfExec) => new Catch2Executable(sharedVarOfExec, version);
+    },
   },
   gtest: {
     priority: 20,
@@ -134,22 +240,37 @@ const frameworkDatas: Record<
       /This program contains tests written using .*--(\w+)list_tests.*List the names of all tests instead of running them/s,
     create: (sharedVarOfExec: SharedVarOfExec, match: RegExpMatchArray) =>
       new GoogleTestExecutable(sharedVarOfExec, match[1] ?? 'gtest_'),
+    signatures: ['_ZN7testing14InitGoogleTest', 'This program contains tests written using', gtestListTestsHelp],
+    markers: ['_ZN7testing', 'libgtest', 'libgmock'],
+    createFromScan: (found: ReadonlySet<string>) =>
+      found.has(gtestListTestsHelp)
+        ? (sharedVarOfExec: SharedVarOfExec) => new GoogleTestExecutable(sharedVarOfExec, 'gtest_')
+        : undefined, // the help text is in a shared lib or the flag prefix is custom
   },
   doctest: {
     priority: 30,
     regex: /doctest version is "(\d+)\.(\d+)\.(\d+)"/,
     create: (sharedVarOfExec: SharedVarOfExec, match: RegExpMatchArray) =>
       new DOCExecutable(sharedVarOfExec, parseVersion123(match)),
+    signatures: ['_ZN7doctest7Context', 'doctest version is'],
+    markers: ['_ZN7doctest'],
+    // the version is informative only: the executable does not depend on it
+    createFromScan: () => (sharedVarOfExec: SharedVarOfExec) => new DOCExecutable(sharedVarOfExec, undefined),
   },
   gbenchmark: {
     priority: 40,
     regex: /benchmark \[--benchmark_list_tests=\{true\|false\}\]/,
     create: (sharedVarOfExec: SharedVarOfExec) => new GoogleBenchmarkExecutable(sharedVarOfExec),
+    signatures: ['_ZN9benchmark22RunSpecifiedBenchmarks', 'benchmark_list_tests'],
+    markers: ['_ZN9benchmark', 'libbenchmark'],
+    createFromScan: () => (sharedVarOfExec: SharedVarOfExec) => new GoogleBenchmarkExecutable(sharedVarOfExec),
   },
   'google-insider': {
     priority: 50,
     regex: /Try --helpfull to get a list of all flags./,
     create: (sharedVarOfExec: SharedVarOfExec) => new GoogleTestExecutable(sharedVarOfExec, 'gunit_'),
+    signatures: ['Try --helpfull to get a list of all flags.'],
+    markers: ['--helpfull'],
   },
 };
 
@@ -157,6 +278,13 @@ const frameworkIdsSorted = Object.keys(frameworkDatas).sort(
   (a: string, b: string) => frameworkDatas[a as FrameworkId].priority - frameworkDatas[b as FrameworkId].priority,
 ) as ReadonlyArray<FrameworkId>;
 
+const scannedSections: readonly string[] = ['.dynstr', '.strtab', '.rodata'];
+
+const allNeedles: readonly string[] = [
+  ...new Set(frameworkIdsSorted.flatMap(id => [...frameworkDatas[id].signatures, ...frameworkDatas[id].markers])),
+  catch2ShardingHelp,
+];
+
 function parseVersion123(match: RegExpMatchArray): Version | undefined {
   const major = parseInt(match[1]);
   const minor = parseInt(match[2]);
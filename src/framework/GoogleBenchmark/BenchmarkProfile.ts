@@ -0,0 +1,110 @@
+import * as vscode from 'vscode';
+import * as TMA from '../../TestMateApi';
+import { Log } from 'vscode-test-adapter-util';
+import { create_advanced_activate } from '../../coverage/common';
+import { ElfFile } from '../../util/Elf';
+
+const configSection = 'testMate.cpp.experimental.benchmark';
+const label = 'benchmark by TestMate C++';
+
+// the symbols of libpfm: Google Benchmark supports `--benchmark_perf_counters` only if it was built with it.
+// a shared libbenchmark isn't followed: `perfCountersSupported` forces it
+const libpfmSignatures = ['libpfm.so', 'pfm_initialize'];
+
+///
+
+export class BenchmarkTestMateTestRunHandler implements TMA.TestMateTestRunHandler {
+  constructor(
+    config: vscode.WorkspaceConfiguration,
+    private readonly log: Log,
+    private readonly libpfmCache: Map<string, Promise<boolean>>,
+  ) {
+    this.allowExecutableConcurrentInvocations = config.get<boolean>('allowExecutableConcurrentInvocations', false);
+    this._repetitions = config.get<number>('repetitions', 5);
+    this._minTime = config.get<string | null>('minTime', null);
+    this._perfCounters = config.get<string[]>('perfCounters', ['CYCLES', 'INSTRUCTIONS']);
+    this._aggregatesOnly = config.get<boolean>('aggregatesOnly', true);
+    this._perfCountersSupported = config.get<boolean | undefined>('perfCountersSupported', undefined);
+  }
+
+  // the other benchmarks running in parallel would disturb the measurement
+  readonly allowExecutableConcurrentInvocations: boolean;
+  private readonly _repetitions: number;
+  private readonly _minTime: string | null;
+  private readonly _perfCounters: string[];
+  private readonly _aggregatesOnly: boolean;
+  private readonly _perfCountersSupported: boolean | undefined;
+
+  async mapTestRunProcessBuilder(builder: TMA.TestMateProcessBuilder): Promise<TMA.TestMateProcessBuilder> {
+    // only the Google Benchmark executables are affected
+    if (!builder.args.includes('--benchmark_format=json')) return builder;
+
+    const has = (flag: string) => builder.args.some(a => a.startsWith(flag + '='));
+    const args = [...builder.args];
+
+    if (this._repetitions > 1 && !has('--benchmark_repetitions')) {
+      args.push(`--benchmark_repetitions=${this._repetitions}`);
+      if (this._aggregatesOnly && !has('--benchmark_report_aggregates_only'))
+        args.push('--benchmark_report_aggregates_only=true');
+    }
+
+    if (this._minTime && !has('--benchmark_min_time')) args.push(`--benchmark_min_time=${this._minTime}`);
+
+    if (this._perfCounters.length > 0 && !has('--benchmark_perf_counters')) {
+      if (await this._hasLibpfm(builder.cmd)) args.push(`--benchmark_perf_counters=${this._perfCounters.join(',')}`);
+      else this.log.info('perf counters are not supported', builder.cmd);
+    }
+
+    return { ...builder, args };
+  }
+
+  private _hasLibpfm(cmd: string): Promise<boolean> {
+    if (this._perfCountersSupported !== undefined) return Promise.resolve(this._perfCountersSupported);
+    if (process.platform !== 'linux') return Promise.resolve(false);
+
+    let result = this.libpfmCache.get(cmd);
+    if (result === undefined) {
+      result = (async () => {
+        const elf = await ElfFile.open(cmd);
+        if (elf === undefined) return false;
+        try {
+          return (await elf.findInSections(['.dynstr', '.strtab'], libpfmSignatures)).size > 0;
+        } catch (e) {
+          this.log.warn('libpfm detection', cmd, e);
+          return false;
+        } finally {
+          await elf.close().catch(() => {});
+        }
+      })();
+      this.libpfmCache.set(cmd, result);
+    }
+    return result;
+  }
+}
+
+class TestMateAdapter implements TMA.TestMateTestRunProfileAdapter {
+  constructor(private readonly log: Log) {}
+
+  label = label;
+  kind = vscode.TestRunProfileKind.Run;
+  tag?: vscode.TestTag = undefined;
+
+  // the executables can be rebuilt with or without libpfm: it is checked again after a reload of the window
+  private readonly _libpfmCache = new Map<string, Promise<boolean>>();
+
+  createTestRunHandler(
+    _testRun: TMA.TestMateTestRun,
+    workspaceFolder: vscode.WorkspaceFolder,
+  ): TMA.TestMateTestRunHandler {
+    // these configs don't need reload, will be applied for future runs
+    const config = vscode.workspace.getConfiguration(configSection, workspaceFolder);
+    return new BenchmarkTestMateTestRunHandler(config, this.log, this._libpfmCache);
+  }
+
+  dispose(): void {}
+}
+
+/**
+ * Runs the Google Benchmark executables with repetitions and hardware performance counters.
+ */
+export const advanced_activate = create_advanced_activate(configSection, label, log => new TestMateAdapter(log));
@@ -1,9 +1,16 @@
 import * as vscode from 'vscode';
-import * as fs from 'fs';
-import { promisify } from 'util';
+import * as readline from 'readline';
+import { Readable } from 'stream';
 
 import { AbstractExecutable, HandleProcessResult } from '../AbstractExecutable';
 import { GoogleBenchmarkTest } from './GoogleBenchmarkTest';
+import { createBenchmarkTable, formatNs, getTimeUnitMultiplier } from './GoogleBenchmarkTable';
+import {
+  BenchmarkGroupCollector,
+  BenchmarkGroupShape,
+  complexityAggregates,
+  getBenchmarkName,
+} from './GoogleBenchmarkGroups';
 import { SharedVarOfExec } from '../SharedVarOfExec';
 import { RunningExecutable } from '../../RunningExecutable';
 import { AbstractTest } from '../AbstractTest';
@@ -12,12 +19,24 @@ import { TestGroupingConfig } from '../../TestGroupingInterface';
 import { TestResultBuilder } from '../../TestResultBuilder';
 import { Logger } from '../../Logger';
 import { TestItemParent } from '../../TestItemManager';
+import { JsonStreamParser } from '../../util/JsonStreamParser';
+import { pipeProcess2Parser } from '../../util/ParserInterface';
+import {
+  BenchmarkSamples,
+  compareToBaseline,
+  getBenchmarkContextKey,
+  getSampleStats,
+  SampleStats,
+} from '../../util/BenchmarkBaselineStore';
 
 export class GoogleBenchmarkExecutable extends AbstractExecutable<GoogleBenchmarkTest> {
   constructor(sharedVarOfExec: SharedVarOfExec) {
     super(sharedVarOfExec, 'GoogleBenchmark', undefined);
   }
 
+  // the shape of the last reported group by benchmark: the custom statistics are set per benchmark
+  private readonly _groupShapes = new Map<string /*name*/, BenchmarkGroupShape>();
+
   private getTestGrouping(): TestGroupingConfig {
     if (this.shared.testGrouping) {
       return this.shared.testGrouping;
@@ -27,7 +46,6 @@ export class GoogleBenchmarkExecutable extends AbstractExecutable<GoogleBenchmar
     }
   }
 
-  //TODO:release streaming would be more efficient
   private async _reloadFromString(stdOutStr: string, cancellationFlag: CancellationFlag): Promise<void> {
     const lines = stdOutStr.split(/\r?\n/);
 
@@ -40,6 +58,20 @@ export class GoogleBenchmarkExecutable extends AbstractExecutable<GoogleBenchmar
     }
   }
 
+  private async _reloadFromStream(stdOut: Readable, cancellationFlag: CancellationFlag): Promise<void> {
+    const lines = readline.createInterface({ input: stdOut, crlfDelay: Infinity });
+    try {
+      for await (const line of lines) {
+        if (cancellationFlag.isCancellationRequested) return;
+
+        if (line.length > 0) this._createAndAddTest(line);
+      }
+    } finally {
+      lines.close();
+      stdOut.destroy();
+    }
+  }
+
   private readonly _createAndAddTest = (testId: string): Promise<GoogleBenchmarkTest> => {
     return this._createTreeAndAddTest(
       this.getTestGrouping(),
@@ -55,19 +87,10 @@ export class GoogleBenchmarkExecutable extends AbstractExecutable<GoogleBenchmar
   };
 
   protected async _reloadChildren(cancellationFlag: CancellationFlag): Promise<void> {
-    const cacheFile = this.shared.path + `.TestMate.testListCache.${this.shared.optionsHash}.xml`;
-
-    if (this.shared.enabledTestListCaching) {
+    const cached = await this._loadTestListFromCache('txt');
+    if (cached !== undefined) {
       try {
-        const cacheStat = await promisify(fs.stat)(cacheFile);
-        const execStat = await promisify(fs.stat)(this.shared.path);
-
-        if (cacheStat.size > 0 && cacheStat.mtime > execStat.mtime) {
-          this.shared.log.info('loading from cache: ', cacheFile);
-          const str = await promisify(fs.readFile)(cacheFile, 'utf8');
-
-          return await this._reloadFromString(str, cancellationFlag);
-        }
+        return await this._reloadFromString(cached, cancellationFlag);
       } catch (e) {
         this.shared.log.info('coudnt use cache', e);
       }
@@ -83,26 +106,30 @@ export class GoogleBenchmarkExecutable extends AbstractExecutable<GoogleBenchmar
       args,
       this.shared.options,
       30000,
+      { limit: this.shared.shared.discoveryOutputLimit, spill: true },
     );
-
-    if (listOutput.stderr && !this.shared.ignoreTestEnumerationStdErr) {
-      this.shared.log.warn('reloadChildren -> googleBenchmarkTestListOutput.stderr: ', listOutput);
-      return await this._createAndAddUnexpectedStdError(listOutput.stdout, listOutput.stderr);
-    } else {
-      try {
+    const stdoutCapture = listOutput.stdoutCapture;
+
+    try {
+      if (listOutput.stderr && !this.shared.ignoreTestEnumerationStdErr) {
+        this.shared.log.warn('reloadChildren -> googleBenchmarkTestListOutput.stderr: ', listOutput);
+        return await this._createAndAddUnexpectedStdError(listOutput.stdout, listOutput.stderr);
+      } else if (stdoutCapture?.isTruncated) {
+        this.shared.log.info('big test list, streaming it', stdoutCapture.size);
+        // not cached: it would be loaded into the memory
+        return await this._reloadFromStream(stdoutCapture.createReadStream(), cancellationFlag);
+      } else {
         const result = await this._reloadFromString(listOutput.stdout, cancellationFlag);
 
-        if (this.shared.enabledTestListCaching) {
-          promisify(fs.writeFile)(cacheFile, listOutput.stdout).catch(err =>
-            this.shared.log.warn('couldnt write cache file:', err),
-          );
-        }
+        this._storeTestListToCache('txt', listOutput.stdout);
 
         return result;
-      } catch (e) {
-        this.shared.log.info('GoogleBenchmark._reloadFromStdOut error', e, listOutput);
-        throw e;
       }
+    } catch (e) {
+      this.shared.log.info('GoogleBenchmark._reloadFromStdOut error', e, listOutput.stdout.length);
+      throw e;
+    } finally {
+      await stdoutCapture?.dispose();
     }
   }
 
@@ -139,76 +166,68 @@ export class GoogleBenchmarkExecutable extends AbstractExecutable<GoogleBenchmar
     const unexpectedTests: GoogleBenchmarkTest[] = [];
     const expectedToRunAndFoundTests: GoogleBenchmarkTest[] = [];
 
-    const data = new (class {
-      sequentialProcessP = Promise.resolve();
-      context: Record<string, unknown> | undefined = undefined;
-      benchmarksJson = '';
-      lastProcessedBenchmarkIndex = -1;
-    })();
-
-    const processChunk = async (chunk: string): Promise<void> => {
-      data.benchmarksJson = data.benchmarksJson + chunk;
-
-      if (data.context === undefined) {
-        const benchmarkStartIndex = data.benchmarksJson.indexOf('"benchmarks"');
-        if (benchmarkStartIndex !== -1) {
-          const contextJson = data.benchmarksJson.substring(0, benchmarkStartIndex) + '"colonfixer": null }';
-          try {
-            data.context = JSON.parse(contextJson)['context'];
-            data.benchmarksJson = '{' + data.benchmarksJson.substring(benchmarkStartIndex);
-          } catch (e) {
-            this.shared.log.errorS("couldn't parse context", e, data.benchmarksJson);
-            throw e;
-          }
-        } else {
-          return;
-        }
+    let context: Record<string, unknown> | undefined = undefined;
+
+    const processGroup = (runs: Record<string, unknown>[]): Promise<void> => {
+      const testName = getBenchmarkName(runs[0]);
+      const processTestCase = async (test: GoogleBenchmarkTest): Promise<void> => {
+        const builder = new TestResultBuilder(test, testRun, runInfo.runPrefix, true);
+        const baselineCheck = await this._checkBaseline(test, runs, context);
+        await parseAndProcessTestCase(this.shared.log, builder, runs, baselineCheck);
+      };
+
+      const test = this._getTest(testName);
+
+      if (test) {
+        expectedToRunAndFoundTests.push(test);
+        return processTestCase(test);
+      } else {
+        this.shared.log.info('Test not found in children', testName);
+        return this._createAndAddTest(testName).then(test => {
+          unexpectedTests.push(test);
+          return processTestCase(test);
+        });
       }
+    };
 
-      const finished = data.benchmarksJson.match(/\]\s*\}\s*$/) !== null;
-      const benchmarksJson = data.benchmarksJson + (finished ? '' : ']}');
-      try {
-        const benchmarks = JSON.parse(benchmarksJson)['benchmarks'] as Record<string, unknown>[];
+    const groups = new BenchmarkGroupCollector(this.shared.log, this._groupShapes);
 
-        for (let i = data.lastProcessedBenchmarkIndex + 1; i < benchmarks.length; ++i) {
+    // the elements of "benchmarks" are processed one by one, as soon as they are complete
+    const parser = new JsonStreamParser(
+      this.shared.log,
+      {
+        onvalue: (path: string, value: unknown): void | Promise<void> => {
           if (runInfo.cancellationToken.isCancellationRequested) return;
 
-          const benchmark = benchmarks[i];
-
-          if (typeof benchmark['name'] != 'string') {
-            this.shared.log.errorS('missing benchamrk[name]', benchmark);
-            continue;
+          if (path === 'context') {
+            if (typeof value === 'object' && value !== null) context = value as Record<string, unknown>;
+            return;
           }
 
-          const testName = benchmark['name'];
-          let test = this._getTest(testName);
+          if (path !== 'benchmarks[]') return;
 
-          if (!test) {
-            this.shared.log.info('Test not found in children', testName);
-            test = await this._createAndAddTest(testName);
-            unexpectedTests.push(test);
-          } else {
-            expectedToRunAndFoundTests.push(test);
+          if (typeof value !== 'object' || value === null) {
+            this.shared.log.errorS('unexpected benchmark', value);
+            return;
           }
 
-          const builder = new TestResultBuilder(test, testRun, runInfo.runPrefix, true);
-          parseAndProcessTestCase(this.shared.log, builder, benchmark);
+          const benchmark = value as Record<string, unknown>;
 
-          data.lastProcessedBenchmarkIndex = i;
-        }
-      } catch (e) {
-        this.shared.log.errorS('parinsg error', e, benchmarksJson, finished);
-      }
-    };
+          if (typeof benchmark['name'] != 'string') {
+            this.shared.log.errorS('missing benchamrk[name]', benchmark);
+            return;
+          }
 
-    runInfo.process.stdout.on('data', (chunk: Uint8Array) => {
-      data.sequentialProcessP = data.sequentialProcessP.then(() => processChunk(chunk.toLocaleString()));
-    });
-    runInfo.process.stderr.on('data', (chunk: Uint8Array) =>
-      this.processStdErr(testRun, runInfo.runPrefix, chunk.toLocaleString()),
+          const processing = groups.add(benchmark).map(processGroup);
+          if (processing.length > 0) return Promise.all(processing).then(() => {});
+        },
+      },
+      ['benchmarks'],
     );
 
-    await runInfo.result;
+    await pipeProcess2Parser(runInfo, parser, (data: string) => this.processStdErr(testRun, runInfo.runPrefix, data));
+
+    if (!runInfo.cancellationToken.isCancellationRequested) await Promise.all(groups.end().map(processGroup));
 
     return {
       unexpectedTests,
@@ -216,69 +235,202 @@ export class GoogleBenchmarkExecutable extends AbstractExecutable<GoogleBenchmar
       leftBehindBuilder: undefined, // currently we cannot detect the start of a benchmark so this we don't know
     };
   }
+
+  /**
+   * The last run of the benchmark becomes its baseline, even if it has failed as regressed.
+   * @returns false if the benchmark has no recorded run
+   */
+  acceptBaseline(test: GoogleBenchmarkTest): Promise<boolean> {
+    return this.shared.shared.benchmarkBaselineStore.accept(this._getBaselineKey(test));
+  }
+
+  private _getBaselineKey(test: GoogleBenchmarkTest): string {
+    return `${this.shared.path}#${test.id}`;
+  }
+
+  /**
+   * Compares the samples of the repetitions to the baseline: the previous not regressed run in the same context.
+   * The run is added to the history of the benchmark.
+   */
+  private async _checkBaseline(
+    test: GoogleBenchmarkTest,
+    runs: readonly Record<string, unknown>[],
+    context: Record<string, unknown> | undefined,
+  ): Promise<BaselineCheck | undefined> {
+    if (runs.some(r => r['error_occurred'])) return undefined;
+
+    const real = getSamplesNs(runs, 'real_time');
+    const cpu = getSamplesNs(runs, 'cpu_time');
+    if (real === undefined || cpu === undefined) return undefined;
+
+    const store = this.shared.shared.benchmarkBaselineStore;
+    const benchmarkKey = this._getBaselineKey(test);
+    const contextKey = getBenchmarkContextKey(context);
+    const limitPercent = this.shared.failIfRegressesPercent;
+
+    try {
+      const baseline = await store.getBaseline(benchmarkKey, contextKey);
+
+      let regressed = false;
+      const lines: string[] = [];
+      if (baseline !== undefined) {
+        const metrics: [string, BenchmarkSamples, BenchmarkSamples][] = [
+          ['real_time', baseline.real, real],
+          ['cpu_time', baseline.cpu, cpu],
+        ];
+        for (const [key, baselineSamples, samples] of metrics) {
+          const baselineStats = getSampleStats(baselineSamples);
+          const stats = getSampleStats(samples);
+          const comparison = compareToBaseline(baselineStats, stats, limitPercent);
+          const delta = ((stats.mean - baselineStats.mean) / baselineStats.mean) * 100;
+          const slower = limitPercent !== undefined ? `slower by more than ${limitPercent}%` : 'slower';
+          const confidence =
+            comparison !== undefined
+              ? `confidence of being ${slower}: ${(comparison.confidence * 100).toFixed(1)}%`
+              : 'at least 2 repetitions are needed for the confidence';
+          lines.push(
+            `${key}: ${delta >= 0 ? '+' : ''}${delta.toFixed(1)}% (${confidence})`,
+            `  ${formatStats(baselineStats)} → ${formatStats(stats)}`,
+          );
+
+          if (comparison !== undefined && limitPercent !== undefined && comparison.confidence >= regressionConfidence) {
+            regressed = true;
+          }
+        }
+      }
+
+      await store.add(benchmarkKey, { context: contextKey, time: Date.now(), regressed, real, cpu });
+
+      if (baseline === undefined) return undefined;
+
+      const since = new Date(baseline.time).toLocaleString();
+      const title = regressed
+        ? `❌ Failed: slower than the baseline (${since}) by more than ${limitPercent}%.`
+        : `Compared to the baseline (${since}):`;
+      return { regressed, title, lines };
+    } catch (e) {
+      this.shared.log.exceptionS(e, 'benchmark baseline', benchmarkKey);
+      return undefined;
+    }
+  }
+}
+
+interface BaselineCheck {
+  regressed: boolean;
+  title: string;
+  lines: string[];
+}
+
+// the confidence of the Welch's t-test above which a slowdown is a regression
+const regressionConfidence = 0.99;
+
+const isLimitedAggregate = (metric: Record<string, unknown>): boolean =>
+  ['mean', 'median', ...complexityAggregates].includes(metric['aggregate_name'] as string);
+
+/**
+ * @returns the samples of the repetitions in nanoseconds, or their statistics if only the aggregates were reported
+ */
+function getSamplesNs(runs: readonly Record<string, unknown>[], key: string): BenchmarkSamples | undefined {
+  const samples: number[] = [];
+  for (const run of runs) {
+    if (run['run_type'] !== 'aggregate' && typeof run[key] === 'number') {
+      samples.push((run[key] as number) * getTimeUnitMultiplier(run)[0]);
+    }
+  }
+  if (samples.length > 0) return samples;
+
+  const getAggregate = (name: string): Record<string, unknown> | undefined =>
+    runs.find(r => r['run_type'] === 'aggregate' && r['aggregate_name'] === name && typeof r[key] === 'number');
+  const mean = getAggregate('mean');
+  const stddev = getAggregate('stddev');
+  if (mean === undefined || stddev === undefined || typeof mean['repetitions'] !== 'number') return undefined;
+
+  return {
+    n: mean['repetitions'],
+    mean: (mean[key] as number) * getTimeUnitMultiplier(mean)[0],
+    stddev: (stddev[key] as number) * getTimeUnitMultiplier(stddev)[0],
+  };
 }
 
-function parseAndProcessTestCase(
+const formatStats = (stats: SampleStats): string =>
+  `${formatNs(stats.mean)} ± ${formatNs(stats.stddev)} (n=${stats.n})`;
+
+async function parseAndProcessTestCase(
   log: Logger,
   builder: TestResultBuilder<GoogleBenchmarkTest>,
-  metric: Record<string, unknown>,
-): void {
+  metrics: readonly Record<string, unknown>[],
+  baselineCheck: BaselineCheck | undefined,
+): Promise<void> {
   builder.started();
   builder.passed();
 
-  try {
-    if (metric['error_occurred']) {
-      builder.addReindentedOutput(1, '❌ Error occurred:', (metric['error_occurred'] as string).toString());
-      builder.errored();
-    }
+  const table = createBenchmarkTable(metrics);
 
-    const metricType = ['cpu_time', 'cpu_coefficient', 'rms'];
-    const key = metricType.find(m => metric[m]);
-    const value: number | undefined = key && typeof metric[key] === 'number' ? (metric[key] as number) : undefined;
+  for (const metric of metrics) {
+    try {
+      if (metric['error_occurred']) {
+        builder.addReindentedOutput(1, '❌ Error occurred:', (metric['error_occurred'] as string).toString());
+        builder.errored();
+      }
 
-    if (value !== undefined) {
-      const [timeUnitMultiplier, _timeUnit] = getTimeUnitMultiplier(metric);
+      const metricType = ['cpu_time', 'cpu_coefficient', 'rms'];
+      const key = metricType.find(m => metric[m]);
+      const value: number | undefined = key && typeof metric[key] === 'number' ? (metric[key] as number) : undefined;
+
+      // the spread of the repetitions (stddev, cv, ...) is not a time to be limited
+      if (value !== undefined && (metric['run_type'] !== 'aggregate' || isLimitedAggregate(metric))) {
+        const [timeUnitMultiplier, _timeUnit] = getTimeUnitMultiplier(metric);
+
+        if (
+          typeof builder.test.failIfExceedsLimitNs === 'number' &&
+          builder.test.failIfExceedsLimitNs < value * timeUnitMultiplier
+        ) {
+          builder.addReindentedOutput(
+            1,
+            `❌ Failed: "${key}" exceeded limit: ${builder.test.failIfExceedsLimitNs} ns.`,
+          );
+          builder.addReindentedOutput(1, ' ');
+          builder.failed();
+        }
+      }
 
-      if (
-        typeof builder.test.failIfExceedsLimitNs === 'number' &&
-        builder.test.failIfExceedsLimitNs < value * timeUnitMultiplier
-      ) {
-        builder.addReindentedOutput(1, `❌ Failed: "${key}" exceeded limit: ${builder.test.failIfExceedsLimitNs} ns.`);
-        builder.addReindentedOutput(1, ' ');
-        builder.failed();
+      if (table === undefined) {
+        Object.keys(metric).forEach(key => {
+          const value = metric[key];
+          const value2 = typeof value === 'string' ? '"' + value + '"' : value;
+          builder.addReindentedOutput(1, key + ': ' + value2);
+        });
+        if (metrics.length > 1) builder.addReindentedOutput(1, ' ');
       }
+    } catch (e) {
+      log.exceptionS(e, metric);
+
+      builder.addReindentedOutput(
+        1,
+        '❌ Unexpected ERROR while parsing',
+        `Exception: "${e}"`,
+        '(If you think it should work then file an issue)',
+        JSON.stringify(metric),
+      );
+
+      builder.errored();
     }
+  }
 
-    Object.keys(metric).forEach(key => {
-      const value = metric[key];
-      const value2 = typeof value === 'string' ? '"' + value + '"' : value;
-      builder.addReindentedOutput(1, key + ': ' + value2);
-    });
-  } catch (e) {
-    log.exceptionS(e, metric);
-
-    builder.addReindentedOutput(
-      1,
-      '❌ Unexpected ERROR while parsing',
-      `Exception: "${e}"`,
-      '(If you think it should work then file an issue)',
-      JSON.stringify(metric),
-    );
+  if (table !== undefined) {
+    if (typeof metrics[0]['label'] === 'string') builder.addReindentedOutput(1, 'label: ' + metrics[0]['label']);
+    builder.addReindentedOutput(1, ...table);
+  }
 
-    builder.errored();
+  if (baselineCheck !== undefined) {
+    if (baselineCheck.regressed) {
+      await builder.addMessageWithOutput(undefined, undefined, baselineCheck.title, ...baselineCheck.lines);
+      builder.failed();
+    } else {
+      builder.addReindentedOutput(1, baselineCheck.title);
+      builder.addReindentedOutput(2, ...baselineCheck.lines);
+    }
   }
 
   builder.build();
 }
-
-const getTimeUnitMultiplier = (metric: Record<string, unknown>): [number, string] => {
-  if (metric['time_unit'] === 'ns') {
-    return [1, 'ns'];
-  } else if (metric['time_unit'] === 'ms') {
-    return [1000000, 'ms'];
-  } else if (metric['time_unit'] === 'us') {
-    return [1000, 'μs'];
-  } else {
-    return [1, '?'];
-  }
-};
@@ -0,0 +1,117 @@
+import { Logger } from '../../Logger';
+
+///
+
+// an element of the `benchmarks` array of the json output
+type Metric = Record<string, unknown>;
+
+// the complexity results are reported as separate benchmarks
+export const complexityAggregates = ['BigO', 'RMS'];
+
+export interface BenchmarkGroupShape {
+  repetitions: unknown;
+  iterations: number;
+  aggregates: string[];
+}
+
+const isAggregate = (benchmark: Metric): boolean => benchmark['run_type'] === 'aggregate';
+
+const getGroupShape = (runs: readonly Metric[]): BenchmarkGroupShape => ({
+  repetitions: runs[0]['repetitions'],
+  iterations: runs.filter(r => !isAggregate(r)).length,
+  aggregates: runs.filter(isAggregate).map(r => r['aggregate_name'] as string),
+});
+
+/**
+ * The statistics are computed only from more repetitions. Their count is unknown (custom statistics), so
+ * the group is complete if it has the shape of the last report of the same benchmark with the same repetitions.
+ */
+function isGroupComplete(runs: readonly Metric[], lastShape: BenchmarkGroupShape | undefined): boolean {
+  const shape = getGroupShape(runs);
+  if (lastShape === undefined || lastShape.repetitions !== shape.repetitions)
+    return shape.aggregates.length === 0 && shape.repetitions === 1;
+  return shape.iterations === lastShape.iterations && lastShape.aggregates.every(a => shape.aggregates.includes(a));
+}
+
+/**
+ * The aggregates of a benchmark are reported together, so an other benchmark after them ends the group.
+ * The versions which don't report the repetitions cannot interleave them: the next benchmark ends the group.
+ */
+const isGroupOver = (runs: readonly Metric[]): boolean =>
+  isAggregate(runs[runs.length - 1]) || typeof runs[0]['repetitions'] !== 'number';
+
+/**
+ * The repetitions and their statistics (mean, median, stddev, cv, ...) belong to the same benchmark.
+ */
+export const getBenchmarkName = (benchmark: Metric): string =>
+  benchmark['run_type'] === 'aggregate' &&
+  typeof benchmark['run_name'] === 'string' &&
+  !complexityAggregates.includes(benchmark['aggregate_name'] as string)
+    ? benchmark['run_name']
+    : (benchmark['name'] as string);
+
+/**
+ * Groups the elements of `benchmarks` by benchmark: its repetitions and their aggregates.
+ * With `--benchmark_enable_random_interleaving` the repetitions of the benchmarks are mixed and the aggregates
+ * are reported only after all of them, so a group is buffered until its aggregates or the end of the output.
+ */
+export class BenchmarkGroupCollector {
+  /**
+   * @param _shapes the shape of the last reported group by benchmark name, it is updated by the reported groups
+   */
+  constructor(
+    private readonly _log: Logger,
+    private readonly _shapes: Map<string, BenchmarkGroupShape>,
+  ) {}
+
+  private readonly _groups = new Map<string /*name*/, Metric[]>();
+  private readonly _reported = new Set<string>();
+  private _lastName: string | undefined = undefined;
+
+  /**
+   * @returns the groups which have been completed by the benchmark
+   */
+  add(benchmark: Metric): Metric[][] {
+    const name = getBenchmarkName(benchmark);
+    const completed: Metric[][] = [];
+
+    if (this._lastName !== undefined && this._lastName !== name) {
+      const last = this._groups.get(this._lastName);
+      if (last !== undefined && isGroupOver(last)) completed.push(this._take(this._lastName));
+    }
+    this._lastName = name;
+
+    let group = this._groups.get(name);
+    if (group === undefined) {
+      if (this._reported.has(name)) {
+        // the benchmark has more aggregates than last time: it has been reported already without them
+        this._log.info('late aggregate of benchmark', name, benchmark['aggregate_name']);
+        this._shapes.delete(name);
+        return completed;
+      }
+      group = [];
+      this._groups.set(name, group);
+    }
+
+    group.push(benchmark);
+    // it is reported as soon as it is complete, not only when the next one arrives
+    if (isGroupComplete(group, this._shapes.get(name))) completed.push(this._take(name));
+
+    return completed;
+  }
+
+  /**
+   * @returns the rest of the groups at the end of the output
+   */
+  end(): Metric[][] {
+    return [...this._groups.keys()].map(name => this._take(name));
+  }
+
+  private _take(name: string): Metric[] {
+    const group = this._groups.get(name)!;
+    this._groups.delete(name);
+    this._reported.add(name);
+    this._shapes.set(name, getGroupShape(group));
+    return group;
+  }
+}
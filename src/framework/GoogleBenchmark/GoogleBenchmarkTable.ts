@@ -0,0 +1,135 @@
+// an element of the `benchmarks` array of the json output
+type Metric = Record<string, unknown>;
+
+// the fields of the json output which are not counters
+const knownFields = new Set([
+  'name',
+  'family_index',
+  'per_family_instance_index',
+  'run_name',
+  'run_type',
+  'repetitions',
+  'repetition_index',
+  'threads',
+  'iterations',
+  'real_time',
+  'cpu_time',
+  'time_unit',
+  'aggregate_name',
+  'aggregate_unit',
+  'error_occurred',
+  'error_message',
+  'label',
+  'big_o',
+  'rms',
+  'cpu_coefficient',
+  'real_coefficient',
+  'complexity_n',
+]);
+
+// the statistics of the spread: the rates are not meaningful for them
+const spreadAggregates = ['stddev', 'cv'];
+
+export const getTimeUnitMultiplier = (metric: Metric): [number, string] => {
+  if (metric['time_unit'] === 'ns') {
+    return [1, 'ns'];
+  } else if (metric['time_unit'] === 'ms') {
+    return [1000000, 'ms'];
+  } else if (metric['time_unit'] === 'us') {
+    return [1000, 'μs'];
+  } else if (metric['time_unit'] === 's') {
+    return [1000000000, 's'];
+  } else {
+    return [1, '?'];
+  }
+};
+
+export const formatNs = (ns: number): string => {
+  const abs = Math.abs(ns);
+  if (abs >= 1e9) return `${(ns / 1e9).toPrecision(4)} s`;
+  if (abs >= 1e6) return `${(ns / 1e6).toPrecision(4)} ms`;
+  if (abs >= 1e3) return `${(ns / 1e3).toPrecision(4)} μs`;
+  return `${ns.toPrecision(4)} ns`;
+};
+
+// like the console reporter of Google Benchmark
+const formatCount = (value: number): string => {
+  const abs = Math.abs(value);
+  if (abs >= 1e9) return `${(value / 1e9).toPrecision(4)}G`;
+  if (abs >= 1e6) return `${(value / 1e6).toPrecision(4)}M`;
+  if (abs >= 1e3) return `${(value / 1e3).toPrecision(4)}k`;
+  return Number.isInteger(value) ? value.toString() : value.toPrecision(4);
+};
+
+const findCounter = (counters: readonly string[], name: string): string | undefined =>
+  counters.find(c => c.toUpperCase() === name);
+
+/**
+ * Renders the results of a benchmark (its repetitions or their aggregates) as a table:
+ * times, counters (ex.: `--benchmark_perf_counters`) and the rates derived from the hardware counters.
+ * @returns undefined if the runs don't have times (ex.: complexity results)
+ */
+export function createBenchmarkTable(runs: readonly Metric[]): string[] | undefined {
+  const aggregates = runs.filter(r => r['run_type'] === 'aggregate');
+  const columns = aggregates.length > 0 ? aggregates : runs;
+  if (
+    columns.length === 0 ||
+    columns.some(c => typeof c['real_time'] !== 'number' || typeof c['cpu_time'] !== 'number')
+  )
+    return undefined;
+
+  const headers = columns.map((c, i) =>
+    typeof c['aggregate_name'] === 'string'
+      ? c['aggregate_name']
+      : columns.length === 1
+        ? 'value'
+        : `#${typeof c['repetition_index'] === 'number' ? c['repetition_index'] : i}`,
+  );
+  const isPercentage = columns.map(c => c['aggregate_unit'] === 'percentage');
+  const isSpread = columns.map(c => spreadAggregates.includes(c['aggregate_name'] as string));
+
+  const counters: string[] = [];
+  for (const column of columns) {
+    for (const key of Object.keys(column)) {
+      if (!knownFields.has(key) && typeof column[key] === 'number' && !counters.includes(key)) counters.push(key);
+    }
+  }
+
+  const rows: string[][] = [['', ...headers]];
+  type Format = (value: number, column: Metric) => string;
+  const asTime: Format = (value, column) => formatNs(value * getTimeUnitMultiplier(column)[0]);
+  const asRate: Format = value => value.toFixed(3);
+  const addRow = (label: string, getValue: (column: Metric) => number | undefined, format: Format): void => {
+    const cells = columns.map((column, i) => {
+      const value = getValue(column);
+      if (value === undefined || !Number.isFinite(value)) return '';
+      if (isPercentage[i]) return `${(value * 100).toFixed(2)}%`;
+      return format(value, column);
+    });
+    rows.push([label, ...cells]);
+  };
+  const getNumber = (column: Metric, key: string): number | undefined =>
+    typeof column[key] === 'number' ? (column[key] as number) : undefined;
+
+  addRow('real_time', c => getNumber(c, 'real_time'), asTime);
+  addRow('cpu_time', c => getNumber(c, 'cpu_time'), asTime);
+  if (aggregates.length === 0) addRow('iterations', c => getNumber(c, 'iterations'), formatCount);
+  for (const counter of counters) addRow(counter, c => getNumber(c, counter), formatCount);
+
+  // the perf counters are reported per iteration
+  const cycles = findCounter(counters, 'CYCLES');
+  const instructions = findCounter(counters, 'INSTRUCTIONS');
+  const getRate = (column: Metric, numerator: number | undefined, denominator: number | undefined) =>
+    isSpread[columns.indexOf(column)] || numerator === undefined || !denominator ? undefined : numerator / denominator;
+  if (cycles !== undefined && instructions !== undefined) {
+    addRow('IPC (instructions/cycle)', c => getRate(c, getNumber(c, instructions), getNumber(c, cycles)), asRate);
+  }
+  if (cycles !== undefined) {
+    const cpuTimeNs = (c: Metric): number | undefined =>
+      (getNumber(c, 'cpu_time') ?? NaN) * getTimeUnitMultiplier(c)[0];
+    addRow('GHz (cycles/cpu_time)', c => getRate(c, getNumber(c, cycles), cpuTimeNs(c)), asRate);
+  }
+
+  const widths = rows[0].map((_, i) => Math.max(...rows.map(r => r[i].length)));
+  return rows.map(r => r.map((cell, i) => (i === 0 ? cell.padEnd(widths[i]) : cell.padStart(widths[i]))).join('  '));
+}
@@ -3,7 +3,7 @@ import * as vscode from 'vscode';
 import { promisify } from 'util';
 import * as ansi from 'ansi-colors';
 
-import { AbstractExecutable as AbstractExecutable, HandleProcessResult } from '../AbstractExecutable';
+import { AbstractExecutable as AbstractExecutable, HandleProcessResult, ShardParams } from '../AbstractExecutable';
 import { GoogleTestTest } from './GoogleTestTest';
 import { SharedVarOfExec } from '../SharedVarOfExec';
 import { RunningExecutable } from '../../RunningExecutable';
@@ -17,6 +17,7 @@ import { assert, debugBreak } from '../../util/DevelopmentHelper';
 import { TestItemParent } from '../../TestItemManager';
 import { pipeOutputStreams2Parser, pipeOutputStreams2String, pipeProcess2Parser } from '../../util/ParserInterface';
 import { Readable } from 'stream';
+import { TestEventTestStart } from '../../util/TestEventParser';
 
 export class GoogleTestExecutable extends AbstractExecutable<GoogleTestTest> {
   constructor(
@@ -165,28 +166,22 @@ export class GoogleTestExecutable extends AbstractExecutable<GoogleTestTest> {
   };
 
   protected async _reloadChildren(cancellationToken: CancellationToken): Promise<void> {
-    const cacheFile = this.shared.path + `.TestMate.testListCache.${this.shared.optionsHash}.xml`;
-
-    if (this.shared.enabledTestListCaching) {
+    const cached = await this._loadTestListFromCache('xml');
+    if (cached !== undefined) {
       try {
-        const cacheStat = await promisify(fs.stat)(cacheFile);
-        const execStat = await promisify(fs.stat)(this.shared.path);
-
-        if (cacheStat.size > 0 && cacheStat.mtime > execStat.mtime) {
-          this.shared.log.info('loading from cache: ', cacheFile);
-          const xmlStream = fs.createReadStream(cacheFile, 'utf8');
-
-          return await this._reloadFromXml(xmlStream, cancellationToken);
-        }
+        return await this._reloadFromXml(Readable.from([cached]), cancellationToken);
       } catch (e) {
         this.shared.log.info('coudnt use cache', e);
       }
     }
 
+    // temporary output next to the executable: the spawner (ex.: remote) might not see other paths
+    const outputFile = this.shared.path + `.TestMate.testList.${this.shared.optionsHash}.xml`;
+
     const prependTestListingArgs = await Promise.all(this.shared.prependTestListingArgs.map(x => this.resolveText(x)));
     const args = prependTestListingArgs.concat([
       `--${this._argumentPrefix}list_tests`,
-      `--${this._argumentPrefix}output=xml:${cacheFile}`,
+      `--${this._argumentPrefix}output=xml:${outputFile}`,
     ]);
 
     const pathForExecution = await this._getPathForExecution();
@@ -198,27 +193,26 @@ export class GoogleTestExecutable extends AbstractExecutable<GoogleTestTest> {
     );
 
     const loadFromFileIfHas = async (): Promise<boolean> => {
-      const hasXmlFile = await promisify(fs.exists)(cacheFile);
-
-      if (hasXmlFile) {
-        const xmlStream = fs.createReadStream(cacheFile, 'utf8');
-
-        await this._reloadFromXml(xmlStream, cancellationToken);
-
-        if (!this.shared.enabledTestListCaching) {
-          fs.unlink(cacheFile, (err: Error | null) => {
-            if (err) this.shared.log.warn("Couldn't remove: ", cacheFile, err);
-          });
-        }
-
-        return true;
-      } else {
+      let content: string;
+      try {
+        content = await promisify(fs.readFile)(outputFile, 'utf8');
+      } catch {
         this.shared.log.warn(
           "Couldn't parse output file. Possibly it is an older version of Google Test framework, NAVIGATION MIGHT WON'T WORK.",
         );
 
         return false;
       }
+
+      fs.unlink(outputFile, (err: Error | null) => {
+        if (err) this.shared.log.warn("Couldn't remove: ", outputFile, err);
+      });
+
+      await this._reloadFromXml(Readable.from([content]), cancellationToken);
+
+      this._storeTestListToCache('xml', content);
+
+      return true;
     };
 
     try {
@@ -265,6 +259,22 @@ export class GoogleTestExecutable extends AbstractExecutable<GoogleTestTest> {
     return [`--${this._argumentPrefix}color=no`, ...this._getRunParamsCommon(childrenToRun)];
   }
 
+  // the listener is activated by the environment
+  protected override _getTestEventsRunParams(runParams: readonly string[]): string[] | undefined {
+    return [...runParams];
+  }
+
+  protected override _getTestIdOfEvent(event: TestEventTestStart): string {
+    return event.suite !== undefined ? `${event.suite}.${event.name}` : event.name;
+  }
+
+  protected override _getShardParams(shardCount: number): ShardParams[] | undefined {
+    // https://google.github.io/googletest/advanced.html#distributing-test-functions-to-multiple-machines
+    return Array.from({ length: shardCount }, (_, shardIndex) => ({
+      env: { GTEST_TOTAL_SHARDS: shardCount.toString(), GTEST_SHARD_INDEX: shardIndex.toString() },
+    }));
+  }
+
   protected _getDebugParamsInner(childrenToRun: readonly Readonly<AbstractTest>[], breakOnFailure: boolean): string[] {
     const colouring = this.shared.enableDebugColouring ? 'yes' : 'no';
     const debugParams = [`--${this._argumentPrefix}color=${colouring}`, ...this._getRunParamsCommon(childrenToRun)];
@@ -280,43 +290,58 @@ export class GoogleTestExecutable extends AbstractExecutable<GoogleTestTest> {
     const data = { lastBuilder: undefined as TestResultBuilder | undefined };
     // we dont need this now: const rngSeed: number | undefined = typeof this._shared.rngSeed === 'number' ? this._shared.rngSeed : undefined;
 
+    const beginTest = (test: GoogleTestTest): LineProcessor => {
+      data.lastBuilder = new TestResultBuilder(test, testRun, runInfo.runPrefix, false);
+      return new TestCaseProcessor(executable.shared, testEndRe(test.id), data.lastBuilder);
+    };
+
+    const isUninteresting = (line: string): boolean =>
+      line === '' ||
+      ['Running main()', 'Note: Google Test filter =', '[==========]', '[----------]'].some(x => line.startsWith(x));
+
+    const tearDownPrefix = '[----------] Global test environment tear-down';
+
     const parser = new TextStreamParser(
       this.shared.log,
       {
-        async online(line: string): Promise<void | LineProcessor> {
+        onlines(lines: readonly string[], start: number): number {
+          const hideUninteresting = executable.shared.shared.hideUninterestingOutput != false;
+          let output = '';
+          let i = start;
+          for (; i < lines.length; ++i) {
+            const line = lines[i];
+            if (testBeginRe.test(line) || line.startsWith(tearDownPrefix)) break;
+            if (!hideUninteresting || !isUninteresting(line)) output += runInfo.runPrefix + line + '\r\n';
+          }
+          if (output) testRun.appendOutput(output);
+          return i - start;
+        },
+
+        online(line: string): void | LineProcessor | Promise<LineProcessor> {
           const beginMatch = testBeginRe.exec(line);
           if (beginMatch) {
             const testNameAsId = beginMatch[1];
             const testName = beginMatch[3];
             const suiteName = beginMatch[2];
-            let test = executable._getTest(testNameAsId);
+            const test = executable._getTest(testNameAsId);
             if (!test) {
               log.info('TestCase not found in children', testNameAsId);
-              test = await executable._createAndAddTest(
-                testName,
-                suiteName,
-                undefined,
-                undefined,
-                undefined,
-                undefined,
-              );
-              unexpectedTests.push(test);
+              return executable
+                ._createAndAddTest(testName, suiteName, undefined, undefined, undefined, undefined)
+                .then(test => {
+                  unexpectedTests.push(test);
+                  return beginTest(test);
+                });
             } else {
               expectedToRunAndFoundTests.push(test);
+              return beginTest(test);
             }
-            data.lastBuilder = new TestResultBuilder(test, testRun, runInfo.runPrefix, false);
-            return new TestCaseProcessor(executable.shared, testEndRe(test.id), data.lastBuilder);
-          } else if (line.startsWith('[----------] Global test environment tear-down')) {
+          } else if (line.startsWith(tearDownPrefix)) {
             return executable.shared.shared.hideUninterestingOutput
               ? new NoOpLineProcessor()
               : new LambdaLineProcessor(l => testRun.appendOutput(runInfo.runPrefix + l + '\r\n'));
           } else {
-            if (
-              line === '' ||
-              ['Running main()', 'Note: Google Test filter =', '[==========]', '[----------]'].some(x =>
-                line.startsWith(x),
-              )
-            ) {
+            if (isUninteresting(line)) {
               if (executable.shared.shared.hideUninterestingOutput == false)
                 testRun.appendOutput(runInfo.runPrefix + line + '\r\n');
             } else {
@@ -385,7 +410,7 @@ class TestSuiteListingProcessor implements XmlTagProcessor {
 ///
 
 // Remark: not necessarily starts like this so do not use: ^
-const testBeginRe = /\[ RUN {6}\] ((.+)\.(.*))$/m;
+export const testBeginRe = /\[ RUN {6}\] ((.+)\.(.*))$/m;
 // Ex: "Is True[       OK ] TestCas1.test5 (0 ms)"
 // m[1] == '[       '
 // m[2] == 'OK'
@@ -402,8 +427,10 @@ const testBeginRe = /\[ RUN {6}\] ((.+)\.(.*))$/m;
 // m[5] == ', where GetParam() = 3 '
 // m[6] == '(0 ms)'
 // m[7] == '0'
-const testEndRe = (testId: string) =>
+export const testEndRe = (testId: string) =>
   new RegExp('(\\[\\s*)(\\S+)(\\s*\\] )(' + testId.replace('.', '\\.') + ')(.*)(\\(([0-9]+) ms\\))$');
+// cheap pre-checks: the regexes are expensive on the lines which don't match (most of the output)
+const isTestEndCandidate = (line: string): boolean => line.endsWith(' ms)');
 
 ///
 
@@ -418,7 +445,8 @@ class TestCaseSharedData {
 
 ///
 
-class TestCaseProcessor implements LineProcessor {
+// exported for the benchmark: test/benchmark
+export class TestCaseProcessor implements LineProcessor {
   constructor(
     shared: SharedVarOfExec,
     private readonly testEndRe: RegExp,
@@ -439,8 +467,8 @@ class TestCaseProcessor implements LineProcessor {
     this.testCaseShared.builder.addReindentedOutput(0, ansi.bold(line) + loc);
   }
 
-  async online(line: string): Promise<void | true | LineProcessor> {
-    const testEndMatch = this.testEndRe.exec(line);
+  online(line: string): void | true | LineProcessor | Promise<void | LineProcessor> {
+    const testEndMatch = isTestEndCandidate(line) ? this.testEndRe.exec(line) : null;
 
     if (testEndMatch) {
       const duration = Number(testEndMatch[7]);
@@ -485,29 +513,9 @@ class TestCaseProcessor implements LineProcessor {
       return true;
     }
 
-    const failureMatch = failureRe.exec(line);
+    const failureMatch = isFailureCandidate(line) ? failureRe.exec(line) : null;
     if (failureMatch) {
-      const type = failureMatch[6] as FailureType;
-      const file = await this.testCaseShared.builder.test.exec.findSourceFilePath(failureMatch[2]);
-      const line = failureMatch[3];
-      const fullMsg = failureMatch[5];
-      const failureMsg = failureMatch[7];
-
-      this.testCaseShared.builder.addReindentedOutput(
-        1,
-        ansi.red(type) + failureMsg + this.builder.getLocationAtStr(file, line, false),
-      );
-
-      switch (type) {
-        case 'Failure':
-        case 'error':
-          return new FailureProcessor(this.testCaseShared, file, line, fullMsg, this.testEndRe);
-        case 'EXPECT_CALL':
-          return new ExpectCallProcessor(this.testCaseShared, file, line, fullMsg);
-        default:
-          this.testCaseShared.shared.log.errorS('assertion of gtest parser', line);
-          break;
-      }
+      return this._onFailure(failureMatch, line);
     }
 
     if (line === 'Google Test trace:') {
@@ -516,6 +524,32 @@ class TestCaseProcessor implements LineProcessor {
 
     this.testCaseShared.builder.addOutput(1, line);
   }
+
+  private async _onFailure(failureMatch: RegExpExecArray, origLine: string): Promise<void | LineProcessor> {
+    const type = failureMatch[6] as FailureType;
+    const file = await this.testCaseShared.builder.test.exec.findSourceFilePath(failureMatch[2]);
+    const line = failureMatch[3];
+    const fullMsg = failureMatch[5];
+    const failureMsg = failureMatch[7];
+
+    this.testCaseShared.builder.addReindentedOutput(
+      1,
+      ansi.red(type) + failureMsg + this.builder.getLocationAtStr(file, line, false),
+    );
+
+    switch (type) {
+      case 'Failure':
+      case 'error':
+        return new FailureProcessor(this.testCaseShared, file, line, fullMsg, this.testEndRe);
+      case 'EXPECT_CALL':
+        return new ExpectCallProcessor(this.testCaseShared, file, line, fullMsg);
+      default:
+        this.testCaseShared.shared.log.errorS('assertion of gtest parser', line);
+        break;
+    }
+
+    this.testCaseShared.builder.addOutput(1, origLine);
+  }
 }
 
 // Ex:'/Users/mapek/private/vscode-catch2-test-adapter/test/cpp/gtest/gtest1.cpp:69: Failure blabla'
@@ -527,6 +561,8 @@ class TestCaseProcessor implements LineProcessor {
 // m[6] == 'Failure'
 // m[7] == ' bla bla'
 const failureRe = /^((.+)[:(]([0-9]+)\)?)(: )((Failure|EXPECT_CALL|error)(.*))$/;
+const isFailureCandidate = (line: string): boolean =>
+  line.includes(': Failure') || line.includes(': EXPECT_CALL') || line.includes(': error');
 type FailureType = 'Failure' | 'EXPECT_CALL' | 'error';
 const actualMsgPrefix = '  Actual:';
 ///
@@ -545,7 +581,7 @@ class FailureProcessor implements LineProcessor {
   private promotedMsg: string | null = null;
 
   online(line: string): void | boolean {
-    if (this.testEndRe.exec(line)) {
+    if (isTestEndCandidate(line) && this.testEndRe.exec(line)) {
       return false;
     }
     if (this.treatRemainingAsPart) {
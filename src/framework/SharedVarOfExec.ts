@@ -1,7 +1,7 @@
 import * as vscode from 'vscode';
 import { FrameworkSpecificConfig, RunTaskConfig } from '../AdvancedExecutableInterface';
 import { TestGroupingConfig } from '../TestGroupingInterface';
-import { ResolveRuleAsync } from '../util/ResolveRule';
+import { resolveAllAsync, ResolveRuleAsync } from '../util/ResolveRule';
 import { TaskPool } from '../util/TaskPool';
 import { Spawner, SpawnOptionsWithoutStdioEx } from '../Spawner';
 import { WorkspaceShared } from '../WorkspaceShared';
@@ -17,12 +17,18 @@ export class SharedVarOfExec {
     readonly varToValue: readonly ResolveRuleAsync[],
     readonly path: string,
     readonly options: SpawnOptionsWithoutStdioEx,
+    // see `hashExecOptions`
+    readonly optionsHash: string,
     private readonly _frameworkSpecific: FrameworkSpecificConfig,
     parallelizationLimit: number,
     readonly maxTestsPerExecutable: number | null,
     readonly markAsSkipped: boolean,
     readonly executableRunAsImplicitAll: boolean,
     readonly executableCloning: boolean,
+    readonly dynamicTestDispatch: boolean,
+    readonly persistentWorker: boolean,
+    // undefined: detected by the signature of the reporter in the binary
+    readonly testEvents: boolean | undefined,
     readonly debugConfigData: DebugConfigData | undefined,
     readonly runTask: RunTaskConfig,
     readonly spawnerForListing: Spawner,
@@ -30,23 +36,6 @@ export class SharedVarOfExec {
     readonly resolvedSourceFileMap: Record<string, string>,
   ) {
     this.parallelizationPool = new TaskPool(parallelizationLimit);
-    {
-      const h = createHash('md5');
-      const env = options.customEnv;
-      Object.keys(env)
-        .sort()
-        .forEach(k => h.update(`${k}=${env[k]}`));
-      if (this._frameworkSpecific.prependTestRunningArgs) {
-        h.update('prependTestRunningArgs=' + this._frameworkSpecific.prependTestRunningArgs.join('|'));
-      }
-      if (this._frameworkSpecific.prependTestDebuggingArgs) {
-        h.update('prependTestDebuggingArgs=' + this._frameworkSpecific.prependTestDebuggingArgs.join('|'));
-      }
-      if (this._frameworkSpecific.prependTestListingArgs) {
-        h.update('prependTestListingArgs=' + this._frameworkSpecific.prependTestListingArgs.join('|'));
-      }
-      this.optionsHash = h.digest('hex').substring(0, 6);
-    }
     this.shared.log.debug(
       'exec hash',
       path,
@@ -59,7 +48,6 @@ export class SharedVarOfExec {
   }
 
   readonly parallelizationPool: TaskPool;
-  readonly optionsHash: string;
 
   get testGrouping(): TestGroupingConfig | undefined {
     return this._frameworkSpecific.testGrouping;
@@ -93,6 +81,10 @@ export class SharedVarOfExec {
     return this._frameworkSpecific.failIfExceedsLimitNs;
   }
 
+  get failIfRegressesPercent(): number | undefined {
+    return this._frameworkSpecific.failIfRegressesPercent;
+  }
+
   /// accessors for shared
 
   get log() {
@@ -148,3 +140,29 @@ export class SharedVarOfExec {
     return this.shared.testNameLengthLimit;
   }
 }
+
+/**
+ * Identifies the options which affect the listing and the results: the test list cache and the durations use it.
+ * The resolved values are hashed: the same template can resolve differently in an other workspace.
+ */
+export async function hashExecOptions(
+  options: SpawnOptionsWithoutStdioEx,
+  frameworkSpecific: FrameworkSpecificConfig,
+  varToValue: readonly ResolveRuleAsync[],
+): Promise<string> {
+  const h = createHash('md5');
+  const env = await resolveAllAsync(options.customEnv, varToValue, false);
+  Object.keys(env)
+    .sort()
+    .forEach(k => h.update(`${k}=${env[k]}`));
+  h.update('cwd=' + options.cwd);
+  const args: [string, string[] | undefined][] = [
+    ['prependTestRunningArgs', frameworkSpecific.prependTestRunningArgs],
+    ['prependTestDebuggingArgs', frameworkSpecific.prependTestDebuggingArgs],
+    ['prependTestListingArgs', frameworkSpecific.prependTestListingArgs],
+  ];
+  for (const [name, value] of args) {
+    if (value) h.update(name + '=' + (await resolveAllAsync(value, varToValue, false)).join('|'));
+  }
+  return h.digest('hex').substring(0, 6);
+}
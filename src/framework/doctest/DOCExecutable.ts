@@ -1,8 +1,8 @@
 import * as vscode from 'vscode';
-import * as fs from 'fs';
-import { inspect, promisify } from 'util';
+import { inspect } from 'util';
+import { Readable } from 'stream';
 
-import { AbstractExecutable, HandleProcessResult } from '../AbstractExecutable';
+import { AbstractExecutable, HandleProcessResult, ShardParams } from '../AbstractExecutable';
 
 import { DOCTest } from './DOCTest';
 import { SharedVarOfExec } from '../SharedVarOfExec';
@@ -14,7 +14,8 @@ import { assert, debugBreak } from '../../util/DevelopmentHelper';
 import { addOutputForTestRun, TestResultBuilder } from '../../TestResultBuilder';
 import { TestItemParent } from '../../TestItemManager';
 import { AbstractTest, SubTest, SubTestTree } from '../AbstractTest';
-import { pipeProcess2Parser } from '../../util/ParserInterface';
+import { pipeOutputStreams2Parser, pipeProcess2Parser } from '../../util/ParserInterface';
+import { TestEventTestStart } from '../../util/TestEventParser';
 
 export class DOCExecutable extends AbstractExecutable<DOCTest> {
   constructor(sharedVarOfExec: SharedVarOfExec, docVersion: Version | undefined) {
@@ -31,8 +32,12 @@ export class DOCExecutable extends AbstractExecutable<DOCTest> {
     }
   }
 
-  private async _reloadFromXml(testListOutput: string, _cancellationFlag: CancellationFlag): Promise<void> {
+  // the test cases in the order of the listing: `--first` and `--last` of `--order-by=file` index this
+  private _listingOrder: DOCTest[] = [];
+
+  private async _reloadFromXml(testListOutput: string | Readable, _cancellationFlag: CancellationFlag): Promise<void> {
     const createAndAddTest = this._createAndAddTest;
+    const listingOrder: DOCTest[] = [];
 
     const parser = new XmlParser(
       this.shared.log,
@@ -42,7 +47,7 @@ export class DOCExecutable extends AbstractExecutable<DOCTest> {
             case 'TestCase':
               {
                 assert(tag.attribs.name);
-                await createAndAddTest(
+                const test = await createAndAddTest(
                   tag.attribs.name,
                   tag.attribs.testsuite, // currently doctest doesn't provide it
                   tag.attribs.filename,
@@ -50,6 +55,7 @@ export class DOCExecutable extends AbstractExecutable<DOCTest> {
                   tag.attribs.description, // currently doctest doesn't provide it
                   tag.attribs.skipped, // currently doctest doesn't provide it
                 );
+                listingOrder.push(test);
               }
               break;
             default:
@@ -66,8 +72,14 @@ export class DOCExecutable extends AbstractExecutable<DOCTest> {
       },
     );
 
-    parser.write(testListOutput);
-    await parser.end();
+    if (typeof testListOutput === 'string') {
+      parser.write(testListOutput);
+      await parser.end();
+    } else {
+      await pipeOutputStreams2Parser(testListOutput, undefined, parser, undefined);
+    }
+
+    this._listingOrder = listingOrder;
   }
 
   private readonly _createAndAddTest = async (
@@ -96,19 +108,12 @@ export class DOCExecutable extends AbstractExecutable<DOCTest> {
   };
 
   protected async _reloadChildren(cancellationFlag: CancellationFlag): Promise<void> {
-    const cacheFile = this.shared.path + `.TestMate.testListCache.${this.shared.optionsHash}.txt`;
+    this._listingOrder = [];
 
-    if (this.shared.enabledTestListCaching) {
+    const cached = await this._loadTestListFromCache('xml');
+    if (cached !== undefined) {
       try {
-        const cacheStat = await promisify(fs.stat)(cacheFile);
-        const execStat = await promisify(fs.stat)(this.shared.path);
-
-        if (cacheStat.size > 0 && cacheStat.mtime > execStat.mtime) {
-          this.shared.log.info('loading from cache: ', cacheFile);
-          const content = await promisify(fs.readFile)(cacheFile, 'utf8');
-
-          return await this._reloadFromXml(content, cancellationFlag);
-        }
+        return await this._reloadFromXml(cached, cancellationFlag);
       } catch (e) {
         this.shared.log.warn('coudnt use cache', e);
       }
@@ -119,6 +124,7 @@ export class DOCExecutable extends AbstractExecutable<DOCTest> {
       '--list-test-cases',
       '--reporters=xml',
       '--no-skip=true',
+      '--order-by=file',
       '--no-color=true',
     ]);
 
@@ -129,28 +135,36 @@ export class DOCExecutable extends AbstractExecutable<DOCTest> {
       args,
       this.shared.options,
       30000,
+      { limit: this.shared.shared.discoveryOutputLimit, spill: true },
     );
+    const stdoutCapture = docTestListOutput.stdoutCapture;
+
+    try {
+      if (docTestListOutput.stderr && !this.shared.ignoreTestEnumerationStdErr) {
+        this.shared.log.warn(
+          'reloadChildren -> docTestListOutput.stderr',
+          docTestListOutput.stdout,
+          docTestListOutput.stderr,
+          docTestListOutput.error,
+          docTestListOutput.status,
+        );
+        return await this._createAndAddUnexpectedStdError(docTestListOutput.stdout, docTestListOutput.stderr);
+      }
 
-    if (docTestListOutput.stderr && !this.shared.ignoreTestEnumerationStdErr) {
-      this.shared.log.warn(
-        'reloadChildren -> docTestListOutput.stderr',
-        docTestListOutput.stdout,
-        docTestListOutput.stderr,
-        docTestListOutput.error,
-        docTestListOutput.status,
-      );
-      return await this._createAndAddUnexpectedStdError(docTestListOutput.stdout, docTestListOutput.stderr);
-    }
+      if (stdoutCapture?.isTruncated) {
+        this.shared.log.info('big test list, streaming it', stdoutCapture.size);
+        // not cached: it would be loaded into the memory
+        return await this._reloadFromXml(stdoutCapture.createReadStream(), cancellationFlag);
+      }
 
-    const result = await this._reloadFromXml(docTestListOutput.stdout, cancellationFlag);
+      const result = await this._reloadFromXml(docTestListOutput.stdout, cancellationFlag);
 
-    if (this.shared.enabledTestListCaching) {
-      promisify(fs.writeFile)(cacheFile, docTestListOutput.stdout).catch(err =>
-        this.shared.log.warn('couldnt write cache file:', err),
-      );
-    }
+      this._storeTestListToCache('xml', docTestListOutput.stdout);
 
-    return result;
+      return result;
+    } finally {
+      await stdoutCapture?.dispose();
+    }
   }
 
   private _getDocTestRunParams(childrenToRun: readonly Readonly<AbstractTest>[] | null): string[] {
@@ -202,6 +216,110 @@ export class DOCExecutable extends AbstractExecutable<DOCTest> {
     return execParams;
   }
 
+  protected override _getShardParams(shardCount: number): ShardParams[] | undefined {
+    if (!this._canRunByRange()) return undefined;
+    return this._getRanges(this._listingOrder, shardCount)?.map(DOCExecutable._getRangeArgs);
+  }
+
+  protected override _getRangeParams(tests: readonly AbstractTest[], processCount: number): ShardParams[] | undefined {
+    // small selections keep the names: they are cheap to match and don't depend on the listing being up-to-date
+    if (!this._canRunByRange() || tests.length * 2 < this._listingOrder.length) return undefined;
+    return this._getRanges(tests, processCount)?.map(DOCExecutable._getRangeArgs);
+  }
+
+  private static _getRangeArgs([first, last]: [number, number]): ShardParams {
+    // doctest counts from 1 and `last` is inclusive
+    return { args: ['--order-by=file', `--first=${first + 1}`, `--last=${last}`] };
+  }
+
+  private static readonly _orderAffectingArgRe =
+    /^(--dt-|-)(-?)(tc|tce|ts|tse|sf|sfe|ob|rs|f|l|test-case(-exclude)?|test-suite(-exclude)?|source-file(-exclude)?|order-by|rand-seed|first|last)(=|$)/;
+
+  private _canRunByRange(): boolean {
+    return (
+      this.shared.rngSeed === null &&
+      this._listingOrder.length > 0 &&
+      this._listingOrder.length === this._tests.size &&
+      !this.shared.prependTestRunningArgs.some(arg => DOCExecutable._orderAffectingArgRe.test(arg))
+    );
+  }
+
+  /**
+   * Splits the tests into contiguous ranges of the listing order which contain only the given tests.
+   * The ranges of a segment are balanced by the recorded durations.
+   * @returns [first, last) indices or undefined if it would need more ranges than `processCount`
+   */
+  private _getRanges(tests: readonly AbstractTest[], processCount: number): [number, number][] | undefined {
+    const indexOf = new Map<AbstractTest, number>(this._listingOrder.map((t, i) => [t, i]));
+
+    const indices: number[] = [];
+    for (const test of tests) {
+      const index = indexOf.get(test);
+      if (index === undefined) return undefined; // SubTest or not listed
+      indices.push(index);
+    }
+    indices.sort((a, b) => a - b);
+
+    const segments: [number, number][] = [];
+    for (const index of indices) {
+      const last = segments.length > 0 ? segments[segments.length - 1] : undefined;
+      if (last !== undefined && last[1] === index) last[1] = index + 1;
+      else if (last === undefined || last[1] < index) segments.push([index, index + 1]);
+    }
+    if (segments.length > processCount) return undefined;
+
+    const recorded = this._listingOrder.map(t => this.getRecordedTestDuration(t));
+    const known = recorded.filter((d): d is number => d !== undefined);
+    const defaultDuration = known.length > 0 ? known.reduce((a, b) => a + b, 0) / known.length : 1;
+    const costs = recorded.map(d => Math.max(d ?? defaultDuration, Number.EPSILON));
+    const segmentCost = ([begin, end]: [number, number]): number =>
+      costs.slice(begin, end).reduce((a, b) => a + b, 0);
+
+    const maxSize = this.shared.maxTestsPerExecutable ?? Infinity;
+    const partCounts = segments.map(([begin, end]) => Math.ceil((end - begin) / maxSize));
+    for (let extra = processCount - partCounts.reduce((a, b) => a + b, 0); extra > 0; --extra) {
+      let best = -1;
+      for (let i = 0; i < segments.length; ++i) {
+        if (partCounts[i] >= segments[i][1] - segments[i][0]) continue;
+        const perPart = segmentCost(segments[i]) / partCounts[i];
+        if (best === -1 || perPart > segmentCost(segments[best]) / partCounts[best]) best = i;
+      }
+      if (best === -1) break;
+      ++partCounts[best];
+    }
+
+    const ranges: [number, number][] = [];
+    for (let i = 0; i < segments.length; ++i) {
+      const [begin, end] = segments[i];
+      const parts = partCounts[i];
+      let remainingCost = segmentCost(segments[i]);
+      let start = begin;
+      let pos = begin;
+      for (let part = 1; part < parts; ++part) {
+        const remainingParts = parts - part;
+        const target = remainingCost / (remainingParts + 1);
+        const lo = Math.max(start + 1, end - remainingParts * maxSize);
+        const hi = Math.min(start + maxSize, end - remainingParts);
+        let cost = 0;
+        while (pos < hi && (pos < lo || cost + costs[pos] / 2 < target)) cost += costs[pos++];
+        ranges.push([start, pos]);
+        remainingCost -= cost;
+        start = pos;
+      }
+      ranges.push([start, end]);
+    }
+
+    return ranges;
+  }
+
+  protected override _getTestEventsRunParams(runParams: readonly string[]): string[] | undefined {
+    return runParams.map(p => (p === '--reporters=xml' ? '--reporters=testmate' : p));
+  }
+
+  protected override _getTestIdOfEvent(event: TestEventTestStart): string {
+    return getTestId(event.file, event.line?.toString(), event.name);
+  }
+
   protected _getDebugParamsInner(childrenToRun: readonly Readonly<AbstractTest>[], breakOnFailure: boolean): string[] {
     const execParams: string[] = this._getDocTestRunParams(childrenToRun);
     execParams.push('--reporters=console');
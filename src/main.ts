@@ -8,7 +8,16 @@ import * as TMA from './TestMateApi';
 import * as llvm_cov from './coverage/llvm-cov';
 import * as gcov from './coverage/gcov';
 import * as custom from './coverage/custom';
+import * as benchmark from './framework/GoogleBenchmark/BenchmarkProfile';
 import { noLimitTaskPoolMap, TaskPoolMap } from './util/TaskPool';
+import { TestListCache } from './util/TestListCache';
+import { TestCoverageIndex } from './util/TestCoverageIndex';
+import { ChangedLinesTracker } from './util/ChangedLines';
+import { ExecClonePool } from './util/ExecClonePool';
+import { PhaseTimings } from './util/PhaseTimings';
+import { BenchmarkBaselineStore } from './util/BenchmarkBaselineStore';
+import { GoogleBenchmarkExecutable } from './framework/GoogleBenchmark/GoogleBenchmarkExecutable';
+import { GoogleBenchmarkTest } from './framework/GoogleBenchmark/GoogleBenchmarkTest';
 
 ///
 
@@ -24,12 +33,51 @@ export async function activate(context: vscode.ExtensionContext): Promise<TMA.Te
   const executableChanged = (e: Iterable<AbstractExecutable>): void => {
     executableChangedEmitter.fire(e);
   };
+  const testListCache = new TestListCache(context.globalStorageUri?.fsPath, log);
+  context.subscriptions.push(testListCache);
+  const testCoverageIndex = new TestCoverageIndex((context.storageUri ?? context.globalStorageUri)?.fsPath, log);
+  context.subscriptions.push(testCoverageIndex);
+  const execClonePool = new ExecClonePool(log);
+  context.subscriptions.push(execClonePool);
+  const phaseTimings = new PhaseTimings(log);
+  context.subscriptions.push(phaseTimings);
+  const benchmarkBaselineStore = new BenchmarkBaselineStore(
+    (context.storageUri ?? context.globalStorageUri)?.fsPath,
+    log,
+  );
+  context.subscriptions.push(benchmarkBaselineStore);
+  const getTimings = (): TMA.TestMateTimings => ({
+    ...phaseTimings.toJSON(),
+    executableCloning: execClonePool.toJSON(),
+  });
+  const getCfgTraceFile = () => vscode.workspace.getConfiguration('testMate.cpp.log').get<string>('traceFile');
+  phaseTimings.setTraceFile(getCfgTraceFile());
+  context.subscriptions.push(
+    vscode.workspace.onDidChangeConfiguration(event => {
+      if (event.affectsConfiguration('testMate.cpp.log.traceFile')) phaseTimings.setTraceFile(getCfgTraceFile());
+    }),
+  );
 
   ///
 
   const addWorkspaceManager = (wf: vscode.WorkspaceFolder): void => {
     if (workspace2manager.get(wf)) log.errorS('Unexpected workspace manager', wf);
-    else workspace2manager.set(wf, new WorkspaceManager(wf, log, testItemManager, executableChanged));
+    else
+      workspace2manager.set(
+        wf,
+        new WorkspaceManager(
+          wf,
+          log,
+          testItemManager,
+          executableChanged,
+          context.workspaceState,
+          testListCache,
+          execClonePool,
+          phaseTimings,
+          benchmarkBaselineStore,
+          testCoverageIndex,
+        ),
+      );
   };
 
   const removeWorkspaceManager = (wf: vscode.WorkspaceFolder): void => {
@@ -311,6 +359,97 @@ export async function activate(context: vscode.ExtensionContext): Promise<TMA.Te
     true,
   );
 
+  // runs the tests which cover the changed lines by the coverage index (`perTestCoverage` has to be recorded before)
+  let changedLinesTracker: ChangedLinesTracker | undefined = undefined;
+  const affectedContinuousRuns = new Set<vscode.TestRunRequest>();
+  let affectedRunTimer: NodeJS.Timeout | undefined = undefined;
+
+  const isSelectedBy = (item: vscode.TestItem, request: vscode.TestRunRequest): boolean => {
+    let included = request.include === undefined;
+    for (let i: vscode.TestItem | undefined = item; i; i = i.parent) {
+      if (request.exclude?.includes(i)) return false;
+      if (!included && request.include!.includes(i)) included = true;
+    }
+    return included;
+  };
+
+  const runAffectedTests = async (requests: vscode.TestRunRequest[]): Promise<number> => {
+    const affected = new Map<string, vscode.TestItem>();
+    for (const [fsPath, lines] of getChangedLinesTracker().takeChangedLines()) {
+      for (const id of await testCoverageIndex.getTestsCoveringLines(vscode.Uri.file(fsPath), lines)) {
+        const item = testItemManager.findByUniqueId(id);
+        if (item) affected.set(id, item);
+      }
+    }
+    log.info('affected tests', affected.size);
+
+    const started = new Set<vscode.TestItem>();
+    const runs: Promise<void>[] = [];
+    for (const request of requests) {
+      const include = [...affected.values()].filter(item => isSelectedBy(item, request));
+      if (include.length > 0) {
+        include.forEach(item => started.add(item));
+        runs.push(
+          startTestRun(
+            new vscode.TestRunRequest(include, undefined, request.profile, request.continuous),
+            SharedTestTags.runnable,
+            null,
+          ),
+        );
+      }
+    }
+    await Promise.all(runs);
+    return started.size;
+  };
+
+  // created only if the index is recorded or the profile is used: it keeps the content of the open files
+  const getChangedLinesTracker = (): ChangedLinesTracker => {
+    if (changedLinesTracker === undefined) {
+      log.info('ChangedLinesTracker: created');
+      changedLinesTracker = new ChangedLinesTracker();
+      changedLinesTracker.onDidSaveChanges(() => {
+        if (affectedContinuousRuns.size === 0) return;
+        // a "save all" fires for every file: they are run together
+        if (affectedRunTimer) clearTimeout(affectedRunTimer);
+        affectedRunTimer = setTimeout(() => {
+          affectedRunTimer = undefined;
+          runAffectedTests([...affectedContinuousRuns]).catch(e => log.errorS('runAffectedTests', e));
+        }, 300);
+      });
+    }
+    return changedLinesTracker;
+  };
+
+  const cfgPerTestCoverage = 'testMate.cpp.experimental.llvm-cov';
+  const isPerTestCoverageEnabled = (): boolean =>
+    (vscode.workspace.workspaceFolders ?? []).some(wf =>
+      vscode.workspace.getConfiguration(cfgPerTestCoverage, wf.uri).get<boolean>('perTestCoverage', false),
+    );
+  if (isPerTestCoverageEnabled()) getChangedLinesTracker();
+  context.subscriptions.push(
+    vscode.workspace.onDidChangeConfiguration(event => {
+      if (event.affectsConfiguration(`${cfgPerTestCoverage}.perTestCoverage`) && isPerTestCoverageEnabled())
+        getChangedLinesTracker();
+    }),
+  );
+
+  const affectedProfile = controller.createRunProfile(
+    'Run Affected Tests',
+    vscode.TestRunProfileKind.Run,
+    async (request: vscode.TestRunRequest, cancellation: vscode.CancellationToken): Promise<void> => {
+      if (request.continuous) {
+        getChangedLinesTracker();
+        affectedContinuousRuns.add(request);
+        cancellation.onCancellationRequested(() => affectedContinuousRuns.delete(request));
+      } else if ((await runAffectedTests([request])) === 0) {
+        vscode.window.showInformationMessage('No test covers the lines changed since the last run.');
+      }
+    },
+    false,
+    SharedTestTags.runnable,
+    true,
+  );
+
   // https://github.com/matepek/vscode-catch2-test-adapter/issues/375
   let currentDebugExec = '';
   let currentDebugArgs: string[] = [];
@@ -393,6 +532,9 @@ export async function activate(context: vscode.ExtensionContext): Promise<TMA.Te
       testResultInvalidator.dispose();
       continousRunHandler.dispose();
       runProfile.dispose();
+      affectedProfile.dispose();
+      if (affectedRunTimer) clearTimeout(affectedRunTimer);
+      changedLinesTracker?.dispose();
       debugProfile.dispose();
       controller.dispose();
       log.info('Deactivating finished');
@@ -427,6 +569,37 @@ export async function activate(context: vscode.ExtensionContext): Promise<TMA.Te
     ),
   );
 
+  context.subscriptions.push(
+    vscode.commands.registerCommand('testMate.cmd.dump-timings', async () => {
+      const doc = await vscode.workspace.openTextDocument({
+        language: 'json',
+        content: JSON.stringify(getTimings(), undefined, 2),
+      });
+      await vscode.window.showTextDocument(doc);
+    }),
+  );
+
+  context.subscriptions.push(
+    vscode.commands.registerCommand('testMate.cmd.clear-benchmark-baselines', async () => {
+      await benchmarkBaselineStore.clear();
+      vscode.window.showInformationMessage('Benchmark baselines were cleared.');
+    }),
+  );
+
+  context.subscriptions.push(
+    vscode.commands.registerCommand('testMate.test.acceptBenchmarkBaseline', async (...items: vscode.TestItem[]) => {
+      let accepted = 0;
+      for (const item of items) {
+        const test = testItemManager.mapToTest(item);
+        if (test instanceof GoogleBenchmarkTest && test.exec instanceof GoogleBenchmarkExecutable) {
+          if (await test.exec.acceptBaseline(test)) ++accepted;
+        }
+      }
+      if (accepted > 0) vscode.window.showInformationMessage(`The last run of ${accepted} benchmark(s) was accepted.`);
+      else vscode.window.showWarningMessage('There is no benchmark run to accept.');
+    }),
+  );
+
   context.subscriptions.push(vscode.commands.registerCommand('testMate.cmd.get-debug-exec', () => currentDebugExec));
 
   context.subscriptions.push(
@@ -488,8 +661,11 @@ export async function activate(context: vscode.ExtensionContext): Promise<TMA.Te
   llvm_cov.advanced_activate(context);
   gcov.advanced_activate(context);
   custom.advanced_activate(context);
+  benchmark.advanced_activate(context);
 
   return {
     createTestRunProfile,
+    testCoverageIndex,
+    getTimings,
   };
 }
@@ -0,0 +1,116 @@
+///
+
+/**
+ * Shared queue of items for work-stealing style dispatch: every worker takes the next batch when it has finished.
+ * The batch size adapts to the observed duration per item: short items are grouped into bigger batches
+ * (so the process start-up overhead is amortized) and the batches shrink towards the end of the queue
+ * (so every worker is busy until the very end).
+ */
+export class AdaptiveBatchQueue<T> {
+  constructor(
+    items: readonly T[],
+    private readonly _workerCount: number,
+    private readonly _maxBatchSize: number | null,
+    getKnownDurationMilisec: (item: T) => number | undefined,
+  ) {
+    const withDuration: [T, number][] = [];
+    const withoutDuration: T[] = [];
+    for (const item of items) {
+      const d = getKnownDurationMilisec(item);
+      if (d !== undefined) withDuration.push([item, d]);
+      else withoutDuration.push(item);
+    }
+    // longest first: the long ones cannot cause a long tail at the end
+    withDuration.sort((a, b) => b[1] - a[1]);
+    this._items = [...withDuration.map(x => x[0]), ...withoutDuration];
+    this._knownMilisecs = withDuration.map(x => x[1]);
+    this._hasKnownDuration = withDuration.length > 0;
+    this._remainingKnownMilisec = withDuration.reduce((acc, x) => acc + x[1], 0);
+    this._averageKnownMilisec = this._hasKnownDuration ? this._remainingKnownMilisec / withDuration.length : 0;
+  }
+
+  static readonly minBatchMilisec = 250;
+  private static readonly _initialBatchDivisor = 4;
+  private static readonly _batchDivisor = 2;
+  // weight of the latest observation in the exponential moving average
+  private static readonly _newObservationWeight = 0.5;
+
+  private readonly _items: readonly T[];
+  // the known durations of the first items of `_items`: the rest are unknown
+  private readonly _knownMilisecs: readonly number[];
+  private readonly _hasKnownDuration: boolean;
+  // kept up to date so `next` doesn't have to sum the whole remaining queue
+  private _remainingKnownMilisec: number;
+  private readonly _averageKnownMilisec: number;
+  private _cursor = 0;
+  private _observedMilisecPerItem: number | undefined = undefined;
+
+  get isEmpty(): boolean {
+    return this._cursor >= this._items.length;
+  }
+
+  get remaining(): number {
+    return this._items.length - this._cursor;
+  }
+
+  get observedMilisecPerItem(): number | undefined {
+    return this._observedMilisecPerItem;
+  }
+
+  next(): T[] {
+    if (this.isEmpty) return [];
+
+    const limit = Math.min(this.remaining, this._maxBatchSize ?? Number.MAX_SAFE_INTEGER);
+    let size: number;
+
+    if (this._observedMilisecPerItem === undefined && !this._hasKnownDuration) {
+      // nothing is known yet: guided self-scheduling with small initial chunks
+      size = Math.ceil(this.remaining / (this._workerCount * AdaptiveBatchQueue._initialBatchDivisor));
+    } else {
+      const remainingUnknownCount = this._items.length - Math.max(this._cursor, this._knownMilisecs.length);
+      const remainingMilisec = this._remainingKnownMilisec + remainingUnknownCount * this._estimateUnknown();
+
+      const targetMilisec = Math.max(
+        AdaptiveBatchQueue.minBatchMilisec,
+        remainingMilisec / (this._workerCount * AdaptiveBatchQueue._batchDivisor),
+      );
+
+      size = 0;
+      let batchMilisec = 0;
+      while (size < limit && (size === 0 || batchMilisec < targetMilisec)) {
+        batchMilisec += this._estimate(this._cursor + size);
+        ++size;
+      }
+    }
+
+    size = Math.max(1, Math.min(size, limit));
+    const batch = this._items.slice(this._cursor, this._cursor + size);
+    for (let i = this._cursor; i < this._cursor + size && i < this._knownMilisecs.length; ++i)
+      this._remainingKnownMilisec -= this._knownMilisecs[i];
+    this._cursor += size;
+    return batch;
+  }
+
+  /**
+   * Should be called after a batch has been finished. The elapsed time can contain the process start-up overhead,
+   * that is intentional: it makes the following batches bigger if the overhead dominates.
+   */
+  reportBatch(batchSize: number, elapsedMilisec: number): void {
+    if (batchSize <= 0 || !Number.isFinite(elapsedMilisec) || elapsedMilisec < 0) return;
+
+    const observed = elapsedMilisec / batchSize;
+    this._observedMilisecPerItem =
+      this._observedMilisecPerItem === undefined
+        ? observed
+        : this._observedMilisecPerItem +
+          (observed - this._observedMilisecPerItem) * AdaptiveBatchQueue._newObservationWeight;
+  }
+
+  private _estimate(index: number): number {
+    return index < this._knownMilisecs.length ? this._knownMilisecs[index] : this._estimateUnknown();
+  }
+
+  private _estimateUnknown(): number {
+    return this._observedMilisecPerItem ?? this._averageKnownMilisec;
+  }
+}
@@ -0,0 +1,279 @@
+import * as pathlib from 'path';
+import * as vscode from 'vscode';
+import { Logger } from '../Logger';
+import { decodeTypedArray, encodeTypedArray, PersistentJsonFile } from './PersistentJsonFile';
+
+///
+
+export interface SampleStats {
+  n: number;
+  mean: number;
+  stddev: number;
+}
+
+// nanoseconds: the samples of the repetitions or only their aggregates
+export type BenchmarkSamples = readonly number[] | SampleStats;
+
+export interface BenchmarkRun {
+  // the result of `getBenchmarkContextKey`: runs are compared only within the same context
+  context: string;
+  time: number;
+  // regressed runs are not used as baseline
+  regressed: boolean;
+  real: BenchmarkSamples;
+  cpu: BenchmarkSamples;
+}
+
+export interface BaselineComparison {
+  // relative difference of the means: 0.1 means 10% slower
+  delta: number;
+  // the confidence of the current run being slower than the threshold (one-sided Welch's t-test)
+  confidence: number;
+}
+
+///
+
+// the fields of the `context` of the json output which make the results comparable
+const contextFields = ['host_name', 'num_cpus', 'mhz_per_cpu', 'library_build_type', 'cpu_scaling_enabled'];
+
+export function getBenchmarkContextKey(context: Record<string, unknown> | undefined): string {
+  const picked: Record<string, unknown> = {};
+  for (const field of contextFields) {
+    const value = context?.[field];
+    // the frequency is measured, it can vary a bit from run to run
+    picked[field] = field === 'mhz_per_cpu' && typeof value === 'number' ? Math.round(value / 100) * 100 : value;
+  }
+  return JSON.stringify(picked);
+}
+
+function isSampleStats(samples: BenchmarkSamples): samples is SampleStats {
+  return !Array.isArray(samples);
+}
+
+export function getSampleStats(samples: BenchmarkSamples): SampleStats {
+  if (isSampleStats(samples)) return samples;
+  const n = samples.length;
+  const mean = samples.reduce((a, b) => a + b, 0) / n;
+  const variance = n > 1 ? samples.reduce((a, b) => a + (b - mean) * (b - mean), 0) / (n - 1) : 0;
+  return { n, mean, stddev: Math.sqrt(variance) };
+}
+
+/**
+ * Welch's t-test of the current samples against the baseline slowed down by `limitPercent`.
+ * @returns undefined if there are not enough samples (at least 2 repetitions are needed on both sides)
+ */
+export function compareToBaseline(
+  baseline: SampleStats,
+  current: SampleStats,
+  limitPercent = 0,
+): BaselineComparison | undefined {
+  if (baseline.n < 2 || current.n < 2 || !(baseline.mean > 0)) return undefined;
+
+  const delta = (current.mean - baseline.mean) / baseline.mean;
+  const threshold = baseline.mean * (1 + limitPercent / 100);
+  const varB = (baseline.stddev * baseline.stddev) / baseline.n;
+  const varC = (current.stddev * current.stddev) / current.n;
+  const se = Math.sqrt(varB + varC);
+
+  if (!(se > 0)) {
+    return { delta, confidence: current.mean > threshold ? 1 : current.mean < threshold ? 0 : 0.5 };
+  }
+
+  const t = (current.mean - threshold) / se;
+  const df = ((varB + varC) * (varB + varC)) / ((varB * varB) / (baseline.n - 1) + (varC * varC) / (current.n - 1));
+  // P(T > |t|) of the Student's t distribution
+  const tail = 0.5 * incompleteBeta(df / (df + t * t), df / 2, 0.5);
+  return { delta, confidence: t > 0 ? 1 - tail : tail };
+}
+
+function logGamma(x: number): number {
+  // Lanczos approximation
+  const c = [
+    76.18009172947146, -86.50532032941677, 24.01409824083091, -1.231739572450155, 0.1208650973866179e-2,
+    -0.5395239384953e-5,
+  ];
+  let y = x;
+  const tmp = x + 5.5 - (x + 0.5) * Math.log(x + 5.5);
+  let ser = 1.000000000190015;
+  for (const ci of c) ser += ci / ++y;
+  return -tmp + Math.log((2.5066282746310005 * ser) / x);
+}
+
+// regularized incomplete beta function I_x(a, b)
+function incompleteBeta(x: number, a: number, b: number): number {
+  if (x <= 0) return 0;
+  if (x >= 1) return 1;
+  const front = Math.exp(logGamma(a + b) - logGamma(a) - logGamma(b) + a * Math.log(x) + b * Math.log(1 - x));
+  if (x < (a + 1) / (a + b + 2)) return (front * betaContinuedFraction(x, a, b)) / a;
+  return 1 - (front * betaContinuedFraction(1 - x, b, a)) / b;
+}
+
+function betaContinuedFraction(x: number, a: number, b: number): number {
+  const tiny = 1e-30;
+  let c = 1;
+  let d = 1 - ((a + b) * x) / (a + 1);
+  if (Math.abs(d) < tiny) d = tiny;
+  d = 1 / d;
+  let h = d;
+  for (let m = 1; m <= 200; ++m) {
+    const m2 = 2 * m;
+    let aa = (m * (b - m) * x) / ((a + m2 - 1) * (a + m2));
+    d = 1 + aa * d;
+    if (Math.abs(d) < tiny) d = tiny;
+    c = 1 + aa / c;
+    if (Math.abs(c) < tiny) c = tiny;
+    d = 1 / d;
+    h *= d * c;
+    aa = (-(a + m) * (a + b + m) * x) / ((a + m2) * (a + m2 + 1));
+    d = 1 + aa * d;
+    if (Math.abs(d) < tiny) d = tiny;
+    c = 1 + aa / c;
+    if (Math.abs(c) < tiny) c = tiny;
+    d = 1 / d;
+    const del = d * c;
+    h *= del;
+    if (Math.abs(del - 1) < 1e-12) break;
+  }
+  return h;
+}
+
+///
+
+// base64 encoded Float64Array of the samples or [n, mean, stddev] if only the aggregates were reported
+type StoredSamples = string | [number, number, number];
+
+interface StoredRun {
+  c: number; // index of contexts
+  t: number;
+  r?: 1;
+  real: StoredSamples;
+  cpu: StoredSamples;
+}
+
+interface StoredBaselines {
+  version: number;
+  contexts: string[];
+  // by the key of the benchmark, the oldest first
+  runs: Record<string, StoredRun[]>;
+}
+
+const storedVersion = 1;
+
+function encodeSamples(samples: BenchmarkSamples): StoredSamples {
+  if (isSampleStats(samples)) return [samples.n, samples.mean, samples.stddev];
+  return encodeTypedArray(Float64Array.from(samples));
+}
+
+function decodeSamples(stored: StoredSamples): BenchmarkSamples {
+  if (Array.isArray(stored)) return { n: stored[0], mean: stored[1], stddev: stored[2] };
+  return Array.from(decodeTypedArray(stored, Float64Array));
+}
+
+/**
+ * The history of the benchmark results by benchmark.
+ * It is loaded lazily and saved to the storage directory after the updates.
+ */
+export class BenchmarkBaselineStore implements vscode.Disposable {
+  constructor(
+    storageDir: string | undefined,
+    private readonly _log: Logger,
+  ) {
+    this._file = new PersistentJsonFile<StoredBaselines>(
+      storageDir !== undefined ? pathlib.join(storageDir, 'benchmarkBaselines.json') : undefined,
+      storedVersion,
+      _log,
+      'BenchmarkBaselineStore',
+      stored => this._restore(stored),
+      () => this._serialize(),
+    );
+  }
+
+  private static readonly _maxRunsPerBenchmark = 20;
+
+  private readonly _file: PersistentJsonFile<StoredBaselines>;
+  private _runs = new Map<string /*benchmarkKey*/, BenchmarkRun[]>();
+
+  dispose(): void {
+    this._file.dispose();
+  }
+
+  /**
+   * @returns the latest not regressed run with the same context
+   */
+  async getBaseline(benchmarkKey: string, context: string): Promise<BenchmarkRun | undefined> {
+    await this._file.load();
+    const runs = this._runs.get(benchmarkKey);
+    if (runs === undefined) return undefined;
+    for (let i = runs.length - 1; i >= 0; --i) {
+      if (runs[i].context === context && !runs[i].regressed) return runs[i];
+    }
+    return undefined;
+  }
+
+  async add(benchmarkKey: string, run: BenchmarkRun): Promise<void> {
+    await this._file.load();
+    let runs = this._runs.get(benchmarkKey);
+    if (runs === undefined) {
+      runs = [];
+      this._runs.set(benchmarkKey, runs);
+    }
+    runs.push(run);
+    if (runs.length > BenchmarkBaselineStore._maxRunsPerBenchmark) runs.shift();
+    this._file.scheduleSave();
+  }
+
+  /**
+   * The latest run of the benchmark becomes the baseline of its context even if it was regressed.
+   * @returns false if there is no run of the benchmark
+   */
+  async accept(benchmarkKey: string): Promise<boolean> {
+    await this._file.load();
+    const runs = this._runs.get(benchmarkKey);
+    if (runs === undefined || runs.length === 0) return false;
+    runs[runs.length - 1].regressed = false;
+    this._log.info('BenchmarkBaselineStore: accepted', benchmarkKey);
+    this._file.scheduleSave();
+    return true;
+  }
+
+  async clear(): Promise<void> {
+    await this._file.load();
+    this._runs = new Map();
+    this._log.info('BenchmarkBaselineStore: cleared');
+    this._file.scheduleSave();
+  }
+
+  private _restore(stored: StoredBaselines): void {
+    for (const key in stored.runs) {
+      this._runs.set(
+        key,
+        stored.runs[key].map(r => ({
+          context: stored.contexts[r.c],
+          time: r.t,
+          regressed: r.r === 1,
+          real: decodeSamples(r.real),
+          cpu: decodeSamples(r.cpu),
+        })),
+      );
+    }
+  }
+
+  private _serialize(): StoredBaselines {
+    const stored: StoredBaselines = { version: storedVersion, contexts: [], runs: {} };
+    const contextIndexes = new Map<string, number>();
+    for (const [key, runs] of this._runs) {
+      stored.runs[key] = runs.map(run => {
+        let c = contextIndexes.get(run.context);
+        if (c === undefined) {
+          c = stored.contexts.length;
+          stored.contexts.push(run.context);
+          contextIndexes.set(run.context, c);
+        }
+        const r: StoredRun = { c, t: run.time, real: encodeSamples(run.real), cpu: encodeSamples(run.cpu) };
+        if (run.regressed) r.r = 1;
+        return r;
+      });
+    }
+    return stored;
+  }
+}
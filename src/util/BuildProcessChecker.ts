@@ -1,6 +1,7 @@
 import { Logger } from '../Logger';
 import findProcess from 'find-process';
 import { promisify } from 'node:util';
+import * as fs from 'node:fs';
 import { CancellationToken } from '../Util';
 
 ///
@@ -67,7 +68,7 @@ export abstract class BuildProcessCheckerBase {
               this._log.exceptionS('Finding process', reason);
               return;
             }
-            await promisify(setTimeout)(_checkIntervalMillis);
+            await this._waitForNextCheck(patternToUse, token);
           }
         })
         .finally(() => {
@@ -84,6 +85,10 @@ export abstract class BuildProcessCheckerBase {
   }
 
   protected abstract _find(pattern: RegExp): Promise<string[]>;
+
+  protected _waitForNextCheck(_pattern: RegExp, _token: CancellationToken): Promise<void> {
+    return promisify(setTimeout)(_checkIntervalMillis);
+  }
 }
 
 ///
@@ -97,6 +102,111 @@ export class FindProcessChecker extends BuildProcessCheckerBase {
 
 ///
 
+// the found processes are checked this often: it is cheap, only their `/proc/<pid>` is checked
+const _exitCheckIntervalMillis = 200;
+// the number of `/proc/<pid>/cmdline` files read at the same time
+const _procReadBatchSize = 256;
+
+interface ProcEntry {
+  name: string;
+  // a forked process might exec a build tool after it was seen: it is read again at the next scan
+  confirmed: boolean;
+}
+
+/**
+ * The name of the process like `find-process` has it: the basename of `argv[0]`.
+ * `/proc/<pid>/comm` would be truncated to 15 characters (ex.: `x86_64-linux-gn` of `x86_64-linux-gnu-g++-12`).
+ * Kernel threads have no command line, their `comm` is used.
+ */
+async function readProcName(pid: number): Promise<string> {
+  const cmdline = await fs.promises.readFile(`/proc/${pid}/cmdline`, 'utf8');
+  const end = cmdline.indexOf('\0');
+  const argv0 = end === -1 ? cmdline : cmdline.substring(0, end);
+  if (argv0.length > 0) return argv0.substring(argv0.lastIndexOf('/') + 1);
+  return (await fs.promises.readFile(`/proc/${pid}/comm`, 'utf8')).trimEnd();
+}
+
+/**
+ * Linux only: scans `/proc` instead of spawning `ps` through `find-process`.
+ * The scan is incremental: the names of the already known processes aren't read again.
+ * While matching processes are running only their existence is checked (frequently), so the finish is noticed
+ * quickly without rescanning the whole process table.
+ */
+export class ProcfsProcessChecker extends BuildProcessCheckerBase {
+  private readonly _procs = new Map<number /*pid*/, ProcEntry>();
+  private readonly _matchingPids = new Map<RegExp, number[]>();
+  private _procfsFailed = false;
+
+  protected override async _find(pattern: RegExp): Promise<string[]> {
+    if (this._procfsFailed) return (await findProcess('name', pattern)).map(p => p.name);
+
+    let entries: string[];
+    try {
+      entries = await fs.promises.readdir('/proc');
+    } catch (e) {
+      this._log.warn('Cannot read /proc, falling back to find-process', e);
+      this._procfsFailed = true;
+      return this._find(pattern);
+    }
+
+    const alive = new Set<number>();
+    const toRead: number[] = [];
+    for (const entry of entries) {
+      const c = entry.charCodeAt(0);
+      if (c < 48 || c > 57) continue; // not a pid
+      const pid = Number(entry);
+      alive.add(pid);
+      const known = this._procs.get(pid);
+      if (known === undefined || !known.confirmed) toRead.push(pid);
+    }
+
+    for (const pid of this._procs.keys()) if (!alive.has(pid)) this._procs.delete(pid);
+
+    for (let i = 0; i < toRead.length; i += _procReadBatchSize) {
+      await Promise.all(
+        toRead.slice(i, i + _procReadBatchSize).map(pid =>
+          readProcName(pid).then(
+            name => this._procs.set(pid, { name, confirmed: this._procs.has(pid) }),
+            () => this._procs.delete(pid), // exited meanwhile
+          ),
+        ),
+      );
+    }
+
+    const found: string[] = [];
+    const matchingPids: number[] = [];
+    for (const [pid, proc] of this._procs) {
+      if (pattern.test(proc.name)) {
+        found.push(`${proc.name}(${pid})`);
+        matchingPids.push(pid);
+      }
+    }
+    this._matchingPids.set(pattern, matchingPids);
+    return found;
+  }
+
+  protected override async _waitForNextCheck(pattern: RegExp, token: CancellationToken): Promise<void> {
+    let pids = this._matchingPids.get(pattern) ?? [];
+    const until = Date.now() + _checkIntervalMillis;
+    while (pids.length > 0 && Date.now() < until && !token.isCancellationRequested) {
+      await promisify(setTimeout)(_exitCheckIntervalMillis);
+      const exists = await Promise.all(
+        pids.map(pid =>
+          fs.promises.access(`/proc/${pid}`).then(
+            () => true,
+            () => false,
+          ),
+        ),
+      );
+      pids = pids.filter((_, i) => exists[i]);
+    }
+    // the last one has exited (or the interval is over): the full scan finds the next step of the build
+    this._matchingPids.delete(pattern);
+  }
+}
+
+///
+
 // import psList, { ProcessDescriptor } from 'ps-list';
 // export class PSListProcessChecker extends BuildProcessCheckerBase {
 //   private runningFind: Promise<ProcessDescriptor[]> | undefined = undefined;
@@ -117,6 +227,7 @@ export class FindProcessChecker extends BuildProcessCheckerBase {
 export const buildProcessCheckerFactory = {
   // https://www.npmjs.com/package/ps-list : "Works on macOS, Linux, and Windows. Windows ARM64 is not supported yet."
   create: (log: Logger) => {
+    if (process.platform === 'linux') return new ProcfsProcessChecker(log);
     return /*process.platform === 'win32' && process.arch == 'x64' ? new PSListProcessChecker(log) : */ new FindProcessChecker(
       log,
     );
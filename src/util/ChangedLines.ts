@@ -0,0 +1,97 @@
+import * as vscode from 'vscode';
+
+///
+
+/**
+ * Cheap diff: everything between the common prefix and the common suffix is considered changed,
+ * so separate edits of the same save result in a superset of the changed lines.
+ * @returns the 0-based lines of the old text which were changed, removed or next to an insertion
+ */
+export function getChangedLines(oldText: string, newText: string): number[] {
+  if (oldText === newText) return [];
+
+  const oldLines = oldText.split(/\r?\n/);
+  const newLines = newText.split(/\r?\n/);
+  const maxCommon = Math.min(oldLines.length, newLines.length);
+
+  let prefix = 0;
+  while (prefix < maxCommon && oldLines[prefix] === newLines[prefix]) ++prefix;
+  if (prefix === oldLines.length && prefix === newLines.length) return []; // only the line endings were changed
+
+  let suffix = 0;
+  while (
+    suffix < maxCommon - prefix &&
+    oldLines[oldLines.length - 1 - suffix] === newLines[newLines.length - 1 - suffix]
+  )
+    ++suffix;
+
+  const changed: number[] = [];
+  const end = oldLines.length - suffix;
+  if (prefix < end) {
+    for (let l = prefix; l < end; ++l) changed.push(l);
+  } else {
+    // pure insertion: the neighbours of the new lines are affected
+    if (prefix > 0) changed.push(prefix - 1);
+    if (prefix < oldLines.length) changed.push(prefix);
+  }
+  return changed;
+}
+
+/**
+ * Remembers the last saved content of the open files and collects the lines which were changed by the saves.
+ * The lines are in the coordinates of the content before the first save since the last {@linkcode takeChangedLines}:
+ * every save is diffed against that content, so the lines of the later saves are remapped too.
+ */
+export class ChangedLinesTracker implements vscode.Disposable {
+  constructor() {
+    for (const doc of vscode.workspace.textDocuments) this._onOpen(doc);
+    this._disposables.push(
+      vscode.workspace.onDidOpenTextDocument(doc => this._onOpen(doc)),
+      vscode.workspace.onDidCloseTextDocument(doc => this._savedContents.delete(doc.uri.fsPath)),
+      vscode.workspace.onDidSaveTextDocument(doc => this._onSave(doc)),
+      this._onDidSaveChangesEmitter,
+    );
+  }
+
+  private readonly _savedContents = new Map<string /*fsPath*/, string>();
+  // the content before the first save since the last take and the lines changed relative to it
+  private readonly _changedLines = new Map<string /*fsPath*/, { baseText: string; lines: number[] }>();
+  private readonly _onDidSaveChangesEmitter = new vscode.EventEmitter<vscode.Uri>();
+  private readonly _disposables: vscode.Disposable[] = [];
+
+  readonly onDidSaveChanges = this._onDidSaveChangesEmitter.event;
+
+  dispose(): void {
+    this._disposables.forEach(d => d.dispose());
+  }
+
+  takeChangedLines(): Map<string /*fsPath*/, number[]> {
+    const taken = new Map<string, number[]>();
+    for (const [fsPath, changed] of this._changedLines) if (changed.lines.length > 0) taken.set(fsPath, changed.lines);
+    this._changedLines.clear();
+    return taken;
+  }
+
+  private _onOpen(doc: vscode.TextDocument): void {
+    if (doc.uri.scheme !== 'file' || doc.isDirty) return;
+    this._savedContents.set(doc.uri.fsPath, doc.getText());
+  }
+
+  private _onSave(doc: vscode.TextDocument): void {
+    if (doc.uri.scheme !== 'file') return;
+    const fsPath = doc.uri.fsPath;
+    const newText = doc.getText();
+    const oldText = this._savedContents.get(fsPath);
+    this._savedContents.set(fsPath, newText);
+    if (oldText === undefined || oldText === newText) return;
+
+    let changed = this._changedLines.get(fsPath);
+    if (changed === undefined) {
+      changed = { baseText: oldText, lines: [] };
+      this._changedLines.set(fsPath, changed);
+    }
+    changed.lines = getChangedLines(changed.baseText, newText);
+
+    this._onDidSaveChangesEmitter.fire(doc.uri);
+  }
+}
@@ -0,0 +1,220 @@
+import * as fs from 'fs';
+
+///
+
+const elfMagic = [0x7f, 0x45, 0x4c, 0x46]; // \x7fELF
+const PT_NOTE = 4;
+const NT_GNU_BUILD_ID = 3;
+const SHT_NOBITS = 8;
+const _maxNoteSegmentSize = 1024 * 1024;
+const _scanChunkSize = 4 * 1024 * 1024;
+
+export interface ElfHeader {
+  readonly is64: boolean;
+  readonly isLittleEndian: boolean;
+  readonly programHeaderOffset: number;
+  readonly programHeaderEntrySize: number;
+  readonly programHeaderCount: number;
+  readonly sectionHeaderOffset: number;
+  readonly sectionHeaderEntrySize: number;
+  readonly sectionHeaderCount: number;
+  readonly sectionNameTableIndex: number;
+}
+
+export interface ElfSection {
+  readonly name: string;
+  readonly type: number;
+  readonly offset: number;
+  readonly size: number;
+}
+
+/**
+ * Minimal reader of the ELF format: only the parts necessary for the adapter.
+ * Every function returns undefined if the file is not an ELF file or it cannot be read.
+ */
+export class ElfFile {
+  private constructor(
+    private readonly _fd: fs.promises.FileHandle,
+    readonly header: ElfHeader,
+  ) {}
+
+  static async open(path: string): Promise<ElfFile | undefined> {
+    let fd: fs.promises.FileHandle | undefined = undefined;
+    try {
+      fd = await fs.promises.open(path, 'r');
+      const ident = Buffer.alloc(64);
+      const { bytesRead } = await fd.read(ident, 0, ident.length, 0);
+      if (bytesRead < 52 || elfMagic.some((b, i) => ident[i] !== b)) {
+        await fd.close();
+        return undefined;
+      }
+
+      const is64 = ident[4] === 2;
+      const isLittleEndian = ident[5] === 1;
+      const u16 = (o: number): number => (isLittleEndian ? ident.readUInt16LE(o) : ident.readUInt16BE(o));
+      const u32 = (o: number): number => (isLittleEndian ? ident.readUInt32LE(o) : ident.readUInt32BE(o));
+      const u64 = (o: number): number =>
+        Number(isLittleEndian ? ident.readBigUInt64LE(o) : ident.readBigUInt64BE(o));
+
+      const header: ElfHeader = is64
+        ? {
+            is64,
+            isLittleEndian,
+            programHeaderOffset: u64(0x20),
+            programHeaderEntrySize: u16(0x36),
+            programHeaderCount: u16(0x38),
+            sectionHeaderOffset: u64(0x28),
+            sectionHeaderEntrySize: u16(0x3a),
+            sectionHeaderCount: u16(0x3c),
+            sectionNameTableIndex: u16(0x3e),
+          }
+        : {
+            is64,
+            isLittleEndian,
+            programHeaderOffset: u32(0x1c),
+            programHeaderEntrySize: u16(0x2a),
+            programHeaderCount: u16(0x2c),
+            sectionHeaderOffset: u32(0x20),
+            sectionHeaderEntrySize: u16(0x2e),
+            sectionHeaderCount: u16(0x30),
+            sectionNameTableIndex: u16(0x32),
+          };
+
+      return new ElfFile(fd, header);
+    } catch {
+      await fd?.close().catch(() => {});
+      return undefined;
+    }
+  }
+
+  close(): Promise<void> {
+    return this._fd.close();
+  }
+
+  async read(offset: number, length: number): Promise<Buffer> {
+    const buffer = Buffer.alloc(length);
+    const { bytesRead } = await this._fd.read(buffer, 0, length, offset);
+    return bytesRead === length ? buffer : buffer.subarray(0, bytesRead);
+  }
+
+  readU16(buffer: Buffer, offset: number): number {
+    return this.header.isLittleEndian ? buffer.readUInt16LE(offset) : buffer.readUInt16BE(offset);
+  }
+
+  readU32(buffer: Buffer, offset: number): number {
+    return this.header.isLittleEndian ? buffer.readUInt32LE(offset) : buffer.readUInt32BE(offset);
+  }
+
+  readAddr(buffer: Buffer, offset: number): number {
+    if (!this.header.is64) return this.readU32(buffer, offset);
+    return Number(this.header.isLittleEndian ? buffer.readBigUInt64LE(offset) : buffer.readBigUInt64BE(offset));
+  }
+
+  /**
+   * The content of the `NT_GNU_BUILD_ID` note (hex), which is unique for every linked binary (`-Wl,--build-id`).
+   */
+  async getBuildId(): Promise<string | undefined> {
+    const { programHeaderOffset, programHeaderEntrySize, programHeaderCount, is64 } = this.header;
+    if (programHeaderEntrySize === 0 || programHeaderCount === 0) return undefined;
+
+    const table = await this.read(programHeaderOffset, programHeaderEntrySize * programHeaderCount);
+
+    for (let i = 0; i < programHeaderCount; ++i) {
+      const entry = i * programHeaderEntrySize;
+      if (entry + programHeaderEntrySize > table.length) break;
+      if (this.readU32(table, entry) !== PT_NOTE) continue;
+
+      const offset = this.readAddr(table, entry + (is64 ? 0x08 : 0x04));
+      const size = this.readAddr(table, entry + (is64 ? 0x20 : 0x10));
+      if (size > _maxNoteSegmentSize) continue;
+
+      const notes = await this.read(offset, size);
+      let pos = 0;
+      while (pos + 12 <= notes.length) {
+        const nameSize = this.readU32(notes, pos);
+        const descSize = this.readU32(notes, pos + 4);
+        const type = this.readU32(notes, pos + 8);
+        const nameStart = pos + 12;
+        const descStart = nameStart + align4(nameSize);
+        const descEnd = descStart + descSize;
+        if (descEnd > notes.length) break;
+
+        if (type === NT_GNU_BUILD_ID && notes.toString('latin1', nameStart, nameStart + nameSize) === 'GNU\0') {
+          return notes.toString('hex', descStart, descEnd);
+        }
+
+        pos = descStart + align4(descSize);
+      }
+    }
+
+    return undefined;
+  }
+
+  async getSections(): Promise<ElfSection[]> {
+    const { sectionHeaderOffset, sectionHeaderEntrySize, sectionHeaderCount, sectionNameTableIndex, is64 } =
+      this.header;
+    if (sectionHeaderEntrySize === 0 || sectionHeaderCount === 0 || sectionNameTableIndex >= sectionHeaderCount)
+      return [];
+
+    const table = await this.read(sectionHeaderOffset, sectionHeaderEntrySize * sectionHeaderCount);
+    if (table.length < sectionHeaderEntrySize * sectionHeaderCount) return [];
+
+    const raw = Array.from({ length: sectionHeaderCount }, (_, i) => {
+      const entry = i * sectionHeaderEntrySize;
+      return {
+        nameOffset: this.readU32(table, entry),
+        type: this.readU32(table, entry + 0x04),
+        offset: this.readAddr(table, entry + (is64 ? 0x18 : 0x10)),
+        size: this.readAddr(table, entry + (is64 ? 0x20 : 0x14)),
+      };
+    });
+
+    const nameTable = raw[sectionNameTableIndex];
+    const names = await this.read(nameTable.offset, nameTable.size);
+
+    return raw.map(r => {
+      const end = names.indexOf(0, r.nameOffset);
+      const name = names.toString('latin1', r.nameOffset, end === -1 ? names.length : end);
+      return { name, type: r.type, offset: r.offset, size: r.size };
+    });
+  }
+
+  /**
+   * Searches the given byte sequences in the content of the given sections (ex.: `.dynstr`, `.rodata`).
+   * It is much cheaper than reading the whole file: debug info is usually the biggest part of a test executable.
+   */
+  async findInSections(sectionNames: readonly string[], needles: readonly string[]): Promise<Set<string>> {
+    const found = new Set<string>();
+    const needleBuffers = needles.map(n => [n, Buffer.from(n, 'latin1')] as const);
+    const overlap = Math.max(0, ...needleBuffers.map(n => n[1].length - 1));
+    const sections = (await this.getSections()).filter(s => s.type !== SHT_NOBITS && sectionNames.includes(s.name));
+
+    for (const section of sections) {
+      for (let pos = 0; pos < section.size && found.size < needles.length; pos += _scanChunkSize) {
+        const length = Math.min(_scanChunkSize + overlap, section.size - pos);
+        const chunk = await this.read(section.offset + pos, length);
+        for (const [needle, buffer] of needleBuffers) {
+          if (!found.has(needle) && chunk.indexOf(buffer) !== -1) found.add(needle);
+        }
+      }
+    }
+
+    return found;
+  }
+}
+
+function align4(n: number): number {
+  return (n + 3) & ~3;
+}
+
+export async function readElfBuildId(path: string): Promise<string | undefined> {
+  const elf = await ElfFile.open(path);
+  if (elf === undefined) return undefined;
+  try {
+    return await elf.getBuildId();
+  } catch {
+    return undefined;
+  } finally {
+    await elf.close().catch(() => {});
+  }
+}
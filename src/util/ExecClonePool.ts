@@ -0,0 +1,257 @@
+import * as fs from 'fs';
+import * as pathlib from 'path';
+import * as crypto from 'crypto';
+import * as vscode from 'vscode';
+import { Logger } from '../Logger';
+import { readElfBuildId } from './Elf';
+import * as TMA from '../TestMateApi';
+
+///
+
+type CloneMethod = keyof TMA.TestMateExecutableCloning['clones'];
+
+interface CloneEntry {
+  origPath: string;
+  // the clone right after its creation: it is verified before every use
+  created: Promise<{ method: CloneMethod; stat: fs.Stats }>;
+  lastUsed: number;
+}
+
+const isSameFile = (a: fs.Stats, b: fs.Stats): boolean =>
+  a.ino === b.ino && a.size === b.size && a.mtimeMs === b.mtimeMs;
+
+/**
+ * Clones of the executables so the build can replace the original while the tests are running.
+ * Shared by every workspace.
+ *
+ * The clones are content addressed (ELF build-id if there is one, size and modification time otherwise)
+ * and placed next to the original (`$ORIGIN` rpath, resources relative to the executable).
+ * Preference: reflink (copy-on-write), hardlink, copy.
+ * A hardlink is a snapshot only as long as the build replaces its output (the linkers unlink or rename it,
+ * a running executable cannot be written on Linux anyway). So the linked inode is checked against the stat
+ * of the content id and every clone is verified (inode, size, mtime) before it is used. If an original turns out
+ * to be rewritten in place, its clones are copies from then on. Not on Windows: a running executable is locked
+ * by all of its names.
+ * Parallel processes of the same executable share the clone. The clones of an outdated content are removed
+ * when they haven't been used for a while.
+ */
+export class ExecClonePool implements vscode.Disposable {
+  constructor(
+    private readonly _log: Logger,
+    private readonly _gcDelayMillis: number = 10 * 60 * 1000,
+  ) {}
+
+  static readonly prefix = '.';
+  static readonly suffix = '.TestMate.execClone.tmp';
+
+  private readonly _entries = new Map<string /*clonePath*/, CloneEntry>();
+  private readonly _currentClone = new Map<string /*origPath*/, string /*clonePath*/>();
+  private readonly _rewrittenInPlace = new Set<string /*origPath*/>();
+  private _gcTimer: NodeJS.Timeout | undefined = undefined;
+  private _bytesSaved = 0;
+  private _bytesCopied = 0;
+  private readonly _clones: TMA.TestMateExecutableCloning['clones'] = { reflink: 0, hardlink: 0, copy: 0, existing: 0 };
+
+  dispose(): void {
+    if (this._gcTimer) clearInterval(this._gcTimer);
+    this._gcTimer = undefined;
+    for (const clonePath of this._entries.keys()) {
+      try {
+        fs.unlinkSync(clonePath);
+      } catch (e) {
+        this._log.debug('ExecClonePool: cannot remove', clonePath, e);
+      }
+    }
+    this._entries.clear();
+    this._log.info('ExecClonePool: bytes saved', this._bytesSaved, 'bytes copied', this._bytesCopied);
+  }
+
+  get bytesSaved(): number {
+    return this._bytesSaved;
+  }
+
+  toJSON(): TMA.TestMateExecutableCloning {
+    return { bytesSaved: this._bytesSaved, bytesCopied: this._bytesCopied, clones: { ...this._clones } };
+  }
+
+  static isClonePath(path: string): boolean {
+    return path.endsWith(ExecClonePool.suffix);
+  }
+
+  /**
+   * @returns the path of the clone of the current content or the original path if it doesn't exist
+   */
+  async getClone(origPath: string): Promise<string> {
+    let stat: fs.Stats;
+    try {
+      stat = await fs.promises.stat(origPath);
+    } catch {
+      return origPath; // no file exists, nothing to do
+    }
+
+    const clonePath = ExecClonePool._generateClonePath(origPath, await this._getContentId(origPath, stat));
+
+    const prevClonePath = this._currentClone.get(origPath);
+    let entry = this._entries.get(clonePath);
+    if (entry !== undefined) {
+      entry.lastUsed = Date.now();
+      const created = await entry.created;
+      if (await this._isUnchanged(clonePath, created.stat)) {
+        this._bytesSaved += stat.size;
+        return clonePath;
+      }
+      // a parallel call has replaced it meanwhile
+      if (this._entries.get(clonePath) !== entry) return this.getClone(origPath);
+      this._onRewrittenInPlace(origPath);
+    } else {
+      const prevEntry = prevClonePath !== undefined ? this._entries.get(prevClonePath) : undefined;
+      if (prevEntry !== undefined) {
+        // the previous content was linked and the original still has the same inode: it was written in place
+        const prev = await prevEntry.created.catch(() => undefined);
+        if (prev?.method === 'hardlink' && prev.stat.ino === stat.ino) this._onRewrittenInPlace(origPath);
+        // a parallel call has created it meanwhile
+        if (this._entries.has(clonePath)) return this.getClone(origPath);
+      }
+    }
+
+    // the rename replaces the modified clone: the running processes keep their inode
+    const replace = entry !== undefined;
+    entry = { origPath, created: this._createClone(origPath, clonePath, stat, replace), lastUsed: Date.now() };
+    this._entries.set(clonePath, entry);
+
+    const isFirstClone = prevClonePath === undefined;
+    this._currentClone.set(origPath, clonePath);
+    this._scheduleGc();
+
+    try {
+      await entry.created;
+    } catch (e) {
+      this._entries.delete(clonePath);
+      throw e;
+    }
+
+    if (isFirstClone) await this._removeLeftovers(origPath);
+
+    return clonePath;
+  }
+
+  private static _generateClonePath(origPath: string, contentId: string): string {
+    const { dir, base } = pathlib.parse(origPath);
+    return pathlib.join(dir, ExecClonePool.prefix + base + '.' + contentId + ExecClonePool.suffix);
+  }
+
+  private async _getContentId(origPath: string, stat: fs.Stats): Promise<string> {
+    const buildId = await readElfBuildId(origPath).catch(() => undefined);
+    const key = buildId ? `build-id:${buildId}:${stat.size}` : `mtime:${stat.mtimeMs}:${stat.size}`;
+    return crypto.createHash('sha1').update(key).digest('hex').substring(0, 16);
+  }
+
+  private async _createClone(
+    origPath: string,
+    clonePath: string,
+    origStat: fs.Stats,
+    replace: boolean,
+  ): Promise<{ method: CloneMethod; stat: fs.Stats }> {
+    let method: CloneMethod | undefined = undefined;
+
+    try {
+      // a previous session might have left it there: it is content addressed
+      if (!replace && (await fs.promises.stat(clonePath)).size === origStat.size) method = 'existing';
+    } catch {} // eslint-disable-line
+
+    if (method === undefined) {
+      // the temporary file has the suffix too: the watchers ignore it
+      const tmpPath = ExecClonePool._generateClonePath(origPath, crypto.randomBytes(8).toString('hex'));
+      try {
+        method = await this._cloneFile(origPath, tmpPath, origStat);
+        await fs.promises.rename(tmpPath, clonePath);
+      } catch (e) {
+        fs.promises.unlink(tmpPath).catch(() => {});
+        throw e;
+      }
+    }
+
+    if (method === 'copy') this._bytesCopied += origStat.size;
+    else this._bytesSaved += origStat.size;
+    ++this._clones[method];
+
+    this._log.info('ExecClonePool: clone', method, clonePath, 'bytes saved so far', this._bytesSaved);
+    return { method, stat: await fs.promises.stat(clonePath) };
+  }
+
+  private async _cloneFile(origPath: string, tmpPath: string, origStat: fs.Stats): Promise<CloneMethod> {
+    try {
+      await fs.promises.copyFile(origPath, tmpPath, fs.constants.COPYFILE_FICLONE_FORCE);
+      return 'reflink';
+    } catch (e) {
+      this._log.debug('ExecClonePool: reflink is not supported', e);
+    }
+
+    if (process.platform !== 'win32' && !this._rewrittenInPlace.has(origPath)) {
+      try {
+        await fs.promises.link(origPath, tmpPath);
+        // the original might have been replaced since its content id was calculated
+        if (isSameFile(await fs.promises.stat(tmpPath), origStat)) return 'hardlink';
+        await fs.promises.unlink(tmpPath);
+      } catch (e) {
+        this._log.debug('ExecClonePool: hardlink is not supported', e);
+      }
+    }
+
+    await fs.promises.copyFile(origPath, tmpPath);
+    return 'copy';
+  }
+
+  private async _isUnchanged(clonePath: string, created: fs.Stats): Promise<boolean> {
+    try {
+      return isSameFile(await fs.promises.stat(clonePath), created);
+    } catch {
+      return false;
+    }
+  }
+
+  private _onRewrittenInPlace(origPath: string): void {
+    if (this._rewrittenInPlace.has(origPath)) return;
+    this._rewrittenInPlace.add(origPath);
+    this._log.info('ExecClonePool: rewritten in place, its clones are copies from now on', origPath);
+  }
+
+  // the clones of the previous sessions and the ones of the former naming
+  private async _removeLeftovers(origPath: string): Promise<void> {
+    const { dir, base } = pathlib.parse(origPath);
+    const legacyName = ExecClonePool.prefix + base + ExecClonePool.suffix;
+    const namePrefix = ExecClonePool.prefix + base + '.';
+    const isCloneOf = (name: string): boolean =>
+      name === legacyName ||
+      (name.startsWith(namePrefix) &&
+        name.endsWith(ExecClonePool.suffix) &&
+        /^[0-9a-f]{16}$/.test(name.substring(namePrefix.length, name.length - ExecClonePool.suffix.length)));
+    try {
+      for (const name of await fs.promises.readdir(dir)) {
+        if (!isCloneOf(name)) continue;
+        const path = pathlib.join(dir, name);
+        if (this._entries.has(path)) continue;
+        await fs.promises.unlink(path).catch(e => this._log.debug('ExecClonePool: cannot remove leftover', path, e));
+      }
+    } catch (e) {
+      this._log.debug('ExecClonePool: cannot list', dir, e);
+    }
+  }
+
+  private _scheduleGc(): void {
+    if (this._gcTimer) return;
+    this._gcTimer = setInterval(() => this._gc(), Math.max(1000, this._gcDelayMillis / 2));
+    this._gcTimer.unref?.();
+  }
+
+  private _gc(): void {
+    const now = Date.now();
+    for (const [clonePath, entry] of this._entries) {
+      if (this._currentClone.get(entry.origPath) === clonePath) continue;
+      if (now - entry.lastUsed < this._gcDelayMillis) continue;
+      this._entries.delete(clonePath);
+      // a process might still use it (Windows): it will be tried again by `_removeLeftovers` next time
+      fs.promises.unlink(clonePath).catch(e => this._log.debug('ExecClonePool: cannot remove', clonePath, e));
+    }
+  }
+}
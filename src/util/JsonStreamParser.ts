@@ -0,0 +1,251 @@
+import { Logger } from '../Logger';
+import { isThenable, ParserInterface } from './ParserInterface';
+
+///
+
+export interface JsonValueProcessor {
+  /**
+   * Called with the values of the streamed objects and arrays, in order.
+   * Synchronous return value is preferred: a promise makes the parser queue the following values.
+   * @param path the keys from the root joined by `.`, `[]` for the elements of an array: `data[].files[]`.
+   *             It is `benchmarks[]` for the elements of the `benchmarks` array of the root object.
+   */
+  onvalue(path: string, value: unknown): void | Promise<void>;
+}
+
+const enum FrameState {
+  Key,
+  Colon,
+  Value,
+}
+
+interface Frame {
+  path: string;
+  isArray: boolean;
+  state: FrameState;
+  key: string;
+}
+
+const enum ValueTarget {
+  Key,
+  Value,
+}
+
+const enum Char {
+  Tab = 9,
+  LineFeed = 10,
+  CarriageReturn = 13,
+  Space = 32,
+  Quote = 34,
+  Comma = 44,
+  Colon = 58,
+  OpenBracket = 91,
+  Backslash = 92,
+  CloseBracket = 93,
+  OpenBrace = 123,
+  CloseBrace = 125,
+}
+
+const isWhitespace = (c: number): boolean =>
+  c === Char.Space || c === Char.LineFeed || c === Char.CarriageReturn || c === Char.Tab;
+
+/**
+ * Incremental tokenizer for outputs like `{ "context": {...}, "benchmarks": [ {...}, {...} ] }`.
+ * The root and the objects/arrays on the `streamedPaths` are not parsed as a whole: each of their values is
+ * parsed and emitted once, as soon as it is complete. Only the text of the current value is kept in memory.
+ */
+export class JsonStreamParser implements ParserInterface {
+  constructor(
+    private readonly log: Pick<Logger, 'warn' | 'error'>,
+    private readonly processor: JsonValueProcessor,
+    streamedPaths: readonly string[],
+  ) {
+    this.streamedPaths = new Set(streamedPaths);
+  }
+
+  private readonly streamedPaths: Set<string>;
+  private readonly stack: Frame[] = [];
+
+  // the value being scanned: undefined if there is none
+  private valueTarget: ValueTarget | undefined = undefined;
+  private valuePath = '';
+  private valueParts: string[] = [];
+  private nesting = 0;
+  private inString = false;
+  private escaped = false;
+
+  // undefined: nothing is pending, the values can be processed synchronously
+  private pending: Promise<void> | undefined = undefined;
+
+  write(data: string): void {
+    let i = 0;
+    while (i < data.length) {
+      if (this.valueTarget !== undefined) {
+        const end = this._scanValue(data, i);
+        if (end === -1) {
+          this.valueParts.push(data.substring(i));
+          return;
+        }
+        this.valueParts.push(data.substring(i, end));
+        this._onValue();
+        i = end;
+        continue;
+      }
+
+      const c = data.charCodeAt(i);
+
+      if (isWhitespace(c)) {
+        ++i;
+        continue;
+      }
+
+      const frame = this.stack.length > 0 ? this.stack[this.stack.length - 1] : undefined;
+
+      if (frame === undefined) {
+        // anything before the root is ignored
+        if (c === Char.OpenBrace || c === Char.OpenBracket) this._push('', c === Char.OpenBracket);
+        ++i;
+      } else if (frame.isArray) {
+        if (c === Char.CloseBracket) {
+          this.stack.pop();
+          ++i;
+        } else if (c === Char.Comma) {
+          ++i;
+        } else if (this._beginValue(frame.path + '[]', c)) {
+          ++i;
+        }
+      } else if (frame.state === FrameState.Key) {
+        if (c === Char.Quote) {
+          this.valueTarget = ValueTarget.Key;
+          this._resetValue();
+        } else {
+          if (c === Char.CloseBrace) this.stack.pop();
+          else if (c !== Char.Comma) this.log.warnS('unexpected character in json', String.fromCharCode(c));
+          ++i;
+        }
+      } else if (frame.state === FrameState.Colon) {
+        if (c === Char.Colon) frame.state = FrameState.Value;
+        else this.log.warnS('expected ":" in json', String.fromCharCode(c));
+        ++i;
+      } else {
+        frame.state = FrameState.Key;
+        if (this._beginValue(frame.path ? frame.path + '.' + frame.key : frame.key, c)) ++i;
+      }
+    }
+  }
+
+  writeStdErr(_data: string): Promise<boolean> {
+    return Promise.resolve(false);
+  }
+
+  async end(): Promise<void> {
+    if (this.valueTarget !== undefined || this.stack.length > 0) {
+      this.log.warn('json output is incomplete', this.valuePath);
+    }
+
+    this.valueTarget = undefined;
+    this.valueParts = [];
+
+    while (this.pending !== undefined) await this.pending;
+  }
+
+  private _push(path: string, isArray: boolean): void {
+    this.stack.push({ path, isArray, state: FrameState.Key, key: '' });
+  }
+
+  /**
+   * @returns true if the character was consumed: it has opened a streamed object or array
+   */
+  private _beginValue(path: string, c: number): boolean {
+    if ((c === Char.OpenBrace || c === Char.OpenBracket) && this.streamedPaths.has(path)) {
+      this._push(path, c === Char.OpenBracket);
+      return true;
+    }
+    this.valueTarget = ValueTarget.Value;
+    this.valuePath = path;
+    this._resetValue();
+    return false;
+  }
+
+  private _resetValue(): void {
+    this.valueParts = [];
+    this.nesting = 0;
+    this.inString = false;
+    this.escaped = false;
+  }
+
+  /**
+   * @returns the index after the end of the value or -1 if it continues in the next chunk
+   */
+  private _scanValue(data: string, from: number): number {
+    for (let i = from; i < data.length; ++i) {
+      const c = data.charCodeAt(i);
+      if (this.inString) {
+        if (this.escaped) {
+          this.escaped = false;
+        } else if (c === Char.Backslash) {
+          this.escaped = true;
+        } else if (c === Char.Quote) {
+          this.inString = false;
+          if (this.nesting === 0) return i + 1;
+        }
+      } else if (c === Char.Quote) {
+        this.inString = true;
+      } else if (c === Char.OpenBrace || c === Char.OpenBracket) {
+        ++this.nesting;
+      } else if (c === Char.CloseBrace || c === Char.CloseBracket) {
+        // end of a number or literal: the bracket belongs to the parent
+        if (this.nesting === 0) return i;
+        if (--this.nesting === 0) return i + 1;
+      } else if (this.nesting === 0 && (c === Char.Comma || isWhitespace(c))) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  private _onValue(): void {
+    const target = this.valueTarget;
+    const text = this.valueParts.join('');
+    this.valueTarget = undefined;
+    this.valueParts = [];
+
+    let value: unknown;
+    try {
+      value = JSON.parse(text);
+    } catch (e) {
+      this.log.errorS("couldn't parse json value", e, text);
+    }
+
+    if (target === ValueTarget.Key) {
+      const frame = this.stack[this.stack.length - 1];
+      frame.key = typeof value === 'string' ? value : '';
+      frame.state = FrameState.Colon;
+    } else if (value !== undefined) {
+      this._process(this.valuePath, value);
+    }
+  }
+
+  private _process(path: string, value: unknown): void {
+    if (this.pending !== undefined) {
+      this.pending = this._track(this.pending.then(() => this.processor.onvalue(path, value)));
+      return;
+    }
+
+    try {
+      const result = this.processor.onvalue(path, value);
+      if (isThenable(result)) this.pending = this._track(result);
+    } catch (e) {
+      this.log.exceptionS(e);
+    }
+  }
+
+  private _track(p: PromiseLike<void>): Promise<void> {
+    const tracked: Promise<void> = Promise.resolve(p)
+      .catch(e => this.log.exceptionS(e))
+      .then(() => {
+        if (this.pending === tracked) this.pending = undefined;
+      });
+    return tracked;
+  }
+}
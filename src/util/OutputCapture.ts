@@ -0,0 +1,139 @@
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+import { Readable } from 'stream';
+
+import { generateId } from '../Util';
+
+///
+
+export interface OutputCaptureOptions {
+  // [bytes] the output is kept in memory up to this size
+  limit: number;
+  // the whole output is written to a temporary file if it is bigger than the limit (see `createReadStream`)
+  spill?: boolean;
+}
+
+const _tailSize = 64 * 1024;
+
+/**
+ * Collects the output of a process with bounded memory usage.
+ * Up to the limit it is like string concatenation. Above it only the head (first `limit` bytes) and
+ * the tail (last 64 KiB, ring buffer) are kept in memory, the rest is dropped or spilled to a temporary file.
+ */
+export class OutputCapture {
+  constructor(private readonly _options: OutputCaptureOptions) {}
+
+  private readonly _head: Buffer[] = [];
+  private _headSize = 0;
+  private _size = 0;
+  private _tail: Buffer | undefined = undefined;
+  private _tailWritten = 0;
+  private _spillFile: string | undefined = undefined;
+  private _spillStream: fs.WriteStream | undefined = undefined;
+  private _spillError: Error | undefined = undefined;
+
+  get size(): number {
+    return this._size;
+  }
+
+  get isTruncated(): boolean {
+    return this._size > this._headSize;
+  }
+
+  /**
+   * @returns false if the spill file cannot keep up: the source should wait for `drain()`
+   */
+  write(chunk: Buffer): boolean {
+    this._size += chunk.length;
+
+    if (this._tail === undefined && this._headSize + chunk.length <= this._options.limit) {
+      this._head.push(chunk);
+      this._headSize += chunk.length;
+      return true;
+    }
+
+    if (this._tail === undefined) {
+      if (this._options.spill) this._startSpilling();
+      const headPart = chunk.subarray(0, this._options.limit - this._headSize);
+      this._head.push(headPart);
+      this._headSize += headPart.length;
+      this._tail = Buffer.alloc(_tailSize);
+    }
+
+    this._writeTail(chunk);
+    return this._spillStream?.write(chunk) ?? true;
+  }
+
+  drain(): Promise<void> {
+    const stream = this._spillStream;
+    if (stream === undefined || !stream.writableNeedDrain) return Promise.resolve();
+    return new Promise<void>(resolve => stream.once('drain', resolve).once('error', resolve));
+  }
+
+  /**
+   * Has to be called after the last `write`. Waits for the spill file.
+   */
+  async finish(): Promise<void> {
+    const stream = this._spillStream;
+    if (stream === undefined || stream.writableFinished) return;
+    await new Promise<void>(resolve => stream.end(resolve));
+  }
+
+  /**
+   * The first `limit` bytes: the whole output if it is not truncated.
+   */
+  head(): string {
+    return Buffer.concat(this._head, this._headSize).toString();
+  }
+
+  /**
+   * The end of the output (at most 64 KiB) if it is truncated, otherwise the whole.
+   */
+  tail(): string {
+    if (this._tail === undefined) return this.head();
+    if (this._tailWritten < _tailSize) return this._tail.toString(undefined, 0, this._tailWritten);
+    const end = this._tailWritten % _tailSize;
+    return Buffer.concat([this._tail.subarray(end), this._tail.subarray(0, end)]).toString();
+  }
+
+  /**
+   * The whole output, from memory or from the spill file.
+   * @throws if the output is truncated and it wasn't spilled
+   */
+  createReadStream(): Readable {
+    if (!this.isTruncated) return Readable.from([Buffer.concat(this._head, this._headSize)], { objectMode: false });
+    if (this._spillFile === undefined || this._spillError !== undefined)
+      throw Error(`The output is truncated at ${this._options.limit} bytes: ${this._spillError ?? 'not spilled'}`);
+    return fs.createReadStream(this._spillFile);
+  }
+
+  async dispose(): Promise<void> {
+    const spillFile = this._spillFile;
+    this._spillFile = undefined;
+    if (spillFile === undefined) return;
+    await this.finish();
+    await fs.promises.unlink(spillFile).catch(() => {});
+  }
+
+  private _startSpilling(): void {
+    this._spillFile = path.join(os.tmpdir(), `testmate-output-${process.pid}-${generateId()}.txt`);
+    this._spillStream = fs.createWriteStream(this._spillFile);
+    this._spillStream.on('error', (e: Error) => (this._spillError = e));
+    for (const c of this._head) this._spillStream.write(c);
+  }
+
+  private _writeTail(chunk: Buffer): void {
+    const tail = this._tail!;
+    if (chunk.length >= _tailSize) {
+      chunk.copy(tail, 0, chunk.length - _tailSize);
+      this._tailWritten = _tailSize;
+      return;
+    }
+    const end = this._tailWritten % _tailSize;
+    const firstPart = Math.min(chunk.length, _tailSize - end);
+    chunk.copy(tail, end, 0, firstPart);
+    chunk.copy(tail, 0, firstPart);
+    this._tailWritten += chunk.length;
+  }
+}
@@ -9,12 +9,40 @@ export interface ParserInterface {
   writeStdErr(data: string): Promise<boolean>;
 }
 
+export function isThenable<T>(value: T | PromiseLike<T>): value is PromiseLike<T> {
+  return value !== null && typeof value === 'object' && typeof (value as PromiseLike<T>).then === 'function';
+}
+
 export const pipeProcess2Parser = async (
   runInfo: RunningExecutable,
   parser: ParserInterface,
-  unhandlerStdErrHandler: (data: string) => void,
-): Promise<void> =>
-  pipeOutputStreams2Parser(runInfo.process.stdout, runInfo.process.stderr, parser, unhandlerStdErrHandler);
+  unhandlerStdErrHandler: ((data: string) => void) | undefined,
+  stdout: Readable = runInfo.process.stdout,
+  stderr: Readable | undefined = runInfo.process.stderr,
+): Promise<void> => {
+  // only the time spent in the parser counts, not the waiting for the output
+  const startMillis = performance.now();
+  let parseMillis = 0;
+  let chars = 0;
+  const timedParser: ParserInterface = {
+    write: (data: string): void => {
+      const start = performance.now();
+      parser.write(data);
+      parseMillis += performance.now() - start;
+      chars += data.length;
+    },
+    end: async (): Promise<void> => {
+      const start = performance.now();
+      await parser.end();
+      parseMillis += performance.now() - start;
+    },
+    writeStdErr: (data: string): Promise<boolean> => parser.writeStdErr(data),
+  };
+
+  await pipeOutputStreams2Parser(stdout, stderr, timedParser, unhandlerStdErrHandler);
+
+  runInfo.shared.shared.phaseTimings.record('parse', runInfo.shared.path, startMillis, parseMillis, chars);
+};
 
 export const pipeOutputStreams2Parser = async (
   stdout: Readable,
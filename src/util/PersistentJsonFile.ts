@@ -0,0 +1,114 @@
+import * as fs from 'fs';
+import * as pathlib from 'path';
+import * as crypto from 'crypto';
+import * as vscode from 'vscode';
+import { Logger } from '../Logger';
+
+///
+
+/**
+ * Writes a temporary file and renames it: a reader never sees a partially written file.
+ * It doesn't merge anything: if more windows write the same file the last one wins.
+ */
+export async function writeFileAtomic(path: string, content: string): Promise<void> {
+  const tmpPath = `${path}.${process.pid}.${crypto.randomBytes(4).toString('hex')}.tmp`;
+  try {
+    await fs.promises.writeFile(tmpPath, content, 'utf8');
+    await fs.promises.rename(tmpPath, path);
+  } catch (e) {
+    fs.promises.unlink(tmpPath).catch(() => {});
+    throw e;
+  }
+}
+
+export function encodeTypedArray(array: Uint32Array | Float64Array): string {
+  return Buffer.from(array.buffer, array.byteOffset, array.byteLength).toString('base64');
+}
+
+export function decodeTypedArray<T extends Uint32Array | Float64Array>(
+  encoded: string,
+  arrayType: { new (length: number): T; readonly BYTES_PER_ELEMENT: number },
+): T {
+  const bytes = Buffer.from(encoded, 'base64');
+  const array = new arrayType(Math.floor(bytes.length / arrayType.BYTES_PER_ELEMENT));
+  new Uint8Array(array.buffer).set(bytes.subarray(0, array.byteLength));
+  return array;
+}
+
+export interface PersistentJsonContent {
+  version: number;
+}
+
+/**
+ * A JSON file of the storage directory which is loaded lazily and saved with a delay after the changes.
+ * The owner converts the content: `restore` is called once with the loaded content (if there is any and its version
+ * is the current one), `serialize` is called for every save.
+ * The pending save is done synchronously by `dispose`.
+ */
+export class PersistentJsonFile<T extends PersistentJsonContent> implements vscode.Disposable {
+  constructor(
+    private readonly _path: string | undefined,
+    private readonly _version: number,
+    private readonly _log: Logger,
+    private readonly _name: string,
+    private readonly _restore: (stored: T) => void,
+    private readonly _serialize: () => T,
+    private readonly _saveDelayMillis = 2000,
+  ) {}
+
+  private _loaded: Promise<void> | undefined = undefined;
+  private _saveTimer: NodeJS.Timeout | undefined = undefined;
+
+  dispose(): void {
+    if (this._saveTimer) {
+      clearTimeout(this._saveTimer);
+      this._saveTimer = undefined;
+      this._saveSync();
+    }
+  }
+
+  load(): Promise<void> {
+    if (this._loaded === undefined) {
+      this._loaded = (async (): Promise<void> => {
+        if (this._path === undefined) return;
+        try {
+          const stored = JSON.parse(await fs.promises.readFile(this._path, 'utf8')) as T;
+          if (stored.version !== this._version) {
+            this._log.info(`${this._name}: ignoring stored version`, stored.version);
+            return;
+          }
+          this._restore(stored);
+        } catch (e) {
+          if ((e as NodeJS.ErrnoException).code !== 'ENOENT') this._log.warn(`${this._name}: load`, this._path, e);
+        }
+      })();
+    }
+    return this._loaded;
+  }
+
+  scheduleSave(): void {
+    if (this._path === undefined || this._saveTimer) return;
+    this._saveTimer = setTimeout(() => {
+      this._saveTimer = undefined;
+      this._save();
+    }, this._saveDelayMillis);
+  }
+
+  private async _save(): Promise<void> {
+    try {
+      await fs.promises.mkdir(pathlib.dirname(this._path!), { recursive: true });
+      await writeFileAtomic(this._path!, JSON.stringify(this._serialize()));
+    } catch (e) {
+      this._log.warn(`${this._name}: save`, this._path, e);
+    }
+  }
+
+  private _saveSync(): void {
+    try {
+      fs.mkdirSync(pathlib.dirname(this._path!), { recursive: true });
+      fs.writeFileSync(this._path!, JSON.stringify(this._serialize()), 'utf8');
+    } catch (e) {
+      this._log.warn(`${this._name}: save`, this._path, e);
+    }
+  }
+}
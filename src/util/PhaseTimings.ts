@@ -0,0 +1,234 @@
+import * as fs from 'fs';
+import * as vscode from 'vscode';
+import { Logger } from '../Logger';
+import * as TMA from '../TestMateApi';
+
+///
+
+const bucketBoundsMillis = [1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 30000, 60000];
+
+class Histogram {
+  count = 0;
+  sumMillis = 0;
+  minMillis = Infinity;
+  maxMillis = 0;
+  chars = 0;
+  readonly buckets = new Uint32Array(bucketBoundsMillis.length + 1);
+
+  add(durationMillis: number, chars: number): void {
+    ++this.count;
+    this.sumMillis += durationMillis;
+    if (durationMillis < this.minMillis) this.minMillis = durationMillis;
+    if (durationMillis > this.maxMillis) this.maxMillis = durationMillis;
+    this.chars += chars;
+    let i = 0;
+    while (i < bucketBoundsMillis.length && durationMillis > bucketBoundsMillis[i]) ++i;
+    ++this.buckets[i];
+  }
+
+  toJSON(): TMA.TestMateTimingHistogram {
+    return {
+      count: this.count,
+      sumMillis: this.sumMillis,
+      minMillis: this.count > 0 ? this.minMillis : 0,
+      maxMillis: this.maxMillis,
+      chars: this.chars,
+      buckets: [...this.buckets],
+    };
+  }
+}
+
+// https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+// JSON Array Format: the closing `]` is optional, so the new events can be appended
+type TraceEvent =
+  | {
+      name: string;
+      cat: string;
+      ph: 'X';
+      ts: number; // microseconds
+      dur: number;
+      pid: number;
+      tid: number;
+      args: { executable?: string; chars?: number };
+    }
+  | { name: 'thread_name'; ph: 'M'; pid: number; tid: number; args: { name: string } };
+
+function getHistogram<K>(map: Map<K, Histogram>, key: K): Histogram {
+  let histogram = map.get(key);
+  if (histogram === undefined) {
+    histogram = new Histogram();
+    map.set(key, histogram);
+  }
+  return histogram;
+}
+
+/**
+ * Latency histograms of the phases: in total and by executable. Shared by every workspace.
+ * If the trace file is set the measurements are written there as Chrome trace events too (chrome://tracing, Perfetto).
+ */
+export class PhaseTimings implements vscode.Disposable {
+  constructor(private readonly _log: Logger) {}
+
+  private static readonly _maxTraceEvents = 1000000;
+  private static readonly _traceWriteDelayMillis = 5000;
+
+  private readonly _byPhase = new Map<TMA.TestMateTimingPhase, Histogram>();
+  private readonly _byExecutable = new Map<string, Map<TMA.TestMateTimingPhase, Histogram>>();
+  // a row in the trace for every executable
+  private readonly _traceThreadIds = new Map<string, number>();
+  private _traceFile: string | undefined = undefined;
+  private _traceEventCount = 0;
+  // not written yet
+  private _traceEvents: TraceEvent[] = [];
+  private _traceStarted = false;
+  private _traceWriting: Promise<void> | undefined = undefined;
+  private _traceWriteTimer: NodeJS.Timeout | undefined = undefined;
+
+  dispose(): void {
+    if (this._traceWriteTimer) {
+      clearTimeout(this._traceWriteTimer);
+      this._traceWriteTimer = undefined;
+      // the appends have to keep their order
+      if (this._traceWriting) this._writeTrace();
+      else this._writeTraceSync();
+    }
+  }
+
+  /**
+   * @param traceFile empty or undefined means disabled
+   */
+  setTraceFile(traceFile: string | undefined): void {
+    if (!traceFile) traceFile = undefined;
+    if (traceFile === this._traceFile) return;
+    this._traceFile = traceFile;
+    this._traceEvents = [];
+    this._traceEventCount = 0;
+    this._traceStarted = false;
+    this._traceThreadIds.clear();
+    this._log.info('PhaseTimings: trace file', traceFile);
+  }
+
+  /**
+   * @returns the function which has to be called at the end of the phase
+   */
+  start(phase: TMA.TestMateTimingPhase, executable: string | undefined): (chars?: number) => void {
+    const startMillis = performance.now();
+    return (chars?: number) => this.record(phase, executable, startMillis, performance.now() - startMillis, chars);
+  }
+
+  async measure<T>(phase: TMA.TestMateTimingPhase, executable: string | undefined, fn: () => Promise<T>): Promise<T> {
+    const stop = this.start(phase, executable);
+    try {
+      return await fn();
+    } finally {
+      stop();
+    }
+  }
+
+  /**
+   * @param startMillis by `performance.now()`
+   */
+  record(
+    phase: TMA.TestMateTimingPhase,
+    executable: string | undefined,
+    startMillis: number,
+    durationMillis: number,
+    chars = 0,
+  ): void {
+    getHistogram(this._byPhase, phase).add(durationMillis, chars);
+
+    if (executable !== undefined) {
+      let ofExecutable = this._byExecutable.get(executable);
+      if (ofExecutable === undefined) {
+        ofExecutable = new Map();
+        this._byExecutable.set(executable, ofExecutable);
+      }
+      getHistogram(ofExecutable, phase).add(durationMillis, chars);
+    }
+
+    if (this._traceFile !== undefined && this._traceEventCount < PhaseTimings._maxTraceEvents) {
+      ++this._traceEventCount;
+      this._traceEvents.push({
+        name: phase,
+        cat: 'testmate',
+        ph: 'X',
+        ts: Math.round(startMillis * 1000),
+        dur: Math.round(durationMillis * 1000),
+        pid: process.pid,
+        tid: this._getTraceThreadId(executable),
+        args: chars > 0 ? { executable, chars } : { executable },
+      });
+      this._scheduleTraceWrite();
+    }
+  }
+
+  toJSON(): TMA.TestMateTimings {
+    const toRecord = (
+      map: Map<TMA.TestMateTimingPhase, Histogram>,
+    ): Partial<Record<TMA.TestMateTimingPhase, TMA.TestMateTimingHistogram>> => {
+      const r: Partial<Record<TMA.TestMateTimingPhase, TMA.TestMateTimingHistogram>> = {};
+      for (const [phase, histogram] of map) r[phase] = histogram.toJSON();
+      return r;
+    };
+
+    const executables: TMA.TestMateTimings['executables'] = {};
+    for (const [executable, ofExecutable] of this._byExecutable) executables[executable] = toRecord(ofExecutable);
+
+    return { bucketBoundsMillis: [...bucketBoundsMillis], phases: toRecord(this._byPhase), executables };
+  }
+
+  private _getTraceThreadId(executable: string | undefined): number {
+    if (executable === undefined) return 0;
+    let tid = this._traceThreadIds.get(executable);
+    if (tid === undefined) {
+      tid = this._traceThreadIds.size + 1;
+      this._traceThreadIds.set(executable, tid);
+      this._traceEvents.push({ name: 'thread_name', ph: 'M', pid: process.pid, tid, args: { name: executable } });
+    }
+    return tid;
+  }
+
+  // the first chunk creates the file, the others are appended
+  private _takeTraceChunk(): { chunk: string; append: boolean } | undefined {
+    if (this._traceEvents.length === 0) return undefined;
+    const append = this._traceStarted;
+    const chunk = (append ? ',\n' : '[\n') + this._traceEvents.map(e => JSON.stringify(e)).join(',\n');
+    this._traceEvents = [];
+    this._traceStarted = true;
+    return { chunk, append };
+  }
+
+  private _writeTrace(): Promise<void> {
+    const traceFile = this._traceFile;
+    const taken = this._takeTraceChunk();
+    if (traceFile === undefined || taken === undefined) return this._traceWriting ?? Promise.resolve();
+
+    const writing = (this._traceWriting ?? Promise.resolve())
+      .then(() => (taken.append ? fs.promises.appendFile : fs.promises.writeFile)(traceFile, taken.chunk))
+      .catch(e => this._log.warn('PhaseTimings: cannot write trace', traceFile, e))
+      .finally(() => {
+        if (this._traceWriting === writing) this._traceWriting = undefined;
+      });
+    this._traceWriting = writing;
+    return writing;
+  }
+
+  private _writeTraceSync(): void {
+    const taken = this._takeTraceChunk();
+    if (this._traceFile === undefined || taken === undefined) return;
+    try {
+      if (taken.append) fs.appendFileSync(this._traceFile, taken.chunk);
+      else fs.writeFileSync(this._traceFile, taken.chunk);
+    } catch (e) {
+      this._log.warn('PhaseTimings: cannot write trace', this._traceFile, e);
+    }
+  }
+
+  private _scheduleTraceWrite(): void {
+    if (this._traceWriteTimer) return;
+    this._traceWriteTimer = setTimeout(() => {
+      this._traceWriteTimer = undefined;
+      this._writeTrace();
+    }, PhaseTimings._traceWriteDelayMillis);
+  }
+}
@@ -0,0 +1,188 @@
+import * as pathlib from 'path';
+
+import { Logger } from '../Logger';
+import { applyRegexpWithSubstitution, getAbsolutePath } from '../Util';
+
+///
+
+const strategyKey = '$strategy';
+
+// number of resolved file paths kept in memory
+const defaultCacheSize = 8192;
+
+/**
+ * Resolves the file paths of the test outputs by the `sourceFileMap` and by looking for them on the disk.
+ * The map is compiled once and the results are memoized (least recently used ones are dropped).
+ */
+export class SourceFileResolver {
+  constructor(
+    private readonly log: Logger,
+    sourceFileMap: Record<string, string>,
+    private readonly workspacePath: string,
+    private readonly directoriesToCheck: readonly string[],
+    private readonly cacheSize = defaultCacheSize,
+  ) {
+    this._strategy = sourceFileMap[strategyKey] ?? 'legacy';
+    this._rules = Object.keys(sourceFileMap)
+      .filter(k => k !== strategyKey)
+      .map(k => [k, sourceFileMap[k]]);
+
+    if (this._rules.length === 0) {
+      this._mapper = undefined;
+    } else if (this._strategy === 'legacy') {
+      this._mapper = this._mapLegacy;
+    } else if (this._strategy === 'starts-with') {
+      this._rules.forEach(([k], index) => {
+        if (pathlib.isAbsolute(k)) this._absoluteTrie.add(k, index);
+        else this._relativeTrie.add(k, index);
+      });
+      this._mapper = this._mapStartsWith;
+    } else if (this._strategy === 'replace-first') {
+      this._mapper = this._mapReplaceFirst;
+    } else if (this._strategy === 'regex-relative' || this._strategy === 'regex-absolute') {
+      this._regexes = this._rules.map(([k, v]) => [new RegExp(k), v]);
+      this._mapper = this._mapRegex;
+    } else {
+      this.log.errorS('unexpected strategy', this._strategy);
+      this._mapper = undefined;
+    }
+  }
+
+  private readonly _strategy: string;
+  private readonly _rules: [string, string][];
+  private readonly _mapper: ((file: string) => string) | undefined;
+  private readonly _absoluteTrie = new PrefixTrie();
+  private readonly _relativeTrie = new PrefixTrie();
+  private readonly _regexes: [RegExp, string][] = [];
+  private readonly _cache = new Map<string, Promise<string>>();
+
+  resolve(file: string): Promise<string> {
+    const cached = this._cache.get(file);
+    if (cached !== undefined) {
+      // moving to the end: the first one is the least recently used
+      this._cache.delete(file);
+      this._cache.set(file, cached);
+      return cached;
+    }
+
+    const resolved = this._resolve(file);
+    this._cache.set(file, resolved);
+    if (this._cache.size > this.cacheSize) this._cache.delete(this._cache.keys().next().value!);
+    return resolved;
+  }
+
+  // the files might have been moved or the executable might have been rebuilt with different paths
+  clearCache(): void {
+    this._cache.clear();
+  }
+
+  private async _resolve(file: string): Promise<string> {
+    // normalize before apply the map because it is normalize too
+    // this is for better platform independent resolution
+    const normalizedFileInput = pathlib.normalize(file);
+    let resolved = this._mapper ? this._mapper(normalizedFileInput) : normalizedFileInput;
+
+    if (!pathlib.isAbsolute(resolved)) resolved = await getAbsolutePath(resolved, this.directoriesToCheck);
+
+    this.log.debug('findSourceFilePath:', file, '=>', resolved);
+
+    return pathlib.normalize(resolved);
+  }
+
+  // REMARK: this logic dos not guarantee that the `normalizedFileInput` is actually absolute
+  // we just assume that most ofe the cases it is relative.
+  private _relative(normalizedFileInput: string): string {
+    return pathlib.isAbsolute(normalizedFileInput)
+      ? pathlib.relative(this.workspacePath, normalizedFileInput)
+      : normalizedFileInput;
+  }
+
+  private _absolute(normalizedFileInput: string): string {
+    return pathlib.isAbsolute(normalizedFileInput)
+      ? normalizedFileInput
+      : pathlib.join(this.workspacePath, normalizedFileInput);
+  }
+
+  private readonly _mapLegacy = (normalizedFileInput: string): string => {
+    let resolved = normalizedFileInput;
+    for (const [k, v] of this._rules) {
+      resolved = resolved.replace(k, v); // Note: it just replaces the first occurence
+    }
+    return resolved;
+  };
+
+  private readonly _mapStartsWith = (normalizedFileInput: string): string => {
+    const absoluteFileInput = this._absolute(normalizedFileInput);
+    const relativeFileInput = this._relative(normalizedFileInput);
+    // the first matching rule in the order of the map, as if they were checked one by one
+    const a = this._absoluteTrie.findFirstPrefix(absoluteFileInput);
+    const r = this._relativeTrie.findFirstPrefix(relativeFileInput);
+    if (a === undefined && r === undefined) return normalizedFileInput;
+    if (r === undefined || (a !== undefined && a < r)) {
+      const [k, v] = this._rules[a!];
+      return absoluteFileInput.replace(k, v);
+    } else {
+      const [k, v] = this._rules[r];
+      return relativeFileInput.replace(k, v);
+    }
+  };
+
+  private readonly _mapReplaceFirst = (normalizedFileInput: string): string => {
+    const absoluteFileInput = this._absolute(normalizedFileInput);
+    const relativeFileInput = this._relative(normalizedFileInput);
+    for (const [k, v] of this._rules) {
+      const input = pathlib.isAbsolute(k) ? absoluteFileInput : relativeFileInput;
+      if (input.includes(k)) return input.replace(k, v); // Note: it just replaces the first occurence
+    }
+    return normalizedFileInput;
+  };
+
+  private readonly _mapRegex = (normalizedFileInput: string): string => {
+    const input =
+      this._strategy === 'regex-relative' ? this._relative(normalizedFileInput) : this._absolute(normalizedFileInput);
+    for (const [regex, v] of this._regexes) {
+      const match = applyRegexpWithSubstitution(regex, input, v);
+      if (match !== null) return match;
+    }
+    return normalizedFileInput;
+  };
+}
+
+///
+
+interface TrieNode {
+  children: Map<string, TrieNode>;
+  // the smallest index of the keys ending here
+  index: number | undefined;
+}
+
+class PrefixTrie {
+  private readonly _root: TrieNode = { children: new Map(), index: undefined };
+
+  add(key: string, index: number): void {
+    let node = this._root;
+    for (const c of key) {
+      let child = node.children.get(c);
+      if (child === undefined) {
+        child = { children: new Map(), index: undefined };
+        node.children.set(c, child);
+      }
+      node = child;
+    }
+    if (node.index === undefined || index < node.index) node.index = index;
+  }
+
+  /**
+   * @returns the smallest index of the keys which are prefixes of the input
+   */
+  findFirstPrefix(input: string): number | undefined {
+    let found = this._root.index;
+    let node: TrieNode | undefined = this._root;
+    for (const c of input) {
+      node = node.children.get(c);
+      if (node === undefined) break;
+      if (node.index !== undefined && (found === undefined || node.index < found)) found = node.index;
+    }
+    return found;
+  }
+}
@@ -0,0 +1,239 @@
+import * as pathlib from 'path';
+import * as vscode from 'vscode';
+import { Logger } from '../Logger';
+import * as TMA from '../TestMateApi';
+import { decodeTypedArray, encodeTypedArray, PersistentJsonFile } from './PersistentJsonFile';
+
+///
+
+interface StoredIndex {
+  version: number;
+  tests: string[];
+  // base64 encoded Uint32Array bitmaps of the test indexes, every distinct set is stored once
+  sets: string[];
+  // [line, setIndex, line, setIndex, ...] by file path
+  files: Record<string, number[]>;
+}
+
+const storedVersion = 1;
+
+function withBits(bitmap: Uint32Array | undefined, bits: readonly number[]): Uint32Array {
+  // not spread into Math.max: the number of the arguments is limited
+  let length = bitmap?.length ?? 0;
+  for (const bit of bits) length = Math.max(length, (bit >>> 5) + 1);
+  const result = new Uint32Array(length);
+  if (bitmap !== undefined) result.set(bitmap);
+  for (const bit of bits) result[bit >>> 5] |= 1 << (bit & 31);
+  return result;
+}
+
+function forEachBit(bitmap: Uint32Array, func: (bit: number) => void): void {
+  for (let word = 0; word < bitmap.length; ++word) {
+    for (let bits = bitmap[word]; bits !== 0; bits &= bits - 1) func((word << 5) + (31 - Math.clz32(bits & -bits)));
+  }
+}
+
+/**
+ * Line → set of tests index of the per-test coverage.
+ * The sets are bitmaps of the indexes of the test ids: a line covered by thousands of tests costs a few hundred bytes.
+ * The bitmaps are interned and immutable: the lines covered by the same tests share one.
+ * The index is loaded lazily and saved to the storage directory after every update.
+ */
+export class TestCoverageIndex implements TMA.TestMateTestCoverageIndex, vscode.Disposable {
+  constructor(
+    storageDir: string | undefined,
+    private readonly _log: Logger,
+  ) {
+    this._file = new PersistentJsonFile<StoredIndex>(
+      storageDir !== undefined ? pathlib.join(storageDir, 'testCoverageIndex.json') : undefined,
+      storedVersion,
+      _log,
+      'TestCoverageIndex',
+      stored => this._restore(stored),
+      () => this._serialize(),
+    );
+  }
+
+  private readonly _file: PersistentJsonFile<StoredIndex>;
+  private readonly _tests: string[] = [];
+  private readonly _testIndexes = new Map<string /*testId*/, number>();
+  private readonly _files = new Map<string /*fsPath*/, Map<number /*line*/, Uint32Array>>();
+  private _sets = new Map<string /*encoded*/, Uint32Array>();
+
+  dispose(): void {
+    this._file.dispose();
+  }
+
+  async update(records: readonly TMA.TestMateTestCoverageRecord[]): Promise<void> {
+    await this._file.load();
+
+    const updated = new Set<number>();
+    for (const record of records) for (const id of record.testIds) updated.add(this._getTestIndex(id));
+    if (updated.size > 0) {
+      const cleared = withBits(undefined, [...updated]);
+      this._mapBitmaps(bitmap =>
+        this._intern(bitmap.map((word, i) => (i < cleared.length ? word & ~cleared[i] : word))),
+      );
+    }
+
+    for (const record of records) {
+      const indexes = record.testIds.map(id => this._getTestIndex(id));
+      if (indexes.length === 0) continue;
+      // the lines with the same set get the same new set
+      const transitions = new Map<Uint32Array | undefined, Uint32Array>();
+      for (const [file, lines] of record.coveredLines) {
+        let ofFile = this._files.get(file);
+        if (ofFile === undefined) {
+          ofFile = new Map();
+          this._files.set(file, ofFile);
+        }
+        for (const line of lines) {
+          const bitmap = ofFile.get(line);
+          let next = transitions.get(bitmap);
+          if (next === undefined) {
+            next = this._intern(withBits(bitmap, indexes))!;
+            transitions.set(bitmap, next);
+          }
+          ofFile.set(line, next);
+        }
+      }
+    }
+    this._releaseUnusedSets();
+
+    this._log.info('TestCoverageIndex: updated', records.length, this._files.size, this._sets.size);
+    this._file.scheduleSave();
+  }
+
+  /**
+   * Forgets the tests which don't exist anymore: their indexes are reused.
+   */
+  async removeTests(testIds: readonly string[]): Promise<void> {
+    await this._file.load();
+
+    const removed = new Set<number>();
+    for (const id of testIds) {
+      const index = this._testIndexes.get(id);
+      if (index !== undefined) removed.add(index);
+    }
+    if (removed.size === 0) return;
+
+    const tests: string[] = [];
+    const newIndexes = this._tests.map((id, i) => (removed.has(i) ? -1 : tests.push(id) - 1));
+    this._mapBitmaps(bitmap => {
+      const bits: number[] = [];
+      forEachBit(bitmap, bit => {
+        if (newIndexes[bit] !== -1) bits.push(newIndexes[bit]);
+      });
+      return bits.length > 0 ? this._intern(withBits(undefined, bits)) : undefined;
+    });
+    this._releaseUnusedSets();
+
+    this._tests.splice(0, this._tests.length, ...tests);
+    this._testIndexes.clear();
+    tests.forEach((id, i) => this._testIndexes.set(id, i));
+
+    this._log.info('TestCoverageIndex: removed tests', removed.size);
+    this._file.scheduleSave();
+  }
+
+  async getTestsCoveringLines(file: vscode.Uri, lines: readonly number[]): Promise<string[]> {
+    await this._file.load();
+
+    const ofFile = this._files.get(file.fsPath);
+    if (ofFile === undefined) return [];
+
+    let union = new Uint32Array(0);
+    for (const line of lines) {
+      const bitmap = ofFile.get(line);
+      if (bitmap === undefined) continue;
+      if (bitmap.length > union.length) {
+        const grown = new Uint32Array(bitmap.length);
+        grown.set(union);
+        union = grown;
+      }
+      for (let i = 0; i < bitmap.length; ++i) union[i] |= bitmap[i];
+    }
+
+    const testIds: string[] = [];
+    forEachBit(union, bit => testIds.push(this._tests[bit]));
+    return testIds;
+  }
+
+  private _getTestIndex(testId: string): number {
+    let index = this._testIndexes.get(testId);
+    if (index === undefined) {
+      index = this._tests.length;
+      this._tests.push(testId);
+      this._testIndexes.set(testId, index);
+    }
+    return index;
+  }
+
+  /**
+   * @returns the interned equivalent of the bitmap, `undefined` if it is empty
+   */
+  private _intern(bitmap: Uint32Array): Uint32Array | undefined {
+    let length = bitmap.length;
+    while (length > 0 && bitmap[length - 1] === 0) --length;
+    if (length === 0) return undefined;
+    if (length < bitmap.length) bitmap = bitmap.slice(0, length);
+
+    const encoded = encodeTypedArray(bitmap);
+    const interned = this._sets.get(encoded);
+    if (interned !== undefined) return interned;
+    this._sets.set(encoded, bitmap);
+    return bitmap;
+  }
+
+  /**
+   * Replaces every set by `func`: it is called once per distinct set.
+   */
+  private _mapBitmaps(func: (bitmap: Uint32Array) => Uint32Array | undefined): void {
+    const mapped = new Map<Uint32Array, Uint32Array | undefined>();
+    for (const [file, ofFile] of this._files) {
+      for (const [line, bitmap] of ofFile) {
+        let next = mapped.get(bitmap);
+        if (next === undefined && !mapped.has(bitmap)) {
+          next = func(bitmap);
+          mapped.set(bitmap, next);
+        }
+        if (next === undefined) ofFile.delete(line);
+        else if (next !== bitmap) ofFile.set(line, next);
+      }
+      if (ofFile.size === 0) this._files.delete(file);
+    }
+  }
+
+  private _releaseUnusedSets(): void {
+    const used = new Set<Uint32Array>();
+    for (const ofFile of this._files.values()) for (const bitmap of ofFile.values()) used.add(bitmap);
+    this._sets = new Map([...this._sets].filter(([, bitmap]) => used.has(bitmap)));
+  }
+
+  private _restore(stored: StoredIndex): void {
+    for (const id of stored.tests) this._getTestIndex(id);
+    const sets = stored.sets.map(encoded => this._intern(decodeTypedArray(encoded, Uint32Array)));
+    for (const file in stored.files) {
+      const pairs = stored.files[file];
+      const ofFile = new Map<number, Uint32Array>();
+      for (let i = 0; i + 1 < pairs.length; i += 2) {
+        const bitmap = sets[pairs[i + 1]];
+        if (bitmap !== undefined) ofFile.set(pairs[i], bitmap);
+      }
+      if (ofFile.size > 0) this._files.set(file, ofFile);
+    }
+    this._releaseUnusedSets();
+  }
+
+  private _serialize(): StoredIndex {
+    const stored: StoredIndex = { version: storedVersion, tests: this._tests, sets: [], files: {} };
+    const setIndexes = new Map<Uint32Array, number>();
+    for (const [encoded, bitmap] of this._sets) setIndexes.set(bitmap, stored.sets.push(encoded) - 1);
+    for (const [file, ofFile] of this._files) {
+      const pairs: number[] = [];
+      for (const [line, bitmap] of ofFile) pairs.push(line, setIndexes.get(bitmap)!);
+      stored.files[file] = pairs;
+    }
+    return stored;
+  }
+}
@@ -0,0 +1,146 @@
+import * as vscode from 'vscode';
+import { Logger } from '../Logger';
+
+///
+
+type DurationsOfExec = Record<string /*testId*/, number /*milisec*/>;
+
+/**
+ * Remembers the last known duration of the tests so parallel runs of the same executable
+ * can be balanced. It is persisted in the workspace state so it survives restarts.
+ */
+export class TestDurationStore implements vscode.Disposable {
+  constructor(
+    private readonly _memento: vscode.Memento | undefined,
+    private readonly _log: Logger,
+  ) {
+    try {
+      const stored = this._memento?.get<Record<string, DurationsOfExec>>(TestDurationStore._mementoKey);
+      if (stored && typeof stored === 'object') {
+        for (const execKey in stored) this._durations.set(execKey, stored[execKey]);
+      }
+    } catch (e) {
+      this._log.exceptionS(e, 'TestDurationStore: loading');
+    }
+  }
+
+  private static readonly _mementoKey = 'testMate.cpp.testDurations';
+  private static readonly _saveDelayMillis = 5000;
+  // smoothing factor: a single outlier shouldn't reorder the buckets too much
+  private static readonly _newValueWeight = 0.5;
+
+  private readonly _durations = new Map<string /*execKey*/, DurationsOfExec>();
+  private _saveTimer: NodeJS.Timeout | undefined = undefined;
+
+  dispose(): void {
+    if (this._saveTimer) {
+      clearTimeout(this._saveTimer);
+      this._save();
+    }
+  }
+
+  get(execKey: string, testId: string): number | undefined {
+    return this._durations.get(execKey)?.[testId];
+  }
+
+  set(execKey: string, testId: string, durationMilisec: number): void {
+    if (!Number.isFinite(durationMilisec) || durationMilisec < 0) return;
+
+    let ofExec = this._durations.get(execKey);
+    if (ofExec === undefined) {
+      ofExec = {};
+      this._durations.set(execKey, ofExec);
+    }
+
+    const prev = ofExec[testId];
+    ofExec[testId] =
+      prev === undefined ? durationMilisec : prev + (durationMilisec - prev) * TestDurationStore._newValueWeight;
+
+    this._scheduleSave();
+  }
+
+  removeMissing(execKey: string, existingTestIds: Iterable<string>): void {
+    const ofExec = this._durations.get(execKey);
+    if (ofExec === undefined) return;
+
+    const existing = new Set(existingTestIds);
+    let changed = false;
+    for (const testId of Object.keys(ofExec)) {
+      if (!existing.has(testId)) {
+        delete ofExec[testId];
+        changed = true;
+      }
+    }
+    if (Object.keys(ofExec).length === 0) this._durations.delete(execKey);
+    if (changed) this._scheduleSave();
+  }
+
+  private _scheduleSave(): void {
+    if (this._saveTimer || this._memento === undefined) return;
+    this._saveTimer = setTimeout(() => {
+      this._saveTimer = undefined;
+      this._save();
+    }, TestDurationStore._saveDelayMillis);
+  }
+
+  private _save(): void {
+    if (this._memento === undefined) return;
+    const toStore: Record<string, DurationsOfExec> = {};
+    for (const [execKey, ofExec] of this._durations) toStore[execKey] = ofExec;
+    this._memento.update(TestDurationStore._mementoKey, toStore).then(undefined, e => {
+      this._log.exceptionS(e, 'TestDurationStore: saving');
+    });
+  }
+}
+
+///
+
+/**
+ * Longest-processing-time-first: items with known duration are assigned one by one (slowest first)
+ * to the bucket with the least total duration. Items without duration are dealt round-robin.
+ * No bucket gets more items than the round-robin would give it, so `maxTestsPerExecutable` is respected.
+ * @returns the non-empty buckets
+ */
+export function distributeByDuration<T>(
+  items: readonly T[],
+  bucketCount: number,
+  getDuration: (item: T) => number | undefined,
+): { buckets: T[][]; bucketDurations: number[]; withoutDurationCount: number } {
+  const buckets: T[][] = Array.from({ length: bucketCount }, () => []);
+  const bucketDurations: number[] = Array.from({ length: bucketCount }, () => 0);
+  const bucketSizeLimit = Math.ceil(items.length / bucketCount);
+
+  const withDuration: [T, number][] = [];
+  const withoutDuration: T[] = [];
+  for (const item of items) {
+    const duration = getDuration(item);
+    if (duration !== undefined) withDuration.push([item, duration]);
+    else withoutDuration.push(item);
+  }
+
+  withDuration.sort((a, b) => b[1] - a[1]);
+
+  for (const [item, duration] of withDuration) {
+    let minIndex = -1;
+    for (let i = 0; i < buckets.length; ++i) {
+      if (buckets[i].length < bucketSizeLimit && (minIndex === -1 || bucketDurations[i] < bucketDurations[minIndex]))
+        minIndex = i;
+    }
+    buckets[minIndex].push(item);
+    bucketDurations[minIndex] += duration;
+  }
+
+  let next = 0;
+  for (const item of withoutDuration) {
+    while (buckets[next % buckets.length].length >= bucketSizeLimit) ++next;
+    buckets[next++ % buckets.length].push(item);
+  }
+
+  // the durations have to stay at the index of their bucket
+  const nonEmpty = buckets.map((_, i) => i).filter(i => buckets[i].length > 0);
+  return {
+    buckets: nonEmpty.map(i => buckets[i]),
+    bucketDurations: nonEmpty.map(i => bucketDurations[i]),
+    withoutDurationCount: withoutDuration.length,
+  };
+}
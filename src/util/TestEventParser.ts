@@ -0,0 +1,170 @@
+import { Logger } from '../Logger';
+import { ElfFile } from './Elf';
+import { isThenable, ParserInterface } from './ParserInterface';
+
+///
+
+// documents/examples/test_events/testmate_events.hpp
+export const testEventsFdEnv = 'TESTMATE_EVENTS_FD';
+export const testEventsRequestedEnv = 'TESTMATE_EVENTS';
+export const testEventsFd = 3;
+export const testEventsVersion = 1;
+// the reporter reads this variable: the string literal is in the binary
+const testEventsSignature = testEventsFdEnv;
+
+export interface TestEventHello {
+  type: 'hello';
+  version: number;
+}
+
+export interface TestEventTestStart {
+  type: 'testStart';
+  name: string;
+  suite?: string;
+  file?: string;
+  line?: number;
+}
+
+export interface TestEventFailure {
+  type: 'failure';
+  file?: string;
+  line?: number;
+  macro?: string;
+  expr?: string;
+  expanded?: string;
+  message?: string;
+  kind?: 'exception';
+}
+
+export interface TestEventTestEnd {
+  type: 'testEnd';
+  result: 'passed' | 'failed' | 'skipped';
+  durationMs?: number;
+}
+
+// Catch2 section, doctest subcase: nested into the test or into an other section
+export interface TestEventSectionStart {
+  type: 'sectionStart';
+  name: string;
+  file?: string;
+  line?: number;
+}
+
+export interface TestEventSectionEnd {
+  type: 'sectionEnd';
+  result: 'passed' | 'failed' | 'skipped';
+  durationMs?: number;
+}
+
+export type TestEvent =
+  | TestEventHello
+  | TestEventTestStart
+  | TestEventFailure
+  | TestEventTestEnd
+  | TestEventSectionStart
+  | TestEventSectionEnd;
+
+/**
+ * @returns true if the signature of the reporter is found in the ELF binary, false otherwise (other formats too)
+ */
+export async function hasTestEventsReporter(path: string, log: Logger): Promise<boolean> {
+  const elf = await ElfFile.open(path);
+  if (elf === undefined) return false;
+  try {
+    return (await elf.findInSections(['.rodata'], [testEventsSignature])).size > 0;
+  } catch (e) {
+    log.warn('TestMate event reporter detection', path, e);
+    return false;
+  } finally {
+    await elf.close().catch(() => {});
+  }
+}
+
+/**
+ * Parses the NDJSON events of the TestMate event reporter.
+ * The events are processed synchronously as long as the handler returns synchronously.
+ * If it returns a promise the following events are queued until it is resolved.
+ */
+export class TestEventParser implements ParserInterface {
+  constructor(
+    private readonly _log: Logger,
+    private readonly _handler: (event: TestEvent) => void | Promise<void>,
+  ) {}
+
+  private _lastLine = '';
+  private _pending: TestEvent[] = [];
+  // undefined: nothing is pending, the events can be processed synchronously
+  private _asyncLoop: Promise<void> | undefined = undefined;
+
+  write(data: string): void {
+    let newline = data.indexOf('\n');
+    if (newline === -1) {
+      this._lastLine += data;
+      return;
+    }
+
+    this._parseLine(this._lastLine + data.substring(0, newline));
+    let start = newline + 1;
+    while ((newline = data.indexOf('\n', start)) !== -1) {
+      this._parseLine(data.substring(start, newline));
+      start = newline + 1;
+    }
+    this._lastLine = data.substring(start);
+  }
+
+  async end(): Promise<void> {
+    if (this._lastLine) this._parseLine(this._lastLine);
+    this._lastLine = '';
+    await this._asyncLoop;
+  }
+
+  writeStdErr(_data: string): Promise<boolean> {
+    return Promise.resolve(false);
+  }
+
+  private _parseLine(line: string): void {
+    if (!line.trim()) return;
+
+    let event: TestEvent;
+    try {
+      event = JSON.parse(line);
+    } catch (e) {
+      this._log.warn('TestEventParser: invalid event', line, e);
+      return;
+    }
+
+    if (this._asyncLoop !== undefined) {
+      this._pending.push(event);
+      return;
+    }
+
+    const r = this._handle(event);
+    if (isThenable(r)) this._asyncLoop = this._loop(r);
+  }
+
+  private _handle(event: TestEvent): void | Promise<void> {
+    try {
+      return this._handler(event);
+    } catch (e) {
+      this._log.exceptionS(e, 'TestEventParser', event);
+    }
+  }
+
+  private async _loop(first: Promise<void>): Promise<void> {
+    try {
+      await first;
+    } catch (e) {
+      this._log.exceptionS(e, 'TestEventParser');
+    }
+    // new events can be pushed while waiting
+    for (let i = 0; i < this._pending.length; ++i) {
+      try {
+        await this._handle(this._pending[i]);
+      } catch (e) {
+        this._log.exceptionS(e, 'TestEventParser', this._pending[i]);
+      }
+    }
+    this._pending = [];
+    this._asyncLoop = undefined;
+  }
+}
@@ -0,0 +1,172 @@
+import * as fs from 'fs';
+import * as pathlib from 'path';
+import * as crypto from 'crypto';
+import * as vscode from 'vscode';
+import { Logger } from '../Logger';
+import { readElfBuildId } from './Elf';
+import { writeFileAtomic } from './PersistentJsonFile';
+
+///
+
+/**
+ * Central store of the test lists of the executables. Shared by every workspace.
+ *
+ * The ELF executables are keyed by their build-id so a relink which produces the same binary or a restored build
+ * cache can reuse the list. Other executables (PE, Mach-O) are keyed by the size, the modification time and
+ * a hash of the beginning and the end of the file: hashing the whole of a big debug binary would be too slow.
+ * Every entry is a file in the storage directory: the modification time of the file is the last usage time,
+ * the least recently used ones are removed if the total size exceeds the limit.
+ */
+export class TestListCache implements vscode.Disposable {
+  constructor(
+    storageDir: string | undefined,
+    private readonly _log: Logger,
+    private readonly _maxSizeBytes: number = 64 * 1024 * 1024,
+  ) {
+    this._dir = storageDir !== undefined ? pathlib.join(storageDir, 'testListCache') : undefined;
+  }
+
+  private static readonly _extension = '.testlist';
+  private static readonly _evictionDelayMillis = 10000;
+  private static readonly _sampleSizeBytes = 1024 * 1024;
+
+  private readonly _dir: string | undefined;
+  private _dirCreated: Promise<boolean> | undefined = undefined;
+  private _evictionTimer: NodeJS.Timeout | undefined = undefined;
+  // the content id is recalculated only if the file has changed
+  private readonly _contentIdCache = new Map<string /*path*/, { mtimeMs: number; size: number; id: Promise<string> }>();
+
+  dispose(): void {
+    if (this._evictionTimer) clearTimeout(this._evictionTimer);
+    this._evictionTimer = undefined;
+  }
+
+  get isAvailable(): boolean {
+    return this._dir !== undefined;
+  }
+
+  /**
+   * @param keyParts everything else which affects the output of the listing (framework, version, arguments, env)
+   */
+  async get(execPath: string, keyParts: readonly string[]): Promise<string | undefined> {
+    if (this._dir === undefined) return undefined;
+
+    let entryPath: string | undefined = undefined;
+    try {
+      entryPath = await this._getEntryPath(execPath, keyParts);
+      const content = await fs.promises.readFile(entryPath, 'utf8');
+      const now = new Date();
+      fs.promises.utimes(entryPath, now, now).catch(e => this._log.debug('TestListCache: touch', e));
+      this._log.info('TestListCache: hit', execPath, entryPath);
+      return content;
+    } catch (e) {
+      if ((e as NodeJS.ErrnoException).code !== 'ENOENT') this._log.warn('TestListCache: read', execPath, entryPath, e);
+      return undefined;
+    }
+  }
+
+  async set(execPath: string, keyParts: readonly string[], content: string): Promise<void> {
+    if (this._dir === undefined || content.length === 0) return;
+    if (!(await this._ensureDir())) return;
+
+    try {
+      // the entries are content addressed: the windows writing the same one write the same content
+      await writeFileAtomic(await this._getEntryPath(execPath, keyParts), content);
+      this._scheduleEviction();
+    } catch (e) {
+      this._log.warn('TestListCache: write', execPath, e);
+    }
+  }
+
+  private async _getEntryPath(execPath: string, keyParts: readonly string[]): Promise<string> {
+    const contentId = await this._getContentId(execPath);
+    const hash = crypto.createHash('sha1');
+    hash.update(contentId);
+    for (const part of keyParts) hash.update('\0' + part);
+    return pathlib.join(this._dir!, hash.digest('hex') + TestListCache._extension);
+  }
+
+  private async _getContentId(execPath: string): Promise<string> {
+    const stat = await fs.promises.stat(execPath);
+    const cached = this._contentIdCache.get(execPath);
+    if (cached && cached.mtimeMs === stat.mtimeMs && cached.size === stat.size) return cached.id;
+
+    const id = (async (): Promise<string> => {
+      const buildId = await readElfBuildId(execPath);
+      if (buildId) return `build-id:${buildId}`;
+      const sample = await hashFileSample(execPath, stat.size, TestListCache._sampleSizeBytes);
+      return `sample:${sample}:${stat.size}:${stat.mtimeMs}`;
+    })();
+    this._contentIdCache.set(execPath, { mtimeMs: stat.mtimeMs, size: stat.size, id });
+    id.catch(() => this._contentIdCache.delete(execPath));
+    return id;
+  }
+
+  private _ensureDir(): Promise<boolean> {
+    if (this._dirCreated === undefined) {
+      this._dirCreated = fs.promises.mkdir(this._dir!, { recursive: true }).then(
+        () => true,
+        e => {
+          this._log.warn('TestListCache: cannot create dir', this._dir, e);
+          this._dirCreated = undefined;
+          return false;
+        },
+      );
+    }
+    return this._dirCreated;
+  }
+
+  private _scheduleEviction(): void {
+    if (this._evictionTimer) return;
+    this._evictionTimer = setTimeout(() => {
+      this._evictionTimer = undefined;
+      this._evict().catch(e => this._log.warn('TestListCache: eviction', e));
+    }, TestListCache._evictionDelayMillis);
+  }
+
+  private async _evict(): Promise<void> {
+    const dir = this._dir!;
+    const names = (await fs.promises.readdir(dir)).filter(n => n.endsWith(TestListCache._extension));
+    const entries: { path: string; size: number; mtimeMs: number }[] = [];
+    for (const name of names) {
+      const path = pathlib.join(dir, name);
+      try {
+        const stat = await fs.promises.stat(path);
+        entries.push({ path, size: stat.size, mtimeMs: stat.mtimeMs });
+      } catch {} // eslint-disable-line
+    }
+
+    let totalSize = entries.reduce((acc, e) => acc + e.size, 0);
+    if (totalSize <= this._maxSizeBytes) return;
+
+    // least recently used first
+    entries.sort((a, b) => a.mtimeMs - b.mtimeMs);
+    for (const entry of entries) {
+      if (totalSize <= this._maxSizeBytes) break;
+      try {
+        await fs.promises.unlink(entry.path);
+        totalSize -= entry.size;
+      } catch (e) {
+        this._log.debug('TestListCache: unlink', entry.path, e);
+      }
+    }
+    this._log.info('TestListCache: evicted', dir, totalSize);
+  }
+}
+
+// md5 of the first and the last `sampleSize` bytes
+async function hashFileSample(path: string, size: number, sampleSize: number): Promise<string> {
+  const hash = crypto.createHash('md5');
+  const fd = await fs.promises.open(path, 'r');
+  try {
+    const ranges = size <= 2 * sampleSize ? [[0, size]] : [[0, sampleSize], [size - sampleSize, sampleSize]];
+    for (const [position, length] of ranges) {
+      const buffer = Buffer.alloc(length);
+      const { bytesRead } = await fd.read(buffer, 0, length, position);
+      hash.update(buffer.subarray(0, bytesRead));
+    }
+  } finally {
+    await fd.close();
+  }
+  return hash.digest('hex');
+}
@@ -1,20 +1,32 @@
 import { Logger } from '../Logger';
 import { debugBreak } from './DevelopmentHelper';
-import { ParserInterface } from './ParserInterface';
+import { isThenable, ParserInterface } from './ParserInterface';
 
+type LineResult = void | boolean | LineProcessor;
+
+// the consumed lines are dropped only above this to avoid copying on every chunk
+const _compactionThreshold = 4096;
+
+/**
+ * The lines are processed synchronously as long as the processors return synchronously.
+ * If a processor returns a promise the following lines are queued until it is resolved.
+ */
 export class TextStreamParser implements ParserInterface {
   constructor(
     private readonly log: Logger,
-    rootProcessor: RootLineProcessor,
+    private readonly rootProcessor: RootLineProcessor,
     private readonly handleStdErr = true,
   ) {
     this.topProcessor = rootProcessor;
   }
 
-  private readonly lines: string[] = [];
+  // lines before `nextLine` are already processed
+  private lines: string[] = [];
+  private nextLine = 0;
   private lastLine = '';
 
-  private sequentialP = Promise.resolve();
+  // undefined: nothing is pending, the lines can be processed synchronously
+  private asyncLoop: Promise<void> | undefined = undefined;
   private readonly processorStack: LineProcessor[] = [];
   private topProcessor: LineProcessor;
 
@@ -26,7 +38,7 @@ export class TextStreamParser implements ParserInterface {
 
     this._process();
 
-    await this.sequentialP;
+    await this.asyncLoop;
 
     if (this.topProcessor.end) await this.topProcessor.end();
 
@@ -37,17 +49,33 @@ export class TextStreamParser implements ParserInterface {
   }
 
   write(data: string): void {
-    if (data) {
-      const lines = data.split(/\r?\n/); // has at least 1 element
-
-      lines[0] = this.lastLine + lines[0];
+    if (!data) return;
 
-      this.lastLine = lines.pop()!; // has at least 1 element
+    let newline = data.indexOf('\n');
+    if (newline === -1) {
+      this.lastLine += data;
+      return;
+    }
 
-      this.lines.push(...lines);
+    let start = 0;
+    let lastLine = this.lastLine;
+    do {
+      const end = newline > 0 && data.charCodeAt(newline - 1) === 13 /* \r */ ? newline - 1 : newline;
+      if (lastLine) {
+        // the previous chunk could have ended with '\r'
+        const line = lastLine + data.substring(start, end);
+        this.lines.push(newline === 0 && line.endsWith('\r') ? line.substring(0, line.length - 1) : line);
+        lastLine = '';
+      } else {
+        this.lines.push(data.substring(start, end));
+      }
+      start = newline + 1;
+      newline = data.indexOf('\n', start);
+    } while (newline !== -1);
+
+    this.lastLine = data.substring(start);
 
-      if (lines.length) this._process();
-    }
+    this._process();
   }
 
   writeStdErr(data: string): Promise<boolean> {
@@ -56,34 +84,110 @@ export class TextStreamParser implements ParserInterface {
   }
 
   private _process(): void {
-    this.sequentialP = this.sequentialP
-      .then(async () => {
-        while (this.lines.length) {
-          const line = this.lines.shift()!;
-          const result = await this.topProcessor.online(line);
-
-          if (typeof result === 'boolean') {
-            if (this.processorStack.length) {
-              if (this.topProcessor.end) await this.topProcessor.end();
-              this.topProcessor = this.processorStack.pop()!;
-              if (!result) {
-                // putting back because the popped processor should process it too
-                this.lines.unshift(line);
-              }
-            } else {
-              debugBreak();
-              this.log.error('rootProcessor should not be dropped');
-            }
-          } else if (result === undefined) {
-            // skip: the line was processed
-          } else {
-            this.processorStack.push(this.topProcessor);
-            this.topProcessor = result;
-            if (result.begin) await result.begin(line);
-          }
+    // the running loop will continue with the new lines
+    if (this.asyncLoop !== undefined) return;
+
+    const pending = this._processSync();
+    if (pending !== undefined) {
+      this.asyncLoop = this._processAsync(pending).finally(() => (this.asyncLoop = undefined));
+    }
+  }
+
+  /**
+   * @returns the first promise returned by a processor: the rest has to be processed asynchronously
+   */
+  private _processSync(): PromiseLike<void> | undefined {
+    while (this._hasNextLine()) {
+      const current = this.nextLine;
+      try {
+        const result = this._processNext();
+        if (isThenable(result)) return result;
+      } catch (e) {
+        this._onError(e, current);
+      }
+    }
+    return undefined;
+  }
+
+  private async _processAsync(pending: PromiseLike<void>): Promise<void> {
+    try {
+      await pending;
+    } catch (e) {
+      this.log.exceptionS(e);
+    }
+
+    while (this._hasNextLine()) {
+      const current = this.nextLine;
+      try {
+        const result = this._processNext();
+        if (isThenable(result)) await result;
+      } catch (e) {
+        this._onError(e, current);
+      }
+    }
+  }
+
+  private _onError(e: Error, lineBefore: number): void {
+    this.log.exceptionS(e);
+    // skipping the line which couldn't be processed
+    if (this.nextLine === lineBefore) ++this.nextLine;
+  }
+
+  private _hasNextLine(): boolean {
+    if (this.nextLine < this.lines.length) {
+      if (this.nextLine > _compactionThreshold && this.nextLine * 2 > this.lines.length) {
+        this.lines = this.lines.slice(this.nextLine);
+        this.nextLine = 0;
+      }
+      return true;
+    } else {
+      this.lines = [];
+      this.nextLine = 0;
+      return false;
+    }
+  }
+
+  private _processNext(): void | PromiseLike<void> {
+    const top = this.topProcessor;
+
+    if (top === this.rootProcessor && this.rootProcessor.onlines) {
+      const count = this.rootProcessor.onlines(this.lines, this.nextLine);
+      if (isThenable(count)) return count.then(c => this._onLinesProcessed(c));
+      this._onLinesProcessed(count);
+    }
+
+    if (this.nextLine >= this.lines.length) return;
+
+    const line = this.lines[this.nextLine++];
+    const result = top.online(line);
+    return isThenable(result) ? result.then(r => this._onResult(line, r)) : this._onResult(line, result);
+  }
+
+  private _onLinesProcessed(count: number): void {
+    this.nextLine = Math.min(this.nextLine + Math.max(0, count), this.lines.length);
+  }
+
+  private _onResult(line: string, result: LineResult): void | PromiseLike<void> {
+    if (typeof result === 'boolean') {
+      if (this.processorStack.length) {
+        const retired = this.topProcessor;
+        this.topProcessor = this.processorStack.pop()!;
+        if (!result) {
+          // putting back because the popped processor should process it too
+          --this.nextLine;
         }
-      })
-      .catch(e => this.log.exceptionS(e));
+        if (retired.end) return retired.end();
+      } else {
+        debugBreak();
+        this.log.error('rootProcessor should not be dropped');
+      }
+    } else if (result === undefined) {
+      // skip: the line was processed
+    } else {
+      this.processorStack.push(this.topProcessor);
+      this.topProcessor = result;
+      if (result.begin) return result.begin(line);
+    }
   }
 }
 
@@ -93,6 +197,7 @@ export interface LineProcessor {
   end?(): void | Promise<void>;
 
   /**
+   * Synchronous return value is preferred: a promise makes the parser queue the following lines.
    * @returns `LineProcessor` the control is passed to the new processor
    *            - `begin` will be called with current line
    *            - `online` will be called with the following lines
@@ -108,6 +213,14 @@ export interface RootLineProcessor extends LineProcessor {
   end?(): void;
 
   online(line: string): void | LineProcessor | Promise<void | LineProcessor>;
+
+  /**
+   * Optional batch version of `online` for the lines which don't need a new processor.
+   * It is called with the available lines, starting from `lines[start]`, before `online` is.
+   * @returns the number of processed lines: it should stop before the first line which needs a new processor.
+   *          `online` will be called with that line.
+   */
+  onlines?(lines: readonly string[], start: number): number | Promise<number>;
 }
 
 export class NoOpLineProcessor implements LineProcessor {
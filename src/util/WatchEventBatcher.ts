@@ -0,0 +1,91 @@
+import { Logger } from '../Logger';
+
+///
+
+export interface WatchEventBatcherHandler {
+  /**
+   * Called once per batch. The batches wait for each other only here.
+   */
+  waitForBuild(): Promise<void>;
+  /**
+   * The paths are handled in ascending order of the rank.
+   */
+  rank(filePath: string): number;
+  handle(filePath: string): Promise<void>;
+}
+
+/**
+ * Collects the watcher events and handles them together when the build is quiet: a relink touches many files.
+ * The batch starts after `quietPeriodMillis` without new event or at latest `maxDelayMillis` after its first event.
+ * The handling of the paths is not awaited by the next batch: a file which isn't ready yet can be retried for long.
+ */
+export class WatchEventBatcher {
+  constructor(
+    private readonly _log: Logger,
+    private readonly _handler: WatchEventBatcherHandler,
+    private readonly _quietPeriodMillis = 1000,
+    private readonly _maxDelayMillis = 10000,
+    // the paths of a rank get this much head start before the next rank is started
+    private readonly _rankHeadStartMillis = 2000,
+  ) {}
+
+  private readonly _pendingPaths = new Set<string /*fsPath*/>();
+  private _firstEventAt: number | undefined = undefined;
+  private _timer: NodeJS.Timeout | undefined = undefined;
+  private _waitingForBuild: Promise<void> | undefined = undefined;
+
+  dispose(): void {
+    if (this._timer) clearTimeout(this._timer);
+    this._timer = undefined;
+    this._pendingPaths.clear();
+  }
+
+  add(filePath: string): void {
+    this._pendingPaths.add(filePath);
+
+    const now = Date.now();
+    if (this._firstEventAt === undefined) this._firstEventAt = now;
+    // a continuous stream of events shouldn't postpone the handling forever
+    const delay = Math.min(this._quietPeriodMillis, Math.max(0, this._firstEventAt + this._maxDelayMillis - now));
+    if (this._timer) clearTimeout(this._timer);
+    this._timer = setTimeout(() => {
+      this._timer = undefined;
+      this._firstEventAt = undefined;
+      const filePaths = [...this._pendingPaths];
+      this._pendingPaths.clear();
+      this._startBatch(filePaths);
+    }, delay);
+  }
+
+  private _startBatch(filePaths: string[]): void {
+    // one build check at a time: the next batch waits for the previous one
+    const prev = this._waitingForBuild?.catch(() => {}) ?? Promise.resolve();
+    const waiting = prev.then(() => this._handler.waitForBuild());
+    this._waitingForBuild = waiting;
+    waiting
+      .finally(() => {
+        if (this._waitingForBuild === waiting) this._waitingForBuild = undefined;
+      })
+      .then(() => this._handleBatch(filePaths))
+      .catch(e => this._log.errorS('WatchEventBatcher: errors should be handled inside', e));
+  }
+
+  private async _handleBatch(filePaths: string[]): Promise<void> {
+    const byRank = new Map<number, string[]>();
+    for (const filePath of filePaths) {
+      const rank = this._handler.rank(filePath);
+      const ofRank = byRank.get(rank);
+      if (ofRank) ofRank.push(filePath);
+      else byRank.set(rank, [filePath]);
+    }
+    const ranks = [...byRank.keys()].sort((a, b) => a - b);
+    this._log.info('watcher batch:', ranks.map(r => `${r}: ${byRank.get(r)!.length}`).join(', '));
+
+    for (const rank of ranks) {
+      const handled = Promise.allSettled(byRank.get(rank)!.map(filePath => this._handler.handle(filePath)));
+      let timer: NodeJS.Timeout | undefined = undefined;
+      await Promise.race([handled, new Promise<void>(r => (timer = setTimeout(r, this._rankHeadStartMillis)))]);
+      clearTimeout(timer);
+    }
+  }
+}
@@ -1,14 +1,28 @@
 import * as htmlparser2 from 'htmlparser2';
 import { Logger } from '../Logger';
 import { debugBreak } from './DevelopmentHelper';
-import { ParserInterface } from './ParserInterface';
+import { isThenable, ParserInterface } from './ParserInterface';
 
 type ProcessorFrame = { tag: XmlTag; processor: XmlTagProcessor; nesting: number };
 type XmlTagFrame = XmlTag & { _text: string };
+type Step = () => void | PromiseLike<void>;
 
+const nonWhitespaceRe = /\S/;
+
+// calls `next` synchronously unless `value` is a promise
+function andThen<T>(value: T | PromiseLike<T>, next: (v: T) => void | PromiseLike<void>): void | PromiseLike<void> {
+  return isThenable(value) ? value.then(next) : next(value);
+}
+
+/**
+ * The events are processed synchronously as long as the processors return synchronously.
+ * If a processor returns a promise the following events are queued until it is resolved,
+ * so the order of the callbacks is the same in both cases.
+ */
 export class XmlParser implements ParserInterface {
   private readonly htmlParser: htmlparser2.Parser;
-  private sequentialP = Promise.resolve();
+  // undefined: nothing is pending, the next event can be processed synchronously
+  private asyncTail: Promise<void> | undefined = undefined;
   private readonly endP: Promise<void>;
   private readonly endPResolver: () => void;
   private readonly rootTag = { name: '<root>', attribs: {}, _text: '' };
@@ -29,93 +43,22 @@ export class XmlParser implements ParserInterface {
     this.htmlParser = new htmlparser2.Parser(
       {
         onopentag: (name: string, attribs: Record<string, string>): void => {
-          this.sequentialP = this.sequentialP.then(async () => {
-            // flush ontext
-            if (this.tagStack.length) {
-              const prevTag = this.tagStack[this.tagStack.length - 1];
-              if (this.topTagProcessor.processor.ontext) {
-                const trimmedText = prevTag._text.trim();
-                if (trimmedText) await this.topTagProcessor.processor.ontext(trimmedText, prevTag);
-              }
-              prevTag._text = '';
-            }
-
-            const tag = { name, attribs, _text: '' };
-            this.log.trace('onopentag', tag);
-            this.tagStack.push(tag);
-
-            if (this.topTagProcessor.processor.onopentag) {
-              const processor = await this.topTagProcessor.processor.onopentag(tag);
-              if (processor) {
-                this.xmlTagProcessorStack.push(this.topTagProcessor);
-                this.topTagProcessor = { tag, processor, nesting: 0 };
-                if (processor.begin) await processor.begin(tag);
-              } else {
-                if (this.topTagProcessor.tag.name === name) this.topTagProcessor.nesting++;
-              }
-            } else {
-              if (this.topTagProcessor.tag.name === name) this.topTagProcessor.nesting++;
-            }
-          });
+          this.schedule(() => this.onopentag(name, attribs));
         },
         onclosetag: (name: string): void => {
-          this.sequentialP = this.sequentialP.then(async () => {
-            this.log.trace('onclosetag', name);
-            const tag = this.tagStack.pop();
-
-            if (tag?.name !== name) {
-              debugger; // eslint-disable-line
-              throw Error('onclosetag: tag mismatch');
-            }
-
-            // flush ontext
-            if (this.topTagProcessor.processor.ontext) {
-              const trimmedText = tag._text.trim();
-              if (trimmedText) await this.topTagProcessor.processor.ontext(trimmedText, tag);
-            }
-
-            if (this.topTagProcessor.tag.name === name && --this.topTagProcessor.nesting < 0) {
-              if (this.topTagProcessor.processor.end) await this.topTagProcessor.processor.end();
-
-              if (this.xmlTagProcessorStack.length === 0) {
-                debugger; // eslint-disable-line
-                const error = Error('onclosetag should have at least the root');
-                this.log.exceptionS(error, this);
-                throw error;
-              }
-
-              this.topTagProcessor = this.xmlTagProcessorStack.pop()!;
-            } else {
-              if (this.topTagProcessor.processor.onclosetag) this.topTagProcessor.processor.onclosetag(tag);
-            }
-          });
+          this.schedule(() => this.onclosetag(name));
         },
         onend: () => {
-          this.sequentialP = this.sequentialP
-            .then(async () => {
-              this.log.trace('onend');
-
-              if (this.xmlTagProcessorStack.length !== 0) {
-                debugBreak();
-                this.log.warn('onend should not have more processors unless the parser was abandoned', this);
-              }
-
-              if (this.topTagProcessor.processor.ontext) {
-                const trimmedText = this.rootTag._text.trim();
-                if (trimmedText) await this.topTagProcessor.processor.ontext(trimmedText, this.rootTag);
-              }
-              if (this.topTagProcessor.processor.end) await this.topTagProcessor.processor.end();
-            })
+          (this.asyncTail ?? Promise.resolve())
+            .then(() => this.onend())
             .catch(reason => this.log.errorS(reason))
             .finally(this.endPResolver);
         },
         ontext: (dataStr: string): void => {
-          this.sequentialP = this.sequentialP.then(() => {
-            const dataTrimmed = dataStr.trim();
-            if (dataTrimmed === '') return;
-            this.log.trace('ontext', dataTrimmed);
-            const currTag = this.tagStack[this.tagStack.length - 1];
-            currTag._text += dataStr;
+          this.schedule(() => {
+            if (!nonWhitespaceRe.test(dataStr)) return;
+            this.log.trace('ontext', dataStr);
+            this.tagStack[this.tagStack.length - 1]._text += dataStr;
           });
         },
         onerror: (error: Error): void => {
@@ -129,8 +72,101 @@ export class XmlParser implements ParserInterface {
     this.topTagProcessor = { tag: this.rootTag, processor, nesting: 0 };
   }
 
+  private schedule(step: Step): void {
+    if (this.asyncTail !== undefined) {
+      this.setAsyncTail(this.asyncTail.then(step));
+      return;
+    }
+
+    try {
+      const result = step();
+      if (isThenable(result)) this.setAsyncTail(Promise.resolve(result));
+    } catch (e) {
+      // same as a rejected chain: the following steps are skipped and onend reports it
+      this.setAsyncTail(Promise.reject(e));
+    }
+  }
+
+  private setAsyncTail(p: Promise<void>): void {
+    // if it is rejected it stays the tail, so the rest of the steps are skipped
+    const tail: Promise<void> = p.then(() => {
+      if (this.asyncTail === tail) this.asyncTail = undefined;
+    });
+    this.asyncTail = tail;
+  }
+
+  private flushText(tag: XmlTagFrame): void | PromiseLike<void> {
+    const text = tag._text;
+    tag._text = '';
+    if (text && this.topTagProcessor.processor.ontext) {
+      const trimmedText = text.trim();
+      if (trimmedText) return this.topTagProcessor.processor.ontext(trimmedText, tag);
+    }
+  }
+
+  private onopentag(name: string, attribs: Record<string, string>): void | PromiseLike<void> {
+    return andThen(this.flushText(this.tagStack[this.tagStack.length - 1]), () => {
+      const tag = { name, attribs, _text: '' };
+      this.log.trace('onopentag', tag);
+      this.tagStack.push(tag);
+
+      if (this.topTagProcessor.processor.onopentag) {
+        return andThen(this.topTagProcessor.processor.onopentag(tag), processor => {
+          if (processor) {
+            this.xmlTagProcessorStack.push(this.topTagProcessor);
+            this.topTagProcessor = { tag, processor, nesting: 0 };
+            if (processor.begin) return processor.begin(tag);
+          } else {
+            if (this.topTagProcessor.tag.name === name) this.topTagProcessor.nesting++;
+          }
+        });
+      } else {
+        if (this.topTagProcessor.tag.name === name) this.topTagProcessor.nesting++;
+      }
+    });
+  }
+
+  private onclosetag(name: string): void | PromiseLike<void> {
+    this.log.trace('onclosetag', name);
+    const tag = this.tagStack.pop();
+
+    if (tag?.name !== name) {
+      debugger; // eslint-disable-line
+      throw Error('onclosetag: tag mismatch');
+    }
+
+    return andThen(this.flushText(tag), () => {
+      if (this.topTagProcessor.tag.name === name && --this.topTagProcessor.nesting < 0) {
+        return andThen(this.topTagProcessor.processor.end?.(), () => {
+          if (this.xmlTagProcessorStack.length === 0) {
+            debugger; // eslint-disable-line
+            const error = Error('onclosetag should have at least the root');
+            this.log.exceptionS(error, this);
+            throw error;
+          }
+
+          this.topTagProcessor = this.xmlTagProcessorStack.pop()!;
+        });
+      } else {
+        if (this.topTagProcessor.processor.onclosetag) this.topTagProcessor.processor.onclosetag(tag);
+      }
+    });
+  }
+
+  private async onend(): Promise<void> {
+    this.log.trace('onend');
+
+    if (this.xmlTagProcessorStack.length !== 0) {
+      debugBreak();
+      this.log.warn('onend should not have more processors unless the parser was abandoned', this);
+    }
+
+    await this.flushText(this.rootTag);
+    if (this.topTagProcessor.processor.end) await this.topTagProcessor.processor.end();
+  }
+
   writeStdErr(data: string): Promise<boolean> {
-    const p = this.sequentialP.then(async () => {
+    const p = (this.asyncTail ?? Promise.resolve()).then(async () => {
       let tag = this.topTagProcessor;
       for (let i = this.xmlTagProcessorStack.length - 1; tag.processor.onstderr === undefined && i >= 0; --i) {
         tag = this.xmlTagProcessorStack[i];
@@ -143,7 +179,7 @@ export class XmlParser implements ParserInterface {
         return false;
       }
     });
-    this.sequentialP = p.then();
+    this.setAsyncTail(p.then());
     return p;
   }
 
@@ -173,6 +209,7 @@ export interface XmlTagProcessor {
   /**
    * If returns with XmlTagProcessor then it will be used for this tag and it's children.
    * In this case the onclosetag won't be called for the tag;
+   * Synchronous return value is preferred: a promise makes the parser queue the following events.
    */
   onopentag?(tag: XmlTag): void | XmlTagProcessor | PromiseLike<void | XmlTagProcessor>;
   onclosetag?(tag: XmlTag): void;
@@ -0,0 +1,75 @@
+import * as assert from 'assert';
+import * as path from 'path';
+
+import { AdaptiveBatchQueue } from '../src/util/AdaptiveBatchQueue';
+
+describe(path.basename(__filename), function () {
+  const range = (n: number): number[] => Array.from({ length: n }, (_, i) => i);
+
+  const drain = <T>(queue: AdaptiveBatchQueue<T>): T[][] => {
+    const batches: T[][] = [];
+    while (!queue.isEmpty) batches.push(queue.next());
+    return batches;
+  };
+
+  it('returns every item exactly once', function () {
+    const queue = new AdaptiveBatchQueue(range(100), 4, null, () => undefined);
+    const batches = drain(queue);
+    assert.deepStrictEqual(batches.flat().sort((a, b) => a - b), range(100));
+    assert.deepStrictEqual(queue.next(), []);
+  });
+
+  it('starts with small batches if nothing is known', function () {
+    const queue = new AdaptiveBatchQueue(range(160), 4, null, () => undefined);
+    assert.strictEqual(queue.next().length, 10);
+  });
+
+  it('respects maxBatchSize', function () {
+    const queue = new AdaptiveBatchQueue(range(100), 1, 3, () => undefined);
+    for (const batch of drain(queue)) assert.ok(batch.length <= 3);
+  });
+
+  it('takes the longest ones first', function () {
+    const durations = [10, 1000, 20, 500];
+    const queue = new AdaptiveBatchQueue(range(4), 2, 1, i => durations[i]);
+    assert.deepStrictEqual(drain(queue), [[1], [3], [2], [0]]);
+  });
+
+  it('grows the batch if the items are fast', function () {
+    const queue = new AdaptiveBatchQueue(range(1000), 2, null, () => undefined);
+    const first = queue.next();
+    queue.reportBatch(first.length, first.length); // 1ms per item
+    assert.ok(queue.next().length >= AdaptiveBatchQueue.minBatchMilisec);
+  });
+
+  it('shrinks the batches towards the end', function () {
+    const queue = new AdaptiveBatchQueue(range(1000), 2, null, () => undefined);
+    const first = queue.next();
+    queue.reportBatch(first.length, first.length * 10);
+    const second = queue.next();
+    queue.reportBatch(second.length, second.length * 1000);
+    assert.ok(queue.next().length < second.length);
+  });
+
+  it('asks the durations only once', function () {
+    let calls = 0;
+    const queue = new AdaptiveBatchQueue(range(10000), 4, 1, i => {
+      ++calls;
+      return i % 2 ? i : undefined;
+    });
+    const batches = drain(queue);
+    assert.strictEqual(batches.length, 10000);
+    assert.strictEqual(calls, 10000);
+  });
+
+  it('targets the remaining known and estimated duration', function () {
+    // 4 known items of 1s, 4 unknown estimated by the average: 8s / (2 workers * 2) = 2s per batch
+    const queue = new AdaptiveBatchQueue(range(8), 2, null, i => (i < 4 ? 1000 : undefined));
+    assert.strictEqual(queue.next().length, 2);
+    queue.reportBatch(2, 20000); // 10s per item for the unknown ones
+    // (2 * 1s + 4 * 10s) / 4 = 10.5s: the 2 known and 1 unknown
+    assert.strictEqual(queue.next().length, 3);
+    // 3 * 10s / 4 = 7.5s: one item is enough
+    assert.strictEqual(queue.next().length, 1);
+  });
+});
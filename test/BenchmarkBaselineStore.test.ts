@@ -0,0 +1,114 @@
+import * as assert from 'assert';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+
+import { Logger } from '../src/Logger';
+import {
+  BenchmarkBaselineStore,
+  BenchmarkRun,
+  compareToBaseline,
+  getBenchmarkContextKey,
+  getSampleStats,
+} from '../src/util/BenchmarkBaselineStore';
+
+///
+
+const logger = new Logger();
+
+describe(path.basename(__filename), function () {
+  let storageDir: string;
+
+  beforeEach(async function () {
+    storageDir = await fs.promises.mkdtemp(path.join(os.tmpdir(), 'benchmarkBaselineStore_'));
+  });
+
+  afterEach(async function () {
+    await fs.promises.rm(storageDir, { recursive: true, force: true });
+  });
+
+  const run = (context: string, real: number[], regressed = false): BenchmarkRun => ({
+    context,
+    time: 1,
+    regressed,
+    real,
+    cpu: { n: 3, mean: 10, stddev: 1 },
+  });
+
+  it('compares the samples by Welch t-test', function () {
+    const baseline = getSampleStats([100, 101, 99, 100, 102, 98]);
+
+    const slower = compareToBaseline(baseline, getSampleStats([110, 111, 109, 110, 112, 108]))!;
+    assert.ok(Math.abs(slower.delta - 0.1) < 1e-9);
+    assert.ok(slower.confidence > 0.999);
+
+    const noise = compareToBaseline(baseline, getSampleStats([101, 99, 102, 98, 100, 100]))!;
+    assert.ok(noise.confidence > 0.1 && noise.confidence < 0.9);
+
+    const faster = compareToBaseline(baseline, getSampleStats([90, 91, 89, 90, 92, 88]))!;
+    assert.ok(faster.confidence < 0.001);
+
+    assert.strictEqual(compareToBaseline(baseline, getSampleStats([120])), undefined);
+  });
+
+  it('tests against the baseline slowed down by the limit', function () {
+    const baseline = getSampleStats([100, 101, 99, 100, 102, 98]);
+    const current = getSampleStats([110, 111, 109, 110, 112, 108]);
+
+    // 10% slower is surely slower by more than 5% but not by more than 10% or 15%
+    assert.ok(compareToBaseline(baseline, current, 5)!.confidence > 0.999);
+    assert.ok(Math.abs(compareToBaseline(baseline, current, 10)!.confidence - 0.5) < 0.01);
+    assert.ok(compareToBaseline(baseline, current, 15)!.confidence < 0.001);
+    assert.ok(Math.abs(compareToBaseline(baseline, current, 15)!.delta - 0.1) < 1e-9);
+  });
+
+  it('matches the t distribution', function () {
+    // t = 2.228, df = 10: two-sided p = 0.05
+    const current = { n: 6, mean: 10 + 2.228 / Math.sqrt(3), stddev: 1 };
+    const result = compareToBaseline({ n: 6, mean: 10, stddev: 1 }, current)!;
+    assert.ok(Math.abs(result.confidence - 0.975) < 1e-4, result.confidence.toString());
+  });
+
+  it('uses the latest not regressed run of the same context as baseline', async function () {
+    const store = new BenchmarkBaselineStore(undefined, logger);
+    await store.add('b', run('ctx1', [1, 2]));
+    await store.add('b', run('ctx2', [3, 4]));
+    await store.add('b', run('ctx1', [5, 6], true));
+
+    assert.deepStrictEqual((await store.getBaseline('b', 'ctx1'))?.real, [1, 2]);
+    assert.deepStrictEqual((await store.getBaseline('b', 'ctx2'))?.real, [3, 4]);
+    assert.strictEqual(await store.getBaseline('b', 'ctx3'), undefined);
+    assert.strictEqual(await store.getBaseline('a', 'ctx1'), undefined);
+
+    await store.clear();
+    assert.strictEqual(await store.getBaseline('b', 'ctx1'), undefined);
+  });
+
+  it('accepts the latest run as baseline', async function () {
+    const store = new BenchmarkBaselineStore(undefined, logger);
+    assert.strictEqual(await store.accept('b'), false);
+
+    await store.add('b', run('ctx', [1, 2]));
+    await store.add('b', run('ctx', [5, 6], true));
+    assert.deepStrictEqual((await store.getBaseline('b', 'ctx'))?.real, [1, 2]);
+
+    assert.strictEqual(await store.accept('b'), true);
+    assert.deepStrictEqual((await store.getBaseline('b', 'ctx'))?.real, [5, 6]);
+  });
+
+  it('persists the runs', async function () {
+    const store = new BenchmarkBaselineStore(storageDir, logger);
+    await store.add('b', run('ctx', [1.5, 2.25, 3]));
+    await store.add('b', run('ctx', [4], true));
+    store.dispose();
+
+    const loaded = new BenchmarkBaselineStore(storageDir, logger);
+    assert.deepStrictEqual(await loaded.getBaseline('b', 'ctx'), run('ctx', [1.5, 2.25, 3]));
+  });
+
+  it('getBenchmarkContextKey', function () {
+    const key = getBenchmarkContextKey({ num_cpus: 8, mhz_per_cpu: 2995, library_build_type: 'release', date: 'x' });
+    assert.strictEqual(key, getBenchmarkContextKey({ num_cpus: 8, mhz_per_cpu: 3010, library_build_type: 'release' }));
+    assert.notStrictEqual(key, getBenchmarkContextKey({ num_cpus: 8, mhz_per_cpu: 2995, library_build_type: 'debug' }));
+  });
+});
@@ -0,0 +1,114 @@
+import * as assert from 'assert';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+import * as vscode from 'vscode';
+import { Log } from 'vscode-test-adapter-util';
+
+import { BenchmarkTestMateTestRunHandler } from '../src/framework/GoogleBenchmark/BenchmarkProfile';
+import { TestMateProcessBuilder } from '../src/TestMateApi';
+import { createElf } from './util/ElfWriter';
+
+///
+
+const log = { info: () => {}, warn: () => {} } as unknown as Log;
+
+describe(path.basename(__filename), function () {
+  const createHandler = (
+    values: Record<string, unknown>,
+    libpfmCache = new Map<string, Promise<boolean>>(),
+  ): BenchmarkTestMateTestRunHandler => {
+    const config = {
+      get: <T>(key: string, defaultValue: T): T => (key in values ? (values[key] as T) : defaultValue),
+    } as unknown as vscode.WorkspaceConfiguration;
+    return new BenchmarkTestMateTestRunHandler(config, log, libpfmCache);
+  };
+
+  const builder = (...args: string[]): TestMateProcessBuilder => ({
+    cwd: '.',
+    cmd: path.join(__dirname, 'not_existing_benchmark'),
+    args: ['--benchmark_color=false', '--benchmark_format=json', ...args],
+    env: {},
+  });
+
+  it('adds the arguments', async function () {
+    const handler = createHandler({ minTime: '0.5s', perfCountersSupported: true });
+    const result = await handler.mapTestRunProcessBuilder(builder('--benchmark_filter=BM_a'));
+    assert.deepStrictEqual(result.args, [
+      '--benchmark_color=false',
+      '--benchmark_format=json',
+      '--benchmark_filter=BM_a',
+      '--benchmark_repetitions=5',
+      '--benchmark_report_aggregates_only=true',
+      '--benchmark_min_time=0.5s',
+      '--benchmark_perf_counters=CYCLES,INSTRUCTIONS',
+    ]);
+  });
+
+  it('keeps the arguments of the user', async function () {
+    const handler = createHandler({ minTime: '0.5s', perfCounters: ['CYCLES'], perfCountersSupported: true });
+    const given = builder(
+      '--benchmark_repetitions=3',
+      '--benchmark_min_time=100x',
+      '--benchmark_perf_counters=BRANCH-MISSES',
+    );
+    const result = await handler.mapTestRunProcessBuilder(given);
+    assert.deepStrictEqual(result.args, given.args);
+  });
+
+  it('keeps the aggregates only argument of the user', async function () {
+    const handler = createHandler({ repetitions: 2, perfCounters: [] });
+    const given = builder('--benchmark_report_aggregates_only=false');
+    const result = await handler.mapTestRunProcessBuilder(given);
+    assert.deepStrictEqual(result.args, [...given.args, '--benchmark_repetitions=2']);
+  });
+
+  it('without repetitions there is nothing to aggregate', async function () {
+    const handler = createHandler({ repetitions: 1, perfCounters: [] });
+    const given = builder();
+    assert.deepStrictEqual((await handler.mapTestRunProcessBuilder(given)).args, given.args);
+  });
+
+  it('does not affect the other frameworks', async function () {
+    const handler = createHandler({ perfCountersSupported: true });
+    const given: TestMateProcessBuilder = { cwd: '.', cmd: 'gtest', args: ['--gtest_color=no'], env: {} };
+    assert.strictEqual(await handler.mapTestRunProcessBuilder(given), given);
+  });
+
+  it('the perf counters can be disabled', async function () {
+    const libpfmCache = new Map([[builder().cmd, Promise.resolve(true)]]);
+    const handler = createHandler({ repetitions: 1, perfCountersSupported: false }, libpfmCache);
+    const given = builder();
+    assert.deepStrictEqual((await handler.mapTestRunProcessBuilder(given)).args, given.args);
+  });
+
+  describe('libpfm detection', function () {
+    let tmpDir: string;
+
+    beforeEach(async function () {
+      if (process.platform !== 'linux') this.skip();
+      tmpDir = await fs.promises.mkdtemp(path.join(os.tmpdir(), 'testmate-benchmark-'));
+    });
+
+    afterEach(async function () {
+      if (tmpDir) await fs.promises.rm(tmpDir, { recursive: true, force: true });
+    });
+
+    const perfCountersOf = async (dynstr: string): Promise<string[]> => {
+      const cmd = path.join(tmpDir, 'benchmark');
+      await fs.promises.writeFile(cmd, createElf({ sections: { '.dynstr': dynstr } }));
+      const result = await createHandler({ repetitions: 1 }).mapTestRunProcessBuilder({ ...builder(), cmd });
+      return result.args.filter(a => a.startsWith('--benchmark_perf_counters'));
+    };
+
+    it('finds libpfm in the executable', async function () {
+      assert.deepStrictEqual(await perfCountersOf('\0libpfm.so.4\0libc.so.6\0'), [
+        '--benchmark_perf_counters=CYCLES,INSTRUCTIONS',
+      ]);
+    });
+
+    it('without libpfm', async function () {
+      assert.deepStrictEqual(await perfCountersOf('\0libbenchmark.so.1\0libc.so.6\0'), []);
+    });
+  });
+});
@@ -0,0 +1,115 @@
+import * as assert from 'assert';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+
+import { Logger } from '../src/Logger';
+import { scanBinary } from '../src/framework/ExecutableFactory';
+import { SharedVarOfExec } from '../src/framework/SharedVarOfExec';
+import { createElf, ElfFixture } from './util/ElfWriter';
+
+///
+
+const logger = new Logger();
+
+///
+
+describe(path.basename(__filename), function () {
+  let tmpDir: string;
+
+  beforeEach(async function () {
+    tmpDir = await fs.promises.mkdtemp(path.join(os.tmpdir(), 'testmate-binaryscan-'));
+  });
+
+  afterEach(async function () {
+    await fs.promises.rm(tmpDir, { recursive: true, force: true });
+  });
+
+  const scanFile = async (fixture: ElfFixture): Promise<Awaited<ReturnType<typeof scanBinary>>> => {
+    const filePath = path.join(tmpDir, 'exec');
+    await fs.promises.writeFile(filePath, createElf(fixture));
+    return scanBinary(filePath, logger);
+  };
+
+  const scan = async (fixture: ElfFixture): Promise<string | undefined> => {
+    const scanned = await scanFile(fixture);
+    return scanned === 'notATest' ? scanned : scanned?.frameworkId;
+  };
+
+  const versionOf = async (fixture: ElfFixture): Promise<string | undefined> => {
+    const scanned = await scanFile(fixture);
+    assert.ok(scanned !== undefined && scanned !== 'notATest');
+    const shared = { log: logger, path: 'exec', optionsHash: 'hash' } as unknown as SharedVarOfExec;
+    return scanned.create(shared).frameworkVersion?.toString();
+  };
+
+  it('recognises a statically linked gtest', async function () {
+    const frameworkId = await scan({
+      sections: {
+        '.strtab': '\0_ZN7testing14InitGoogleTestEPiPPc\0',
+        '.rodata': 'This program contains tests written using Google Test.\0  @G--gtest_list_tests@D\0',
+      },
+    });
+    assert.strictEqual(frameworkId, 'gtest');
+  });
+
+  it('recognises a statically linked Google Benchmark without symbol table', async function () {
+    const frameworkId = await scan({ sections: { '.rodata': 'benchmark [--benchmark_list_tests={true|false}]\0' } });
+    assert.strictEqual(frameworkId, 'gbenchmark');
+  });
+
+  it('falls back to --help if gtest is a shared library', async function () {
+    // only the imported symbol is there, the help text is in libgtest.so
+    const frameworkId = await scan({
+      sections: { '.dynstr': '\0libgtest.so.1.14\0_ZN7testing14InitGoogleTestEPiPPc\0', '.rodata': 'x' },
+    });
+    assert.strictEqual(frameworkId, undefined);
+  });
+
+  it('recognises Catch2 v3', async function () {
+    const sections = { '.strtab': '\0_ZN5Catch7Session3runEv\0', '.rodata': '\nCatch2 v\0--list-tests\0' };
+    assert.strictEqual(await scan({ sections }), 'catch2');
+    assert.strictEqual(await versionOf({ sections }), '3.0.0');
+    assert.strictEqual(
+      await versionOf({ sections: { ...sections, '.rodata': sections['.rodata'] + '--shard-count\0' } }),
+      '3.0.1',
+    );
+  });
+
+  it('recognises doctest', async function () {
+    const sections = { '.strtab': '\0_ZN7doctest7Context3runEv\0', '.rodata': 'doctest version is "\0' };
+    assert.strictEqual(await scan({ sections }), 'doctest');
+    assert.strictEqual(await versionOf({ sections }), undefined);
+  });
+
+  it('not a test if there is no framework in the binary', async function () {
+    const frameworkId = await scan({
+      sections: { '.dynstr': '\0libc.so.6\0', '.strtab': '\0main\0', '.rodata': 'usage: tool [--help]\0' },
+    });
+    assert.strictEqual(frameworkId, 'notATest');
+  });
+
+  it('falls back to --help if there is no signature but a marker', async function () {
+    // ex.: the framework is a shared library and its symbols are not referenced by the executable directly
+    const frameworkId = await scan({ sections: { '.dynstr': '\0libCatch2.so.3\0libc.so.6\0', '.rodata': 'x' } });
+    assert.strictEqual(frameworkId, undefined);
+  });
+
+  it('falls back to --help if the binary is stripped', async function () {
+    const frameworkId = await scan({
+      sections: { '.rodata': 'This program contains tests written using\0@G--gtest_list_tests@D\0' },
+      withoutSectionHeaders: true,
+    });
+    assert.strictEqual(frameworkId, undefined);
+  });
+
+  it('falls back to --help if the version is needed or it is ambiguous', async function () {
+    // Catch2 v2 or the help text is in a shared library
+    assert.strictEqual(await scan({ sections: { '.strtab': '\0_ZN5Catch7Session3runEv\0' } }), undefined);
+    assert.strictEqual(await scan({ sections: { '.rodata': '\nCatch v\0--list-tests\0' } }), undefined);
+    assert.strictEqual(
+      await scan({ sections: { '.strtab': '\0_ZN7doctest7Context3runEv\0_ZN9benchmark22RunSpecifiedBenchmarksEv\0' } }),
+      undefined,
+    );
+  });
+});
@@ -0,0 +1,86 @@
+import * as assert from 'assert';
+import * as cp from 'child_process';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+
+import { Logger } from '../src/Logger';
+import { ProcfsProcessChecker } from '../src/util/BuildProcessChecker';
+
+///
+
+const logger = new Logger();
+
+const token = { isCancellationRequested: false, onCancellationRequested: () => ({ dispose: () => {} }) };
+
+///
+
+describe(path.basename(__filename), function () {
+  it('procfs: resolves soon after the matching process has exited', async function () {
+    if (process.platform !== 'linux') {
+      this.skip();
+      return;
+    }
+    this.timeout(10000);
+
+    const checker = new ProcfsProcessChecker(logger);
+    try {
+      const proc = cp.spawn('sleep', ['1']);
+      const exited = new Promise<number>(resolve => proc.on('exit', () => resolve(Date.now())));
+      await new Promise(resolve => setTimeout(resolve, 100));
+
+      await checker.resolveAtFinish('^sleep$', token);
+      const resolvedAt = Date.now();
+
+      // otherwise it would wait for the whole check interval
+      assert.ok(resolvedAt - (await exited) < 1000, `${resolvedAt - (await exited)}`);
+    } finally {
+      checker.dispose();
+    }
+  });
+
+  it('procfs: resolves immediately without matching process', async function () {
+    if (process.platform !== 'linux') {
+      this.skip();
+      return;
+    }
+
+    const checker = new ProcfsProcessChecker(logger);
+    try {
+      const start = Date.now();
+      await checker.resolveAtFinish('^no-such-build-tool$', token);
+      assert.ok(Date.now() - start < 1000);
+    } finally {
+      checker.dispose();
+    }
+  });
+
+  it('procfs: matches the whole name, not the 15 characters of comm', async function () {
+    if (process.platform !== 'linux') {
+      this.skip();
+      return;
+    }
+    this.timeout(10000);
+
+    const dir = await fs.promises.mkdtemp(path.join(os.tmpdir(), 'buildProcessChecker_'));
+    const checker = new ProcfsProcessChecker(logger);
+    try {
+      const longName = path.join(dir, 'x86_64-linux-gnu-sleep-12');
+      await fs.promises.copyFile(cp.execFileSync('which', ['sleep'], { encoding: 'utf8' }).trim(), longName);
+      await fs.promises.chmod(longName, 0o755);
+      const proc = cp.spawn(longName, ['1']);
+      const exited = new Promise<number>(resolve => proc.on('exit', () => resolve(Date.now())));
+      await new Promise(resolve => setTimeout(resolve, 100));
+
+      const start = Date.now();
+      await checker.resolveAtFinish('^x86_64-linux-gnu-sleep-12$', token);
+
+      // it has waited for the process
+      assert.ok(Date.now() - start > 500, `${Date.now() - start}`);
+      assert.ok(Date.now() - (await exited) < 1000);
+    } finally {
+      checker.dispose();
+      await fs.promises.rm(dir, { recursive: true, force: true });
+    }
+  });
+});
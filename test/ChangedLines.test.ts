@@ -0,0 +1,77 @@
+import * as assert from 'assert';
+import * as path from 'path';
+import * as vscode from 'vscode';
+
+import { ChangedLinesTracker, getChangedLines } from '../src/util/ChangedLines';
+
+///
+
+describe(path.basename(__filename), function () {
+  const text = ['a', 'b', 'c', 'd', 'e'].join('\n');
+
+  it('no change', function () {
+    assert.deepStrictEqual(getChangedLines(text, text), []);
+  });
+
+  it('modified line', function () {
+    assert.deepStrictEqual(getChangedLines(text, ['a', 'b', 'X', 'd', 'e'].join('\n')), [2]);
+  });
+
+  it('removed lines', function () {
+    assert.deepStrictEqual(getChangedLines(text, ['a', 'e'].join('\n')), [1, 2, 3]);
+  });
+
+  it('inserted lines', function () {
+    assert.deepStrictEqual(getChangedLines(text, ['a', 'b', 'X', 'Y', 'c', 'd', 'e'].join('\n')), [1, 2]);
+    assert.deepStrictEqual(getChangedLines(text, ['X', 'a', 'b', 'c', 'd', 'e'].join('\n')), [0]);
+    assert.deepStrictEqual(getChangedLines(text, text + '\nX'), [4]);
+  });
+
+  it('separate edits are merged into one range', function () {
+    assert.deepStrictEqual(getChangedLines(text, ['X', 'b', 'c', 'd', 'Y'].join('\n')), [0, 1, 2, 3, 4]);
+  });
+
+  it('ignores the line endings', function () {
+    assert.deepStrictEqual(getChangedLines(text, text.replace(/\n/g, '\r\n')), []);
+  });
+
+  describe('ChangedLinesTracker', function () {
+    const fsPath = path.resolve('/ws/a.cpp');
+    const doc = (lines: string[]) =>
+      ({ uri: { scheme: 'file', fsPath }, isDirty: false, getText: () => lines.join('\n') }) as vscode.TextDocument;
+
+    let tracker: ChangedLinesTracker;
+
+    beforeEach(function () {
+      tracker = new ChangedLinesTracker();
+      tracker['_onOpen'](doc(['a', 'b', 'c', 'd', 'e']));
+    });
+
+    afterEach(function () {
+      tracker.dispose();
+    });
+
+    it('remaps the lines of the later saves to the content before the first save', function () {
+      tracker['_onSave'](doc(['X', 'Y', 'a', 'b', 'c', 'd', 'e']));
+      tracker['_onSave'](doc(['X', 'Y', 'a', 'b', 'c', 'D', 'e']));
+
+      assert.deepStrictEqual(tracker.takeChangedLines(), new Map([[fsPath, [0, 1, 2, 3]]]));
+      assert.deepStrictEqual(tracker.takeChangedLines(), new Map());
+    });
+
+    it('starts from the last saved content after a take', function () {
+      tracker['_onSave'](doc(['X', 'b', 'c', 'd', 'e']));
+      tracker.takeChangedLines();
+      tracker['_onSave'](doc(['X', 'b', 'c', 'D', 'e']));
+
+      assert.deepStrictEqual(tracker.takeChangedLines(), new Map([[fsPath, [3]]]));
+    });
+
+    it('forgets the reverted changes', function () {
+      tracker['_onSave'](doc(['a', 'B', 'c', 'd', 'e']));
+      tracker['_onSave'](doc(['a', 'b', 'c', 'd', 'e']));
+
+      assert.deepStrictEqual(tracker.takeChangedLines(), new Map());
+    });
+  });
+});
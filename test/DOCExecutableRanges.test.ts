@@ -0,0 +1,112 @@
+import * as assert from 'assert';
+import * as path from 'path';
+
+import { Logger } from '../src/Logger';
+import { DOCExecutable } from '../src/framework/doctest/DOCExecutable';
+import { DOCTest } from '../src/framework/doctest/DOCTest';
+import { SharedVarOfExec } from '../src/framework/SharedVarOfExec';
+import { ShardParams } from '../src/framework/AbstractExecutable';
+import { TestDurationStore } from '../src/util/TestDurationStore';
+
+///
+
+const logger = new Logger();
+
+describe(path.basename(__filename), function () {
+  let durationStore: TestDurationStore;
+  let shared: Record<string, unknown>;
+
+  beforeEach(function () {
+    durationStore = new TestDurationStore(undefined, logger);
+    shared = {
+      log: logger,
+      path: 'exec',
+      optionsHash: 'hash',
+      rngSeed: null,
+      prependTestRunningArgs: [],
+      maxTestsPerExecutable: null,
+      shared: { testDurationStore: durationStore },
+    };
+  });
+
+  // the listing order is fixed: `--first` and `--last` index it
+  const createExecutable = (testCount: number, durations: number[] = []): [DOCExecutable, DOCTest[]] => {
+    const exec = new DOCExecutable(shared as unknown as SharedVarOfExec, undefined);
+    const tests = Array.from({ length: testCount }, (_, i) => ({ id: `t${i}` }) as unknown as DOCTest);
+    exec['_listingOrder'] = tests;
+    exec['_tests'] = new Map(tests.map(t => [t.id, t]));
+    durations.forEach((d, i) => durationStore.set('exec#hash', `t${i}`, d));
+    return [exec, tests];
+  };
+
+  const ranges = (params: ShardParams[] | undefined): string[] | undefined =>
+    params?.map(p => p.args!.filter(a => a.startsWith('--first') || a.startsWith('--last')).join(' '));
+
+  it('shards by `--first` and `--last` which count from 1 inclusive', function () {
+    const [exec] = createExecutable(4);
+    assert.deepStrictEqual(exec['_getShardParams'](2), [
+      { args: ['--order-by=file', '--first=1', '--last=2'] },
+      { args: ['--order-by=file', '--first=3', '--last=4'] },
+    ]);
+  });
+
+  it('balances the shards by the recorded durations', function () {
+    const [exec] = createExecutable(5, [10, 1, 1, 1, 1]);
+    assert.deepStrictEqual(ranges(exec['_getShardParams'](2)), ['--first=1 --last=1', '--first=2 --last=5']);
+  });
+
+  it('the tests without recorded duration cost the average', function () {
+    const [exec] = createExecutable(4, [3, 3]);
+    assert.deepStrictEqual(ranges(exec['_getShardParams'](2)), ['--first=1 --last=2', '--first=3 --last=4']);
+  });
+
+  it('respects maxTestsPerExecutable', function () {
+    shared.maxTestsPerExecutable = 2;
+    const [exec] = createExecutable(5);
+    assert.deepStrictEqual(ranges(exec['_getShardParams'](1)), [
+      '--first=1 --last=2',
+      '--first=3 --last=3',
+      '--first=4 --last=5',
+    ]);
+  });
+
+  it('computes the ranges once for all the shards', function () {
+    const [exec] = createExecutable(6);
+    let lookups = 0;
+    const get = durationStore.get.bind(durationStore);
+    durationStore.get = (key: string, testId: string) => {
+      ++lookups;
+      return get(key, testId);
+    };
+
+    assert.strictEqual(exec['_getShardParams'](3)?.length, 3);
+    assert.strictEqual(lookups, 6);
+  });
+
+  it('selects only if at least the half of the tests is selected', function () {
+    const [exec, tests] = createExecutable(4);
+    assert.strictEqual(exec['_getRangeParams']([tests[0]], 1), undefined);
+    assert.deepStrictEqual(ranges(exec['_getRangeParams']([tests[1], tests[0]], 1)), ['--first=1 --last=2']);
+  });
+
+  it('a range per contiguous segment of the selection', function () {
+    const [exec, tests] = createExecutable(6);
+    const selected = [tests[0], tests[1], tests[3], tests[4]];
+    assert.strictEqual(exec['_getRangeParams'](selected, 1), undefined);
+    assert.deepStrictEqual(ranges(exec['_getRangeParams'](selected, 2)), ['--first=1 --last=2', '--first=4 --last=5']);
+    // the extra process goes to a segment
+    assert.strictEqual(exec['_getRangeParams'](selected, 3)?.length, 3);
+  });
+
+  it('not by range if the listing order might not be followed', function () {
+    const [exec, tests] = createExecutable(4);
+    shared.rngSeed = 1;
+    assert.strictEqual(exec['_getShardParams'](2), undefined);
+    shared.rngSeed = null;
+    shared.prependTestRunningArgs = ['--test-case=x*'];
+    assert.strictEqual(exec['_getRangeParams'](tests, 2), undefined);
+    shared.prependTestRunningArgs = [];
+    exec['_tests'].delete('t3');
+    assert.strictEqual(exec['_getShardParams'](2), undefined);
+  });
+});
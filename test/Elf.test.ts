@@ -0,0 +1,93 @@
+import * as assert from 'assert';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+
+import { ElfFile, readElfBuildId } from '../src/util/Elf';
+import { createElf, ElfFixture } from './util/ElfWriter';
+
+///
+
+describe(path.basename(__filename), function () {
+  let tmpDir: string;
+
+  beforeEach(async function () {
+    tmpDir = await fs.promises.mkdtemp(path.join(os.tmpdir(), 'testmate-elf-'));
+  });
+
+  afterEach(async function () {
+    await fs.promises.rm(tmpDir, { recursive: true, force: true });
+  });
+
+  const write = async (fixture: ElfFixture | Buffer): Promise<string> => {
+    const filePath = path.join(tmpDir, 'exec');
+    await fs.promises.writeFile(filePath, Buffer.isBuffer(fixture) ? fixture : createElf(fixture));
+    return filePath;
+  };
+
+  const withElf = async <T>(fixture: ElfFixture, f: (elf: ElfFile) => Promise<T>): Promise<T> => {
+    const elf = await ElfFile.open(await write(fixture));
+    assert.ok(elf);
+    try {
+      return await f(elf);
+    } finally {
+      await elf.close();
+    }
+  };
+
+  it('rejects not ELF files', async function () {
+    assert.strictEqual(await ElfFile.open(await write(Buffer.from('#!/bin/sh\necho hello\n'.repeat(8)))), undefined);
+    assert.strictEqual(await ElfFile.open(path.join(tmpDir, 'missing')), undefined);
+  });
+
+  it('getSections', async function () {
+    const sections = await withElf({ sections: { '.dynstr': 'abc\0', '.rodata': 'x', '.bss': 'zzzz' } }, elf =>
+      elf.getSections(),
+    );
+    assert.deepStrictEqual(
+      sections.map(s => [s.name, s.size]),
+      [
+        ['', 0],
+        ['.dynstr', 4],
+        ['.rodata', 1],
+        ['.bss', 4],
+        ['.shstrtab', 32],
+      ],
+    );
+  });
+
+  it('getSections of a binary without section headers', async function () {
+    const sections = await withElf({ sections: { '.rodata': 'x' }, withoutSectionHeaders: true }, elf =>
+      elf.getSections(),
+    );
+    assert.deepStrictEqual(sections, []);
+  });
+
+  it('findInSections searches only the given sections', async function () {
+    const found = await withElf(
+      { sections: { '.dynstr': '\0libgtest.so\0', '.comment': 'needle2', '.rodata': 'has needle1 in it' } },
+      elf => elf.findInSections(['.dynstr', '.rodata'], ['needle1', 'needle2', 'libgtest.so', 'missing']),
+    );
+    assert.deepStrictEqual([...found].sort(), ['libgtest.so', 'needle1']);
+  });
+
+  it('findInSections finds the needle on the boundary of the chunks', async function () {
+    const rodata = Buffer.alloc(5 * 1024 * 1024, 0);
+    rodata.write('needle', 4 * 1024 * 1024 - 3, 'latin1');
+    const found = await withElf({ sections: { '.rodata': rodata } }, elf =>
+      elf.findInSections(['.rodata'], ['needle']),
+    );
+    assert.deepStrictEqual([...found], ['needle']);
+  });
+
+  it('findInSections skips the NOBITS sections', async function () {
+    const found = await withElf({ sections: { '.bss': 'needle' } }, elf => elf.findInSections(['.bss'], ['needle']));
+    assert.strictEqual(found.size, 0);
+  });
+
+  it('readElfBuildId', async function () {
+    const buildId = '0123456789abcdef01';
+    assert.strictEqual(await readElfBuildId(await write({ sections: {}, buildId })), buildId);
+    assert.strictEqual(await readElfBuildId(await write({ sections: { '.rodata': 'x' } })), undefined);
+  });
+});
@@ -0,0 +1,146 @@
+import * as assert from 'assert';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+
+import { Logger } from '../src/Logger';
+import { ExecClonePool } from '../src/util/ExecClonePool';
+
+///
+
+const logger = new Logger();
+
+///
+
+describe(path.basename(__filename), function () {
+  let tmpDir: string;
+  let execPath: string;
+
+  beforeEach(async function () {
+    tmpDir = await fs.promises.mkdtemp(path.join(os.tmpdir(), 'testmate-execclonepool-'));
+    execPath = path.join(tmpDir, 'exec');
+    await fs.promises.writeFile(execPath, 'not an elf file');
+  });
+
+  afterEach(async function () {
+    await fs.promises.rm(tmpDir, { recursive: true, force: true });
+  });
+
+  it('shares the clone of the same content', async function () {
+    const pool = new ExecClonePool(logger);
+    try {
+      const [clone1, clone2] = await Promise.all([pool.getClone(execPath), pool.getClone(execPath)]);
+      assert.strictEqual(clone1, clone2);
+      assert.notStrictEqual(clone1, execPath);
+      assert.ok(ExecClonePool.isClonePath(clone1));
+      assert.strictEqual(path.dirname(clone1), tmpDir);
+      assert.strictEqual(await fs.promises.readFile(clone1, 'utf8'), 'not an elf file');
+    } finally {
+      pool.dispose();
+    }
+  });
+
+  it('creates a new clone for a new content and collects the old one', async function () {
+    const pool = new ExecClonePool(logger, 0);
+    try {
+      const clone1 = await pool.getClone(execPath);
+
+      // the linkers replace the output
+      await fs.promises.unlink(execPath);
+      await fs.promises.writeFile(execPath, 'new content');
+      await fs.promises.utimes(execPath, new Date(), new Date(Date.now() + 5000));
+
+      const clone2 = await pool.getClone(execPath);
+      assert.notStrictEqual(clone2, clone1);
+      assert.strictEqual(await fs.promises.readFile(clone1, 'utf8'), 'not an elf file');
+      assert.strictEqual(await fs.promises.readFile(clone2, 'utf8'), 'new content');
+
+      (pool as unknown as { _gc(): void })._gc();
+      await new Promise(resolve => setTimeout(resolve, 100));
+      assert.ok(!fs.existsSync(clone1));
+      assert.ok(fs.existsSync(clone2));
+    } finally {
+      pool.dispose();
+    }
+  });
+
+  it('the clone is a snapshot even if the original is rewritten in place', async function () {
+    const pool = new ExecClonePool(logger);
+    try {
+      await pool.getClone(execPath);
+      // same inode: a hardlink would have changed with it
+      await fs.promises.writeFile(execPath, 'rewritten');
+      await fs.promises.utimes(execPath, new Date(), new Date(Date.now() + 5000));
+
+      const clone = await pool.getClone(execPath);
+      assert.strictEqual(await fs.promises.readFile(clone, 'utf8'), 'rewritten');
+      await fs.promises.writeFile(execPath, 'rewritten again');
+      assert.strictEqual(await fs.promises.readFile(clone, 'utf8'), 'rewritten');
+      assert.notStrictEqual((await fs.promises.stat(clone)).ino, (await fs.promises.stat(execPath)).ino);
+    } finally {
+      pool.dispose();
+    }
+  });
+
+  it('does not copy if the file can be linked', async function () {
+    if (process.platform === 'win32') this.skip();
+    const pool = new ExecClonePool(logger);
+    try {
+      const size = (await fs.promises.stat(execPath)).size;
+      const clone = await pool.getClone(execPath);
+      await pool.getClone(execPath);
+
+      const stats = pool.toJSON();
+      assert.strictEqual(stats.clones.reflink + stats.clones.hardlink, 1);
+      assert.strictEqual(stats.clones.copy, 0);
+      assert.strictEqual(stats.bytesCopied, 0);
+      assert.strictEqual(stats.bytesSaved, 2 * size); // the created and the shared one
+      if (stats.clones.hardlink === 1) {
+        assert.strictEqual((await fs.promises.stat(clone)).ino, (await fs.promises.stat(execPath)).ino);
+      }
+    } finally {
+      pool.dispose();
+    }
+  });
+
+  it('does not use a modified clone', async function () {
+    const pool = new ExecClonePool(logger);
+    try {
+      const clone1 = await pool.getClone(execPath);
+      // ex.: it is a link and the build wrote the original in place
+      await fs.promises.writeFile(clone1, 'modified');
+      await fs.promises.utimes(clone1, new Date(), new Date(Date.now() + 5000));
+
+      const clone2 = await pool.getClone(execPath);
+      assert.strictEqual(await fs.promises.readFile(clone2, 'utf8'), await fs.promises.readFile(execPath, 'utf8'));
+      assert.strictEqual(pool.toJSON().clones.copy, 1);
+    } finally {
+      pool.dispose();
+    }
+  });
+
+  it('removes the leftovers of the previous sessions', async function () {
+    const legacy = path.join(tmpDir, '.exec' + ExecClonePool.suffix);
+    const old = path.join(tmpDir, '.exec.0123456789abcdef' + ExecClonePool.suffix);
+    const other = path.join(tmpDir, '.exec.other.0123456789abcdef' + ExecClonePool.suffix);
+    for (const p of [legacy, old, other]) await fs.promises.writeFile(p, 'x');
+
+    const pool = new ExecClonePool(logger);
+    try {
+      const clone = await pool.getClone(execPath);
+      assert.ok(fs.existsSync(clone));
+      assert.ok(!fs.existsSync(legacy));
+      assert.ok(!fs.existsSync(old));
+      assert.ok(fs.existsSync(other)); // clone of `exec.other`
+    } finally {
+      pool.dispose();
+    }
+  });
+
+  it('returns the original path if it does not exist', async function () {
+    const pool = new ExecClonePool(logger);
+    const missing = path.join(tmpDir, 'missing');
+    assert.strictEqual(await pool.getClone(missing), missing);
+    pool.dispose();
+  });
+});
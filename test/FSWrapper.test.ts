@@ -25,6 +25,21 @@ describe('FsWrapper.spawnAsync', function () {
     assert.strictEqual(r.status, 0);
   });
 
+  it('echoes with bounded capture', async function () {
+    const isWin = process.platform === 'win32';
+    const opt: SpawnOptionsWithoutStdio = isWin ? { shell: true } : {};
+    const r = await spawner.spawnAsync('echo', ['apple'], opt, undefined, { limit: 3, spill: true });
+    assert.strictEqual(r.stdout, 'app');
+    assert.strictEqual(r.output[1], 'app');
+    assert.strictEqual(r.status, 0);
+    assert.ok(r.stdoutCapture?.isTruncated);
+
+    const chunks: Buffer[] = [];
+    for await (const chunk of r.stdoutCapture!.createReadStream()) chunks.push(Buffer.from(chunk));
+    assert.strictEqual(Buffer.concat(chunks).toString(), 'apple' + EOL);
+    await r.stdoutCapture!.dispose();
+  });
+
   it('not existing', function () {
     if (process.env['TRAVIS'] == 'true') this.skip();
     let hasErr = false;
@@ -0,0 +1,44 @@
+import * as assert from 'assert';
+import * as path from 'path';
+
+import { createGcdaBatches, maxGcdaPerGcov, maxGcovArgsLength } from '../src/coverage/gcov';
+
+///
+
+describe(path.basename(__filename), function () {
+  const paths = (count: number, length = 10): string[] =>
+    Array.from({ length: count }, (_, i) => i.toString().padStart(length, '0'));
+
+  it('keeps the order and every path', function () {
+    const gcdaPaths = paths(100);
+    const batches = createGcdaBatches(gcdaPaths, 4);
+    assert.deepStrictEqual(batches.flat(), gcdaPaths);
+  });
+
+  it('creates at least as many batches as parallel processes', function () {
+    const batches = createGcdaBatches(paths(10), 4);
+    assert.deepStrictEqual(batches.map(b => b.length), [3, 3, 3, 1]);
+  });
+
+  it('limits the number of files per gcov', function () {
+    const batches = createGcdaBatches(paths(maxGcdaPerGcov * 2 + 1), 1);
+    assert.deepStrictEqual(batches.map(b => b.length), [maxGcdaPerGcov, maxGcdaPerGcov, 1]);
+  });
+
+  it('limits the length of the command line', function () {
+    const pathLength = 1000;
+    const batches = createGcdaBatches(paths(40, pathLength), 1);
+    for (const batch of batches) assert.ok(batch.length * (pathLength + 1) <= maxGcovArgsLength);
+    assert.strictEqual(batches[0].length, Math.floor(maxGcovArgsLength / (pathLength + 1)));
+    assert.deepStrictEqual(batches.flat(), paths(40, pathLength));
+  });
+
+  it('keeps a path even if it is longer than the limit alone', function () {
+    const long = 'x'.repeat(maxGcovArgsLength + 1);
+    assert.deepStrictEqual(createGcdaBatches(['a', long, 'b'], 1), [['a'], [long], ['b']]);
+  });
+
+  it('creates no batch without files', function () {
+    assert.deepStrictEqual(createGcdaBatches([], 4), []);
+  });
+});
@@ -0,0 +1,116 @@
+import * as assert from 'assert';
+import * as path from 'path';
+
+import { Logger } from '../src/Logger';
+import { BenchmarkGroupCollector, BenchmarkGroupShape } from '../src/framework/GoogleBenchmark/GoogleBenchmarkGroups';
+
+///
+
+const logger = new Logger();
+
+describe(path.basename(__filename), function () {
+  const run = (name: string, index: number) => ({
+    name,
+    run_name: name,
+    run_type: 'iteration',
+    repetitions: 2,
+    repetition_index: index,
+    real_time: index + 1,
+  });
+
+  const aggregate = (name: string, aggregateName: string) => ({
+    name: `${name}_${aggregateName}`,
+    run_name: name,
+    run_type: 'aggregate',
+    repetitions: 2,
+    aggregate_name: aggregateName,
+  });
+
+  const collect = (
+    benchmarks: Record<string, unknown>[],
+    shapes = new Map<string, BenchmarkGroupShape>(),
+  ): [number, string[]][] => {
+    const collector = new BenchmarkGroupCollector(logger, shapes);
+    const reported: [number, string[]][] = [];
+    const report = (groups: Record<string, unknown>[][], index: number) =>
+      groups.forEach(g => reported.push([index, g.map(b => b['name'] as string)]));
+    benchmarks.forEach((b, i) => report(collector.add(b), i));
+    report(collector.end(), benchmarks.length);
+    return reported;
+  };
+
+  it('groups the repetitions with their aggregates', function () {
+    const output = [
+      run('BM_a', 0),
+      run('BM_a', 1),
+      aggregate('BM_a', 'mean'),
+      aggregate('BM_a', 'stddev'),
+      run('BM_b', 0),
+      run('BM_b', 1),
+      aggregate('BM_b', 'mean'),
+      aggregate('BM_b', 'stddev'),
+    ];
+
+    assert.deepStrictEqual(collect(output), [
+      [4, ['BM_a', 'BM_a', 'BM_a_mean', 'BM_a_stddev']],
+      [8, ['BM_b', 'BM_b', 'BM_b_mean', 'BM_b_stddev']],
+    ]);
+  });
+
+  it('buffers the interleaved repetitions until their aggregates', function () {
+    const output = [
+      run('BM_b', 0),
+      run('BM_a', 0),
+      run('BM_a', 1),
+      run('BM_b', 1),
+      aggregate('BM_a', 'mean'),
+      aggregate('BM_a', 'stddev'),
+      aggregate('BM_b', 'mean'),
+      aggregate('BM_b', 'stddev'),
+    ];
+
+    assert.deepStrictEqual(collect(output), [
+      [6, ['BM_a', 'BM_a', 'BM_a_mean', 'BM_a_stddev']],
+      [8, ['BM_b', 'BM_b', 'BM_b_mean', 'BM_b_stddev']],
+    ]);
+  });
+
+  it('reports the interleaved repetitions as soon as they have the learned shape', function () {
+    const shapes = new Map<string, BenchmarkGroupShape>();
+    const output = [
+      run('BM_b', 0),
+      run('BM_a', 0),
+      run('BM_a', 1),
+      run('BM_b', 1),
+      aggregate('BM_a', 'mean'),
+      aggregate('BM_b', 'mean'),
+    ];
+
+    assert.deepStrictEqual(collect(output, shapes), [
+      [5, ['BM_a', 'BM_a', 'BM_a_mean']],
+      [6, ['BM_b', 'BM_b', 'BM_b_mean']],
+    ]);
+    assert.deepStrictEqual(collect(output, shapes), [
+      [4, ['BM_a', 'BM_a', 'BM_a_mean']],
+      [5, ['BM_b', 'BM_b', 'BM_b_mean']],
+    ]);
+  });
+
+  it('a late aggregate is not reported again', function () {
+    const shapes = new Map<string, BenchmarkGroupShape>([
+      ['BM_a', { repetitions: 2, iterations: 2, aggregates: ['mean'] }],
+    ]);
+    const output = [run('BM_a', 0), run('BM_a', 1), aggregate('BM_a', 'mean'), aggregate('BM_a', 'stddev')];
+
+    assert.deepStrictEqual(collect(output, shapes), [[2, ['BM_a', 'BM_a', 'BM_a_mean']]]);
+    assert.strictEqual(shapes.has('BM_a'), false);
+  });
+
+  it('without repetitions the next benchmark ends the group', function () {
+    const single = (name: string) => ({ name, run_name: name, run_type: 'iteration', real_time: 1 });
+    assert.deepStrictEqual(collect([single('BM_a'), single('BM_b')]), [
+      [1, ['BM_a']],
+      [2, ['BM_b']],
+    ]);
+  });
+});
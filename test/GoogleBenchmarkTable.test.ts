@@ -0,0 +1,70 @@
+import * as assert from 'assert';
+import * as path from 'path';
+
+import { createBenchmarkTable } from '../src/framework/GoogleBenchmark/GoogleBenchmarkTable';
+
+///
+
+describe(path.basename(__filename), function () {
+  const aggregate = (name: string, unit: string, realTime: number, cpuTime: number, counters: object) => ({
+    name: `BM_x_${name}`,
+    run_name: 'BM_x',
+    run_type: 'aggregate',
+    repetitions: 3,
+    threads: 1,
+    aggregate_name: name,
+    aggregate_unit: unit,
+    iterations: 3,
+    real_time: realTime,
+    cpu_time: cpuTime,
+    time_unit: 'ns',
+    ...counters,
+  });
+
+  it('renders the aggregates with the perf counters', function () {
+    const table = createBenchmarkTable([
+      aggregate('mean', 'time', 1500, 1000, { CYCLES: 3000, INSTRUCTIONS: 6000 }),
+      aggregate('median', 'time', 1400, 1000, { CYCLES: 3000, INSTRUCTIONS: 6000 }),
+      aggregate('stddev', 'time', 10, 5, { CYCLES: 20, INSTRUCTIONS: 30 }),
+      aggregate('cv', 'percentage', 0.01, 0.005, { CYCLES: 0.006, INSTRUCTIONS: 0.005 }),
+    ])!;
+
+    assert.deepStrictEqual(table, [
+      '                              mean    median    stddev     cv',
+      'real_time                 1.500 μs  1.400 μs  10.00 ns  1.00%',
+      'cpu_time                  1.000 μs  1.000 μs  5.000 ns  0.50%',
+      'CYCLES                      3.000k    3.000k        20  0.60%',
+      'INSTRUCTIONS                6.000k    6.000k        30  0.50%',
+      'IPC (instructions/cycle)     2.000     2.000                 ',
+      'GHz (cycles/cpu_time)        3.000     3.000                 ',
+    ]);
+  });
+
+  it('renders the repetitions', function () {
+    const run = (index: number, realTime: number) => ({
+      name: 'BM_x',
+      run_name: 'BM_x',
+      run_type: 'iteration',
+      repetitions: 2,
+      repetition_index: index,
+      iterations: 1000,
+      real_time: realTime,
+      cpu_time: realTime,
+      time_unit: 'us',
+      items_per_second: 2.5e6,
+    });
+
+    assert.deepStrictEqual(createBenchmarkTable([run(0, 2), run(1, 3)]), [
+      '                        #0        #1',
+      'real_time         2.000 μs  3.000 μs',
+      'cpu_time          2.000 μs  3.000 μs',
+      'iterations          1.000k    1.000k',
+      'items_per_second    2.500M    2.500M',
+    ]);
+  });
+
+  it('skips the complexity results', function () {
+    const bigO = { name: 'BM_x_BigO', run_type: 'aggregate', aggregate_name: 'BigO', cpu_coefficient: 1.5, big_o: 'N' };
+    assert.strictEqual(createBenchmarkTable([bigO]), undefined);
+  });
+});
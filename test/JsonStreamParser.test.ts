@@ -0,0 +1,89 @@
+import * as assert from 'assert';
+import * as path from 'path';
+
+import { Logger } from '../src/Logger';
+import { JsonStreamParser } from '../src/util/JsonStreamParser';
+
+///
+
+const logger = new Logger();
+
+describe(path.basename(__filename), function () {
+  const json = JSON.stringify(
+    {
+      context: { date: '2026-10-16', caches: [{ type: 'Data', size: 32768 }], note: 'a "quoted" } ]' },
+      benchmarks: [
+        { name: 'BM_A/8', cpu_time: 1.5, time_unit: 'ns' },
+        { name: 'BM_B/"x"\\', label: '[{,}]', counters: [1, 2, 3] },
+        42,
+        'str',
+        null,
+      ],
+      empty: [],
+    },
+    null,
+    2,
+  );
+
+  const parse = async (chunkSize: number, async: boolean): Promise<unknown[]> => {
+    const events: unknown[] = [];
+    const parser = new JsonStreamParser(
+      logger,
+      {
+        onvalue: (path: string, value: unknown): void | Promise<void> => {
+          if (async) return new Promise(resolve => setTimeout(resolve, 1)).then(() => void events.push([path, value]));
+          events.push([path, value]);
+        },
+      },
+      ['benchmarks'],
+    );
+    for (let i = 0; i < json.length; i += chunkSize) parser.write(json.substring(i, i + chunkSize));
+    await parser.end();
+    return events;
+  };
+
+  const parsed = JSON.parse(json);
+  const expected = [
+    ['context', parsed['context']],
+    ...(parsed['benchmarks'] as unknown[]).map(b => ['benchmarks[]', b]),
+    ['empty', []],
+  ];
+
+  it('emits the values of the streamed arrays', async function () {
+    assert.deepStrictEqual(await parse(json.length, false), expected);
+  });
+
+  it('emits the elements split between chunks', async function () {
+    for (const chunkSize of [1, 2, 3, 7]) assert.deepStrictEqual(await parse(chunkSize, false), expected);
+  });
+
+  it('keeps the order with asynchronous processor', async function () {
+    assert.deepStrictEqual(await parse(5, true), expected);
+  });
+
+  it('emits the complete elements of an incomplete output', async function () {
+    const events: unknown[] = [];
+    const parser = new JsonStreamParser(logger, { onvalue: (_path, value) => void events.push(value) }, ['benchmarks']);
+    parser.write('{"benchmarks": [{"name": "a"}, {"name": "b"}, {"name": "c", "cpu');
+    await parser.end();
+    assert.deepStrictEqual(events, [{ name: 'a' }, { name: 'b' }]);
+  });
+
+  it('streams nested paths', async function () {
+    const events: unknown[] = [];
+    const parser = new JsonStreamParser(
+      logger,
+      { onvalue: (path, value) => void events.push([path, value]) },
+      ['data', 'data[]', 'data[].files'],
+    );
+    parser.write('{"data": [{"files": [{"f": 1}, {"f": [2]}], "functions": [3]}, {"totals": {}}], "type": "t"}');
+    await parser.end();
+    assert.deepStrictEqual(events, [
+      ['data[].files[]', { f: 1 }],
+      ['data[].files[]', { f: [2] }],
+      ['data[].functions', [3]],
+      ['data[].totals', {}],
+      ['type', 't'],
+    ]);
+  });
+});
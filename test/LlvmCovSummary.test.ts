@@ -0,0 +1,95 @@
+import * as assert from 'assert';
+import * as path from 'path';
+import * as vscode from 'vscode';
+
+import { Logger } from '../src/Logger';
+import { CoveragePart, FileDeclarations, LlvmCovFileCoverage, summarizeCoverageParts } from '../src/coverage/llvm-cov';
+
+///
+
+const logger = new Logger();
+
+///
+
+describe(path.basename(__filename), function () {
+  // [line, col, count, hasCount, isRegionEntry, isGapRegion]
+  const part = (
+    segments: number[][],
+    branches: number[][] = [],
+    functions: [string, number[]][] = [],
+  ): CoveragePart => {
+    const declarations = new FileDeclarations();
+    for (const [name, region] of functions) declarations.add(name, region);
+    return { segments: Float64Array.from(segments.flat()), branches: Float64Array.from(branches.flat()), declarations };
+  };
+
+  // a header function compiled into two objects: every object executes a different branch of it
+  const inline = (taken: number, notTaken: number) =>
+    part(
+      [
+        [10, 1, 1, 1, 1, 0],
+        [11, 5, taken, 1, 1, 0],
+        [12, 1, 1, 1, 0, 0],
+        [13, 5, notTaken, 1, 1, 0],
+        [14, 1, 1, 1, 0, 0],
+        [15, 1, 0, 0, 0, 0],
+      ],
+      [[11, 9, 11, 13, taken, notTaken]],
+      [['f', [10, 1, 15, 1, 1]]],
+    );
+
+  it('counts the union of the lines covered by the parts', function () {
+    const a = summarizeCoverageParts([inline(1, 0)]);
+    const b = summarizeCoverageParts([inline(0, 1)]);
+    assert.deepStrictEqual(a.lines, [4, 5]);
+    assert.deepStrictEqual(b.lines, [4, 5]);
+
+    const merged = summarizeCoverageParts([inline(1, 0), inline(0, 1)]);
+    assert.deepStrictEqual(merged.lines, [5, 5]);
+    assert.deepStrictEqual(merged.branches, [2, 2]);
+    assert.deepStrictEqual(merged.functions, [1, 1]);
+  });
+
+  it('skips the gap regions and the regions without count', function () {
+    const summary = summarizeCoverageParts([
+      part([
+        [1, 1, 1, 1, 1, 0],
+        [2, 1, 0, 1, 0, 1],
+        [3, 1, 0, 0, 0, 0],
+        [4, 1, 0, 1, 1, 0],
+        [5, 1, 0, 0, 0, 0],
+      ]),
+    ]);
+    assert.deepStrictEqual(summary.lines, [1, 2]);
+  });
+
+  it('counts the functions and branches of different parts separately', function () {
+    const summary = summarizeCoverageParts([
+      part([], [[1, 1, 1, 5, 0, 0]], [['f', [1, 1, 2, 1, 0]]]),
+      part([], [[3, 1, 3, 5, 2, 0]], [['g', [3, 1, 4, 1, 2]]]),
+    ]);
+    assert.deepStrictEqual(summary.branches, [1, 4]);
+    assert.deepStrictEqual(summary.functions, [1, 2]);
+  });
+
+  it('a single part and the merged parts are summarized the same way', function () {
+    const uri = vscode.Uri.file('/a.hpp');
+    const counts = (c: LlvmCovFileCoverage) =>
+      [c.statementCoverage, c.branchCoverage!, c.declarationCoverage!].map(({ covered, total }) => [covered, total]);
+    const summary = (parts: CoveragePart[]) => {
+      const s = summarizeCoverageParts(parts);
+      return [s.lines, s.branches, s.functions];
+    };
+
+    const single = LlvmCovFileCoverage.fromParts(uri, logger, [inline(1, 0)]);
+    assert.deepStrictEqual(counts(single), summary([inline(1, 0)]));
+
+    const merged = single.mergeWith(LlvmCovFileCoverage.fromParts(uri, logger, [inline(0, 1)]));
+    assert.deepStrictEqual(counts(merged), summary([inline(1, 0), inline(0, 1)]));
+    assert.deepStrictEqual(counts(merged), [
+      [5, 5],
+      [2, 2],
+      [1, 1],
+    ]);
+  });
+});
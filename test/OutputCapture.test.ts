@@ -0,0 +1,74 @@
+import * as assert from 'assert';
+import * as fs from 'fs';
+import * as path from 'path';
+
+import { OutputCapture } from '../src/util/OutputCapture';
+
+///
+
+const readAll = async (capture: OutputCapture): Promise<string> => {
+  const chunks: Buffer[] = [];
+  for await (const chunk of capture.createReadStream()) chunks.push(Buffer.from(chunk));
+  return Buffer.concat(chunks).toString();
+};
+
+describe(path.basename(__filename), function () {
+  it('keeps small output in memory', async function () {
+    const capture = new OutputCapture({ limit: 10, spill: true });
+    capture.write(Buffer.from('abc'));
+    capture.write(Buffer.from('def'));
+    await capture.finish();
+
+    assert.strictEqual(capture.isTruncated, false);
+    assert.strictEqual(capture.head(), 'abcdef');
+    assert.strictEqual(capture.tail(), 'abcdef');
+    assert.strictEqual(await readAll(capture), 'abcdef');
+    await capture.dispose();
+  });
+
+  it('truncates without spill', async function () {
+    const capture = new OutputCapture({ limit: 4 });
+    capture.write(Buffer.from('abc'));
+    capture.write(Buffer.from('def'));
+    capture.write(Buffer.from('ghi'));
+    await capture.finish();
+
+    assert.strictEqual(capture.isTruncated, true);
+    assert.strictEqual(capture.size, 9);
+    assert.strictEqual(capture.head(), 'abcd');
+    assert.strictEqual(capture.tail(), 'defghi');
+    assert.throws(() => capture.createReadStream());
+    await capture.dispose();
+  });
+
+  it('keeps only the end in the tail', async function () {
+    const capture = new OutputCapture({ limit: 1 });
+    const line = 'x'.repeat(1000) + '\n';
+    for (let i = 0; i < 1000; ++i) capture.write(Buffer.from(line));
+    capture.write(Buffer.from('end'));
+
+    const tail = capture.tail();
+    assert.strictEqual(tail.length, 64 * 1024);
+    assert.ok(tail.endsWith('x\nend'));
+  });
+
+  it('spills big output to a file', async function () {
+    const capture = new OutputCapture({ limit: 4, spill: true });
+    const expected: string[] = [];
+    for (let i = 0; i < 1000; ++i) {
+      const chunk = `line ${i}\n`;
+      expected.push(chunk);
+      capture.write(Buffer.from(chunk));
+    }
+    await capture.finish();
+
+    assert.strictEqual(capture.isTruncated, true);
+    assert.strictEqual(capture.head(), 'line');
+    assert.strictEqual(await readAll(capture), expected.join(''));
+
+    const spillFile = (capture as unknown as { _spillFile: string })._spillFile;
+    assert.ok(fs.existsSync(spillFile));
+    await capture.dispose();
+    assert.ok(!fs.existsSync(spillFile));
+  });
+});
@@ -0,0 +1,80 @@
+import * as assert from 'assert';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+
+import { Logger } from '../src/Logger';
+import { decodeTypedArray, encodeTypedArray, PersistentJsonFile } from '../src/util/PersistentJsonFile';
+
+///
+
+const logger = new Logger();
+
+interface Stored {
+  version: number;
+  values: number[];
+}
+
+describe(path.basename(__filename), function () {
+  let storageDir: string;
+  let filePath: string;
+
+  beforeEach(async function () {
+    storageDir = await fs.promises.mkdtemp(path.join(os.tmpdir(), 'testmate-persistentjson-'));
+    filePath = path.join(storageDir, 'sub', 'file.json');
+  });
+
+  afterEach(async function () {
+    await fs.promises.rm(storageDir, { recursive: true, force: true });
+  });
+
+  const createFile = (values: number[], version = 1, saveDelayMillis?: number) =>
+    new PersistentJsonFile<Stored>(
+      filePath,
+      version,
+      logger,
+      'test',
+      stored => values.push(...stored.values),
+      () => ({ version, values }),
+      saveDelayMillis,
+    );
+
+  it('saves at dispose and loads once', async function () {
+    const file = createFile([1, 2]);
+    file.scheduleSave();
+    file.dispose();
+
+    const values: number[] = [];
+    const loading = createFile(values);
+    await Promise.all([loading.load(), loading.load()]);
+    assert.deepStrictEqual(values, [1, 2]);
+  });
+
+  it('saves after the delay without leaving temporary files', async function () {
+    const file = createFile([3], 1, 1);
+    file.scheduleSave();
+    file.scheduleSave();
+    await new Promise(resolve => setTimeout(resolve, 100));
+
+    assert.deepStrictEqual(await fs.promises.readdir(path.dirname(filePath)), ['file.json']);
+    assert.deepStrictEqual(JSON.parse(await fs.promises.readFile(filePath, 'utf8')), { version: 1, values: [3] });
+    file.dispose();
+  });
+
+  it('ignores the other versions', async function () {
+    const written = createFile([4], 1);
+    written.scheduleSave();
+    written.dispose();
+
+    const values: number[] = [];
+    await createFile(values, 2).load();
+    assert.deepStrictEqual(values, []);
+  });
+
+  it('encodes the typed arrays', function () {
+    const array = Float64Array.from([1.5, -2, 1e300]);
+    assert.deepStrictEqual(decodeTypedArray(encodeTypedArray(array), Float64Array), array);
+    const bitmap = Uint32Array.from([0xffffffff, 1]);
+    assert.deepStrictEqual(decodeTypedArray(encodeTypedArray(bitmap.subarray(1)), Uint32Array), Uint32Array.from([1]));
+  });
+});
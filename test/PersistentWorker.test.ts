@@ -0,0 +1,177 @@
+import * as assert from 'assert';
+import * as path from 'path';
+import { EventEmitter } from 'events';
+import { PassThrough } from 'stream';
+
+import { Logger } from '../src/Logger';
+import { PersistentWorkerPool } from '../src/PersistentWorker';
+import { Spawner, SpawnOptionsWithoutStdio, SpawnReturns } from '../src/Spawner';
+import * as fsw from '../src/util/FSWrapper';
+
+///
+
+const logger = new Logger();
+
+const exited = (code: number, signal = 0) => `\n@@TestMate.persistentWorker.exited@@ ${code} ${signal}\n`;
+
+class FakeProcess extends EventEmitter {
+  readonly stdout = new PassThrough();
+  readonly stderr = new PassThrough();
+  readonly stdin = new PassThrough();
+  readonly pid = 1234;
+  killed = false;
+
+  kill(): boolean {
+    this.killed = true;
+    this.close(null);
+    return true;
+  }
+
+  close(code: number | null): void {
+    if (this.stdout.writableEnded) return;
+    this.stdout.end();
+    this.stderr.end();
+    setImmediate(() => this.emit('close', code, null));
+  }
+}
+
+/**
+ * Mimics `persistent_worker.hpp`: `onRequest` writes the output of the forked child.
+ */
+class FakeSpawner implements Spawner {
+  constructor(
+    private readonly _supportsProtocol: boolean,
+    private readonly _onRequest: (proc: FakeProcess, args: string[]) => void,
+  ) {}
+
+  readonly spawned: { args: string[]; env: NodeJS.ProcessEnv | undefined; proc: FakeProcess }[] = [];
+
+  spawnAsync(): Promise<SpawnReturns> {
+    throw Error('not used');
+  }
+
+  async spawn(_cmd: string, args: string[], options: SpawnOptionsWithoutStdio) {
+    const proc = new FakeProcess();
+    this.spawned.push({ args, env: options.env, proc });
+
+    if (options.env?.['TESTMATE_PERSISTENT_WORKER'] !== undefined) {
+      if (this._supportsProtocol) {
+        proc.stderr.write('static init warning\n');
+        proc.stdout.write('@@TestMate.persistentWorker.ready@@ 3\n');
+        let buffer = '';
+        proc.stdin.on('data', (chunk: Buffer) => {
+          buffer += chunk.toString();
+          const lines = buffer.split('\n');
+          const count = parseInt(lines[0]);
+          if (lines.length < count + 2) return;
+          buffer = lines.slice(count + 1).join('\n');
+          this._onRequest(proc, lines.slice(1, count + 1));
+        });
+      } else {
+        proc.stdout.write('usage: ' + args.join(' ') + '\n');
+        proc.close(0);
+      }
+    } else {
+      proc.stdout.write('normal run\n');
+      proc.close(0);
+    }
+
+    return proc as unknown as fsw.ChildProcessWithoutNullStreams;
+  }
+
+  toString(): string {
+    return 'FakeSpawner';
+  }
+}
+
+const collect = async (
+  proc: fsw.ChildProcessWithoutNullStreams,
+): Promise<{ stdout: string; stderr: string; code: number | null; signal: string | null }> => {
+  let stdout = '';
+  let stderr = '';
+  proc.stdout.on('data', (c: Buffer | string) => (stdout += c.toString()));
+  proc.stderr.on('data', (c: Buffer | string) => (stderr += c.toString()));
+  const [code, signal] = await new Promise<[number | null, string | null]>(r =>
+    proc.once('close', (code: number | null, signal: string | null) => r([code, signal])),
+  );
+  return { stdout, stderr, code, signal };
+};
+
+describe(path.basename(__filename), function () {
+  const cmd = path.join(__dirname, 'not_existing_test_exec');
+  const options = { cwd: __dirname, env: {} };
+  let pool: PersistentWorkerPool;
+
+  beforeEach(function () {
+    pool = new PersistentWorkerPool(logger);
+  });
+
+  afterEach(function () {
+    pool.dispose();
+  });
+
+  it('forwards the output of the run between the markers', async function () {
+    const spawner = new FakeSpawner(true, (proc, args) => {
+      proc.stdout.write('@@TestMate.persistentWorker.started@@ 42\nout: ' + args.join(','));
+      // the marker is split between chunks
+      proc.stdout.write('\n@@TestMate.persistent');
+      setImmediate(() => {
+        proc.stdout.write(exited(3).substring(22));
+        // the streams are not synchronised: late stderr of the child (ex.: sanitizer)
+        setImmediate(() => proc.stderr.write('late report\n' + exited(3)));
+      });
+    });
+
+    const result = await collect(await pool.spawn(spawner, cmd, ['a', 'b c'], options));
+
+    assert.strictEqual(spawner.spawned.length, 1);
+    assert.deepStrictEqual(spawner.spawned[0].args, ['--help']);
+    assert.strictEqual(spawner.spawned[0].env?.['TESTMATE_PERSISTENT_WORKER'], '3');
+    assert.strictEqual(result.stdout, 'out: a,b c');
+    assert.strictEqual(result.stderr, 'static init warning\nlate report\n');
+    assert.strictEqual(result.code, 3);
+    assert.strictEqual(result.signal, null);
+  });
+
+  it('reuses the worker and attaches the stderr between the runs to the next run', async function () {
+    let runCount = 0;
+    const spawner = new FakeSpawner(true, proc => {
+      ++runCount;
+      proc.stdout.write(`@@TestMate.persistentWorker.started@@ ${runCount}\nrun ${runCount}` + exited(0));
+      proc.stderr.write(exited(0));
+      if (runCount === 1) setImmediate(() => proc.stderr.write('between runs\n'));
+    });
+
+    const first = await collect(await pool.spawn(spawner, cmd, [], options));
+    await new Promise(r => setTimeout(r, 10));
+    const second = await collect(await pool.spawn(spawner, cmd, [], options));
+
+    assert.strictEqual(spawner.spawned.length, 1);
+    assert.deepStrictEqual(first, { stdout: 'run 1', stderr: 'static init warning\n', code: 0, signal: null });
+    assert.deepStrictEqual(second, { stdout: 'run 2', stderr: 'between runs\n', code: 0, signal: null });
+  });
+
+  it('reports the signal', async function () {
+    const spawner = new FakeSpawner(true, proc => {
+      proc.stdout.write('@@TestMate.persistentWorker.started@@ 1\n' + exited(-1, 11));
+      proc.stderr.write(exited(-1, 11));
+    });
+
+    const result = await collect(await pool.spawn(spawner, cmd, [], options));
+
+    assert.strictEqual(result.code, null);
+    assert.strictEqual(result.signal, 'SIGSEGV');
+  });
+
+  it('falls back to normal spawn if the executable does not support it', async function () {
+    const spawner = new FakeSpawner(false, () => assert.fail('no request expected'));
+
+    const first = await collect(await pool.spawn(spawner, cmd, ['x'], options));
+    const second = await collect(await pool.spawn(spawner, cmd, ['y'], options));
+
+    assert.strictEqual(first.stdout, 'normal run\n');
+    assert.strictEqual(second.stdout, 'normal run\n');
+    // probed only once and only with `--help`
+    assert.deepStrictEqual(spawner.spawned.map(s => s.args), [['--help'], ['x'], ['y']]);
+  });
+});
@@ -0,0 +1,123 @@
+import * as assert from 'assert';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+
+import { Logger } from '../src/Logger';
+import { PhaseTimings } from '../src/util/PhaseTimings';
+
+///
+
+const logger = new Logger();
+
+///
+
+describe(path.basename(__filename), function () {
+  it('collects the histograms in total and by executable', function () {
+    const timings = new PhaseTimings(logger);
+    try {
+      timings.record('listing', 'exec1', 0, 0.5);
+      timings.record('listing', 'exec1', 0, 3);
+      timings.record('listing', 'exec2', 0, 100000);
+      timings.record('parse', 'exec2', 0, 7, 1024);
+      timings.record('coverageFinalise', undefined, 0, 1);
+
+      const json = timings.toJSON();
+      const listing = json.phases.listing!;
+      assert.strictEqual(listing.count, 3);
+      assert.strictEqual(listing.minMillis, 0.5);
+      assert.strictEqual(listing.maxMillis, 100000);
+      assert.strictEqual(listing.buckets.length, json.bucketBoundsMillis.length + 1);
+      assert.strictEqual(listing.buckets[0], 1); // <= 1ms
+      assert.strictEqual(listing.buckets[json.bucketBoundsMillis.indexOf(5)], 1);
+      assert.strictEqual(listing.buckets[json.bucketBoundsMillis.length], 1); // overflow
+
+      assert.strictEqual(json.phases.parse!.chars, 1024);
+      assert.strictEqual(json.phases.coverageFinalise!.count, 1);
+      assert.strictEqual(json.phases.spawn, undefined);
+
+      assert.deepStrictEqual(Object.keys(json.executables).sort(), ['exec1', 'exec2']);
+      assert.strictEqual(json.executables['exec1'].listing!.count, 2);
+      assert.strictEqual(json.executables['exec2'].parse!.count, 1);
+    } finally {
+      timings.dispose();
+    }
+  });
+
+  it('writes the trace file on dispose', async function () {
+    const tmpDir = await fs.promises.mkdtemp(path.join(os.tmpdir(), 'testmate-phasetimings-'));
+    try {
+      const traceFile = path.join(tmpDir, 'trace.json');
+      const timings = new PhaseTimings(logger);
+      timings.setTraceFile(traceFile);
+      await timings.measure('spawn', 'exec1', async () => {});
+      timings.record('parse', 'exec1', 10, 2, 42);
+      timings.dispose();
+
+      // JSON Array Format without the optional closing bracket
+      const events = JSON.parse((await fs.promises.readFile(traceFile, 'utf8')) + ']') as {
+        name: string;
+        ph: string;
+        ts: number;
+        dur: number;
+        tid: number;
+        args: Record<string, unknown>;
+      }[];
+      const threadName = events.find(e => e.ph === 'M')!;
+      assert.deepStrictEqual(threadName.args, { name: 'exec1' });
+      assert.deepStrictEqual(events.filter(e => e.ph === 'X').map(e => e.name), ['spawn', 'parse']);
+      const parse = events.find(e => e.name === 'parse')!;
+      assert.strictEqual(parse.ts, 10000);
+      assert.strictEqual(parse.dur, 2000);
+      assert.strictEqual(parse.tid, threadName.tid);
+    } finally {
+      await fs.promises.rm(tmpDir, { recursive: true, force: true });
+    }
+  });
+
+  it('appends only the new events to the trace file', async function () {
+    const tmpDir = await fs.promises.mkdtemp(path.join(os.tmpdir(), 'testmate-phasetimings-'));
+    try {
+      const traceFile = path.join(tmpDir, 'trace.json');
+      const timings = new PhaseTimings(logger);
+      timings.setTraceFile(traceFile);
+      timings.record('listing', 'exec1', 0, 1);
+      await timings['_writeTrace']();
+      const first = await fs.promises.readFile(traceFile, 'utf8');
+
+      timings.record('listing', 'exec2', 1, 1);
+      timings.record('spawn', 'exec1', 2, 1);
+      await timings['_writeTrace']();
+      timings.dispose();
+      const second = await fs.promises.readFile(traceFile, 'utf8');
+
+      assert.ok(second.startsWith(first));
+      const events = JSON.parse(second + ']') as { name: string; ph: string; tid: number }[];
+      assert.deepStrictEqual(
+        events.map(e => [e.ph, e.name, e.tid]),
+        [
+          ['M', 'thread_name', 1],
+          ['X', 'listing', 1],
+          ['M', 'thread_name', 2],
+          ['X', 'listing', 2],
+          ['X', 'spawn', 1],
+        ],
+      );
+    } finally {
+      await fs.promises.rm(tmpDir, { recursive: true, force: true });
+    }
+  });
+
+  it('empty trace file means disabled', async function () {
+    const tmpDir = await fs.promises.mkdtemp(path.join(os.tmpdir(), 'testmate-phasetimings-'));
+    try {
+      const timings = new PhaseTimings(logger);
+      timings.setTraceFile('');
+      timings.record('parse', 'exec1', 0, 1);
+      timings.dispose();
+      assert.deepStrictEqual(await fs.promises.readdir(tmpDir), []);
+    } finally {
+      await fs.promises.rm(tmpDir, { recursive: true, force: true });
+    }
+  });
+});
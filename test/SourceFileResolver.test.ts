@@ -0,0 +1,76 @@
+import * as assert from 'assert';
+import * as path from 'path';
+
+import { Logger } from '../src/Logger';
+import { SourceFileResolver } from '../src/util/SourceFileResolver';
+
+///
+
+const logger = new Logger();
+
+describe(path.basename(__filename), function () {
+  const wsPath = path.resolve('/ws');
+
+  const resolve = (map: Record<string, string>, file: string): Promise<string> =>
+    new SourceFileResolver(logger, map, wsPath, []).resolve(file);
+
+  it('resolves without map', async function () {
+    assert.strictEqual(await resolve({}, '/ws/a/../b.cpp'), path.normalize('/ws/b.cpp'));
+  });
+
+  it('legacy: replaces every key', async function () {
+    const map = { '/build/': '/ws/', 'src': 'lib' };
+    assert.strictEqual(await resolve(map, '/build/src/a.cpp'), path.normalize('/ws/lib/a.cpp'));
+  });
+
+  it('starts-with: the first matching key wins', async function () {
+    const map = {
+      $strategy: 'starts-with',
+      [path.resolve('/other')]: path.resolve('/x'),
+      [path.resolve('/ws/sub')]: path.resolve('/first'),
+      [path.resolve('/ws')]: path.resolve('/second'),
+      sub: path.resolve('/third'),
+    };
+    assert.strictEqual(await resolve(map, path.resolve('/ws/sub/a.cpp')), path.resolve('/first/a.cpp'));
+    assert.strictEqual(await resolve(map, path.resolve('/ws/b.cpp')), path.resolve('/second/b.cpp'));
+    assert.strictEqual(await resolve(map, path.resolve('/none/c.cpp')), path.resolve('/none/c.cpp'));
+  });
+
+  it('starts-with: relative keys by the order of the map', async function () {
+    const map = { $strategy: 'starts-with', sub: path.resolve('/first'), [path.resolve('/ws')]: path.resolve('/x') };
+    assert.strictEqual(await resolve(map, path.resolve('/ws/sub/a.cpp')), path.resolve('/first/a.cpp'));
+  });
+
+  it('replace-first', async function () {
+    const map = { '$strategy': 'replace-first', '/nomatch/': '/x/', 'inner': 'replaced' };
+    assert.strictEqual(await resolve(map, path.resolve('/ws/d/inner/a.cpp')), path.normalize('d/replaced/a.cpp'));
+  });
+
+  it('regex-relative', async function () {
+    const map = { '$strategy': 'regex-relative', '^gen/(\\w+)': '/src/$1' };
+    assert.strictEqual(await resolve(map, path.resolve('/ws/gen/mod/a.cpp')), path.normalize('/src/mod/a.cpp'));
+  });
+
+  it('caches the results and drops the least recently used', async function () {
+    let calls = 0;
+    const resolver = new SourceFileResolver(logger, {}, wsPath, [], 2);
+    const countingResolve = (file: string): Promise<string> => {
+      const before = (resolver as unknown as { _cache: Map<string, unknown> })._cache.has(file);
+      if (!before) ++calls;
+      return resolver.resolve(file);
+    };
+
+    const p1 = countingResolve('/a.cpp');
+    assert.strictEqual(countingResolve('/a.cpp'), p1);
+    await countingResolve('/b.cpp');
+    await countingResolve('/a.cpp'); // a is the most recently used
+    await countingResolve('/c.cpp'); // b is dropped
+    await countingResolve('/a.cpp');
+    await countingResolve('/b.cpp');
+    assert.strictEqual(calls, 4);
+
+    resolver.clearCache();
+    await countingResolve('/a.cpp');
+    assert.strictEqual(calls, 5);
+  });
+});
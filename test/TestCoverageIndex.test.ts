@@ -0,0 +1,136 @@
+import * as assert from 'assert';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+import * as vscode from 'vscode';
+
+import { Logger } from '../src/Logger';
+import { TestCoverageIndex } from '../src/util/TestCoverageIndex';
+
+///
+
+const logger = new Logger();
+
+describe(path.basename(__filename), function () {
+  const file = vscode.Uri.file(path.resolve('/ws/a.cpp'));
+  const other = vscode.Uri.file(path.resolve('/ws/b.cpp'));
+
+  let storageDir: string;
+
+  beforeEach(async function () {
+    storageDir = await fs.promises.mkdtemp(path.join(os.tmpdir(), 'testCoverageIndex_'));
+  });
+
+  afterEach(async function () {
+    await fs.promises.rm(storageDir, { recursive: true, force: true });
+  });
+
+  const lines = (entries: [vscode.Uri, number[]][]): Map<string, number[]> =>
+    new Map(entries.map(([uri, l]) => [uri.fsPath, l]));
+
+  it('finds the tests covering the lines', async function () {
+    const index = new TestCoverageIndex(undefined, logger);
+    await index.update([
+      { testIds: ['t1'], coveredLines: lines([[file, [1, 2, 3]]]) },
+      { testIds: ['t2'], coveredLines: lines([[file, [3, 4]], [other, [1]]]) },
+    ]);
+
+    assert.deepStrictEqual(await index.getTestsCoveringLines(file, [1]), ['t1']);
+    assert.deepStrictEqual(await index.getTestsCoveringLines(file, [3]), ['t1', 't2']);
+    assert.deepStrictEqual(await index.getTestsCoveringLines(file, [2, 4]), ['t1', 't2']);
+    assert.deepStrictEqual(await index.getTestsCoveringLines(file, [5]), []);
+    assert.deepStrictEqual(await index.getTestsCoveringLines(other, [1]), ['t2']);
+  });
+
+  it('replaces the previous coverage of the updated tests', async function () {
+    const index = new TestCoverageIndex(undefined, logger);
+    await index.update([
+      { testIds: ['t1'], coveredLines: lines([[file, [1, 2]]]) },
+      { testIds: ['t2'], coveredLines: lines([[file, [2]]]) },
+    ]);
+    await index.update([{ testIds: ['t1'], coveredLines: lines([[other, [7]]]) }]);
+
+    assert.deepStrictEqual(await index.getTestsCoveringLines(file, [1, 2]), ['t2']);
+    assert.deepStrictEqual(await index.getTestsCoveringLines(other, [7]), ['t1']);
+  });
+
+  it('handles more tests than the bits of a word', async function () {
+    const index = new TestCoverageIndex(undefined, logger);
+    const testIds = Array.from({ length: 100 }, (_, i) => `t${i}`);
+    await index.update(testIds.map((id, i) => ({ testIds: [id], coveredLines: lines([[file, [0, i]]]) })));
+
+    assert.deepStrictEqual(await index.getTestsCoveringLines(file, [0]), testIds);
+    assert.deepStrictEqual(await index.getTestsCoveringLines(file, [33, 64, 99]), ['t33', 't64', 't99']);
+  });
+
+  it('handles more tests than the arguments of a call', async function () {
+    const index = new TestCoverageIndex(undefined, logger);
+    const testIds = Array.from({ length: 200000 }, (_, i) => `t${i}`);
+    await index.update([{ testIds, coveredLines: lines([[file, [1]]]) }]);
+
+    assert.strictEqual((await index.getTestsCoveringLines(file, [1])).length, testIds.length);
+    await index.removeTests(testIds.slice(1));
+    assert.deepStrictEqual(await index.getTestsCoveringLines(file, [1]), ['t0']);
+  });
+
+  it('shares the sets of the lines covered by the same tests', async function () {
+    const index = new TestCoverageIndex(undefined, logger);
+    await index.update([
+      { testIds: ['t1'], coveredLines: lines([[file, [1, 2, 3]], [other, [1]]]) },
+      { testIds: ['t2'], coveredLines: lines([[file, [3]], [other, [1, 2]]]) },
+    ]);
+
+    const ofFile = index['_files'].get(file.fsPath)!;
+    const ofOther = index['_files'].get(other.fsPath)!;
+    assert.strictEqual(ofFile.get(1), ofFile.get(2));
+    assert.strictEqual(ofFile.get(3), ofOther.get(1));
+    assert.notStrictEqual(ofFile.get(1), ofFile.get(3));
+    assert.strictEqual(index['_sets'].size, 3);
+
+    await index.update([{ testIds: ['t2'], coveredLines: lines([]) }]);
+    assert.strictEqual(ofFile.get(1), ofFile.get(3));
+    assert.strictEqual(ofOther.get(2), undefined);
+    assert.strictEqual(index['_sets'].size, 1);
+  });
+
+  it('removes the tests', async function () {
+    const index = new TestCoverageIndex(storageDir, logger);
+    const testIds = Array.from({ length: 40 }, (_, i) => `t${i}`);
+    await index.update(testIds.map((id, i) => ({ testIds: [id], coveredLines: lines([[file, [0, i]]]) })));
+
+    await index.removeTests(testIds.filter((_, i) => i !== 1 && i !== 35).concat('unknown'));
+
+    assert.deepStrictEqual(await index.getTestsCoveringLines(file, [0]), ['t1', 't35']);
+    assert.deepStrictEqual(await index.getTestsCoveringLines(file, [2, 35]), ['t35']);
+    assert.deepStrictEqual(index['_tests'], ['t1', 't35']);
+
+    // the indexes are reused
+    await index.update([{ testIds: ['t40'], coveredLines: lines([[file, [0]]]) }]);
+    assert.deepStrictEqual(await index.getTestsCoveringLines(file, [0]), ['t1', 't35', 't40']);
+    index.dispose();
+
+    const stored = JSON.parse(await fs.promises.readFile(path.join(storageDir, 'testCoverageIndex.json'), 'utf8'));
+    assert.deepStrictEqual(stored.tests, ['t1', 't35', 't40']);
+    assert.strictEqual(stored.sets.length, 3);
+  });
+
+  it('is persisted', async function () {
+    const index = new TestCoverageIndex(storageDir, logger);
+    await index.update([
+      { testIds: ['t1', 't2'], coveredLines: lines([[file, [1, 2]]]) },
+      { testIds: ['t3'], coveredLines: lines([[file, [2]]]) },
+    ]);
+    index.dispose();
+
+    const stored = JSON.parse(await fs.promises.readFile(path.join(storageDir, 'testCoverageIndex.json'), 'utf8'));
+    assert.strictEqual(stored.sets.length, 2); // the set of line 1 and line 2
+
+    const reloaded = new TestCoverageIndex(storageDir, logger);
+    assert.deepStrictEqual(await reloaded.getTestsCoveringLines(file, [1]), ['t1', 't2']);
+    assert.deepStrictEqual(await reloaded.getTestsCoveringLines(file, [2]), ['t1', 't2', 't3']);
+
+    await reloaded.update([{ testIds: ['t1'], coveredLines: lines([]) }]);
+    assert.deepStrictEqual(await reloaded.getTestsCoveringLines(file, [1, 2]), ['t2', 't3']);
+    reloaded.dispose();
+  });
+});
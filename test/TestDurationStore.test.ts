@@ -0,0 +1,98 @@
+import * as assert from 'assert';
+import * as path from 'path';
+
+import { Logger } from '../src/Logger';
+import { distributeByDuration, TestDurationStore } from '../src/util/TestDurationStore';
+
+///
+
+const logger = new Logger();
+
+class MockMemento {
+  readonly values = new Map<string, unknown>();
+  keys(): readonly string[] {
+    return [...this.values.keys()];
+  }
+  get<T>(key: string): T | undefined {
+    return this.values.get(key) as T | undefined;
+  }
+  update(key: string, value: unknown): Promise<void> {
+    this.values.set(key, JSON.parse(JSON.stringify(value)));
+    return Promise.resolve();
+  }
+}
+
+describe(path.basename(__filename), function () {
+  it('smooths the durations', function () {
+    const store = new TestDurationStore(undefined, logger);
+    store.set('exec', 'a', 100);
+    assert.strictEqual(store.get('exec', 'a'), 100);
+    store.set('exec', 'a', 200);
+    assert.strictEqual(store.get('exec', 'a'), 150);
+    store.set('exec', 'a', NaN);
+    store.set('exec', 'a', -1);
+    assert.strictEqual(store.get('exec', 'a'), 150);
+    assert.strictEqual(store.get('exec', 'b'), undefined);
+    assert.strictEqual(store.get('other', 'a'), undefined);
+  });
+
+  it('removes the missing tests', function () {
+    const store = new TestDurationStore(undefined, logger);
+    store.set('exec', 'a', 1);
+    store.set('exec', 'b', 2);
+    store.removeMissing('exec', ['b']);
+    assert.strictEqual(store.get('exec', 'a'), undefined);
+    assert.strictEqual(store.get('exec', 'b'), 2);
+  });
+
+  it('persists to the memento', function () {
+    const memento = new MockMemento();
+    const store = new TestDurationStore(memento as never, logger);
+    store.set('exec', 'a', 42);
+    store.dispose();
+
+    const loaded = new TestDurationStore(memento as never, logger);
+    assert.strictEqual(loaded.get('exec', 'a'), 42);
+  });
+
+  describe('distributeByDuration', function () {
+    const sums = (buckets: number[][]) => buckets.map(b => b.reduce((a, c) => a + c, 0));
+
+    it('assigns the longest first to the least loaded bucket', function () {
+      const { buckets, bucketDurations } = distributeByDuration([1, 8, 2, 7, 3, 6, 4, 5], 2, d => d);
+      assert.deepStrictEqual(buckets, [
+        [8, 5, 4, 1],
+        [7, 6, 3, 2],
+      ]);
+      assert.deepStrictEqual(bucketDurations, [18, 18]);
+      assert.deepStrictEqual(sums(buckets), bucketDurations);
+    });
+
+    it('balances a skewed distribution', function () {
+      const { buckets } = distributeByDuration([100, 10, 10, 10, 10, 10, 10], 3, d => d);
+      assert.deepStrictEqual(sums(buckets), [100, 30, 30]);
+    });
+
+    it('respects the bucket size limit', function () {
+      // without the limit the 100 would stay alone and the others would share a bucket
+      const { buckets } = distributeByDuration([100, 1, 1, 1], 2, d => d);
+      assert.deepStrictEqual(buckets.map(b => b.length), [2, 2]);
+      assert.deepStrictEqual(sums(buckets), [101, 2]);
+    });
+
+    it('deals the items without duration round-robin', function () {
+      const durations = new Map([['slow', 50]]);
+      const { buckets, withoutDurationCount } = distributeByDuration(['slow', 'a', 'b', 'c', 'd'], 3, i =>
+        durations.get(i),
+      );
+      assert.strictEqual(withoutDurationCount, 4);
+      assert.deepStrictEqual(buckets, [['slow', 'a'], ['b', 'd'], ['c']]);
+    });
+
+    it('drops the empty buckets with their durations', function () {
+      const { buckets, bucketDurations } = distributeByDuration([3, 2], 4, d => d);
+      assert.deepStrictEqual(buckets, [[3], [2]]);
+      assert.deepStrictEqual(bucketDurations, [3, 2]);
+    });
+  });
+});
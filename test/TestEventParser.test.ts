@@ -0,0 +1,96 @@
+import * as assert from 'assert';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+
+import { Logger } from '../src/Logger';
+import { hasTestEventsReporter, TestEvent, TestEventParser } from '../src/util/TestEventParser';
+import { createElf } from './util/ElfWriter';
+
+///
+
+const logger = new Logger();
+
+///
+
+describe(path.basename(__filename), function () {
+  it('parses the events split into chunks', async function () {
+    const events: TestEvent[] = [];
+    const parser = new TestEventParser(logger, e => {
+      events.push(e);
+    });
+
+    parser.write('{"type":"hello","version":1}\n{"type":"testSt');
+    parser.write('art","name":"a\\nb","line":3}\n\n{"type":"testEnd","result":"passed"');
+    assert.strictEqual(events.length, 2);
+    parser.write(',"durationMs":1.5}');
+    await parser.end();
+
+    assert.deepStrictEqual(events, [
+      { type: 'hello', version: 1 },
+      { type: 'testStart', name: 'a\nb', line: 3 },
+      { type: 'testEnd', result: 'passed', durationMs: 1.5 },
+    ]);
+  });
+
+  it('skips the invalid lines', async function () {
+    const events: TestEvent[] = [];
+    const parser = new TestEventParser(logger, e => {
+      events.push(e);
+    });
+
+    parser.write('not json\n{"type":"testEnd","result":"failed"}\n');
+    await parser.end();
+
+    assert.deepStrictEqual(events, [{ type: 'testEnd', result: 'failed' }]);
+  });
+
+  it('keeps the order if the handler is async', async function () {
+    const handled: string[] = [];
+    const parser = new TestEventParser(logger, async e => {
+      if (e.type === 'testStart') await new Promise(r => setTimeout(r, 10));
+      handled.push(e.type);
+    });
+
+    parser.write('{"type":"testStart","name":"a"}\n{"type":"failure"}\n');
+    parser.write('{"type":"testEnd","result":"failed"}\n');
+    await parser.end();
+
+    assert.deepStrictEqual(handled, ['testStart', 'failure', 'testEnd']);
+  });
+
+  describe('hasTestEventsReporter', function () {
+    let tmpDir: string;
+
+    beforeEach(async function () {
+      tmpDir = await fs.promises.mkdtemp(path.join(os.tmpdir(), 'testmate-events-'));
+    });
+
+    afterEach(async function () {
+      await fs.promises.rm(tmpDir, { recursive: true, force: true });
+    });
+
+    const write = async (content: Buffer): Promise<string> => {
+      const filePath = path.join(tmpDir, 'exec');
+      await fs.promises.writeFile(filePath, content);
+      return filePath;
+    };
+
+    it('finds the signature', async function () {
+      const rodata = 'usage\0TESTMATE_EVENTS_FD\0TESTMATE_EVENTS\0';
+      const filePath = await write(createElf({ sections: { '.rodata': rodata } }));
+      assert.strictEqual(await hasTestEventsReporter(filePath, logger), true);
+    });
+
+    it('without the signature', async function () {
+      const sections = { '.rodata': 'usage\0', '.dynstr': 'TESTMATE_EVENTS_FD\0' };
+      const filePath = await write(createElf({ sections }));
+      assert.strictEqual(await hasTestEventsReporter(filePath, logger), false);
+    });
+
+    it('not an ELF file', async function () {
+      const filePath = await write(Buffer.from('#!/bin/sh\necho TESTMATE_EVENTS_FD\n'));
+      assert.strictEqual(await hasTestEventsReporter(filePath, logger), false);
+    });
+  });
+});
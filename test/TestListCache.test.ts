@@ -0,0 +1,114 @@
+import * as assert from 'assert';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+
+import { Logger } from '../src/Logger';
+import { TestListCache } from '../src/util/TestListCache';
+import { hashExecOptions } from '../src/framework/SharedVarOfExec';
+
+///
+
+const logger = new Logger();
+
+///
+
+describe(path.basename(__filename), function () {
+  let tmpDir: string;
+  let execPath: string;
+
+  beforeEach(async function () {
+    tmpDir = await fs.promises.mkdtemp(path.join(os.tmpdir(), 'testmate-testlistcache-'));
+    execPath = path.join(tmpDir, 'exec');
+    await fs.promises.writeFile(execPath, 'not an elf file');
+  });
+
+  afterEach(async function () {
+    await fs.promises.rm(tmpDir, { recursive: true, force: true });
+  });
+
+  it('stores and loads by content', async function () {
+    const time = new Date(1600000000000);
+    await fs.promises.utimes(execPath, time, time);
+    const cache = new TestListCache(path.join(tmpDir, 'storage'), logger);
+    assert.strictEqual(await cache.get(execPath, ['a']), undefined);
+
+    await cache.set(execPath, ['a'], 'list');
+    assert.strictEqual(await cache.get(execPath, ['a']), 'list');
+    assert.strictEqual(await cache.get(execPath, ['b']), undefined);
+
+    // same content, different path: not an ELF file so the modification time is part of the key
+    const otherPath = path.join(tmpDir, 'other');
+    await fs.promises.copyFile(execPath, otherPath);
+    await fs.promises.utimes(otherPath, time, time);
+    assert.strictEqual(await cache.get(otherPath, ['a']), 'list');
+
+    const later = new Date(time.getTime() + 10000);
+    await fs.promises.utimes(otherPath, later, later);
+    assert.strictEqual(await cache.get(otherPath, ['a']), undefined);
+
+    cache.dispose();
+  });
+
+  it('the options are keyed by their resolved values', async function () {
+    // the same settings in two workspaces
+    const options = { cwd: '${workspaceFolder}', env: {}, customEnv: { DATA: '${workspaceFolder}/data' } };
+    const frameworkSpecific = { prependTestListingArgs: ['--config=${workspaceFolder}/cfg'] };
+    const hashIn = async (workspaceFolder: string): Promise<string> => {
+      const varToValue = [{ resolve: '${workspaceFolder}', rule: workspaceFolder }];
+      const resolved = { ...options, customEnv: { DATA: workspaceFolder + '/data' } };
+      return hashExecOptions({ ...resolved, cwd: workspaceFolder }, frameworkSpecific, varToValue);
+    };
+    const hashA = await hashIn('/ws/a');
+    const hashB = await hashIn('/ws/b');
+    assert.strictEqual(hashA, await hashIn('/ws/a'));
+    assert.notStrictEqual(hashA, hashB);
+
+    // only the listing args differ
+    const withArgs = (arg: string) =>
+      hashExecOptions({ ...options, cwd: '/ws' }, frameworkSpecific, [{ resolve: '${workspaceFolder}', rule: arg }]);
+    assert.notStrictEqual(await withArgs('/ws/a'), await withArgs('/ws/b'));
+
+    const cache = new TestListCache(path.join(tmpDir, 'storage'), logger);
+    await cache.set(execPath, ['Catch2', hashA], 'list of a');
+    assert.strictEqual(await cache.get(execPath, ['Catch2', hashB]), undefined);
+    assert.strictEqual(await cache.get(execPath, ['Catch2', hashA]), 'list of a');
+    cache.dispose();
+  });
+
+  it('misses if the content has changed', async function () {
+    const cache = new TestListCache(path.join(tmpDir, 'storage'), logger);
+    await cache.set(execPath, ['a'], 'list');
+
+    await fs.promises.writeFile(execPath, 'changed content');
+    const future = new Date(Date.now() + 10000);
+    await fs.promises.utimes(execPath, future, future);
+    assert.strictEqual(await cache.get(execPath, ['a']), undefined);
+
+    cache.dispose();
+  });
+
+  it('samples the beginning and the end of big files', async function () {
+    const cache = new TestListCache(path.join(tmpDir, 'storage'), logger);
+    const content = Buffer.alloc(3 * 1024 * 1024, 1);
+    const time = new Date(1600000000000);
+    await fs.promises.writeFile(execPath, content);
+    await fs.promises.utimes(execPath, time, time);
+    await cache.set(execPath, ['a'], 'list');
+
+    content[content.length - 1] = 2;
+    await fs.promises.writeFile(execPath, content);
+    await fs.promises.utimes(execPath, time, time);
+    const otherCache = new TestListCache(path.join(tmpDir, 'storage'), logger);
+    assert.strictEqual(await otherCache.get(execPath, ['a']), undefined);
+
+    cache.dispose();
+    otherCache.dispose();
+  });
+
+  it('does nothing without storage', async function () {
+    const cache = new TestListCache(undefined, logger);
+    await cache.set(execPath, ['a'], 'list');
+    assert.strictEqual(await cache.get(execPath, ['a']), undefined);
+  });
+});
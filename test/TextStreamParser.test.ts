@@ -0,0 +1,95 @@
+import * as assert from 'assert';
+import * as path from 'path';
+
+import { Logger } from '../src/Logger';
+import { LineProcessor, RootLineProcessor, TextStreamParser } from '../src/util/TextStreamParser';
+
+///
+
+const logger = new Logger();
+
+describe(path.basename(__filename), function () {
+  const text = 'a\r\nb\nRUN 1\nx\nend\nc\nRUN 2\ny\ndrop\nd\nlast';
+
+  const createProcessor = (events: string[], async: boolean, batch: boolean): RootLineProcessor => {
+    const maybeAsync = <T>(value: T): T | Promise<T> =>
+      async ? new Promise(resolve => setTimeout(() => resolve(value), 1)) : value;
+
+    const child: LineProcessor = {
+      begin: (line: string) => {
+        events.push('begin:' + line);
+      },
+      online: (line: string): void | boolean | Promise<boolean> => {
+        events.push('child:' + line);
+        if (line === 'end') return maybeAsync(true);
+        if (line === 'drop') return maybeAsync(false);
+      },
+      end: () => {
+        events.push('end');
+        return maybeAsync(undefined);
+      },
+    };
+
+    const root: RootLineProcessor = {
+      online: (line: string): void | LineProcessor | Promise<LineProcessor> => {
+        events.push('root:' + line);
+        if (line.startsWith('RUN')) return maybeAsync(child);
+      },
+    };
+
+    if (batch) {
+      root.onlines = (lines: readonly string[], start: number): number => {
+        let i = start;
+        for (; i < lines.length && !lines[i].startsWith('RUN'); ++i) events.push('root:' + lines[i]);
+        return i - start;
+      };
+    }
+
+    return root;
+  };
+
+  const parse = async (async: boolean, batch: boolean, chunkSize: number): Promise<string[]> => {
+    const events: string[] = [];
+    const parser = new TextStreamParser(logger, createProcessor(events, async, batch));
+    for (let i = 0; i < text.length; i += chunkSize) parser.write(text.substring(i, i + chunkSize));
+    await parser.end();
+    return events;
+  };
+
+  const expected = [
+    'root:a',
+    'root:b',
+    'root:RUN 1',
+    'begin:RUN 1',
+    'child:x',
+    'child:end',
+    'end',
+    'root:c',
+    'root:RUN 2',
+    'begin:RUN 2',
+    'child:y',
+    'child:drop',
+    'end',
+    'root:drop',
+    'root:d',
+    'root:last',
+  ];
+
+  for (const async of [false, true]) {
+    for (const batch of [false, true]) {
+      for (const chunkSize of [1, 2, 3, text.length]) {
+        it(`keeps the order (async: ${async}, batch: ${batch}, chunk size: ${chunkSize})`, async function () {
+          assert.deepStrictEqual(await parse(async, batch, chunkSize), expected);
+        });
+      }
+    }
+  }
+
+  it('processes a huge chunk', async function () {
+    let count = 0;
+    const parser = new TextStreamParser(logger, { online: () => void ++count });
+    parser.write('line\n'.repeat(1000000));
+    await parser.end();
+    assert.strictEqual(count, 1000000);
+  });
+});
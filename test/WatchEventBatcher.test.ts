@@ -0,0 +1,126 @@
+import * as assert from 'assert';
+import * as path from 'path';
+import * as sinon from 'sinon';
+
+import { Logger } from '../src/Logger';
+import { WatchEventBatcher, WatchEventBatcherHandler } from '../src/util/WatchEventBatcher';
+
+///
+
+const logger = new Logger();
+
+describe(path.basename(__filename), function () {
+  let clock: sinon.SinonFakeTimers;
+  let handled: { filePath: string; at: number }[];
+  let buildChecks: number;
+
+  beforeEach(function () {
+    clock = sinon.useFakeTimers();
+    handled = [];
+    buildChecks = 0;
+  });
+
+  afterEach(function () {
+    clock.restore();
+  });
+
+  const createBatcher = (handler: Partial<WatchEventBatcherHandler> = {}): WatchEventBatcher =>
+    new WatchEventBatcher(
+      logger,
+      {
+        waitForBuild: async () => void ++buildChecks,
+        rank: () => 0,
+        handle: async filePath => void handled.push({ filePath, at: Date.now() }),
+        ...handler,
+      },
+      1000,
+      10000,
+      2000,
+    );
+
+  it('handles the events together after the quiet period', async function () {
+    const batcher = createBatcher();
+    batcher.add('a');
+    await clock.tickAsync(500);
+    batcher.add('b');
+    await clock.tickAsync(999);
+    assert.deepStrictEqual(handled, []);
+
+    await clock.tickAsync(1);
+    assert.deepStrictEqual(handled, [{ filePath: 'a', at: 1500 }, { filePath: 'b', at: 1500 }]);
+    assert.strictEqual(buildChecks, 1);
+  });
+
+  it('handles a continuous stream of events at latest after the max delay', async function () {
+    const batcher = createBatcher();
+    for (let i = 0; i < 20; ++i) {
+      batcher.add(`p${i}`);
+      await clock.tickAsync(500);
+    }
+
+    assert.strictEqual(handled.length, 20);
+    assert.ok(handled.every(h => h.at === 10000));
+    assert.strictEqual(buildChecks, 1);
+  });
+
+  it('handles the paths in the order of their rank', async function () {
+    const ranks: Record<string, number> = { a: 2, b: 0, c: 1, d: 0 };
+    const batcher = createBatcher({ rank: filePath => ranks[filePath] });
+    for (const filePath of ['a', 'b', 'c', 'd']) batcher.add(filePath);
+    await clock.tickAsync(1000);
+
+    assert.deepStrictEqual(handled.map(h => h.filePath), ['b', 'd', 'c', 'a']);
+  });
+
+  it('gives only a head start to the lower rank', async function () {
+    const batcher = createBatcher({
+      rank: filePath => (filePath === 'retrying' ? 0 : 1),
+      handle: async filePath => {
+        if (filePath === 'retrying') await new Promise(r => setTimeout(r, 60000));
+        handled.push({ filePath, at: Date.now() });
+      },
+    });
+    batcher.add('retrying');
+    batcher.add('other');
+    await clock.tickAsync(3000);
+
+    assert.deepStrictEqual(handled, [{ filePath: 'other', at: 3000 }]);
+  });
+
+  it('the next batch does not wait for the handling of the previous one', async function () {
+    const batcher = createBatcher({
+      handle: async filePath => {
+        if (filePath === 'retrying') await new Promise(r => setTimeout(r, 60000));
+        handled.push({ filePath, at: Date.now() });
+      },
+    });
+    batcher.add('retrying');
+    await clock.tickAsync(1000);
+    batcher.add('next');
+    await clock.tickAsync(1000);
+
+    assert.deepStrictEqual(handled, [{ filePath: 'next', at: 2000 }]);
+    assert.strictEqual(buildChecks, 2);
+  });
+
+  it('the next batch waits for the build check of the previous one', async function () {
+    let finishBuild: () => void = () => {};
+    const batcher = createBatcher({
+      waitForBuild: () => {
+        ++buildChecks;
+        return buildChecks === 1 ? new Promise<void>(r => (finishBuild = r)) : Promise.resolve();
+      },
+    });
+    batcher.add('a');
+    await clock.tickAsync(1000);
+    batcher.add('b');
+    await clock.tickAsync(5000);
+    assert.deepStrictEqual(handled, []);
+    assert.strictEqual(buildChecks, 1);
+
+    finishBuild();
+    await clock.tickAsync(0);
+    assert.deepStrictEqual(handled.map(h => h.filePath), ['a', 'b']);
+    assert.strictEqual(buildChecks, 2);
+  });
+});
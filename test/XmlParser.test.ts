@@ -0,0 +1,81 @@
+import * as assert from 'assert';
+import * as path from 'path';
+
+import { Logger } from '../src/Logger';
+import { XmlParser, XmlTag, XmlTagProcessor } from '../src/util/XmlParser';
+
+///
+
+const logger = new Logger();
+
+describe(path.basename(__filename), function () {
+  const xml = '<a><b x="1">text1</b><c><d>text2</d></c></a>';
+
+  const createProcessor = (events: string[], async: (name: string) => boolean): XmlTagProcessor => {
+    const maybeAsync = <T>(name: string, value: T): T | Promise<T> =>
+      async(name) ? new Promise(resolve => setTimeout(() => resolve(value), 1)) : value;
+
+    const child: XmlTagProcessor = {
+      begin: (tag: XmlTag) => {
+        events.push('begin:' + tag.name);
+        return maybeAsync('begin', undefined);
+      },
+      onopentag: (tag: XmlTag) => {
+        events.push('open:' + tag.name);
+        return maybeAsync(tag.name, undefined);
+      },
+      ontext: (text: string, tag: XmlTag) => {
+        events.push(`text:${tag.name}:${text}`);
+        return maybeAsync('text', undefined);
+      },
+      end: () => {
+        events.push('end');
+        return maybeAsync('end', undefined);
+      },
+    };
+
+    return {
+      onopentag: (tag: XmlTag) => {
+        events.push('root-open:' + tag.name);
+        return maybeAsync(tag.name, tag.name === 'c' ? child : undefined);
+      },
+      ontext: (text: string, tag: XmlTag) => {
+        events.push(`root-text:${tag.name}:${text}`);
+      },
+    };
+  };
+
+  const parse = async (async: (name: string) => boolean): Promise<string[]> => {
+    const events: string[] = [];
+    const parser = new XmlParser(logger, createProcessor(events, async), error => {
+      throw error;
+    });
+    parser.write(xml.substring(0, 10));
+    parser.write(xml.substring(10));
+    await parser.end();
+    return events;
+  };
+
+  const expected = [
+    'root-open:a',
+    'root-open:b',
+    'root-text:b:text1',
+    'root-open:c',
+    'begin:c',
+    'open:d',
+    'text:d:text2',
+    'end',
+  ];
+
+  it('processes synchronous processors', async function () {
+    assert.deepStrictEqual(await parse(() => false), expected);
+  });
+
+  it('keeps the order with asynchronous processors', async function () {
+    assert.deepStrictEqual(await parse(() => true), expected);
+  });
+
+  it('keeps the order with mixed processors', async function () {
+    assert.deepStrictEqual(await parse(name => name === 'b' || name === 'begin'), expected);
+  });
+});
@@ -0,0 +1,51 @@
+import { Logger } from '../../src/Logger';
+
+///
+
+export function inputSizeBytes(defaultMB = 100): number {
+  return Number(process.env['TESTMATE_BENCH_MB'] ?? defaultMB) * 1024 * 1024;
+}
+
+export const noopLogger = new Proxy(
+  {},
+  {
+    get: () => (): void => {},
+  },
+) as Logger;
+
+export class HeapSampler {
+  private _peak = process.memoryUsage().heapUsed;
+  private _counter = 0;
+
+  // can be called often, it samples only every nth call
+  sample(): void {
+    if (++this._counter % 64 === 0) this._peak = Math.max(this._peak, process.memoryUsage().heapUsed);
+  }
+
+  get peak(): number {
+    return Math.max(this._peak, process.memoryUsage().heapUsed);
+  }
+}
+
+export async function measure(
+  name: string,
+  run: (heap: HeapSampler) => Promise<number /*processed bytes*/>,
+): Promise<void> {
+  global.gc?.();
+  const heap = new HeapSampler();
+  const baseline = process.memoryUsage().heapUsed;
+  const start = process.hrtime.bigint();
+  const bytes = await run(heap);
+  const elapsedSec = Number(process.hrtime.bigint() - start) / 1e9;
+  const mb = bytes / 1024 / 1024;
+
+  console.log(
+    [
+      name.padEnd(40),
+      `${mb.toFixed(1)} MB`.padStart(10),
+      `${elapsedSec.toFixed(2)} s`.padStart(10),
+      `${(mb / elapsedSec).toFixed(1)} MB/s`.padStart(12),
+      `peak heap +${((heap.peak - baseline) / 1024 / 1024).toFixed(1)} MB`.padStart(22),
+    ].join(' '),
+  );
+}
@@ -0,0 +1,114 @@
+import * as vscode from 'vscode';
+
+import { AbstractTest } from '../../src/framework/AbstractTest';
+import { TestCaseProcessor, testBeginRe, testEndRe } from '../../src/framework/GoogleTest/GoogleTestExecutable';
+import { SharedVarOfExec } from '../../src/framework/SharedVarOfExec';
+import { TestResultBuilder } from '../../src/TestResultBuilder';
+import { LineProcessor, TextStreamParser } from '../../src/util/TextStreamParser';
+import { inputSizeBytes, measure, noopLogger } from './Benchmark';
+
+///
+
+// the size of the chunks of a process' stdout: lines are split between chunks
+const chunkSize = 64 * 1024;
+
+// verbose gtest output: every test writes a lot, every 7th fails
+function* generateGoogleTestOutput(targetBytes: number): Generator<string> {
+  let pending =
+    'Running main() from gtest_main.cc\n' +
+    '[==========] Running tests.\n' +
+    '[----------] Global test environment set-up.\n';
+  let bytes = 0;
+  for (let t = 0; bytes < targetBytes; ++t) {
+    const name = `Suite${Math.floor(t / 10)}.Test${t % 10}`;
+    const parts: string[] = [];
+    if (t % 10 === 0) parts.push(`[----------] 10 tests from Suite${t / 10}\n`);
+    parts.push(`[ RUN      ] ${name}\n`);
+    for (let l = 0; l < 50; ++l) parts.push(`[ LOG ] iteration ${l}: value=${l * t} status=processing the input\n`);
+    if (t % 7 === 0) {
+      parts.push(
+        `/src/test.cpp:${t}: Failure\n`,
+        `Expected equality of these values:\n  actual\n    Which is: ${t}\n  expected\n    Which is: ${t + 1}\n`,
+        `[  FAILED  ] ${name} (1 ms)\n`,
+      );
+    } else {
+      parts.push(`[       OK ] ${name} (0 ms)\n`);
+    }
+    const str = parts.join('');
+    bytes += str.length;
+    pending += str;
+    while (pending.length >= chunkSize) {
+      yield pending.substring(0, chunkSize);
+      pending = pending.substring(chunkSize);
+    }
+  }
+  yield pending + '[----------] Global test environment tear-down\n[==========] tests ran.\n';
+}
+
+class Counters {
+  tests = 0;
+  failed = 0;
+  outputLength = 0;
+}
+
+function createTestRun(counters: Counters): vscode.TestRun {
+  return {
+    appendOutput: (output: string) => (counters.outputLength += output.length),
+    started: () => counters.tests++,
+    passed: () => {},
+    failed: () => counters.failed++,
+    errored: () => {},
+    skipped: () => {},
+  } as unknown as vscode.TestRun;
+}
+
+async function parse(heap: { sample(): void }): Promise<number> {
+  const counters = new Counters();
+  const testRun = createTestRun(counters);
+  const shared = { log: noopLogger } as unknown as SharedVarOfExec;
+  const exec = {
+    shared: { workspacePath: '/src' },
+    findSourceFilePath: (file: string | undefined) => Promise.resolve(file),
+    recordTestDuration: () => {},
+  };
+
+  // similar to the root processor of GoogleTestExecutable._handleProcess
+  const parser = new TextStreamParser(
+    noopLogger,
+    {
+      onlines(lines: readonly string[], start: number): number {
+        let output = '';
+        let i = start;
+        for (; i < lines.length && !testBeginRe.test(lines[i]); ++i) output += lines[i] + '\r\n';
+        if (output) testRun.appendOutput(output);
+        return i - start;
+      },
+      online(line: string): void | LineProcessor {
+        const m = testBeginRe.exec(line);
+        if (m) {
+          const test = { id: m[1], file: '/src/test.cpp', line: '0', log: noopLogger, item: undefined, exec };
+          const builder = new TestResultBuilder(test as unknown as AbstractTest, testRun, '', false);
+          return new TestCaseProcessor(shared, testEndRe(test.id), builder);
+        }
+      },
+    },
+    false,
+  );
+
+  let bytes = 0;
+  for (const chunk of generateGoogleTestOutput(inputSizeBytes(1024))) {
+    parser.write(chunk);
+    bytes += chunk.length;
+    heap.sample();
+    // the process output arrives in chunks: give a chance to the queued lines (failures are processed async)
+    await new Promise(resolve => setImmediate(resolve));
+  }
+  await parser.end();
+
+  if (counters.tests === 0 || counters.failed === 0 || counters.outputLength === 0) throw Error('nothing was parsed');
+  return bytes;
+}
+
+export async function run(): Promise<void> {
+  await measure('TextStreamParser: gtest output', heap => parse(heap));
+}
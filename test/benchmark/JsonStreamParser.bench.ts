@@ -0,0 +1,70 @@
+import { JsonStreamParser } from '../../src/util/JsonStreamParser';
+import { inputSizeBytes, measure, noopLogger } from './Benchmark';
+
+///
+
+// the size of the chunks of a process' stdout: benchmarks are split between chunks
+const chunkSize = 64 * 1024;
+
+// --benchmark_format=json of many parameterised benchmarks
+function* generateGoogleBenchmarkJson(targetBytes: number): Generator<string> {
+  let pending =
+    '{\n  "context": {\n    "date": "2026-10-16T10:00:00+00:00",\n    "num_cpus": 8,\n' +
+    '    "caches": [\n      {"type": "Data", "level": 1, "size": 32768}\n    ]\n  },\n  "benchmarks": [\n';
+  let bytes = 0;
+  for (let b = 0; bytes < targetBytes; ++b) {
+    const benchmark =
+      (b > 0 ? ',\n' : '') +
+      JSON.stringify(
+        {
+          name: `BM_Suite${b % 100}/Range/${b}`,
+          family_index: b % 100,
+          run_name: `BM_Suite${b % 100}/Range/${b}`,
+          run_type: 'iteration',
+          repetitions: 1,
+          iterations: 1000 + b,
+          real_time: b * 1.25,
+          cpu_time: b * 1.125,
+          time_unit: 'ns',
+          label: `range [${b}, ${b * 2}] "quoted"`,
+        },
+        null,
+        2,
+      );
+    bytes += benchmark.length;
+    pending += benchmark;
+    while (pending.length >= chunkSize) {
+      yield pending.substring(0, chunkSize);
+      pending = pending.substring(chunkSize);
+    }
+  }
+  yield pending + '\n  ]\n}\n';
+}
+
+async function parse(heap: { sample(): void }): Promise<number> {
+  let benchmarks = 0;
+  const parser = new JsonStreamParser(
+    noopLogger,
+    {
+      onvalue: (path: string): void => {
+        if (path === 'benchmarks[]') ++benchmarks;
+      },
+    },
+    ['benchmarks'],
+  );
+
+  let bytes = 0;
+  for (const chunk of generateGoogleBenchmarkJson(inputSizeBytes())) {
+    parser.write(chunk);
+    bytes += chunk.length;
+    heap.sample();
+  }
+  await parser.end();
+
+  if (benchmarks === 0) throw Error('nothing was parsed');
+  return bytes;
+}
+
+export async function run(): Promise<void> {
+  await measure('JsonStreamParser: benchmark json', heap => parse(heap));
+}
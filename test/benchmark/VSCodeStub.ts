@@ -0,0 +1,28 @@
+import Module = require('module');
+
+///
+
+// Anything can be accessed, called or constructed on it and the result is itself.
+// It is just enough to load and run the parsers without VSCode.
+const anything: object = new Proxy(function () {}, {
+  get: (_target, prop) => {
+    if (prop === 'then') return undefined; // so it is not a thenable
+    if (prop === '__esModule') return true;
+    if (prop === Symbol.toPrimitive) return (): string => '';
+    return anything;
+  },
+  set: () => true,
+  apply: () => anything,
+  construct: () => anything,
+});
+
+/**
+ * The modules which import `vscode` get the stub.
+ */
+export function stubVSCodeModule(): void {
+  const loader = Module as unknown as { _load(request: string, ...rest: unknown[]): unknown };
+  const load = loader._load;
+  loader._load = function (this: unknown, request: string, ...rest: unknown[]): unknown {
+    return request === 'vscode' ? anything : load.call(this, request, ...rest);
+  };
+}
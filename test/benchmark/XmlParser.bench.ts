@@ -0,0 +1,99 @@
+import { XmlParser, XmlTag, XmlTagProcessor } from '../../src/util/XmlParser';
+import { inputSizeBytes, measure, noopLogger } from './Benchmark';
+
+///
+
+// Catch2 xml reporter-like output: many sections with a lot of expressions
+function* generateCatch2Xml(targetBytes: number): Generator<string> {
+  yield '<?xml version="1.0" encoding="UTF-8"?>\n<Catch2TestRun name="bench" rng-seed="1" catch2-version="3.5.0">\n';
+  let bytes = 0;
+  for (let t = 0; bytes < targetBytes; ++t) {
+    const parts: string[] = [`  <TestCase name="Test ${t}" tags="[bench]" filename="/src/test.cpp" line="${t}">\n`];
+    for (let s = 0; s < 5; ++s) {
+      parts.push(`    <Section name="section ${s}" filename="/src/test.cpp" line="${t + s}">\n`);
+      for (let e = 0; e < 20; ++e) {
+        parts.push(
+          `      <Expression success="${e % 7 !== 0}" type="REQUIRE" filename="/src/test.cpp" line="${t + s + e}">\n`,
+          `        <Original>\n          value_${e} == expected_${e}\n        </Original>\n`,
+          `        <Expanded>\n          ${e} == ${e + (e % 7 === 0 ? 1 : 0)}\n        </Expanded>\n`,
+          `      </Expression>\n`,
+        );
+      }
+      parts.push(`      <OverallResults successes="17" failures="3" expectedFailures="0" skipped="false"/>\n`);
+      parts.push(`    </Section>\n`);
+    }
+    parts.push(`    <OverallResult success="false" skips="0" durationInSeconds="0.001"/>\n  </TestCase>\n`);
+    const chunk = parts.join('');
+    bytes += chunk.length;
+    yield chunk;
+  }
+  yield '</Catch2TestRun>\n';
+}
+
+class Counters {
+  testCases = 0;
+  sections = 0;
+  expressions = 0;
+  textLength = 0;
+}
+
+function createProcessors(counters: Counters, async: boolean): XmlTagProcessor {
+  const wrap = <T>(value: T): T | Promise<T> => (async ? Promise.resolve(value) : value);
+
+  const expressionProcessor: XmlTagProcessor = {
+    ontext: (dataTrimmed: string) => {
+      counters.textLength += dataTrimmed.length;
+      return wrap(undefined);
+    },
+  };
+
+  const testCaseProcessor: XmlTagProcessor = {
+    onopentag: (tag: XmlTag) => {
+      switch (tag.name) {
+        case 'Section':
+          counters.sections++;
+          return wrap(undefined);
+        case 'Expression':
+          counters.expressions++;
+          return wrap(expressionProcessor);
+        default:
+          return wrap(undefined);
+      }
+    },
+  };
+
+  return {
+    onopentag: (tag: XmlTag) => {
+      if (tag.name === 'TestCase') {
+        counters.testCases++;
+        return wrap(testCaseProcessor);
+      }
+      return wrap(undefined);
+    },
+  };
+}
+
+async function parse(async: boolean, heap: { sample(): void }): Promise<number> {
+  const counters = new Counters();
+  const parser = new XmlParser(noopLogger, createProcessors(counters, async), error => {
+    throw error;
+  });
+
+  let bytes = 0;
+  for (const chunk of generateCatch2Xml(inputSizeBytes())) {
+    parser.write(chunk);
+    bytes += chunk.length;
+    heap.sample();
+    // the process output arrives in chunks: give a chance to the queued events (async processors)
+    if (async) await new Promise(resolve => setImmediate(resolve));
+  }
+  await parser.end();
+
+  if (counters.expressions === 0 || counters.textLength === 0) throw Error('nothing was parsed');
+  return bytes;
+}
+
+export async function run(): Promise<void> {
+  await measure('XmlParser: Catch2 xml, sync processors', heap => parse(false, heap));
+  await measure('XmlParser: Catch2 xml, async processors', heap => parse(true, heap));
+}
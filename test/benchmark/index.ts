@@ -0,0 +1,25 @@
+import * as path from 'path';
+import * as glob from 'glob';
+import { stubVSCodeModule } from './VSCodeStub';
+
+// Standalone benchmarks, they are not part of the test run (they don't need VSCode).
+// Usage: npm run benchmark [-- <name filter>]
+// The size of the generated input can be set by `TESTMATE_BENCH_MB` (default: 100, or as the benchmark defines).
+
+async function main(): Promise<void> {
+  stubVSCodeModule();
+
+  const filter = process.argv[2];
+  const files = (await glob.glob('**/*.bench.js', { cwd: __dirname })).sort();
+
+  for (const file of files) {
+    if (filter && !file.includes(filter)) continue;
+    const benchmark = (await import(path.resolve(__dirname, file))) as { run(): Promise<void> };
+    await benchmark.run();
+  }
+}
+
+main().catch(err => {
+  console.error(err);
+  process.exit(1);
+});
@@ -0,0 +1,97 @@
+///
+
+const SHT_PROGBITS = 1;
+const SHT_STRTAB = 3;
+const SHT_NOTE = 7;
+const SHT_NOBITS = 8;
+const PT_NOTE = 4;
+
+export interface ElfFixture {
+  // name -> content; `.dynstr` and `.strtab` are string tables, `.bss` is NOBITS
+  sections: Record<string, string | Buffer>;
+  // hex, written as an `NT_GNU_BUILD_ID` note
+  buildId?: string;
+  // like `strip --strip-section-headers` or `sstrip`: only the program headers remain
+  withoutSectionHeaders?: boolean;
+}
+
+/**
+ * Creates a minimal little endian ELF64 file: just enough for `ElfFile`, it is not loadable.
+ */
+export function createElf(fixture: ElfFixture): Buffer {
+  const chunks: Buffer[] = [];
+  let offset = 64;
+  const append = (b: Buffer): number => {
+    const at = offset;
+    chunks.push(b);
+    offset += b.length;
+    return at;
+  };
+
+  let note: { offset: number; size: number } | undefined = undefined;
+  if (fixture.buildId !== undefined) {
+    const desc = Buffer.from(fixture.buildId, 'hex');
+    const b = Buffer.alloc(12 + 4 + Math.ceil(desc.length / 4) * 4);
+    b.writeUInt32LE(4, 0);
+    b.writeUInt32LE(desc.length, 4);
+    b.writeUInt32LE(3, 8); // NT_GNU_BUILD_ID
+    b.write('GNU\0', 12, 'latin1');
+    desc.copy(b, 16);
+    note = { offset: append(b), size: b.length };
+  }
+
+  const names = ['', ...Object.keys(fixture.sections), '.shstrtab'];
+  const shstrtab = Buffer.from(names.join('\0') + '\0', 'latin1');
+  const nameOffsets = names.map((_, i) => names.slice(0, i).reduce((acc, n) => acc + n.length + 1, 0));
+
+  const headers: { name: number; type: number; offset: number; size: number }[] = [
+    { name: 0, type: 0, offset: 0, size: 0 },
+  ];
+  Object.entries(fixture.sections).forEach(([name, content], i) => {
+    const data = typeof content === 'string' ? Buffer.from(content, 'latin1') : content;
+    const type =
+      name === '.bss' ? SHT_NOBITS : name.endsWith('str') || name.endsWith('strtab') ? SHT_STRTAB : SHT_PROGBITS;
+    const at = type === SHT_NOBITS ? offset : append(data);
+    headers.push({ name: nameOffsets[i + 1], type, offset: at, size: data.length });
+  });
+  if (note) headers.push({ name: 0, type: SHT_NOTE, offset: note.offset, size: note.size });
+  const shstrtabName = nameOffsets[names.length - 1];
+  headers.push({ name: shstrtabName, type: SHT_STRTAB, offset: append(shstrtab), size: shstrtab.length });
+
+  let phoff = 0;
+  if (note) {
+    const ph = Buffer.alloc(56);
+    ph.writeUInt32LE(PT_NOTE, 0);
+    ph.writeBigUInt64LE(BigInt(note.offset), 0x08);
+    ph.writeBigUInt64LE(BigInt(note.size), 0x20);
+    phoff = append(ph);
+  }
+
+  let shoff = 0;
+  if (!fixture.withoutSectionHeaders) {
+    const table = Buffer.alloc(64 * headers.length);
+    headers.forEach((h, i) => {
+      table.writeUInt32LE(h.name, i * 64);
+      table.writeUInt32LE(h.type, i * 64 + 0x04);
+      table.writeBigUInt64LE(BigInt(h.offset), i * 64 + 0x18);
+      table.writeBigUInt64LE(BigInt(h.size), i * 64 + 0x20);
+    });
+    shoff = append(table);
+  }
+
+  const header = Buffer.alloc(64);
+  Buffer.from([0x7f, 0x45, 0x4c, 0x46, 2, 1, 1]).copy(header);
+  header.writeUInt16LE(2, 0x10); // ET_EXEC
+  header.writeUInt16LE(0x3e, 0x12); // x86-64
+  header.writeUInt32LE(1, 0x14);
+  header.writeBigUInt64LE(BigInt(phoff), 0x20);
+  header.writeBigUInt64LE(BigInt(shoff), 0x28);
+  header.writeUInt16LE(64, 0x34);
+  header.writeUInt16LE(note ? 56 : 0, 0x36);
+  header.writeUInt16LE(note ? 1 : 0, 0x38);
+  header.writeUInt16LE(fixture.withoutSectionHeaders ? 0 : 64, 0x3a);
+  header.writeUInt16LE(fixture.withoutSectionHeaders ? 0 : headers.length, 0x3c);
+  header.writeUInt16LE(fixture.withoutSectionHeaders ? 0 : headers.length - 1, 0x3e);
+
+  return Buffer.concat([header, ...chunks]);
+}